@@ -19,6 +19,7 @@
 
 #include "CLIProcessor.hpp"
 #include "StelFileMgr.hpp"
+#include "StelSkyImageIndex.hpp"
 #include "StelUtils.hpp"
 
 #include <QSettings>
@@ -72,7 +73,22 @@ void CLIProcessor::parseCLIArgsPreConfig(const QStringList& argList)
 		          << "--projection-type       : Specify projection type, e.g. stereographic\n"
 		          << "--restore-defaults      : Delete existing config.ini and use defaults\n"
 		          << "--multires-image        : With filename / URL argument, specify a\n"
-		          << "                          multi-resolution image to load\n";
+		          << "                          multi-resolution image to load\n"
+		          << "--convert-survey        : Write the binary index of the local multi-\n"
+		          << "                          resolution image described by the given JSON\n"
+		          << "                          file and exit\n"
+		          << "--convert-survey-output : File of the index (default the JSON file name\n"
+		          << "                          with the .stsi extension)\n"
+		          << "--predict-passes        : Print the satellite passes over the given\n"
+		          << "                          number of days and exit\n"
+		          << "--pass-min-elevation    : Minimum elevation of the predicted passes\n"
+		          << "                          in degrees (default 0)\n"
+		          << "--benchmark             : Run the given comma separated benchmark\n"
+		          << "                          scenarios offscreen, or all, and exit\n"
+		          << "--benchmark-frames      : Number of frames of each scenario (default 300)\n"
+		          << "--benchmark-output      : File of the JSON report (default stdout)\n"
+		          << "--benchmark-baseline    : Fail if slower than this previous report\n"
+		          << "--benchmark-tolerance   : Allowed slowdown in percent (default 10)\n";
 		exit(0);
 	}
 
@@ -94,6 +110,23 @@ void CLIProcessor::parseCLIArgsPreConfig(const QStringList& argList)
 		exit(0);
 	}
 
+	try
+	{
+		const QString survey = argsGetOptionWithArg(argList, "", "--convert-survey", "").toString();
+		if (!survey.isEmpty())
+		{
+			QString output = argsGetOptionWithArg(argList, "", "--convert-survey-output", "").toString();
+			if (output.isEmpty())
+				output = survey.left(survey.lastIndexOf('.')) + StelSkyImageIndex::FileExtension;
+			exit(StelSkyImageIndex::convertFromJson(survey, output) ? 0 : 1);
+		}
+	}
+	catch (std::runtime_error& e)
+	{
+		qCritical() << "ERROR: while processing --convert-survey option: " << e.what();
+		exit(1);
+	}
+
 	try
 	{
 		QString newUserDir;
@@ -113,9 +146,12 @@ void CLIProcessor::parseCLIArgsPostConfig(const QStringList& argList, QSettings*
 	// Over-ride config file options with command line options
 	// We should catch exceptions from argsGetOptionWithArg...
 	int fullScreen, altitude;
-	float fov;
+	int benchmarkFrames;
+	float fov, passMinElevation;
+	double predictPassesDays, benchmarkTolerance;
 	QString landscapeId, homePlanet, longitude, latitude, skyDate, skyTime;
 	QString projectionType, screenshotDir, multiresImage, startupScript;
+	QString benchmark, benchmarkOutput, benchmarkBaseline;
 	try
 	{
 		fullScreen = argsGetYesNoOption(argList, "-f", "--full-screen", -1);
@@ -131,6 +167,13 @@ void CLIProcessor::parseCLIArgsPostConfig(const QStringList& argList, QSettings*
 		screenshotDir = argsGetOptionWithArg(argList, "", "--screenshot-dir", "").toString();
 		multiresImage = argsGetOptionWithArg(argList, "", "--multires-image", "").toString();
 		startupScript = argsGetOptionWithArg(argList, "", "--startup-script", "").toString();
+		predictPassesDays = argsGetOptionWithArg(argList, "", "--predict-passes", -1.).toDouble();
+		passMinElevation = argsGetOptionWithArg(argList, "", "--pass-min-elevation", 0.f).toFloat();
+		benchmark = argsGetOptionWithArg(argList, "", "--benchmark", "").toString();
+		benchmarkFrames = argsGetOptionWithArg(argList, "", "--benchmark-frames", 300).toInt();
+		benchmarkOutput = argsGetOptionWithArg(argList, "", "--benchmark-output", "").toString();
+		benchmarkBaseline = argsGetOptionWithArg(argList, "", "--benchmark-baseline", "").toString();
+		benchmarkTolerance = argsGetOptionWithArg(argList, "", "--benchmark-tolerance", 10.).toDouble();
 	}
 	catch (std::runtime_error& e)
 	{
@@ -212,6 +255,21 @@ void CLIProcessor::parseCLIArgsPostConfig(const QStringList& argList, QSettings*
 		qApp->setProperty("onetime_startup_script", startupScript);
 	}
 
+	if (predictPassesDays>0.0)
+	{
+		qApp->setProperty("onetime_predict_passes", predictPassesDays);
+		qApp->setProperty("onetime_pass_min_elevation", passMinElevation);
+	}
+
+	if (!benchmark.isEmpty())
+	{
+		qApp->setProperty("onetime_benchmark", benchmark);
+		qApp->setProperty("onetime_benchmark_frames", benchmarkFrames);
+		qApp->setProperty("onetime_benchmark_output", benchmarkOutput);
+		qApp->setProperty("onetime_benchmark_baseline", benchmarkBaseline);
+		qApp->setProperty("onetime_benchmark_tolerance", benchmarkTolerance);
+	}
+
 	if (fov>0.0) confSettings->setValue("navigation/init_fov", fov);
 	if (!projectionType.isEmpty()) confSettings->setValue("projection/type", projectionType);
 	if (!screenshotDir.isEmpty())
@@ -48,9 +48,24 @@
 #include <QDir>
 
 // Qml Renderer that render the sky in the stellarium item.
+// It only draws a new frame when StelApp tells that something changed in the sky, or shortly after a user input.
 class SkyRenderer : public QQuickFramebufferObject::Renderer
 {
 public:
+	SkyRenderer() : item(NULL), lastEventTime(0.)
+	{
+		QSettings* conf = StelApp::getInstance().getSettings();
+		minFps = conf->value("video/minimum_fps", 1.f).toFloat();
+		maxFps = conf->value("video/maximum_fps", 10000.f).toFloat();
+	}
+
+	virtual void synchronize(QQuickFramebufferObject* aitem) Q_DECL_OVERRIDE
+	{
+		// Called with the GUI thread blocked.
+		item = aitem;
+		lastEventTime = static_cast<StelQuickStelItem*>(aitem)->getLastEventTime();
+	}
+
 	virtual QOpenGLFramebufferObject *createFramebufferObject(const QSize &size) Q_DECL_OVERRIDE
 	{
 		qDebug() << "Creating FBO" << size;
@@ -68,8 +83,37 @@ public:
 		StelApp::getInstance().update(newTime-lastPaint);
 		lastPaint = newTime;
 		StelApp::getInstance().draw();
-		update();
+		scheduleNextFrame(newTime);
 	}
+
+private:
+	void scheduleNextFrame(double now)
+	{
+		double delay = StelApp::getInstance().getNextFrameDelay();
+		// Keep the frame rate high for a while after the user interacted with the view.
+		if (now-lastEventTime<2.5)
+			delay = 0.;
+		if (minFps>0.f && (delay<0. || delay>1./minFps))
+			delay = 1./minFps;
+		if (maxFps>0.f && delay>=0. && delay<1./maxFps)
+			delay = 1./maxFps;
+
+		if (delay>=0. && delay<0.005)
+		{
+			update();
+			return;
+		}
+		if (item==NULL)
+			return;
+		// The timer must run in the GUI thread of the item.
+		const int ms = delay<0. ? -1 : (int)(delay*1000.);
+		QMetaObject::invokeMethod(item, "scheduleRedraw", Qt::QueuedConnection, Q_ARG(int, ms));
+	}
+
+	QQuickFramebufferObject* item;
+	double lastEventTime;
+	float minFps;
+	float maxFps;
 };
 
 
@@ -80,6 +124,11 @@ StelQuickStelItem::StelQuickStelItem()
 	connect(timer, SIGNAL(timeout()), this, SLOT(update()));
 	timer->setInterval(100);
 	timer->start();
+	redrawTimer = new QTimer(this);
+	redrawTimer->setSingleShot(true);
+	redrawTimer->setTimerType(Qt::PreciseTimer);
+	connect(redrawTimer, SIGNAL(timeout()), this, SLOT(redraw()));
+	lastEventTime = StelApp::getTotalRunTime();
 	setMirrorVertically(true);
 	setAcceptHoverEvents(true);
 	setAcceptedMouseButtons(Qt::AllButtons);
@@ -93,6 +142,7 @@ StelQuickStelItem::StelQuickStelItem()
 	connect(StelApp::getInstance().getCore(), SIGNAL(locationChanged(StelLocation)), this, SIGNAL(positionChanged()));
 	GPSMgr* gpsMgr = GETSTELMODULE(GPSMgr);
 	connect(gpsMgr, SIGNAL(stateChanged(GPSMgr::State)), this, SIGNAL(gpsStateChanged()));
+	connect(&StelApp::getInstance(), SIGNAL(redrawRequested()), this, SLOT(redraw()));
 
 	QSettings* conf = StelApp::getInstance().getSettings();
 	setAutoGotoNight(conf->value("gui/auto_goto_night", true).toBool());
@@ -119,8 +169,24 @@ bool StelQuickStelItem::eventFilter(QObject* obj, QEvent* event)
 			timer->stop();
 			break;
 		case QEvent::ApplicationActivate:
+			timer->start();
+			redraw();
+			break;
 		case QEvent::TouchBegin:
 			timer->start();
+			lastEventTime = StelApp::getTotalRunTime();
+			redraw();
+			break;
+		case QEvent::TouchUpdate:
+		case QEvent::TouchEnd:
+		case QEvent::MouseButtonPress:
+		case QEvent::MouseButtonRelease:
+		case QEvent::MouseMove:
+		case QEvent::Wheel:
+		case QEvent::KeyPress:
+		case QEvent::KeyRelease:
+			lastEventTime = StelApp::getTotalRunTime();
+			redraw();
 			break;
 		default:
 			break;
@@ -128,6 +194,20 @@ bool StelQuickStelItem::eventFilter(QObject* obj, QEvent* event)
 	return QObject::eventFilter(obj, event);
 }
 
+void StelQuickStelItem::scheduleRedraw(int ms)
+{
+	if (ms<0)
+		redrawTimer->stop();
+	else
+		redrawTimer->start(ms);
+}
+
+void StelQuickStelItem::redraw()
+{
+	redrawTimer->stop();
+	QQuickFramebufferObject::update();
+}
+
 double StelQuickStelItem::getJd() const
 {
 	StelCore* core = StelApp::getInstance().getCore();
@@ -419,59 +499,33 @@ QString StelQuickStelItem::getCurrentSkyCultureBaseUrl() const
 
 QStringList StelQuickStelItem::getCountryNames() const
 {
-	QSet<QString> done;
-	QStringList ret;
-	QList<StelLocation> allLocations = StelApp::getInstance().getLocationMgr().getAll();
-	foreach(const StelLocation& loc, allLocations)
-	{
-		if (loc.planetName == "Earth" && !done.contains(loc.country))
-		{
-			ret << loc.country;
-			done.insert(loc.country);
-		}
-	}
-	ret.sort();
-	return ret;
+	return StelApp::getInstance().getLocationMgr().getCountryNames();
 }
 
 QStringList StelQuickStelItem::getCityNames(const QString& country, const QString& search) const
 {
 	QStringList ret;
 	if (country.isEmpty()) return ret;
-	QList<StelLocation> allLocations = StelApp::getInstance().getLocationMgr().getAll();
-	foreach(const StelLocation& loc, allLocations)
-	{
-        if (loc.country == country)
-        {
-            if (search.isEmpty())
-            {
-                ret << loc.name;
-            }
-            else
-            {
-                if (loc.name.contains(search))
-                    ret << loc.name;
-            }
-        }
-	}
-	ret.sort();
+	ret = StelApp::getInstance().getLocationMgr().getCityNames(country);
+	if (!search.isEmpty())
+		ret = ret.filter(search);
 	return ret;
 }
 
 bool StelQuickStelItem::testCityNames(const QString& country, const QString& search) const
 {
-    if (country.isEmpty()) return false;
-    if (search.isEmpty()) return true;
-    QList<StelLocation> allLocations = StelApp::getInstance().getLocationMgr().getAll();
-    foreach(const StelLocation& loc, allLocations)
-    {
-        if (loc.country == country)
-        {
-            if (loc.name.contains(search))
-                return true;
-        }
-    }
-    return false;
+	if (country.isEmpty()) return false;
+	if (search.isEmpty()) return true;
+	const StelLocationMgr& locationMgr = StelApp::getInstance().getLocationMgr();
+	// A name starting with the text is found in the sorted location IDs without going through the whole list
+	if (!locationMgr.getCityNames(country, search).isEmpty())
+		return true;
+	foreach(const QString& name, locationMgr.getCityNames(country))
+	{
+		if (name.contains(search))
+			return true;
+	}
+	return false;
 }
 
 QString StelQuickStelItem::getLocation() const
@@ -123,6 +123,8 @@ public:
 	int getLinesThickness() const;
 	void setLinesThickness(int value);
 	Q_INVOKABLE void resetSettings();
+	//! Time of the last user input, in seconds since the start of the application.
+	double getLastEventTime() const {return lastEventTime;}
 
 protected:
 	bool eventFilter(QObject *, QEvent *) Q_DECL_OVERRIDE;
@@ -149,9 +151,15 @@ signals:
 
 private slots:
 	void update();
+	//! Draw the next frame of the sky after the given delay in ms, or stop the pending one if the delay is negative.
+	void scheduleRedraw(int ms);
+	//! Draw the next frame of the sky now.
+	void redraw();
 
 private:
 	class QTimer* timer;
+	class QTimer* redrawTimer;
+	double lastEventTime;
 	bool forwardClicks;
 	bool autoGotoNight;
 	MainThreadProxy* mainThreadProxy;
@@ -154,6 +154,7 @@ void StelQuickView::beforeGlContextDestroyed()
 void StelQuickView::requestQuit()
 {
 	quitRequested = true;
+	update();
 }
 
 void StelQuickView::handleResize()
@@ -212,6 +213,8 @@ void StelQuickView::synchronize()
 void StelQuickView::showGui()
 {
 	setSource(QUrl("qrc:/qml/main.qml"));
+	// From now on the sky item requests the frames it needs.
+	timer->stop();
 #ifdef Q_OS_ANDROID
 	StelAndroid::setCanPause(true);
 #endif
@@ -226,7 +229,10 @@ bool StelQuickView::eventFilter(QObject* obj, QEvent* event)
 			break;
 		case QEvent::ApplicationActivate:
 		case QEvent::TouchBegin:
-			timer->start();
+			if (stelApp==NULL)
+				timer->start();
+			else
+				update();
 			break;
 		default:
 			break;
@@ -30,7 +30,9 @@
 #include <QUrl>
 #include <QDir>
 #include <QBuffer>
-#include <QThread>
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QThreadPool>
 #include <QNetworkAccessManager>
 #include <QNetworkRequest>
 #include <QNetworkReply>
@@ -59,34 +61,75 @@ QNetworkAccessManager& MultiLevelJsonBase::getNetworkAccessManager()
 }
 
 /*************************************************************************
-  Class used to load a JSON file in a thread
+  State of a JSON file parsed in the loader threads, shared with the element
  *************************************************************************/
-class JsonLoadThread : public QThread
+struct JsonLoadData
 {
-	public:
-		JsonLoadThread(MultiLevelJsonBase* atile, QByteArray content, bool aqZcompressed=false, bool agzCompressed=false) : QThread((QObject*)atile),
-			tile(atile), data(content), qZcompressed(aqZcompressed), gzCompressed(agzCompressed){;}
-		virtual void run();
-	private:
-		MultiLevelJsonBase* tile;
-		QByteArray data;
-		const bool qZcompressed;
-		const bool gzCompressed;
+	enum State
+	{
+		Pending,
+		Done,
+		Cancelled	//!< the parsing was cancelled before it started
+	};
+
+	JsonLoadData(const QByteArray& acontent, const QString& afileName, bool aqZcompressed, bool agzCompressed)
+		: content(acontent), fileName(afileName), qZcompressed(aqZcompressed), gzCompressed(agzCompressed), state(Pending), cancelled(0) {}
+
+	//! The downloaded file, or empty if the local file must be read.
+	QByteArray content;
+	QString fileName;
+	const bool qZcompressed;
+	const bool gzCompressed;
+
+	QAtomicInt state;
+	//! Set by the element when the parsing is not needed anymore.
+	QAtomicInt cancelled;
+	QVariantMap result;
+	QString errorMessage;
 };
 
-void JsonLoadThread::run()
+/*************************************************************************
+  Class used to load a JSON file in the loader threads
+ *************************************************************************/
+class JsonLoader : public QRunnable
 {
+public:
+	JsonLoader(const QSharedPointer<JsonLoadData>& adata) : data(adata) {}
+	virtual void run();
+private:
+	QSharedPointer<JsonLoadData> data;
+};
+
+void JsonLoader::run()
+{
+	if (data->cancelled.loadAcquire())
+	{
+		data->state.storeRelease(JsonLoadData::Cancelled);
+		return;
+	}
 	try
 	{
-		QBuffer buf(&data);
-		buf.open(QIODevice::ReadOnly);
-		tile->temporaryResultMap = MultiLevelJsonBase::loadFromJSON(buf, qZcompressed, gzCompressed);
+		if (data->content.isEmpty())
+		{
+			QFile f(data->fileName);
+			if (!f.open(QIODevice::ReadOnly))
+				throw std::runtime_error(qPrintable(QString("can't open %1").arg(QDir::toNativeSeparators(data->fileName))));
+			data->result = MultiLevelJsonBase::loadFromJSON(f, data->qZcompressed, data->gzCompressed);
+		}
+		else
+		{
+			QBuffer buf(&data->content);
+			buf.open(QIODevice::ReadOnly);
+			data->result = MultiLevelJsonBase::loadFromJSON(buf, data->qZcompressed, data->gzCompressed);
+		}
 	}
-	catch (std::runtime_error e)
+	catch (std::runtime_error& e)
 	{
-		qWarning() << "WARNING : Can't parse loaded JSON description: " << e.what();
-		tile->errorOccured = true;
+		data->errorMessage = e.what();
 	}
+	// The downloaded file is not needed anymore
+	data->content.clear();
+	data->state.storeRelease(JsonLoadData::Done);
 }
 
 MultiLevelJsonBase::MultiLevelJsonBase(MultiLevelJsonBase* parent) : StelSkyLayer(parent)
@@ -94,7 +137,7 @@ MultiLevelJsonBase::MultiLevelJsonBase(MultiLevelJsonBase* parent) : StelSkyLaye
 	errorOccured = false;
 	httpReply = NULL;
 	downloading = false;
-	loadThread = NULL;
+	lowPriority = false;
 	loadingState = false;
 	lastPercent = 0;
 	// Avoid tiles to be deleted just after constructed
@@ -107,10 +150,11 @@ MultiLevelJsonBase::MultiLevelJsonBase(MultiLevelJsonBase* parent) : StelSkyLaye
 	}
 }
 
-void MultiLevelJsonBase::initFromUrl(const QString& url)
+void MultiLevelJsonBase::initFromUrl(const QString& url, bool alowPriority)
 {
 	const MultiLevelJsonBase* parent = qobject_cast<MultiLevelJsonBase*>(QObject::parent());
 	contructorUrl = url;
+	lowPriority = alowPriority;
 	if (!url.startsWith("http://") && (parent==NULL || !parent->getBaseUrl().startsWith("http://")))
 	{
 		// Assume a local file
@@ -133,10 +177,17 @@ void MultiLevelJsonBase::initFromUrl(const QString& url)
 		}
 		QFileInfo finf(fileName);
 		baseUrl = finf.absolutePath()+'/';
-		QFile f(fileName);
-		f.open(QIODevice::ReadOnly);
 		const bool compressed = fileName.endsWith(".qZ");
 		const bool gzCompressed = fileName.endsWith(".gz");
+		if (parent!=NULL)
+		{
+			// Don't stall the rendering, the element is displayed when its file is parsed
+			loadData = QSharedPointer<JsonLoadData>(new JsonLoadData(QByteArray(), fileName, compressed, gzCompressed));
+			startJsonLoad();
+			return;
+		}
+		QFile f(fileName);
+		f.open(QIODevice::ReadOnly);
 		try
 		{
 			loadFromQVariantMap(loadFromJSON(f, compressed, gzCompressed));
@@ -168,6 +219,8 @@ void MultiLevelJsonBase::initFromUrl(const QString& url)
 		Q_ASSERT(httpReply==NULL);
 		QNetworkRequest req(qurl);
 		req.setRawHeader("User-Agent", StelUtils::getApplicationName().toLatin1());
+		if (lowPriority)
+			req.setPriority(QNetworkRequest::LowPriority);
 		httpReply = getNetworkAccessManager().get(req);
 		//qDebug() << "Started downloading " << httpReply->request().url().path();
 		Q_ASSERT(httpReply->error()==QNetworkReply::NoError);
@@ -217,17 +270,9 @@ MultiLevelJsonBase::~MultiLevelJsonBase()
 		//httpReply->deleteLater();
 		httpReply = NULL;
 	}
-	if (loadThread && loadThread->isRunning())
-	{
-		//qDebug() << "--> Abort thread " << contructorUrl;
-		disconnect(loadThread, SIGNAL(finished()), this, SLOT(jsonLoadFinished()));
-		// The thread is currently running, it needs to be properly stopped
-		if (loadThread->wait(1)==false)
-		{
-			loadThread->terminate();
-			//loadThread->wait(2000);
-		}
-	}
+	// The loader keeps its own reference to the data
+	if (loadData)
+		loadData->cancelled.storeRelease(1);
 	foreach (MultiLevelJsonBase* tile, subTiles)
 	{
 		tile->deleteLater();
@@ -242,19 +287,29 @@ void MultiLevelJsonBase::scheduleChildsDeletion()
 	{
 		if (tile->timeWhenDeletionScheduled<0)
 			tile->timeWhenDeletionScheduled = StelApp::getInstance().getTotalRunTime();
+		if (tile->loadData)
+			tile->loadData->cancelled.storeRelease(1);
 	}
 }
 
 // If a deletion was scheduled, cancel it.
 void MultiLevelJsonBase::cancelDeletion()
 {
-	timeWhenDeletionScheduled=-1.;
+	cancelOwnDeletion();
 	foreach (MultiLevelJsonBase* tile, subTiles)
 	{
 		tile->cancelDeletion();
 	}
 }
 
+void MultiLevelJsonBase::cancelOwnDeletion()
+{
+	timeWhenDeletionScheduled=-1.;
+	// If the parsing was already cancelled, it is started again by updateLoading()
+	if (loadData)
+		loadData->cancelled.storeRelease(0);
+}
+
 // Load the tile information from a JSON file
 QVariantMap MultiLevelJsonBase::loadFromJSON(QIODevice& input, bool qZcompressed, bool gzCompressed)
 {
@@ -319,31 +374,64 @@ void MultiLevelJsonBase::downloadFinished()
 	httpReply->deleteLater();
 	httpReply=NULL;
 
-	Q_ASSERT(loadThread==NULL);
-	loadThread = new JsonLoadThread(this, content, qZcompressed, gzCompressed);
-	connect(loadThread, SIGNAL(finished()), this, SLOT(jsonLoadFinished()));
-	loadThread->start(QThread::LowestPriority);
+	Q_ASSERT(!loadData);
+	loadData = QSharedPointer<JsonLoadData>(new JsonLoadData(content, QString(), qZcompressed, gzCompressed));
+	startJsonLoad();
+}
+
+void MultiLevelJsonBase::startJsonLoad()
+{
+	downloading = true;
+	// The prefetched elements are parsed after the textures being displayed
+	StelApp::getInstance().getLoaderPool()->start(new JsonLoader(loadData), lowPriority ? -1 : getLoadPriority());
 }
 
-// Called when the element is fully loaded from the JSON file
-void MultiLevelJsonBase::jsonLoadFinished()
+// Load the element when its JSON file was parsed
+bool MultiLevelJsonBase::updateLoading()
 {
-	loadThread->wait();
-	delete loadThread;
-	loadThread = NULL;
+	if (!downloading)
+		return false;
+	// Still downloading
+	if (!loadData)
+	{
+		StelApp::getInstance().reportPendingLoad();
+		return true;
+	}
+	switch (loadData->state.loadAcquire())
+	{
+		case JsonLoadData::Pending:
+			StelApp::getInstance().reportPendingLoad();
+			return true;
+		case JsonLoadData::Cancelled:
+			// The element is needed again
+			loadData->state.storeRelease(JsonLoadData::Pending);
+			loadData->cancelled.storeRelease(0);
+			startJsonLoad();
+			StelApp::getInstance().reportPendingLoad();
+			return true;
+		default:
+			break;
+	}
+
+	const QSharedPointer<JsonLoadData> data = loadData;
+	loadData.clear();
 	downloading = false;
-	if (errorOccured)
-		return;
+	if (!data->errorMessage.isEmpty())
+	{
+		qWarning() << "WARNING : Can't parse loaded JSON description: " << data->errorMessage;
+		errorOccured = true;
+		return false;
+	}
 	try
 	{
-		loadFromQVariantMap(temporaryResultMap);
+		loadFromQVariantMap(data->result);
 	}
 	catch (std::runtime_error e)
 	{
 		qWarning() << "WARNING: invalid variant map: " << e.what();
 		errorOccured = true;
-		return;
 	}
+	return false;
 }
 
 
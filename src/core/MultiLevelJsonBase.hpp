@@ -20,6 +20,7 @@
 #define _MULTILEVELJSONBASE_HPP_
 
 #include <QList>
+#include <QSharedPointer>
 #include <QString>
 #include <QVariantMap>
 #include <QNetworkReply>
@@ -28,22 +29,23 @@
 
 class QIODevice;
 class StelCore;
+struct JsonLoadData;
 
 //! Abstract base class for managing multi-level tree objects stored in JSON format.
-//! The JSON files can be stored on disk or remotely and are loaded into threads.
+//! The JSON files can be stored on disk or remotely. They are parsed in the loader threads of StelApp,
+//! except the local file of a root element which is parsed when it is created.
 class MultiLevelJsonBase : public StelSkyLayer
 {
 	Q_OBJECT
 
-	friend class JsonLoadThread;
-
 public:
 	//! Default constructor.
 	MultiLevelJsonBase(MultiLevelJsonBase* parent=NULL);
 
 	//! Init the element from a URL.
 	//! This method should be called by the constructors of the subclass.
-	void initFromUrl(const QString& url);
+	//! @param lowPriority if true a remote JSON file is downloaded after the other requests, e.g. when it is prefetched.
+	void initFromUrl(const QString& url, bool lowPriority=false);
 
 	//! Init the element from a QVariantMap.
 	//! This method should be called by the constructors of the subclass.
@@ -67,13 +69,15 @@ public:
 
 	//! Schedule a deletion for all the childs.
 	//! It will practically occur after the delay passed as argument to deleteUnusedTiles() has expired.
+	//! The parsing of their JSON files is cancelled if it didn't start yet.
 	void scheduleChildsDeletion();
 
+	//! Load the element information from a JSON file
+	static QVariantMap loadFromJSON(QIODevice& input, bool qZcompressed=false, bool gzCompressed=false);
+
 private slots:
 	//! Called when the download for the JSON file terminated.
 	void downloadFinished();
-	//! Called when the JSON file is loaded.
-	void jsonLoadFinished();
 
 protected:
 	//! Load the element from a valid QVariantMap.
@@ -83,6 +87,15 @@ protected:
 	//! Return true if a deletion is currently scheduled.
 	bool isDeletionScheduled() const {return timeWhenDeletionScheduled>0.;}
 
+	//! Return the priority of the parsing of the JSON file in the loader threads, the highest first.
+	//! The default implementation returns 0, which is also the priority of the visible textures.
+	virtual int getLoadPriority() const {return 0;}
+
+	//! Load the element if its JSON file was parsed since the last call.
+	//! It must be called before using an element being downloaded.
+	//! @return true if the JSON file is still downloading or being parsed.
+	bool updateLoading();
+
 	//! The very short name for this image set to be used in loading bar.
 	QString shortName;
 
@@ -103,14 +116,16 @@ protected:
 	//! Delete all the subtiles which were not displayed since more than lastDrawTrigger seconds
 	void deleteUnusedSubTiles();
 
-	//! true if the JSON descriptor file is currently downloading
+	//! true if the JSON descriptor file is currently downloading or being parsed
 	bool downloading;
 
+	//! true if the element is loaded before being displayed, so that its loads have the lowest priority
+	bool lowPriority;
+
 	//! If a deletion was scheduled, cancel it.
 	void cancelDeletion();
-
-	//! Load the element information from a JSON file
-	static QVariantMap loadFromJSON(QIODevice& input, bool qZcompressed=false, bool gzCompressed=false);
+	//! If a deletion was scheduled for this element, cancel it, but not the ones of its childs.
+	void cancelOwnDeletion();
 
 private:
 	//! Return the base URL prefixed to relative URL
@@ -122,14 +137,15 @@ private:
 	// The delay after which a scheduled deletion will occur
 	float deletionDelay;
 
-	class JsonLoadThread* loadThread;
+	// Start parsing the JSON file in the loader threads
+	void startJsonLoad();
+
+	// The JSON file being parsed in the loader threads
+	QSharedPointer<JsonLoadData> loadData;
 
 	// Time at which deletion was first scheduled
 	double timeWhenDeletionScheduled;
 
-	// The temporary map filled in a thread
-	QVariantMap temporaryResultMap;
-
 	bool loadingState;
 	int lastPercent;
 
@@ -70,6 +70,14 @@ public:
 		*mag += airmass(altAzPos[2], false) * ext_coeff;
 	}
 
+	//! Compute extinction effect for a block of @param num stars given only the z components of their
+	//! NORMALIZED altAz positions, i.e. sin(geometrical altitude). The magnitude shifts are added to @param mag.
+	void forward(const float* sinAlt, float* mag, int num) const
+	{
+		for (int i=0;i<num;++i)
+			mag[i] += airmass(sinAlt[i], false) * ext_coeff;
+	}
+
 	//! Compute inverse extinction effect for arrays of size @param num position vectors and magnitudes.
 	//! @param altAzPos are the NORMALIZED (!!) (geometrical) star position vectors, and their z components sin(apparent_altitude).
 	//! Note that forward/backward are no absolute reverse operations!
@@ -150,6 +158,14 @@ public:
 
 	Mat4d getApproximateLinearTransfo() const {return postTransfoMat*preTransfoMat;}
 
+	bool getShaderTransfo(Mat4f& preTransfo, float& refractionCorr, Mat4f& postTransfo) const
+	{
+		preTransfo = preTransfoMatf;
+		refractionCorr = press_temp_corr_Saemundson;
+		postTransfo = postTransfoMatf;
+		return true;
+	}
+
 	StelProjector::ModelViewTranformP clone() const {Refraction* refr = new Refraction(); *refr=*this; return StelProjector::ModelViewTranformP(refr);}
 
 	//! Set surface air pressure (mbars), influences refraction computation.
@@ -43,6 +43,7 @@
 
 #include "StelProgressController.hpp"
 #include "StelModuleMgr.hpp"
+#include "StelFader.hpp"
 #include "StelLocaleMgr.hpp"
 #include "StelSkyCultureMgr.hpp"
 #include "StelFileMgr.hpp"
@@ -52,6 +53,7 @@
 #include "StelVideoMgr.hpp"
 #include "StelGuiBase.hpp"
 #include "StelPainter.hpp"
+#include "StelProfiler.hpp"
 #ifndef DISABLE_SCRIPTING
  #include "StelScriptMgr.hpp"
  #include "StelMainScriptAPIProxy.hpp"
@@ -72,6 +74,8 @@
 #include <QStringList>
 #include <QSysInfo>
 #include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
 #include <QTimer>
 #include <QDir>
 #include <QCoreApplication>
@@ -188,6 +192,9 @@ StelApp::StelApp(QObject* parent)
 	, frame(0)
 	, timefr(0.)
 	, timeBase(0.)
+	, nextFrameDelay(0.)
+	, redrawRequest(1)
+	, pendingLoads(false)
 	, flagNightVision(false)
 	, confSettings(NULL)
 	, initialized(false)
@@ -216,6 +223,10 @@ StelApp::StelApp(QObject* parent)
 
 	moduleMgr = new StelModuleMgr();
 
+	loaderPool = new QThreadPool(this);
+	// Leave one core for the rendering
+	loaderPool->setMaxThreadCount(qMax(1, QThread::idealThreadCount()-1));
+
 	wheelEventTimer = new QTimer(this);
 	wheelEventTimer->setInterval(25);
 	wheelEventTimer->setSingleShot(true);
@@ -228,6 +239,10 @@ StelApp::~StelApp()
 {
 	qDebug() << qPrintable(QString("Downloaded %1 files (%2 kbytes) in a session of %3 sec (average of %4 kB/s + %5 files from cache (%6 kB)).").arg(nbDownloadedFiles).arg(totalDownloadedSize/1024).arg(getTotalRunTime()).arg((double)(totalDownloadedSize/1024)/getTotalRunTime()).arg(nbUsedCache).arg(totalUsedCacheSize/1024));
 
+	// The loaders only use data shared with their owners, but don't keep loading data nobody will use
+	loaderPool->clear();
+	loaderPool->waitForDone();
+
 	stelObjectMgr->unSelect();
 	moduleMgr->unloadModule("StelSkyLayerMgr", false);  // We need to delete it afterward
 	moduleMgr->unloadModule("StelObjectMgr", false);// We need to delete it afterward
@@ -343,6 +358,9 @@ void StelApp::init(QSettings* conf)
 	confSettings = conf;
 
 	devicePixelsPerPixel = QOpenGLContext::currentContext()->screen()->devicePixelRatio();
+
+	if (conf->value("main/flag_profiler", false).toBool())
+		StelProfiler::setEnabled(true);
 	
 	core = new StelCore();
 	if (saveProjW!=-1 && saveProjH!=-1)
@@ -385,6 +403,8 @@ void StelApp::init(QSettings* conf)
 	getModuleMgr().registerModule(hip_stars);
 
 	core->init();
+	// The location can be changed from outside of the frames, e.g. by the GPS
+	connect(core, SIGNAL(locationChanged(StelLocation)), this, SLOT(requestRedraw()));
 
 	// Init nebulas
 	NebulaMgr* nebulas = new NebulaMgr();
@@ -531,6 +551,7 @@ void StelApp::update(double deltaTime)
 		timeBase+=1.;
 	}
 		
+	STEL_PROFILE_SCOPE("StelApp::update");
 	core->update(deltaTime);
 
 	moduleMgr->update();
@@ -538,6 +559,7 @@ void StelApp::update(double deltaTime)
 	// Send the event to every StelModule
 	foreach (StelModule* i, moduleMgr->getCallOrders(StelModule::ActionUpdate))
 	{
+		StelProfileScope moduleScope(StelProfiler::isEnabled() ? StelProfiler::internName(i->objectName()+"::update") : NULL);
 		i->update(deltaTime);
 	}
 
@@ -549,14 +571,54 @@ void StelApp::draw()
 {
 	if (!initialized)
 		return;
+	STEL_PROFILE_SCOPE("StelApp::draw");
+	textureMgr->beginFrame();
+	pendingLoads = false;
 	core->preDraw();
 
 	const QList<StelModule*> modules = moduleMgr->getCallOrders(StelModule::ActionDraw);
 	foreach(StelModule* module, modules)
 	{
+		StelProfileScope moduleScope(StelProfiler::isEnabled() ? StelProfiler::internName(module->objectName()+"::draw") : NULL);
 		module->draw(core);
 	}
 	core->postDraw();
+
+	// The background updates of the modules which were not drawn, e.g. hidden, still have to be finished
+	foreach (StelModule* module, moduleMgr->getAllModules())
+		module->finishUpdate();
+
+	nextFrameDelay = computeNextFrameDelay();
+}
+
+// Interval between the frames while some textures or sky images are still loading
+static const double PendingLoadRedrawDelay = 0.1;
+
+double StelApp::computeNextFrameDelay()
+{
+	// The view is compared at each frame so that the next comparison is with this frame
+	bool changed = core->updateLastFrameView();
+	changed = StelFader::takeChanges() || changed;
+	changed = redrawRequest.fetchAndStoreOrdered(0)!=0 || changed;
+	if (changed)
+		return 0.;
+
+	double delay = core->getSkyDriftDelay();
+	foreach (StelModule* module, moduleMgr->getAllModules())
+	{
+		const double moduleDelay = module->getRedrawDelay();
+		if (moduleDelay>=0. && (delay<0. || moduleDelay<delay))
+			delay = moduleDelay;
+	}
+	if (pendingLoads && (delay<0. || delay>PendingLoadRedrawDelay))
+		delay = PendingLoadRedrawDelay;
+	return delay;
+}
+
+void StelApp::requestRedraw()
+{
+	redrawRequest.storeRelease(1);
+	emit(redrawRequested());
 }
 
 /*************************************************************************
@@ -22,6 +22,7 @@
 
 #include <QString>
 #include <QObject>
+#include <QAtomicInt>
 #include "config.h"
 
 // Predeclaration of some classes
@@ -34,6 +35,7 @@ class StelSkyCultureMgr;
 class QSettings;
 class QNetworkAccessManager;
 class QNetworkReply;
+class QThreadPool;
 class QTime;
 class QTimer;
 class StelLocationMgr;
@@ -133,6 +135,11 @@ public:
 	//! Get the common instance of QNetworkAccessManager used in stellarium
 	QNetworkAccessManager* getNetworkAccessManager() {return networkAccessManager;}
 
+	//! Get the threads shared by all the background loads, e.g. the decoding of the textures
+	//! and the parsing of the sky image descriptions.
+	//! The number of threads is bounded and the loads are started by priority.
+	QThreadPool* getLoaderPool() {return loaderPool;}
+
 	//! Update translations, font for GUI and sky everywhere in the program.
 	void updateI18n();
 
@@ -152,6 +159,16 @@ public:
 	//! @return the max squared distance in pixels that any object has travelled since the last update.
 	void draw();
 
+	//! Get the delay before the next frame, computed after drawing each frame from what changed in the sky.
+	//! @return 0 if the next frame is needed as soon as possible, e.g. during a movement or a transition,
+	//! a positive delay in seconds if only slow changes are pending, e.g. the rotation of the sky at the normal
+	//! time rate, or a negative value if nothing changes until an event or a call to requestRedraw().
+	double getNextFrameDelay() const {return nextFrameDelay;}
+
+	//! Report that something drawn during the current frame is still loading, e.g. a texture,
+	//! so that another frame is drawn soon to show it.
+	void reportPendingLoad() {pendingLoads = true;}
+
 	//! Call this when the size of the GL window has changed.
 	void glWindowHasBeenResized(float x, float y, float w, float h);
 
@@ -207,6 +224,10 @@ public slots:
 	//! Report that a download occured. This is used for statistics purposes.
 	//! Connect this slot to QNetworkAccessManager::finished() slot to obtain statistics at the end of the program.
 	void reportFileDownloadFinished(QNetworkReply* reply);
+
+	//! Request a new frame as soon as possible, e.g. after a change made outside of the update of the modules.
+	//! Can be called from any thread.
+	void requestRedraw();
 	
 signals:
 	void visionNightModeChanged(bool);
@@ -214,6 +235,9 @@ signals:
 	void languageChanged();
 	void skyCultureChanged(const QString&);
 
+	//! Emitted by requestRedraw(), so that the view draws a new frame.
+	void redrawRequested();
+
 	//! Called just after a progress bar is added.
 	void progressBarAdded(const StelProgressController*);
 	//! Called just before a progress bar is removed.
@@ -234,6 +258,9 @@ private:
 
 	void initScriptMgr(QSettings* conf);
 
+	//! Compute the delay before the next frame from what changed during the last one.
+	double computeNextFrameDelay();
+
 	// The StelApp singleton
 	static StelApp* singleton;
 
@@ -264,6 +291,9 @@ private:
 	// Main network manager used for the program
 	QNetworkAccessManager* networkAccessManager;
 
+	// The threads of the background loads
+	QThreadPool* loaderPool;
+
 	//! Get proxy settings from config file... if not set use http_proxy env var
 	void setupHttpProxy();
 
@@ -301,6 +331,13 @@ private:
 	int frame;
 	double timefr, timeBase;		// Used for fps counter
 
+	//! Delay before the next frame, see getNextFrameDelay().
+	double nextFrameDelay;
+	//! Set by requestRedraw(), reset after each frame.
+	QAtomicInt redrawRequest;
+	//! Whether something drawn during the current frame is still loading.
+	bool pendingLoads;
+
 	//! Define whether we are in night vision mode
 	bool flagNightVision;
 	
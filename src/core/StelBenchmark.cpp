@@ -0,0 +1,585 @@
+/*
+ * Stellarium
+ * Copyright (C) 2015 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelBenchmark.hpp"
+#include "StelApp.hpp"
+#include "StelCore.hpp"
+#include "StelDeltaTTable.hpp"
+#include "StelFileMgr.hpp"
+#include "StelIniParser.hpp"
+#include "StelModuleMgr.hpp"
+#include "StelMovementMgr.hpp"
+#include "StelObjectMgr.hpp"
+#include "StelPainter.hpp"
+#include "StelProfiler.hpp"
+#include "StelSkyCultureMgr.hpp"
+#include "StelSkyDrawer.hpp"
+#include "StelUtils.hpp"
+#include "Comet.hpp"
+#include "ConstellationMgr.hpp"
+#include "MeteorMgr.hpp"
+#include "Satellites.hpp"
+#include "SolarSystem.hpp"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QJsonDocument>
+#include <QMetaEnum>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+#include <QSettings>
+#include <QTemporaryFile>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace
+{
+// Size of the framebuffer, a landscape phone screen
+const int FRAME_WIDTH = 1280;
+const int FRAME_HEIGHT = 720;
+// 2015-01-01 22:00 UTC, night in Paris
+const double START_JD = 2457024.416667;
+// Frames drawn before the measure, to fill the caches and load the textures
+const int WARMUP_FRAMES = 10;
+// Maximum number of frames drawn to wait for the textures of the last frame
+const int MAX_SETTLE_FRAMES = 100;
+// Number of calls of each Delta-T measure
+const int DELTAT_LOOKUPS = 200000;
+// The Delta-T accuracy is checked from the year -2500 to +3500, beyond the table on both sides,
+// at dates which are not aligned with its intervals
+const double DELTAT_FIRST_JD = 2451545.0 - 4500*365.25;
+const int DELTAT_SAMPLES = 60000;
+const double DELTAT_SAMPLE_STEP = 36.5173;
+// The comet time-lapse is meaningless without the comet catalogue of data/ssystem_1000comets.ini
+const int MIN_COMETS = 1000;
+
+// Nearest rank percentile of sorted values in milliseconds
+double percentile(const QVector<qint64>& sorted, double p)
+{
+	int rank = (int)std::ceil(p/100.*sorted.size()) - 1;
+	rank = qBound(0, rank, sorted.size()-1);
+	return sorted.at(rank)*1e-6;
+}
+
+// Resident memory in kB, or -1 if it is unknown on this system
+qint64 getResidentMemory()
+{
+#ifdef Q_OS_LINUX
+	QFile file("/proc/self/statm");
+	if (!file.open(QIODevice::ReadOnly))
+		return -1;
+	const QList<QByteArray> fields = file.readAll().split(' ');
+	if (fields.size()<2)
+		return -1;
+	return fields.at(1).toLongLong()*sysconf(_SC_PAGESIZE)/1024;
+#else
+	return -1;
+#endif
+}
+
+// Peak resident memory of the process in kB, or -1 if it is unknown on this system
+qint64 getPeakResidentMemory()
+{
+#ifdef Q_OS_LINUX
+	QFile file("/proc/self/status");
+	if (!file.open(QIODevice::ReadOnly))
+		return -1;
+	foreach (const QByteArray& line, file.readAll().split('\n'))
+	{
+		if (line.startsWith("VmHWM:"))
+			return line.mid(6).trimmed().split(' ').first().toLongLong();
+	}
+#endif
+	return -1;
+}
+
+int countComets(const SolarSystem* ssystem)
+{
+	int count = 0;
+	foreach (const PlanetP& p, ssystem->getAllPlanets())
+	{
+		if (dynamic_cast<const Comet*>(p.data()))
+			++count;
+	}
+	return count;
+}
+}
+
+QStringList StelBenchmark::getScenarioNames()
+{
+	// In the order of the Scenario enum
+	return QStringList() << "deepsky-zoom" << "timelapse-comets" << "satellites" << "skycultures" << "deltat";
+}
+
+int StelBenchmark::exec()
+{
+	const QStringList names = getScenarioNames();
+	QStringList requested = qApp->property("onetime_benchmark").toString().split(',', QString::SkipEmptyParts);
+	if (requested.contains("all"))
+		requested = names;
+	foreach (const QString& name, requested)
+	{
+		if (!names.contains(name))
+		{
+			qWarning() << "StelBenchmark: unknown scenario" << name << "- the scenarios are:" << names.join(", ");
+			return 1;
+		}
+	}
+	const int frames = qMax(1, qApp->property("onetime_benchmark_frames").toInt());
+	const QString outputFile = qApp->property("onetime_benchmark_output").toString();
+	const QString baselineFile = qApp->property("onetime_benchmark_baseline").toString();
+	const double tolerance = qApp->property("onetime_benchmark_tolerance").toDouble();
+
+	// Always start from the default settings so that the results don't depend on the user
+	// configuration, and use a temporary copy so that the user config.ini is left untouched.
+	const QString defaultConfigFile = StelFileMgr::findFile("data/default_config.ini");
+	QFile defaultConfig(defaultConfigFile);
+	QTemporaryFile configFile(QDir::tempPath() + "/stellarium-benchmark-XXXXXX.ini");
+	if (defaultConfigFile.isEmpty() || !defaultConfig.open(QIODevice::ReadOnly) || !configFile.open())
+	{
+		qWarning() << "StelBenchmark: cannot create the configuration from data/default_config.ini";
+		return 1;
+	}
+	configFile.write(defaultConfig.readAll());
+	configFile.close();
+	QSettings conf(configFile.fileName(), StelIniFormat);
+	conf.setValue("init_location/location", "Paris, France");
+	conf.setValue("navigation/startup_time_mode", "preset");
+	conf.setValue("navigation/preset_sky_time", START_JD);
+	conf.setValue("Satellites/updates_enabled", false);
+
+	QOffscreenSurface surface;
+	surface.create();
+	QOpenGLContext context;
+	context.setFormat(surface.format());
+	if (!context.create() || !context.makeCurrent(&surface))
+	{
+		qWarning() << "StelBenchmark: cannot create an offscreen openGL context";
+		return 1;
+	}
+	const QString renderer = QString::fromLatin1((const char*)glGetString(GL_RENDERER));
+	qDebug() << "StelBenchmark: rendering with" << renderer;
+
+	StelProfiler::setEnabled(true);
+	QVariantMap scenarios;
+	QStringList failures;
+	{
+		StelBenchmark benchmark(&conf, FRAME_WIDTH, FRAME_HEIGHT, frames);
+		for (int i=0;i<names.size();++i)
+		{
+			if (!requested.contains(names.at(i)))
+				continue;
+			qDebug() << "StelBenchmark: running" << names.at(i);
+			const QVariantMap result = benchmark.run((Scenario)i);
+			scenarios[names.at(i)] = result;
+			foreach (const QVariant& failure, result["failures"].toList())
+				failures << QString("%1: %2").arg(names.at(i)).arg(failure.toString());
+			if (i==DeltaT)
+			{
+				qDebug() << qPrintable(QString("StelBenchmark: %1 lookup %2 ns, direct evaluation %3 ns, repeated date %4 ns")
+					.arg(names.at(i)).arg(result["lookupNs"].toDouble(), 0, 'f', 1).arg(result["directNs"].toDouble(), 0, 'f', 1)
+					.arg(result["memoNs"].toDouble(), 0, 'f', 1));
+				continue;
+			}
+			const QVariantMap frameTime = result["frameTime"].toMap();
+			qDebug() << qPrintable(QString("StelBenchmark: %1 frame time p50 %2 ms, p90 %3 ms, p99 %4 ms, image %5")
+				.arg(names.at(i)).arg(frameTime["p50"].toDouble(), 0, 'f', 2).arg(frameTime["p90"].toDouble(), 0, 'f', 2)
+				.arg(frameTime["p99"].toDouble(), 0, 'f', 2).arg(result["imageHash"].toString()));
+		}
+	}
+	context.doneCurrent();
+
+	QVariantMap report;
+	report["version"] = StelUtils::getApplicationVersion();
+	report["renderer"] = renderer;
+	report["width"] = FRAME_WIDTH;
+	report["height"] = FRAME_HEIGHT;
+	report["frames"] = frames;
+	report["scenarios"] = scenarios;
+	const QByteArray json = QJsonDocument::fromVariant(report).toJson();
+	if (outputFile.isEmpty())
+		std::cout << json.constData() << std::endl;
+	else
+	{
+		QFile file(outputFile);
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		{
+			qWarning() << "StelBenchmark: cannot write the report" << outputFile;
+			return 1;
+		}
+		file.write(json);
+		qDebug() << "StelBenchmark: wrote the report to" << outputFile;
+	}
+
+	foreach (const QString& failure, failures)
+		qWarning() << "StelBenchmark: failure:" << qPrintable(failure);
+	if (baselineFile.isEmpty())
+		return failures.isEmpty() ? 0 : 1;
+	QFile file(baselineFile);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		qWarning() << "StelBenchmark: cannot read the baseline" << baselineFile;
+		return 1;
+	}
+	const QStringList regressions = compare(report, QJsonDocument::fromJson(file.readAll()).toVariant().toMap(), tolerance);
+	foreach (const QString& regression, regressions)
+		qWarning() << "StelBenchmark: regression:" << qPrintable(regression);
+	if (regressions.isEmpty())
+		qDebug() << "StelBenchmark: no regression compared to" << baselineFile;
+	return regressions.isEmpty() && failures.isEmpty() ? 0 : 1;
+}
+
+StelBenchmark::StelBenchmark(QSettings* conf, int width, int height, int frames)
+	: width(width), height(height), frames(frames), deltaTime(1./60.)
+{
+	QOpenGLFramebufferObjectFormat format;
+	format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+	fbo = new QOpenGLFramebufferObject(width, height, format);
+	fbo->bind();
+
+	// Same initialization as in StelQuickView, with a fixed scaling ratio
+	app = new StelApp();
+	StelApp::initStatic();
+	app->setGlobalScalingRatio(1.f);
+	app->init(conf);
+	StelPainter::initGLShaders();
+	app->glWindowHasBeenResized(0, 0, width, height);
+
+	skyCultures = app->getSkyCultureMgr().getSkyCultureListIDs();
+	skyCultures.sort();
+	defaultSkyCulture = app->getSkyCultureMgr().getCurrentSkyCultureID();
+
+	const StelObjectP m31 = app->getStelObjectMgr().searchByName("M31");
+	if (m31)
+		deepSkyTarget = m31->getJ2000EquatorialPos(app->getCore());
+	else
+		StelUtils::spheToRect(10.6847*M_PI/180., 41.2690*M_PI/180., deepSkyTarget);
+}
+
+StelBenchmark::~StelBenchmark()
+{
+	delete app;
+	app = NULL;
+	StelApp::deinitStatic();
+	StelPainter::deinitGLShaders();
+	delete fbo;
+	fbo = NULL;
+}
+
+QVariantMap StelBenchmark::run(Scenario scenario)
+{
+	if (scenario==DeltaT)
+		return runDeltaT();
+	if (scenario==TimeLapseComets)
+	{
+		// Don't measure anything if the comets of the catalogue are not there
+		const int comets = countComets(GETSTELMODULE(SolarSystem));
+		if (comets<MIN_COMETS)
+		{
+			QVariantMap result;
+			result["comets"] = comets;
+			result["failures"] = QVariantList() << QString("only %1 comets are loaded instead of at least %2, data/ssystem_1000comets.ini is missing or invalid")
+				.arg(comets).arg(MIN_COMETS);
+			return result;
+		}
+	}
+	reset();
+	for (int i=0;i<WARMUP_FRAMES;++i)
+	{
+		setupFrame(scenario, 0);
+		renderFrame();
+	}
+
+	StelProfiler::clear();
+	const qint64 memoryBefore = getResidentMemory();
+	QVector<qint64> frameTimes;
+	frameTimes.reserve(frames);
+	QElapsedTimer timer;
+	for (int i=0;i<frames;++i)
+	{
+		// The changes of the scenario are part of the frame, as when they come from the GUI
+		timer.start();
+		setupFrame(scenario, i);
+		renderFrame();
+		frameTimes.append(timer.nsecsElapsed());
+	}
+	const qint64 memoryAfter = getResidentMemory();
+	const QVariantMap modules = StelProfiler::getStatistics();
+
+	std::sort(frameTimes.begin(), frameTimes.end());
+	qint64 sum = 0;
+	foreach (qint64 t, frameTimes)
+		sum += t;
+	QVariantMap frameTime;
+	frameTime["mean"] = sum*1e-6/frameTimes.size();
+	frameTime["p50"] = percentile(frameTimes, 50.);
+	frameTime["p90"] = percentile(frameTimes, 90.);
+	frameTime["p99"] = percentile(frameTimes, 99.);
+	frameTime["max"] = frameTimes.last()*1e-6;
+
+	// The allocations are seen through the growth of the resident memory
+	QVariantMap memory;
+	memory["residentBefore"] = memoryBefore;
+	memory["residentAfter"] = memoryAfter;
+	memory["residentPeak"] = getPeakResidentMemory();
+
+	QVariantMap result;
+	result["frameTime"] = frameTime;
+	result["modules"] = modules;
+	result["memoryKB"] = memory;
+	result["imageHash"] = settleAndHash();
+	if (scenario==TimeLapseComets)
+		result["comets"] = countComets(GETSTELMODULE(SolarSystem));
+	return result;
+}
+
+QVariantMap StelBenchmark::runDeltaT()
+{
+	StelCore* core = app->getCore();
+	const StelCore::DeltaTAlgorithm defaultAlgorithm = core->getCurrentDeltaTAlgorithm();
+	QVariantMap result;
+
+	// The dates of successive frames, so that the repeated date is not remembered, except for the last measure
+	const double frameStep = 1./(60.*86400.);
+	double sum = 0.;
+	core->getDeltaT(START_JD);
+	QElapsedTimer timer;
+	timer.start();
+	for (int i=0;i<DELTAT_LOOKUPS;++i)
+		sum += core->getDeltaT(START_JD+i*frameStep);
+	result["lookupNs"] = (double)timer.nsecsElapsed()/DELTAT_LOOKUPS;
+	timer.start();
+	for (int i=0;i<DELTAT_LOOKUPS;++i)
+		sum += core->computeDeltaT(START_JD+i*frameStep);
+	result["directNs"] = (double)timer.nsecsElapsed()/DELTAT_LOOKUPS;
+	timer.start();
+	for (int i=0;i<DELTAT_LOOKUPS;++i)
+		sum += core->getDeltaT(START_JD);
+	result["memoNs"] = (double)timer.nsecsElapsed()/DELTAT_LOOKUPS;
+	// Use the results so that the loops are not optimized away
+	volatile double sink = sum;
+	Q_UNUSED(sink);
+
+	const QMetaEnum en = core->metaObject()->enumerator(core->metaObject()->indexOfEnumerator("DeltaTAlgorithm"));
+	QVariantMap algorithms;
+	QVariantList failures;
+	for (int a=0;a<en.keyCount();++a)
+	{
+		core->setCurrentDeltaTAlgorithm((StelCore::DeltaTAlgorithm)en.value(a));
+		double maxError = 0.;
+		double maxErrorJD = DELTAT_FIRST_JD;
+		bool accurate = true;
+		for (int i=0;i<DELTAT_SAMPLES;++i)
+		{
+			const double jd = DELTAT_FIRST_JD + i*DELTAT_SAMPLE_STEP;
+			const double direct = core->computeDeltaT(jd);
+			const double error = std::fabs(core->getDeltaT(jd)-direct);
+			if (error > StelDeltaTTable::Tolerance && accurate)
+			{
+				accurate = false;
+				failures << QString("the table of %1 is off by %2 s at JD %3").arg(en.key(a)).arg(error).arg(jd, 0, 'f', 1);
+			}
+			if (error > maxError)
+			{
+				maxError = error;
+				maxErrorJD = jd;
+			}
+		}
+		QVariantMap algorithm;
+		algorithm["maxError"] = maxError;
+		algorithm["maxErrorJD"] = maxErrorJD;
+		algorithm["accurate"] = accurate;
+		algorithms[en.key(a)] = algorithm;
+	}
+	core->setCurrentDeltaTAlgorithm(defaultAlgorithm);
+
+	result["algorithms"] = algorithms;
+	result["failures"] = failures;
+	return result;
+}
+
+void StelBenchmark::reset()
+{
+	StelCore* core = app->getCore();
+	core->setTimeRate(0.);
+	core->setJDay(START_JD);
+	// Nothing random in the image
+	core->getSkyDrawer()->setFlagTwinkle(false);
+	GETSTELMODULE(MeteorMgr)->setFlagShow(false);
+	srand(1);
+
+	app->getStelObjectMgr().unSelect();
+	StelMovementMgr* mvmgr = core->getMovementMgr();
+	mvmgr->setFlagTracking(false);
+	// South, 45 degrees above the horizon
+	mvmgr->setViewDirectionJ2000(core->altAzToJ2000(Vec3d(1., 0., 1.)));
+	mvmgr->setFov(60.);
+
+	SolarSystem* ssystem = GETSTELMODULE(SolarSystem);
+	ssystem->setFlagOrbits(false);
+	ssystem->setFlagLabels(false);
+	Satellites* satellites = GETSTELMODULE(Satellites);
+	satellites->setFlagDisplayed(false);
+	satellites->setOrbitLinesFlag(false);
+	ConstellationMgr* cmgr = GETSTELMODULE(ConstellationMgr);
+	cmgr->setFlagLines(false);
+	cmgr->setFlagLabels(false);
+	cmgr->setFlagArt(false);
+	cmgr->setFlagBoundaries(false);
+	if (app->getSkyCultureMgr().getCurrentSkyCultureID()!=defaultSkyCulture)
+		app->getSkyCultureMgr().setCurrentSkyCultureID(defaultSkyCulture);
+}
+
+void StelBenchmark::setupFrame(Scenario scenario, int frame)
+{
+	StelCore* core = app->getCore();
+	StelMovementMgr* mvmgr = core->getMovementMgr();
+	const double t = frames>1 ? (double)frame/(frames-1) : 1.;
+	switch (scenario)
+	{
+		case DeepSkyZoom:
+			// From 60 degrees to half a degree at a constant zoom rate
+			mvmgr->setViewDirectionJ2000(deepSkyTarget);
+			mvmgr->setFov(60.*std::pow(0.5/60., t));
+			break;
+		case TimeLapseComets:
+		{
+			SolarSystem* ssystem = GETSTELMODULE(SolarSystem);
+			if (frame==0)
+			{
+				ssystem->setFlagPlanets(true);
+				ssystem->setFlagHints(true);
+				ssystem->setFlagLabels(true);
+				ssystem->setFlagOrbits(true);
+				mvmgr->setFov(120.);
+			}
+			core->setJDay(START_JD + frame*deltaTime*1000.*StelCore::JD_SECOND);
+			break;
+		}
+		case SatelliteCatalog:
+		{
+			Satellites* satellites = GETSTELMODULE(Satellites);
+			if (frame==0)
+			{
+				satellites->displayAllSatellites();
+				satellites->setFlagDisplayed(true);
+				satellites->setFlagHintsVisible(true);
+				satellites->setFlagLabels(true);
+				satellites->setOrbitLinesFlag(true);
+				mvmgr->setFov(120.);
+			}
+			core->setJDay(START_JD + frame*deltaTime*StelCore::JD_SECOND);
+			break;
+		}
+		case SkyCultures:
+		{
+			if (frame==0)
+			{
+				ConstellationMgr* cmgr = GETSTELMODULE(ConstellationMgr);
+				cmgr->setFlagLines(true);
+				cmgr->setFlagLabels(true);
+				cmgr->setFlagArt(true);
+				cmgr->setFlagBoundaries(true);
+				mvmgr->setFov(120.);
+			}
+			// The same number of frames for each culture
+			if (skyCultures.isEmpty())
+				break;
+			const QString& id = skyCultures.at(frame*skyCultures.size()/frames);
+			if (app->getSkyCultureMgr().getCurrentSkyCultureID()!=id)
+				app->getSkyCultureMgr().setCurrentSkyCultureID(id);
+			break;
+		}
+	}
+}
+
+void StelBenchmark::renderFrame()
+{
+	QCoreApplication::processEvents();
+	app->update(deltaTime);
+	fbo->bind();
+	app->draw();
+	glFinish();
+}
+
+QString StelBenchmark::settleAndHash()
+{
+	QByteArray previous;
+	for (int i=0;i<MAX_SETTLE_FRAMES;++i)
+	{
+		QThreadPool::globalInstance()->waitForDone();
+		app->getLoaderPool()->waitForDone();
+		renderFrame();
+		const QImage image = fbo->toImage();
+		const QByteArray hash = QCryptographicHash::hash(QByteArray::fromRawData((const char*)image.constBits(), image.byteCount()), QCryptographicHash::Md5).toHex();
+		if (hash==previous)
+			return QString::fromLatin1(hash);
+		previous = hash;
+	}
+	qWarning() << "StelBenchmark: the image is still changing after" << MAX_SETTLE_FRAMES << "frames";
+	return QString::fromLatin1(previous);
+}
+
+QStringList StelBenchmark::compare(const QVariantMap& report, const QVariantMap& baseline, double tolerance)
+{
+	QStringList regressions;
+	// The images only have to be identical with the same openGL implementation
+	const bool sameRenderer = report["renderer"]==baseline["renderer"];
+	const QVariantMap scenarios = report["scenarios"].toMap();
+	const QVariantMap baselineScenarios = baseline["scenarios"].toMap();
+	for (QVariantMap::const_iterator it=scenarios.constBegin();it!=scenarios.constEnd();++it)
+	{
+		if (!baselineScenarios.contains(it.key()))
+			continue;
+		const QVariantMap result = it.value().toMap();
+		const QVariantMap baselineResult = baselineScenarios[it.key()].toMap();
+		const double p50 = result["frameTime"].toMap()["p50"].toDouble();
+		const double baselineP50 = baselineResult["frameTime"].toMap()["p50"].toDouble();
+		if (p50 > baselineP50*(1.+tolerance/100.))
+		{
+			regressions << QString("%1: median frame time %2 ms instead of %3 ms")
+				.arg(it.key()).arg(p50, 0, 'f', 2).arg(baselineP50, 0, 'f', 2);
+		}
+		if (sameRenderer && result["imageHash"]!=baselineResult["imageHash"])
+			regressions << QString("%1: the image changed").arg(it.key());
+		const double lookup = result["lookupNs"].toDouble();
+		const double baselineLookup = baselineResult["lookupNs"].toDouble();
+		if (lookup > baselineLookup*(1.+tolerance/100.))
+		{
+			regressions << QString("%1: Delta-T lookup %2 ns instead of %3 ns")
+				.arg(it.key()).arg(lookup, 0, 'f', 1).arg(baselineLookup, 0, 'f', 1);
+		}
+	}
+	return regressions;
+}
@@ -0,0 +1,109 @@
+/*
+ * Stellarium
+ * Copyright (C) 2015 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STELBENCHMARK_HPP_
+#define _STELBENCHMARK_HPP_
+
+#include "VecMath.hpp"
+
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+class QOpenGLFramebufferObject;
+class QSettings;
+class StelApp;
+
+//! @class StelBenchmark
+//! Headless benchmark of the whole frame pipeline, started with the --benchmark command line option.
+//! StelApp is run without any view in an offscreen openGL context (QT_QPA_PLATFORM=offscreen with
+//! the Mesa software renderer is fine) and draws into a framebuffer object.
+//! Each scenario replays a fixed camera and time trajectory with a fixed time step, starting from
+//! the default configuration, so that two runs draw exactly the same frames.
+//! For each scenario the report gives the frame times, the time spent in the modules as measured
+//! by StelProfiler, the growth of the resident memory and a hash of the last frame.
+//! When a baseline report is given, the run fails if a scenario got slower than the tolerance
+//! or if its image changed, so that it can be used as a regression gate between releases.
+//! The timelapse-comets scenario runs on the catalogue of data/ssystem_1000comets.ini, and fails without
+//! measuring anything if it is not loaded.
+//! The deltat scenario doesn't draw anything: it compares the time of the Delta-T lookups with the direct
+//! evaluation of the algorithm, and fails if the table of any algorithm is not accurate.
+class StelBenchmark
+{
+public:
+	//! The names of the available scenarios, in the order they are run.
+	static QStringList getScenarioNames();
+
+	//! Boot StelApp in an offscreen context, run the scenarios and write the report.
+	//! The options are read from the application properties set by CLIProcessor.
+	//! @return the exit code of the program: 0 on success, 1 if a scenario regressed or failed.
+	static int exec();
+
+private:
+	enum Scenario
+	{
+		DeepSkyZoom,
+		TimeLapseComets,
+		SatelliteCatalog,
+		SkyCultures,
+		DeltaT
+	};
+
+	//! Create the framebuffer and initialize StelApp with the given settings.
+	//! An openGL context must be current.
+	StelBenchmark(QSettings* conf, int width, int height, int frames);
+	~StelBenchmark();
+
+	//! Run one scenario and return its report.
+	QVariantMap run(Scenario scenario);
+
+	//! Measure the Delta-T lookups and check the table of every algorithm against its direct evaluation.
+	//! The report lists the algorithms whose table is not accurate in "failures".
+	QVariantMap runDeltaT();
+
+	//! Put the view, time and display flags in the state common to all the scenarios.
+	void reset();
+
+	//! Move the camera and time, and change the displayed objects for a frame of a scenario.
+	void setupFrame(Scenario scenario, int frame);
+
+	//! Update and draw one frame into the framebuffer and wait for the GPU.
+	void renderFrame();
+
+	//! Draw the last state of the scenario until the asynchronously loaded textures are all shown,
+	//! and return the hash of the image.
+	QString settleAndHash();
+
+	//! Compare a report with a baseline report.
+	//! @return the list of the regressions, empty if there is none.
+	static QStringList compare(const QVariantMap& report, const QVariantMap& baseline, double tolerance);
+
+	int width, height;
+	int frames;
+	//! Time step of each frame in seconds.
+	double deltaTime;
+	StelApp* app;
+	QOpenGLFramebufferObject* fbo;
+	//! Direction of the deep-sky zoom.
+	Vec3d deepSkyTarget;
+	QStringList skyCultures;
+	QString defaultSkyCulture;
+};
+
+#endif // _STELBENCHMARK_HPP_
@@ -37,11 +37,13 @@
 #include "LandscapeMgr.hpp"
 #include "StelTranslator.hpp"
 #include "StelActionMgr.hpp"
+#include "StelDeltaTTable.hpp"
 
 #include <qopengl.h>
 #include <QSettings>
 #include <QDebug>
 #include <QMetaEnum>
+#include <QThread>
 
 // Init statics transfo matrices
 // See vsop87.doc:
@@ -56,7 +58,17 @@ const double StelCore::JD_HOUR  =0.041666666666666666666;
 const double StelCore::JD_DAY   =1.;
 
 
-StelCore::StelCore() : movementMgr(NULL), geodesicGrid(NULL), currentProjectionType(ProjectionStereographic), position(NULL), timeSpeed(JD_SECOND), JDay(0.)
+namespace
+{
+	// The model tabulated by the Delta-T table
+	double evaluateDeltaT(double jDay, const void* core)
+	{
+		return static_cast<const StelCore*>(core)->computeDeltaT(jDay);
+	}
+}
+
+StelCore::StelCore() : movementMgr(NULL), geodesicGrid(NULL), currentProjectionType(ProjectionStereographic), lastFrameValid(false),
+	lastFrameProjectionType(ProjectionStereographic), position(NULL), timeSpeed(JD_SECOND), JDay(0.)
 {
 	toneConverter = new StelToneReproducer();
 
@@ -80,11 +92,18 @@ StelCore::StelCore() : movementMgr(NULL), geodesicGrid(NULL), currentProjectionT
 	currentProjectorParams.gravityLabels = conf->value("viewing/flag_gravity_labels").toBool();
 	
 	currentProjectorParams.devicePixelsPerPixel = StelApp::getInstance().getDevicePixelsPerPixel();
+
+	deltaTTable = new StelDeltaTTable(&evaluateDeltaT, this);
+	deltaTTableGeneration = deltaTGeneration.load();
+	deltaTMemoValid = false;
+	deltaTMemoJD = 0.;
+	deltaTMemo = 0.;
 }
 
 
 StelCore::~StelCore()
 {
+	delete deltaTTable; deltaTTable=NULL;
 	delete toneConverter; toneConverter=NULL;
 	delete geodesicGrid; geodesicGrid=NULL;
 	delete skyDrawer; skyDrawer=NULL;
@@ -405,6 +424,53 @@ void StelCore::postDraw()
 	sPainter.drawViewportShape();
 }
 
+// Largest difference between the rotation coefficients of two matrices, close to the angle between them in radians
+static double rotationDifference(const Mat4d& m1, const Mat4d& m2)
+{
+	double d = 0.;
+	for (int i=0; i<3; ++i)
+		for (int j=0; j<3; ++j)
+			d = qMax(d, fabs(m1[i*4+j]-m2[i*4+j]));
+	return d;
+}
+
+bool StelCore::updateLastFrameView()
+{
+	const StelProjector::StelProjectorParams& p = currentProjectorParams;
+	const StelProjector::StelProjectorParams& last = lastFrameProjectorParams;
+	const double diameter = qMax(1.f, p.viewportFovDiameter);
+	const double pixel = p.fov*M_PI/180./diameter;
+	const bool changed = !lastFrameValid
+		|| currentProjectionType!=lastFrameProjectionType
+		|| p.viewportXywh!=last.viewportXywh
+		|| p.viewportCenter!=last.viewportCenter
+		|| p.viewportFovDiameter!=last.viewportFovDiameter
+		|| p.flipHorz!=last.flipHorz
+		|| p.flipVert!=last.flipVert
+		|| p.maskType!=last.maskType
+		|| p.gravityLabels!=last.gravityLabels
+		|| p.devicePixelsPerPixel!=last.devicePixelsPerPixel
+		|| fabs(p.fov-last.fov)*diameter>p.fov
+		|| rotationDifference(matAltAzModelView, lastFrameAltAzModelView)>pixel
+		|| rotationDifference(matJ2000ToAltAz, lastFrameJ2000ToAltAz)>pixel;
+
+	lastFrameValid = true;
+	lastFrameAltAzModelView = matAltAzModelView;
+	lastFrameJ2000ToAltAz = matJ2000ToAltAz;
+	lastFrameProjectorParams = currentProjectorParams;
+	lastFrameProjectionType = currentProjectionType;
+	return changed;
+}
+
+double StelCore::getSkyDriftDelay() const
+{
+	if (timeSpeed==0.)
+		return -1.;
+	// The sky turns by 360.9856 degrees per day
+	const double halfPixel = 0.5*currentProjectorParams.fov/qMax(1.f, currentProjectorParams.viewportFovDiameter);
+	return halfPixel/(fabs(timeSpeed)*360.9856);
+}
+
 void StelCore::setCurrentProjectionType(ProjectionType type)
 {
 	currentProjectionType=type;
@@ -1255,6 +1321,26 @@ void StelCore::setStartupTimeMode(const QString& s)
 }
 
 double StelCore::getDeltaT(double jDay) const
+{
+	// The other threads, e.g. the GUI, evaluate the algorithm directly so that the table is never shared
+	if (QThread::currentThread()!=thread())
+		return computeDeltaT(jDay);
+	const int generation = deltaTGeneration.loadAcquire();
+	if (generation!=deltaTTableGeneration)
+	{
+		deltaTTable->clear();
+		deltaTMemoValid = false;
+		deltaTTableGeneration = generation;
+	}
+	if (deltaTMemoValid && jDay==deltaTMemoJD)
+		return deltaTMemo;
+	deltaTMemo = deltaTTable->value(jDay);
+	deltaTMemoJD = jDay;
+	deltaTMemoValid = true;
+	return deltaTMemo;
+}
+
+double StelCore::computeDeltaT(double jDay) const
 {
 	double DeltaT = 0.;
 	double ndot = 0.;
@@ -28,6 +28,7 @@
 #include <QString>
 #include <QStringList>
 #include <QTime>
+#include <QAtomicInt>
 
 class StelToneReproducer;
 class StelSkyDrawer;
@@ -144,6 +145,16 @@ public:
 	//! Update core state after drawing modules.
 	void postDraw();
 
+	//! Compare the view with the one of the previous frame, and remember it for the next frame.
+	//! Called by StelApp after drawing each frame.
+	//! @return true if the sky moved by more than one pixel since the previous frame, because the view direction,
+	//! the field of view, the projection, the location or the date changed.
+	bool updateLastFrameView();
+
+	//! Get the delay after which the time rate turns the sky by half a pixel.
+	//! @return the delay in seconds, or a negative value if the time is stopped.
+	double getSkyDriftDelay() const;
+
 	//! Get a new instance of a simple 2d projection. This projection cannot be used to project or unproject but
 	//! only for 2d painting
 	StelProjectorP getProjection2d() const;
@@ -280,8 +291,13 @@ public:
 	//! @param jDay the date and time expressed as a julian day
 	//! @return Delta-T in seconds
 	//! @note Thanks to Rob van Gent which create a collection from many formulas for calculation of Delta-T: http://www.staff.science.uu.nl/~gent0113/deltat/deltat.htm
+	//! @note In the thread of the core, the value comes from a table of the current algorithm, built when
+	//! it is first needed, and the last value is remembered for the repeated calls with the same date.
 	double getDeltaT(double jDay) const;
 
+	//! Evaluate the current algorithm for Delta-T, without the table used by getDeltaT().
+	double computeDeltaT(double jDay) const;
+
 	//! Get info about valid range for current algorithm for calculation of Delta-T
 	//! @param jDay the JD
 	//! @param marker the marker for valid range
@@ -302,7 +318,7 @@ public slots:
 	QStringList getAllProjectionTypeKeys() const;
 
 	//! Set the current algorithm for time correction (DeltaT)
-	void setCurrentDeltaTAlgorithm(DeltaTAlgorithm algorithm) { currentDeltaTAlgorithm=algorithm; }
+	void setCurrentDeltaTAlgorithm(DeltaTAlgorithm algorithm) { currentDeltaTAlgorithm=algorithm; invalidateDeltaT(); }
 	//! Get the current algorithm for time correction (DeltaT)
 	DeltaTAlgorithm getCurrentDeltaTAlgorithm() const { return currentDeltaTAlgorithm; }
 	//! Get description of the current algorithm for time correction
@@ -496,13 +512,13 @@ public slots:
 
 	//! Set year for custom equation for calculation of Delta-T
 	//! @param y the year, e.g. 1820
-	void setDeltaTCustomYear(float y) { deltaTCustomYear=y; }
+	void setDeltaTCustomYear(float y) { deltaTCustomYear=y; invalidateDeltaT(); }
 	//! Set n-dot for custom equation for calculation of Delta-T
 	//! @param y the n-dot value, e.g. -26.0
-	void setDeltaTCustomNDot(float v) { deltaTCustomNDot=v; }
+	void setDeltaTCustomNDot(float v) { deltaTCustomNDot=v; invalidateDeltaT(); }
 	//! Set coefficients for custom equation for calculation of Delta-T
 	//! @param y the coefficients, e.g. -20,0,32
-	void setDeltaTCustomEquationCoefficients(Vec3f c) { deltaTCustomEquationCoeff=c; }
+	void setDeltaTCustomEquationCoefficients(Vec3f c) { deltaTCustomEquationCoeff=c; invalidateDeltaT(); }
 
 	//! Get year for custom equation for calculation of Delta-T
 	float getDeltaTCustomYear() const { return deltaTCustomYear; }
@@ -550,6 +566,13 @@ private:
 	Mat4d matAltAzModelView;           // Modelview matrix for observer-centric altazimuthal drawing
 	Mat4d invertMatAltAzModelView;     // Inverted modelview matrix for observer-centric altazimuthal drawing
 
+	// View of the previous frame, to know whether the sky changed since
+	bool lastFrameValid;
+	Mat4d lastFrameAltAzModelView;
+	Mat4d lastFrameJ2000ToAltAz;
+	StelProjector::StelProjectorParams lastFrameProjectorParams;
+	ProjectionType lastFrameProjectionType;
+
 	// Position variables
 	StelObserver* position;
 	// The ID of the default startup location
@@ -567,6 +590,19 @@ private:
 	float deltaTCustomNDot;
 	float deltaTCustomYear;
 
+	//! Request the rebuild of the Delta-T table, from any thread.
+	void invalidateDeltaT() { deltaTGeneration.ref(); }
+	//! Table of the current algorithm for Delta-T, only used in the thread of the core.
+	class StelDeltaTTable* deltaTTable;
+	//! Incremented when the algorithm or its parameters change.
+	QAtomicInt deltaTGeneration;
+	//! Value of deltaTGeneration when the table was last cleared.
+	mutable int deltaTTableGeneration;
+	//! The last value returned by getDeltaT() in the thread of the core.
+	mutable bool deltaTMemoValid;
+	mutable double deltaTMemoJD;
+	mutable double deltaTMemo;
+
 };
 
 #endif // _STELCORE_HPP_
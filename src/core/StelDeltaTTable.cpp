@@ -0,0 +1,111 @@
+/*
+ * Stellarium
+ * Copyright (C) 2015 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelDeltaTTable.hpp"
+
+#include <cmath>
+
+namespace
+{
+	// The table covers the years -2000 to +3000, one interval per Julian year
+	const double FirstJD = 2451545.0 - 4000*365.25;
+	const double IntervalDays = 365.25;
+	const int IntervalCount = 5000;
+	// Number of points where the polynomial of an interval is checked against the model, 4 per month.
+	// The models which compute the year from the month of the date are step functions: between two
+	// check points they can move away from the polynomial by a fraction of a step, hence the margin.
+	const int CheckPoints = 48;
+	const double CheckTolerance = 0.5;
+}
+
+const double StelDeltaTTable::Tolerance = 0.1;
+
+StelDeltaTTable::StelDeltaTTable(Model amodel, const void* adata) : model(amodel), data(adata), builtCount(0), directCount(0)
+{
+}
+
+void StelDeltaTTable::clear()
+{
+	// The memory is kept for the next model
+	states.fill(Unbuilt);
+	builtCount = 0;
+	directCount = 0;
+}
+
+double StelDeltaTTable::value(double jDay)
+{
+	const double x = (jDay-FirstJD)/IntervalDays;
+	if (!(x>=0. && x<IntervalCount))
+		return evaluate(jDay);
+	if (states.isEmpty())
+	{
+		states.fill(Unbuilt, IntervalCount);
+		coefficients.resize(IntervalCount*4);
+	}
+	const int interval = (int)x;
+	if (states.at(interval)==Unbuilt)
+		build(interval);
+	if (states.at(interval)==Direct)
+		return evaluate(jDay);
+	const double t = 2.*(x-interval)-1.;
+	const double* c = coefficients.constData()+interval*4;
+	return ((c[3]*t+c[2])*t+c[1])*t+c[0];
+}
+
+void StelDeltaTTable::build(int interval)
+{
+	const double start = FirstJD+interval*IntervalDays;
+	const double halfLength = IntervalDays/2.;
+	const double middle = start+halfLength;
+
+	// Chebyshev interpolation at the 4 nodes, then conversion to the powers of t
+	double f[4];
+	double nodes[4];
+	for (int k=0;k<4;++k)
+	{
+		nodes[k] = std::cos((2*k+1)*M_PI/8.);
+		f[k] = evaluate(middle+nodes[k]*halfLength);
+	}
+	double cheb[4];
+	for (int j=0;j<4;++j)
+	{
+		double sum = 0.;
+		for (int k=0;k<4;++k)
+			sum += f[k]*std::cos(j*(2*k+1)*M_PI/8.);
+		cheb[j] = sum/2.;
+	}
+	cheb[0] /= 2.;
+	double* c = coefficients.data()+interval*4;
+	c[0] = cheb[0]-cheb[2];
+	c[1] = cheb[1]-3.*cheb[3];
+	c[2] = 2.*cheb[2];
+	c[3] = 4.*cheb[3];
+
+	bool matches = true;
+	for (int i=0;i<CheckPoints && matches;++i)
+	{
+		const double t = -1.+(2.*i+1.)/CheckPoints;
+		const double polynomial = ((c[3]*t+c[2])*t+c[1])*t+c[0];
+		matches = std::fabs(polynomial-evaluate(middle+t*halfLength)) <= CheckTolerance*Tolerance;
+	}
+	states[interval] = matches ? Polynomial : Direct;
+	++builtCount;
+	if (!matches)
+		++directCount;
+}
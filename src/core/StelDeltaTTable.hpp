@@ -0,0 +1,80 @@
+/*
+ * Stellarium
+ * Copyright (C) 2015 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STELDELTATTABLE_HPP_
+#define _STELDELTATTABLE_HPP_
+
+#include <QVector>
+
+//! @class StelDeltaTTable
+//! Piecewise cubic table of a Delta-T model, for a constant time lookup instead of the evaluation of the model.
+//! The table covers the years -2000 to +3000 with one cubic polynomial per year, interpolating the model
+//! at 4 Chebyshev nodes. The intervals are built when they are first needed. When the polynomial of an
+//! interval doesn't match the model within Tolerance, e.g. because the model changes of formula with a
+//! discontinuity inside, or its monthly steps are too large as in the ancient times, the interval is
+//! marked so that the model is evaluated directly there.
+//! The dates outside of the table, where the models are plain parabolas, are evaluated directly as well.
+//! The table is not thread safe.
+class StelDeltaTTable
+{
+public:
+	//! A Delta-T model, returning Delta-T in seconds at the given JD.
+	typedef double (*Model)(double jDay, const void* data);
+
+	//! Maximum difference in seconds between value() and the model at any date.
+	static const double Tolerance;
+
+	//! @param model the model to tabulate, called with the given data.
+	StelDeltaTTable(Model model, const void* data);
+
+	//! Forget all the intervals, e.g. when the model or its parameters changed.
+	void clear();
+
+	//! Get Delta-T in seconds at the given JD, from the table or from the model.
+	double value(double jDay);
+
+	//! Evaluate the model directly.
+	double evaluate(double jDay) const {return model(jDay, data);}
+
+	//! Number of intervals built so far, and those of them which use the model directly.
+	int getBuiltCount() const {return builtCount;}
+	int getDirectCount() const {return directCount;}
+
+private:
+	enum IntervalState
+	{
+		Unbuilt,
+		Polynomial,
+		Direct
+	};
+
+	void build(int interval);
+
+	Model model;
+	const void* data;
+	//! The state of each interval, see IntervalState.
+	QVector<quint8> states;
+	//! The 4 coefficients of the polynomial of each interval, in the powers of the position in the interval
+	//! scaled to [-1, 1].
+	QVector<double> coefficients;
+	int builtCount;
+	int directCount;
+};
+
+#endif // _STELDELTATTABLE_HPP_
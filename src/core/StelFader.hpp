@@ -21,6 +21,7 @@
 #define _STELFADER_HPP_
 
 #include <QtGlobal>
+#include <QAtomicInt>
 
 //! @class StelFader
 //! Manages a (usually smooth) transition between two states (typically ON/OFF) in function of a counter
@@ -46,9 +47,19 @@ public:
 	virtual void setMaxValue(float _max) {maxValue = _max;}
 	float getMinValue() {return minValue;}
 	float getMaxValue() {return maxValue;}
+
+	//! Return whether a fader changed or was in transition since the last call, and reset this flag.
+	//! Used by StelApp to know whether the next frame is needed.
+	static bool takeChanges() {return changed.fetchAndStoreOrdered(0)!=0;}
 protected:
+	//! Called by the faders when their value changes.
+	static void setChanged() {changed.storeRelease(1);}
+
 	bool state;
 	float minValue, maxValue;
+
+private:
+	static QAtomicInt changed;
 };
 
 //! @class BooleanFader
@@ -65,7 +76,7 @@ public:
 	float getInterstate() const {return state ? maxValue : minValue;}
 	float getInterstatePercentage() const {return state ? 100.f : 0.f;}
 	// Switchors can be used just as bools
-	StelFader& operator=(bool s) {state=s; return *this;}
+	StelFader& operator=(bool s) {if (state!=s) setChanged(); state=s; return *this;}
 	virtual float getDuration() {return 0.f;}
 protected:
 };
@@ -92,6 +103,7 @@ public:
 	void update(int deltaTicks)
 	{
 		if (!isTransiting) return; // We are not in transition
+		setChanged();
 		counter+=deltaTicks;
 		if (counter>=duration)
 		{
@@ -130,6 +142,7 @@ public:
 			if(state == s) return *this;  // no change
 
 			// set up and begin transit
+			setChanged();
 			state = s;
 			startValue = s ? minValue : maxValue;
 			targetValue = s ? maxValue : minValue;
@@ -175,6 +188,7 @@ public:
 	void update(int deltaTicks)
 	{
 		if (!isTransiting) return; // We are not in transition
+		setChanged();
 		counter+=deltaTicks;
 		if (counter>=duration)
 		{
@@ -216,6 +230,7 @@ public:
 			if(state == s) return *this;  // no change
 
 			// set up and begin transit
+			setChanged();
 			state = s;
 			startValue = s ? minValue : maxValue;
 			targetValue = s ? maxValue : minValue;
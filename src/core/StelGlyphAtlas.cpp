@@ -0,0 +1,207 @@
+/*
+ * Stellarium
+ * Copyright (C) 2015 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelGlyphAtlas.hpp"
+
+#include <QDebug>
+#include <QFont>
+#include <QFontMetrics>
+#include <QGlyphRun>
+#include <QImage>
+#include <QPainter>
+#include <QTextLayout>
+
+#include <cstring>
+
+// Maximum number of glyphs in all the cached layouts
+static const int LAYOUT_CACHE_LIMIT = 100000;
+// Free pixels around each glyph so that linear filtering doesn't pick the neighbours
+static const int GLYPH_MARGIN = 1;
+
+StelGlyphAtlas::StelGlyphAtlas(int size) : textureId(0), size(size), rowX(0), rowY(0), rowHeight(0), layouts(LAYOUT_CACHE_LIMIT)
+{
+	memset(&statistics, 0, sizeof(statistics));
+
+	// The glyphs are white, the color comes from the vertices
+	const QByteArray transparent(size*size*4, 0);
+	glGenTextures(1, &textureId);
+	glBindTexture(GL_TEXTURE_2D, textureId);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, transparent.constData());
+}
+
+StelGlyphAtlas::~StelGlyphAtlas()
+{
+	if (textureId)
+		glDeleteTextures(1, &textureId);
+	textureId = 0;
+}
+
+void StelGlyphAtlas::bind() const
+{
+	glBindTexture(GL_TEXTURE_2D, textureId);
+}
+
+int StelGlyphAtlas::getFontId(const QRawFont& font)
+{
+	const QString key = font.familyName() + '/' + font.styleName() + '/' + QString::number(font.pixelSize())
+			+ '/' + QString::number(font.weight()) + '/' + QString::number(font.style());
+	QHash<QString, int>::const_iterator it = fontIds.constFind(key);
+	if (it!=fontIds.constEnd())
+		return it.value();
+	const int id = fontIds.size();
+	fontIds.insert(key, id);
+	return id;
+}
+
+const StelGlyphAtlas::TextLayout* StelGlyphAtlas::getLayout(const QString& str, const QFont& font)
+{
+	const QByteArray key = str.toUtf8() + '\0' + QByteArray::number(font.pixelSize()) + '/'
+			+ QByteArray::number(font.weight()) + '/' + QByteArray::number(font.style()) + '/' + font.family().toUtf8();
+	TextLayout* layout = layouts.object(key);
+	if (layout)
+	{
+		++statistics.layoutHits;
+		return layout;
+	}
+	++statistics.layoutMisses;
+
+	// Let Qt do the shaping and bidi reordering, only the glyphs are drawn by us
+	QTextLayout textLayout(str, font);
+	textLayout.beginLayout();
+	QTextLine line = textLayout.createLine();
+	textLayout.endLayout();
+
+	layout = new TextLayout;
+	layout->boundingRect = QFontMetrics(font).boundingRect(str);
+	int nbGlyphs = 0;
+	if (line.isValid())
+	{
+		const float ascent = line.ascent();
+		foreach (const QGlyphRun& glyphRun, textLayout.glyphRuns())
+		{
+			Run run;
+			run.font = glyphRun.rawFont();
+			run.fontId = getFontId(run.font);
+			run.glyphIndexes = glyphRun.glyphIndexes();
+			run.positions = glyphRun.positions();
+			for (int i=0;i<run.positions.size();++i)
+				run.positions[i].ry() -= ascent;
+			nbGlyphs += run.glyphIndexes.size();
+			layout->runs.append(run);
+		}
+	}
+	layouts.insert(key, layout, qMax(1, nbGlyphs));
+	return layout;
+}
+
+bool StelGlyphAtlas::getGlyph(const Run& run, int i, Glyph& glyph)
+{
+	const quint32 glyphIndex = run.glyphIndexes.at(i);
+	const quint64 key = ((quint64)run.fontId<<32) | glyphIndex;
+	QHash<quint64, Glyph>::const_iterator it = glyphs.constFind(key);
+	if (it!=glyphs.constEnd())
+	{
+		++statistics.glyphHits;
+		glyph = it.value();
+		return true;
+	}
+
+	const QRect rect = run.font.boundingRect(glyphIndex).toAlignedRect().adjusted(-GLYPH_MARGIN, -GLYPH_MARGIN, GLYPH_MARGIN, GLYPH_MARGIN);
+	if (rect.width()>size || rect.height()>size)
+	{
+		qWarning() << "StelGlyphAtlas: glyph too big for the atlas" << rect.size();
+		glyph.width = 0;
+		glyph.height = 0;
+		return true;
+	}
+
+	// Find room in the current row or in a new one
+	if (rowX+rect.width()>size)
+	{
+		rowX = 0;
+		rowY += rowHeight;
+		rowHeight = 0;
+	}
+	if (rowY+rect.height()>size)
+		return false;
+	++statistics.glyphMisses;
+
+	// Rasterize the glyph alone
+	QImage image(rect.size(), QImage::Format_ARGB32_Premultiplied);
+	image.fill(Qt::transparent);
+	{
+		QGlyphRun glyphRun;
+		glyphRun.setRawFont(run.font);
+		glyphRun.setGlyphIndexes(QVector<quint32>() << glyphIndex);
+		glyphRun.setPositions(QVector<QPointF>() << QPointF(0, 0));
+		QPainter painter(&image);
+		painter.setRenderHints(QPainter::TextAntialiasing);
+		painter.setPen(Qt::white);
+		painter.drawGlyphRun(QPointF(-rect.x(), -rect.y()), glyphRun);
+	}
+
+	// Upload it as white with the coverage in alpha
+	QByteArray data;
+	data.reserve(rect.width()*rect.height()*4);
+	for (int y=0;y<rect.height();++y)
+	{
+		const QRgb* line = (const QRgb*)image.constScanLine(y);
+		for (int x=0;x<rect.width();++x)
+		{
+			const char pixel[4] = {(char)255, (char)255, (char)255, (char)qAlpha(line[x])};
+			data.append(pixel, 4);
+		}
+	}
+	glBindTexture(GL_TEXTURE_2D, textureId);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, rowX, rowY, rect.width(), rect.height(), GL_RGBA, GL_UNSIGNED_BYTE, data.constData());
+
+	glyph.u0 = (float)rowX/size;
+	glyph.v0 = (float)rowY/size;
+	glyph.u1 = (float)(rowX+rect.width())/size;
+	glyph.v1 = (float)(rowY+rect.height())/size;
+	glyph.width = rect.width();
+	glyph.height = rect.height();
+	glyph.left = rect.x();
+	glyph.top = rect.y();
+	glyphs.insert(key, glyph);
+
+	rowX += rect.width();
+	rowHeight = qMax(rowHeight, rect.height());
+	return true;
+}
+
+void StelGlyphAtlas::clear()
+{
+	glyphs.clear();
+	rowX = 0;
+	rowY = 0;
+	rowHeight = 0;
+	++statistics.clears;
+}
+
+StelGlyphAtlas::Statistics StelGlyphAtlas::getStatistics() const
+{
+	Statistics s = statistics;
+	s.glyphCount = glyphs.size();
+	return s;
+}
@@ -0,0 +1,127 @@
+/*
+ * Stellarium
+ * Copyright (C) 2015 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STELGLYPHATLAS_HPP_
+#define _STELGLYPHATLAS_HPP_
+
+#include <QCache>
+#include <QHash>
+#include <QPointF>
+#include <QRawFont>
+#include <QRect>
+#include <QString>
+#include <QVector>
+#include <QOpenGLFunctions>
+
+class QFont;
+
+//! @class StelGlyphAtlas
+//! Cache of rasterized glyphs shared by all the texts drawn by StelPainter.
+//! The glyphs are packed in rows in a single texture, so that any number of strings can be drawn with
+//! one texture and one draw call. The strings are shaped once by QTextLayout and their layout is cached too.
+//! A glyph is identified by its font, pixel size, weight and style, so that changes of font size or scaling ratio
+//! only add new glyphs. The atlas is only cleared when it is full.
+//! Only use it while an openGL context is current.
+class StelGlyphAtlas
+{
+public:
+	//! Position of one rasterized glyph in the atlas.
+	struct Glyph
+	{
+		//! Texture coordinates of the top left and bottom right corners.
+		float u0, v0, u1, v1;
+		//! Size of the glyph image in pixel.
+		int width, height;
+		//! Position of the top left corner of the image relative to the pen position on the baseline (y down).
+		int left, top;
+	};
+
+	//! Glyphs of one font in a shaped string.
+	struct Run
+	{
+		QRawFont font;
+		int fontId;
+		QVector<quint32> glyphIndexes;
+		//! Pen positions relative to the beginning of the baseline (y down).
+		QVector<QPointF> positions;
+	};
+
+	//! A shaped string.
+	struct TextLayout
+	{
+		QVector<Run> runs;
+		//! Bounding rectangle of the string relative to the beginning of the baseline, as QFontMetrics::boundingRect().
+		QRect boundingRect;
+	};
+
+	//! Cache usage since the creation of the atlas.
+	struct Statistics
+	{
+		qint64 layoutHits;
+		qint64 layoutMisses;
+		qint64 glyphHits;
+		qint64 glyphMisses;
+		//! Number of glyphs currently in the atlas.
+		int glyphCount;
+		//! Number of times the atlas was full and had to be cleared.
+		int clears;
+	};
+
+	//! Create the atlas texture.
+	//! @param size the width and height of the atlas texture in pixel.
+	StelGlyphAtlas(int size=1024);
+	~StelGlyphAtlas();
+
+	//! Get the shaped layout of a string, shaping it if needed.
+	//! The returned pointer is only valid until the next call.
+	const TextLayout* getLayout(const QString& str, const QFont& font);
+
+	//! Get a glyph of a run, rasterizing it in the atlas if needed.
+	//! @return false if the atlas is full, the caller should then draw what it has and clear() the atlas.
+	bool getGlyph(const Run& run, int i, Glyph& glyph);
+
+	//! Remove all the glyphs from the atlas. The layouts are kept.
+	void clear();
+
+	//! Bind the atlas texture to the current texture unit.
+	void bind() const;
+
+	Statistics getStatistics() const;
+
+private:
+	//! Get a small integer identifying a font and its pixel size.
+	int getFontId(const QRawFont& font);
+
+	GLuint textureId;
+	int size;
+
+	//! Position of the next glyph in the current row.
+	int rowX, rowY;
+	//! Height of the biggest glyph in the current row.
+	int rowHeight;
+
+	//! Glyphs in the atlas by (fontId, glyph index).
+	QHash<quint64, Glyph> glyphs;
+	QHash<QString, int> fontIds;
+	QCache<QByteArray, TextLayout> layouts;
+
+	Statistics statistics;
+};
+
+#endif // _STELGLYPHATLAS_HPP_
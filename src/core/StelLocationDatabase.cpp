@@ -0,0 +1,456 @@
+/*
+ * Stellarium
+ * Copyright (C) 2015 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelLocationDatabase.hpp"
+
+#include <QDebug>
+#include <QDir>
+#include <QHash>
+#include <QVector>
+#include <QtEndian>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+const char Magic[4] = {'S', 'T', 'L', 'D'};
+const quint32 Version = 1;
+
+// Size of the cells of the grid in degrees
+const int GridCellSize = 10;
+const int GridColumns = 360/GridCellSize;
+const int GridRows = 180/GridCellSize;
+
+enum HeaderField
+{
+	HeaderMagic,
+	HeaderVersion,
+	HeaderRecordCount,
+	HeaderCountryCount,
+	HeaderEarthCount,		// Number of entries of the country and grid tables
+	HeaderStringsSize,
+	HeaderSourceSizeLow,
+	HeaderSourceSizeHigh,
+	HeaderSourceTimeLow,
+	HeaderSourceTimeHigh,
+	HeaderRecordsOffset,
+	HeaderCountriesOffset,
+	HeaderByCountryOffset,
+	HeaderGridStartOffset,
+	HeaderGridRecordsOffset,
+	HeaderStringsOffset,
+	HeaderFieldCount
+};
+
+enum CountryField
+{
+	CountryName,
+	CountryFirst,
+	CountryCount,
+	CountryFieldCount
+};
+
+int gridRow(double latitude)
+{
+	return qBound(0, (int)std::floor((latitude+90.)/GridCellSize), GridRows-1);
+}
+
+int gridColumn(double longitude)
+{
+	const int column = (int)std::floor((longitude+180.)/GridCellSize) % GridColumns;
+	return column<0 ? column+GridColumns : column;
+}
+
+void appendU32(QByteArray& data, quint32 value)
+{
+	uchar buf[4];
+	qToLittleEndian(value, buf);
+	data.append(reinterpret_cast<const char*>(buf), 4);
+}
+
+void appendFloat(QByteArray& data, float value)
+{
+	quint32 bits;
+	memcpy(&bits, &value, 4);
+	appendU32(data, bits);
+}
+
+// The strings of the database, shared when they are repeated
+class StringTable
+{
+public:
+	StringTable() : data(1, '\0') {}
+	quint32 add(const QString& s)
+	{
+		if (s.isEmpty())
+			return 0;
+		QHash<QString, quint32>::const_iterator it = offsets.constFind(s);
+		if (it!=offsets.constEnd())
+			return it.value();
+		const quint32 offset = data.size();
+		data.append(s.toUtf8());
+		data.append('\0');
+		offsets.insert(s, offset);
+		return offset;
+	}
+	QByteArray data;
+private:
+	QHash<QString, quint32> offsets;
+};
+}
+
+StelLocationDatabase::StelLocationDatabase() : data(NULL), dataSize(0), records(NULL), recordCount(0),
+	countries(NULL), countryCount(0), byCountry(NULL), gridStart(NULL), gridRecords(NULL), strings(NULL)
+{
+}
+
+StelLocationDatabase::~StelLocationDatabase()
+{
+	// The mapping is removed when the file is closed
+	file.close();
+}
+
+StelLocationDatabase* StelLocationDatabase::open(const QString& fileName)
+{
+	StelLocationDatabase* db = new StelLocationDatabase();
+	db->file.setFileName(fileName);
+	const uchar* mapped = NULL;
+	if (db->file.open(QIODevice::ReadOnly) && db->file.size()>0)
+		mapped = db->file.map(0, db->file.size());
+	if (!mapped || !db->load(mapped, db->file.size()))
+	{
+		qWarning() << "WARNING: Invalid location database: " << QDir::toNativeSeparators(fileName);
+		delete db;
+		return NULL;
+	}
+	return db;
+}
+
+StelLocationDatabase* StelLocationDatabase::fromData(const QByteArray& data)
+{
+	StelLocationDatabase* db = new StelLocationDatabase();
+	db->memoryData = data;
+	if (!db->load(reinterpret_cast<const uchar*>(db->memoryData.constData()), db->memoryData.size()))
+	{
+		delete db;
+		return NULL;
+	}
+	return db;
+}
+
+quint32 StelLocationDatabase::field(const uchar* p, int i) const
+{
+	return qFromLittleEndian<quint32>(p+4*i);
+}
+
+float StelLocationDatabase::recordFloat(int record, RecordField f) const
+{
+	const quint32 bits = recordField(record, f);
+	float value;
+	memcpy(&value, &bits, 4);
+	return value;
+}
+
+bool StelLocationDatabase::load(const uchar* adata, qint64 asize)
+{
+	data = adata;
+	dataSize = asize;
+	if (dataSize<HeaderFieldCount*4 || memcmp(data, Magic, 4)!=0 || headerField(HeaderVersion)!=Version)
+		return false;
+
+	const quint64 earthCount = headerField(HeaderEarthCount);
+	const quint64 stringsSize = headerField(HeaderStringsSize);
+	recordCount = headerField(HeaderRecordCount);
+	countryCount = headerField(HeaderCountryCount);
+	if (recordCount<0 || countryCount<0 || earthCount>(quint64)recordCount || stringsSize==0)
+		return false;
+	const quint64 size = dataSize;
+	if (headerField(HeaderRecordsOffset)+(quint64)recordCount*RecordFieldCount*4>size
+		|| headerField(HeaderCountriesOffset)+(quint64)countryCount*CountryFieldCount*4>size
+		|| headerField(HeaderByCountryOffset)+earthCount*4>size
+		|| headerField(HeaderGridStartOffset)+(quint64)(GridColumns*GridRows+1)*4>size
+		|| headerField(HeaderGridRecordsOffset)+earthCount*4>size
+		|| headerField(HeaderStringsOffset)+stringsSize>size)
+		return false;
+	records = data+headerField(HeaderRecordsOffset);
+	countries = data+headerField(HeaderCountriesOffset);
+	byCountry = data+headerField(HeaderByCountryOffset);
+	gridStart = data+headerField(HeaderGridStartOffset);
+	gridRecords = data+headerField(HeaderGridRecordsOffset);
+	strings = reinterpret_cast<const char*>(data+headerField(HeaderStringsOffset));
+
+	// All the strings are terminated and all the indices are in their tables
+	if (strings[0]!='\0' || strings[stringsSize-1]!='\0')
+		return false;
+	for (int i=0;i<recordCount;++i)
+	{
+		for (int f=RecordId;f<=RecordLandscape;++f)
+		{
+			if (recordField(i, (RecordField)f)>=stringsSize)
+				return false;
+		}
+	}
+	for (int i=0;i<countryCount;++i)
+	{
+		if (field(countries, i*CountryFieldCount+CountryName)>=stringsSize
+			|| (quint64)field(countries, i*CountryFieldCount+CountryFirst)+field(countries, i*CountryFieldCount+CountryCount)>earthCount)
+			return false;
+	}
+	for (int i=0;i<(int)earthCount;++i)
+	{
+		if (field(byCountry, i)>=(quint32)recordCount || field(gridRecords, i)>=(quint32)recordCount)
+			return false;
+	}
+	for (int i=0;i<GridColumns*GridRows;++i)
+	{
+		if (field(gridStart, i)>field(gridStart, i+1))
+			return false;
+	}
+	if (field(gridStart, GridColumns*GridRows)!=earthCount)
+		return false;
+	return true;
+}
+
+qint64 StelLocationDatabase::getSourceSize() const
+{
+	return (qint64)(((quint64)headerField(HeaderSourceSizeHigh)<<32) | headerField(HeaderSourceSizeLow));
+}
+
+qint64 StelLocationDatabase::getSourceTime() const
+{
+	return (qint64)(((quint64)headerField(HeaderSourceTimeHigh)<<32) | headerField(HeaderSourceTimeLow));
+}
+
+StelLocation StelLocationDatabase::getLocation(int i) const
+{
+	Q_ASSERT(i>=0 && i<recordCount);
+	StelLocation loc;
+	loc.name = getString(recordField(i, RecordName));
+	loc.state = getString(recordField(i, RecordState));
+	loc.country = getString(recordField(i, RecordCountry));
+	loc.planetName = getString(recordField(i, RecordPlanet));
+	loc.landscapeKey = getString(recordField(i, RecordLandscape));
+	loc.longitude = recordFloat(i, RecordLongitude);
+	loc.latitude = recordFloat(i, RecordLatitude);
+	loc.altitude = (qint32)recordField(i, RecordAltitude);
+	loc.population = (qint32)recordField(i, RecordPopulation);
+	loc.bortleScaleIndex = recordFloat(i, RecordBortle);
+	loc.role = QChar((ushort)recordField(i, RecordRole));
+	loc.isUserLocation = false;
+	return loc;
+}
+
+int StelLocationDatabase::findID(const QString& id) const
+{
+	const int i = lowerBoundID(id);
+	return (i<recordCount && getID(i)==id) ? i : -1;
+}
+
+int StelLocationDatabase::lowerBoundID(const QString& id) const
+{
+	// The records are sorted like the keys of a QMap<QString, ...>
+	int lo = 0;
+	int hi = recordCount;
+	while (lo<hi)
+	{
+		const int mid = (lo+hi)/2;
+		if (getID(mid)<id)
+			lo = mid+1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+double StelLocationDatabase::distance(int record, double longitude, double latitude) const
+{
+	const double lng = recordFloat(record, RecordLongitude)*M_PI/180.;
+	const double lat = recordFloat(record, RecordLatitude)*M_PI/180.;
+	const double sinDLat = std::sin((lat-latitude)/2.);
+	const double sinDLng = std::sin((lng-longitude)/2.);
+	const double a = sinDLat*sinDLat + std::cos(lat)*std::cos(latitude)*sinDLng*sinDLng;
+	return 2.*std::asin(qMin(1., std::sqrt(a)));
+}
+
+int StelLocationDatabase::findNearest(float longitude, float latitude) const
+{
+	const double lng = longitude*M_PI/180.;
+	const double lat = latitude*M_PI/180.;
+	// Search the cells which may contain locations closer than a growing radius,
+	// until a location is found within that radius
+	for (double radius=GridCellSize*M_PI/180.;;radius*=2.)
+	{
+		const bool wholeSphere = radius>=M_PI;
+		const double radiusDeg = radius*180./M_PI;
+		const int minRow = gridRow(latitude-radiusDeg);
+		const int maxRow = gridRow(latitude+radiusDeg);
+		int minColumn = 0;
+		int columnCount = GridColumns;
+		if (!wholeSphere && latitude+radiusDeg<90. && latitude-radiusDeg>-90. && std::sin(radius)<std::cos(lat))
+		{
+			// Half width in longitude of the cap of this radius
+			const double deltaLng = std::asin(std::sin(radius)/std::cos(lat))*180./M_PI;
+			minColumn = gridColumn(longitude-deltaLng);
+			columnCount = qMin(GridColumns, (int)std::floor((longitude+deltaLng+180.)/GridCellSize) - (int)std::floor((longitude-deltaLng+180.)/GridCellSize) + 1);
+		}
+
+		int best = -1;
+		double bestDistance = wholeSphere ? std::numeric_limits<double>::max() : radius;
+		for (int row=minRow;row<=maxRow;++row)
+		{
+			for (int c=0;c<columnCount;++c)
+			{
+				const int cell = row*GridColumns + (minColumn+c)%GridColumns;
+				const quint32 end = field(gridStart, cell+1);
+				for (quint32 k=field(gridStart, cell);k<end;++k)
+				{
+					const int record = field(gridRecords, k);
+					const double d = distance(record, lng, lat);
+					if (d<bestDistance)
+					{
+						bestDistance = d;
+						best = record;
+					}
+				}
+			}
+		}
+		if (best>=0 || wholeSphere)
+			return best;
+	}
+}
+
+QStringList StelLocationDatabase::getCountryNames() const
+{
+	QStringList names;
+	names.reserve(countryCount);
+	for (int i=0;i<countryCount;++i)
+		names << getString(field(countries, i*CountryFieldCount+CountryName));
+	return names;
+}
+
+QStringList StelLocationDatabase::getCityNames(const QString& country) const
+{
+	QStringList names;
+	// The countries are sorted
+	int lo = 0;
+	int hi = countryCount;
+	while (lo<hi)
+	{
+		const int mid = (lo+hi)/2;
+		if (getString(field(countries, mid*CountryFieldCount+CountryName))<country)
+			lo = mid+1;
+		else
+			hi = mid;
+	}
+	if (lo>=countryCount || getString(field(countries, lo*CountryFieldCount+CountryName))!=country)
+		return names;
+	const quint32 first = field(countries, lo*CountryFieldCount+CountryFirst);
+	const quint32 count = field(countries, lo*CountryFieldCount+CountryCount);
+	names.reserve(count);
+	for (quint32 k=first;k<first+count;++k)
+		names << getString(recordField(field(byCountry, k), RecordName));
+	return names;
+}
+
+QByteArray StelLocationDatabase::build(const QMap<QString, StelLocation>& locations, qint64 sourceSize, qint64 sourceTime)
+{
+	StringTable strings;
+	QByteArray recordsData;
+	// The Earth locations by country and by cell, in the order of their IDs
+	QMap<QString, QVector<quint32> > countryRecords;
+	QVector<QVector<quint32> > cellRecords(GridColumns*GridRows);
+	quint32 earthCount = 0;
+
+	quint32 i = 0;
+	for (QMap<QString, StelLocation>::const_iterator it=locations.constBegin();it!=locations.constEnd();++it, ++i)
+	{
+		const StelLocation& loc = it.value();
+		appendU32(recordsData, strings.add(it.key()));
+		appendU32(recordsData, strings.add(loc.name));
+		appendU32(recordsData, strings.add(loc.state));
+		appendU32(recordsData, strings.add(loc.country));
+		appendU32(recordsData, strings.add(loc.planetName));
+		appendU32(recordsData, strings.add(loc.landscapeKey));
+		appendFloat(recordsData, loc.longitude);
+		appendFloat(recordsData, loc.latitude);
+		appendU32(recordsData, (quint32)loc.altitude);
+		appendU32(recordsData, (quint32)loc.population);
+		appendFloat(recordsData, loc.bortleScaleIndex);
+		appendU32(recordsData, loc.role.unicode());
+		if (loc.planetName=="Earth")
+		{
+			countryRecords[loc.country].append(i);
+			cellRecords[gridRow(loc.latitude)*GridColumns+gridColumn(loc.longitude)].append(i);
+			++earthCount;
+		}
+	}
+
+	QByteArray countriesData;
+	QByteArray byCountryData;
+	quint32 first = 0;
+	for (QMap<QString, QVector<quint32> >::const_iterator it=countryRecords.constBegin();it!=countryRecords.constEnd();++it)
+	{
+		appendU32(countriesData, strings.add(it.key()));
+		appendU32(countriesData, first);
+		appendU32(countriesData, it.value().size());
+		foreach (quint32 record, it.value())
+			appendU32(byCountryData, record);
+		first += it.value().size();
+	}
+
+	QByteArray gridStartData;
+	QByteArray gridRecordsData;
+	quint32 start = 0;
+	foreach (const QVector<quint32>& cell, cellRecords)
+	{
+		appendU32(gridStartData, start);
+		foreach (quint32 record, cell)
+			appendU32(gridRecordsData, record);
+		start += cell.size();
+	}
+	appendU32(gridStartData, start);
+
+	QByteArray header(Magic, 4);
+	appendU32(header, Version);
+	appendU32(header, locations.size());
+	appendU32(header, countryRecords.size());
+	appendU32(header, earthCount);
+	appendU32(header, strings.data.size());
+	appendU32(header, (quint32)((quint64)sourceSize & 0xffffffff));
+	appendU32(header, (quint32)((quint64)sourceSize>>32));
+	appendU32(header, (quint32)((quint64)sourceTime & 0xffffffff));
+	appendU32(header, (quint32)((quint64)sourceTime>>32));
+	quint32 offset = HeaderFieldCount*4;
+	appendU32(header, offset);
+	offset += recordsData.size();
+	appendU32(header, offset);
+	offset += countriesData.size();
+	appendU32(header, offset);
+	offset += byCountryData.size();
+	appendU32(header, offset);
+	offset += gridStartData.size();
+	appendU32(header, offset);
+	offset += gridRecordsData.size();
+	appendU32(header, offset);
+	Q_ASSERT(header.size()==HeaderFieldCount*4);
+
+	return header + recordsData + countriesData + byCountryData + gridStartData + gridRecordsData + strings.data;
+}
@@ -0,0 +1,135 @@
+/*
+ * Stellarium
+ * Copyright (C) 2015 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STELLOCATIONDATABASE_HPP_
+#define _STELLOCATIONDATABASE_HPP_
+
+#include "StelLocation.hpp"
+
+#include <QByteArray>
+#include <QFile>
+#include <QMap>
+#include <QStringList>
+
+//! @class StelLocationDatabase
+//! Read only binary database of locations, memory mapped so that opening it costs nothing.
+//! The locations are decoded only when they are requested. The file contains:
+//! - the locations sorted by ID, each a fixed size record of string offsets and numbers,
+//! - the countries of the Earth locations, sorted, each with the range of its locations
+//!   in a table of the Earth locations sorted by country,
+//! - a grid of 10x10 degrees cells listing the Earth locations in each cell, for the nearest location search,
+//! - a table of the UTF-8 strings, shared by the locations.
+//! All the numbers are stored in little endian, whatever the machine which wrote it. The file also records the
+//! size and modification time of the text file it was generated from, so that it can be regenerated when
+//! the text file changes.
+class StelLocationDatabase
+{
+public:
+	//! Map a database file.
+	//! @return NULL if the file can't be mapped or is not a valid database of this version.
+	static StelLocationDatabase* open(const QString& fileName);
+
+	//! Use a database already in memory, e.g. when it can't be saved.
+	//! @return NULL if the data is not a valid database of this version.
+	static StelLocationDatabase* fromData(const QByteArray& data);
+
+	//! Create the content of a database file.
+	//! @param locations the locations by ID.
+	//! @param sourceSize, sourceTime the size and the modification time in ms since the epoch of the text file.
+	static QByteArray build(const QMap<QString, StelLocation>& locations, qint64 sourceSize, qint64 sourceTime);
+
+	~StelLocationDatabase();
+
+	qint64 getSourceSize() const;
+	qint64 getSourceTime() const;
+
+	//! Number of locations.
+	int size() const {return recordCount;}
+
+	//! Decode the location of the given number, between 0 and size()-1.
+	StelLocation getLocation(int i) const;
+	QString getID(int i) const {return getString(recordField(i, RecordId));}
+
+	//! Find a location by ID with a binary search.
+	//! @return the number of the location, or -1 if there is none.
+	int findID(const QString& id) const;
+
+	//! Find the first location whose ID is not less than the given string, in the order of the IDs.
+	//! The IDs start with the names, so the locations whose name starts with a prefix follow its lower bound.
+	//! @return size() if all the IDs are less than the string.
+	int lowerBoundID(const QString& id) const;
+
+	//! Find the nearest Earth location of the given position in degrees.
+	//! @return the number of the location, or -1 if there is no Earth location.
+	int findNearest(float longitude, float latitude) const;
+
+	//! The sorted names of the countries of the Earth locations.
+	QStringList getCountryNames() const;
+
+	//! The names of the Earth locations in the given country, in the order of their IDs.
+	QStringList getCityNames(const QString& country) const;
+
+	//! Fields of a location record.
+	enum RecordField
+	{
+		RecordId,
+		RecordName,
+		RecordState,
+		RecordCountry,
+		RecordPlanet,
+		RecordLandscape,
+		RecordLongitude,
+		RecordLatitude,
+		RecordAltitude,
+		RecordPopulation,
+		RecordBortle,
+		RecordRole,
+		RecordFieldCount
+	};
+
+private:
+	StelLocationDatabase();
+
+	//! Check that the data is a valid database, so that the accessors don't need to.
+	bool load(const uchar* adata, qint64 asize);
+
+	quint32 field(const uchar* p, int i) const;
+	quint32 headerField(int i) const {return field(data, i);}
+	quint32 recordField(int record, RecordField f) const {return field(records, record*RecordFieldCount+f);}
+	float recordFloat(int record, RecordField f) const;
+	QString getString(quint32 offset) const {return QString::fromUtf8(strings+offset);}
+	//! Distance in radians between a location and a position in radians.
+	double distance(int record, double longitude, double latitude) const;
+
+	QFile file;
+	QByteArray memoryData;
+	const uchar* data;
+	qint64 dataSize;
+
+	const uchar* records;
+	int recordCount;
+	const uchar* countries;
+	int countryCount;
+	const uchar* byCountry;
+	const uchar* gridStart;
+	const uchar* gridRecords;
+	const char* strings;
+};
+
+#endif // _STELLOCATIONDATABASE_HPP_
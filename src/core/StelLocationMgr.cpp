@@ -18,76 +18,71 @@
 
 #include "StelApp.hpp"
 #include "StelFileMgr.hpp"
+#include "StelLocationDatabase.hpp"
 #include "StelLocationMgr.hpp"
 #include "StelUtils.hpp"
 
 #include <QStringListModel>
-#include <QDataStream>
+#include <QDateTime>
 #include <QDebug>
 #include <QFile>
+#include <QFileInfo>
 #include <QDir>
 
-StelLocationMgr::StelLocationMgr()
+#include <cmath>
+
+StelLocationMgr::StelLocationMgr() : modelAllLocation(NULL)
 {
 	qRegisterMetaType<StelLocation>("StelLocation");
-	// The line below allows to re-generate the location file, you still need to gunzip it manually afterward.
-    // generateBinaryLocationFile("data/base_locations.txt", false, "data/base_locations.bin");
-
-#ifdef Q_OS_ANDROID
-	// The .gz is removed in the assets to avoid double compression.
-    // Modified: loadCitiesBin won't work properly, resort to loadCities (Cheng Xinlun, Feb 20, 2017)
-    locations = loadCities("data/base_locations.txt", true);
-#else
-	locations = loadCitiesBin("data/base_locations.bin.gz");
-#endif
-	locations.unite(loadCities("data/user_locations.txt", true));
-
-	modelAllLocation = new QStringListModel(this);
-	modelAllLocation->setStringList(locations.keys());
-	
+
+	baseLocations.reset(loadBaseLocations("data/base_locations.txt"));
+	userLocations = loadCities("data/user_locations.txt", true);
+
 	// Init to Paris France because it's the center of the world.
 	lastResortLocation = locationForString("Paris, France");
 }
 
-void StelLocationMgr::generateBinaryLocationFile(const QString& fileName, bool isUserLocation, const QString& binFilePath) const
-{
-	const QMap<QString, StelLocation>& cities = loadCities(fileName, isUserLocation);
-	QFile binfile(binFilePath);
-	binfile.open(QIODevice::WriteOnly);
-	QDataStream out(&binfile);
-	out.setVersion(QDataStream::Qt_4_6);
-	out << cities;
-	binfile.close();
-}
-
-QMap<QString, StelLocation> StelLocationMgr::loadCitiesBin(const QString& fileName) const
+StelLocationDatabase* StelLocationMgr::loadBaseLocations(const QString& fileName) const
 {
-	QMap<QString, StelLocation> res;
-	QString cityDataPath = StelFileMgr::findFile(fileName);
-	if (cityDataPath.isEmpty())
-		return res;
-
-	QFile sourcefile(cityDataPath);
-	if (!sourcefile.open(QIODevice::ReadOnly))
+	const QString textPath = StelFileMgr::findFile(fileName);
+	const QFileInfo textInfo(textPath);
+	const qint64 textTime = textInfo.lastModified().toMSecsSinceEpoch();
+
+	// The database generated at a previous start is in the user directory
+	const QString dbName = fileName.left(fileName.lastIndexOf('.')) + ".db";
+	const QString dbPath = StelFileMgr::findFile(dbName);
+	if (!dbPath.isEmpty())
 	{
-		qWarning() << "ERROR: Could not open location data file: " << QDir::toNativeSeparators(cityDataPath);
-		return res;
+		StelLocationDatabase* db = StelLocationDatabase::open(dbPath);
+		if (db && (textPath.isEmpty() || (db->getSourceSize()==textInfo.size() && db->getSourceTime()==textTime)))
+			return db;
+		delete db;
 	}
-
-	if (fileName.endsWith(".gz"))
+	if (textPath.isEmpty())
 	{
-		QDataStream in(StelUtils::uncompress(sourcefile.readAll()));
-		in.setVersion(QDataStream::Qt_4_6);
-		in >> res;
-		return res;
+		qWarning() << "WARNING: Failed to locate location data file: " << QDir::toNativeSeparators(fileName);
+		return NULL;
 	}
-	else
+
+	qDebug() << "Generating the location database from" << QDir::toNativeSeparators(textPath);
+	const QByteArray data = StelLocationDatabase::build(loadCities(fileName, false), textInfo.size(), textTime);
+	const QString userDataDir = StelFileMgr::getUserDir()+"/data";
+	if (StelFileMgr::exists(userDataDir) || StelFileMgr::mkDir(userDataDir))
 	{
-		QDataStream in(&sourcefile);
-		in.setVersion(QDataStream::Qt_4_6);
-		in >> res;
-		return res;
+		const QString newDbPath = StelFileMgr::getUserDir()+"/"+dbName;
+		QFile dbFile(newDbPath);
+		if (dbFile.open(QIODevice::WriteOnly) && dbFile.write(data)==data.size())
+		{
+			dbFile.close();
+			StelLocationDatabase* db = StelLocationDatabase::open(newDbPath);
+			if (db)
+				return db;
+		}
+		else
+			qWarning() << "WARNING: Could not write the location database: " << QDir::toNativeSeparators(newDbPath);
 	}
+	// Use it from memory until it can be saved
+	return StelLocationDatabase::fromData(data);
 }
 
 QMap<QString, StelLocation> StelLocationMgr::loadCities(const QString& fileName, bool isUserLocation) const
@@ -151,6 +146,144 @@ StelLocationMgr::~StelLocationMgr()
 {
 }
 
+QStringList StelLocationMgr::getAllIDs() const
+{
+	QStringList ids;
+	if (baseLocations)
+	{
+		ids.reserve(baseLocations->size()+userLocations.size());
+		for (int i=0;i<baseLocations->size();++i)
+			ids << baseLocations->getID(i);
+	}
+	for (QMap<QString, StelLocation>::ConstIterator iter=userLocations.constBegin();iter!=userLocations.constEnd();++iter)
+	{
+		if (!baseLocations || baseLocations->findID(iter.key())<0)
+			ids << iter.key();
+	}
+	ids.sort();
+	return ids;
+}
+
+QStringListModel* StelLocationMgr::getModelAll()
+{
+	if (!modelAllLocation)
+	{
+		modelAllLocation = new QStringListModel(this);
+		modelAllLocation->setStringList(getAllIDs());
+	}
+	return modelAllLocation;
+}
+
+QList<StelLocation> StelLocationMgr::getAll() const
+{
+	QList<StelLocation> all;
+	if (baseLocations)
+	{
+		for (int i=0;i<baseLocations->size();++i)
+		{
+			if (!userLocations.contains(baseLocations->getID(i)))
+				all << baseLocations->getLocation(i);
+		}
+	}
+	all << userLocations.values();
+	return all;
+}
+
+QStringList StelLocationMgr::getCountryNames() const
+{
+	QStringList countries;
+	if (baseLocations)
+		countries = baseLocations->getCountryNames();
+	bool added = false;
+	foreach (const StelLocation& loc, userLocations)
+	{
+		if (loc.planetName=="Earth" && !countries.contains(loc.country))
+		{
+			countries << loc.country;
+			added = true;
+		}
+	}
+	if (added)
+		countries.sort();
+	return countries;
+}
+
+QStringList StelLocationMgr::getCityNames(const QString& country) const
+{
+	QStringList cities;
+	if (baseLocations)
+		cities = baseLocations->getCityNames(country);
+	foreach (const StelLocation& loc, userLocations)
+	{
+		if (loc.planetName=="Earth" && loc.country==country)
+			cities << loc.name;
+	}
+	cities.sort();
+	return cities;
+}
+
+QStringList StelLocationMgr::getCityNames(const QString& country, const QString& prefix) const
+{
+	if (prefix.isEmpty())
+		return getCityNames(country);
+	QStringList cities;
+	if (baseLocations)
+	{
+		for (int i=baseLocations->lowerBoundID(prefix);i<baseLocations->size() && baseLocations->getID(i).startsWith(prefix);++i)
+		{
+			const StelLocation loc = baseLocations->getLocation(i);
+			// The ID goes on after the name, e.g. with ", " and the state
+			if (loc.planetName=="Earth" && loc.country==country && loc.name.startsWith(prefix))
+				cities << loc.name;
+		}
+	}
+	foreach (const StelLocation& loc, userLocations)
+	{
+		if (loc.planetName=="Earth" && loc.country==country && loc.name.startsWith(prefix))
+			cities << loc.name;
+	}
+	cities.sort();
+	return cities;
+}
+
+// Angular distance in radians between two positions in degrees
+static double angularDistance(double lng1, double lat1, double lng2, double lat2)
+{
+	const double sinDLat = std::sin((lat2-lat1)*M_PI/360.);
+	const double sinDLng = std::sin((lng2-lng1)*M_PI/360.);
+	const double a = sinDLat*sinDLat + std::cos(lat1*M_PI/180.)*std::cos(lat2*M_PI/180.)*sinDLng*sinDLng;
+	return 2.*std::asin(qMin(1., std::sqrt(a)));
+}
+
+const StelLocation StelLocationMgr::getNearestLocation(float longitude, float latitude) const
+{
+	StelLocation ret;
+	ret.role = '!';
+	double retDistance = 4.;
+	if (baseLocations)
+	{
+		const int i = baseLocations->findNearest(longitude, latitude);
+		if (i>=0)
+		{
+			ret = baseLocations->getLocation(i);
+			retDistance = angularDistance(ret.longitude, ret.latitude, longitude, latitude);
+		}
+	}
+	// The user locations are few
+	foreach (const StelLocation& loc, userLocations)
+	{
+		if (loc.planetName!="Earth")
+			continue;
+		const double d = angularDistance(loc.longitude, loc.latitude, longitude, latitude);
+		if (d<retDistance)
+		{
+			ret = loc;
+			retDistance = d;
+		}
+	}
+	return ret;
+}
+
 static float parseAngle(const QString& s, bool* ok)
 {
 	float ret;
@@ -174,11 +307,14 @@ static float parseAngle(const QString& s, bool* ok)
 
 const StelLocation StelLocationMgr::locationForString(const QString& s) const
 {
-	QMap<QString, StelLocation>::const_iterator iter = locations.find(s);
-	if (iter!=locations.end())
+	QMap<QString, StelLocation>::const_iterator iter = userLocations.find(s);
+	if (iter!=userLocations.end())
 	{
 		return iter.value();
 	}
+	const int i = baseLocations ? baseLocations->findID(s) : -1;
+	if (i>=0)
+		return baseLocations->getLocation(i);
 	StelLocation ret;
 	// Maybe it is a coordinate set ? (e.g. GPS 25.107363,121.558807 )
 	QRegExp reg("(?:(.+)\\s+)?(.+),(.+)");
@@ -201,7 +337,7 @@ const StelLocation StelLocationMgr::locationForString(const QString& s) const
 // Get whether a location can be permanently added to the list of user locations
 bool StelLocationMgr::canSaveUserLocation(const StelLocation& loc) const
 {
-	return loc.isValid() && locations.find(loc.getID())==locations.end();
+	return loc.isValid() && !userLocations.contains(loc.getID()) && (!baseLocations || baseLocations->findID(loc.getID())<0);
 }
 
 // Add permanently a location to the list of user locations
@@ -211,10 +347,13 @@ bool StelLocationMgr::saveUserLocation(const StelLocation& loc)
 		return false;
 
 	// Add in the program
-	locations[loc.getID()]=loc;
+	StelLocation userLoc = loc;
+	userLoc.isUserLocation = true;
+	userLocations[loc.getID()]=userLoc;
 
 	// Append in the Qt model
-	modelAllLocation->setStringList(locations.keys());
+	if (modelAllLocation)
+		modelAllLocation->setStringList(getAllIDs());
 
 	// Append to the user location file
 	QString cityDataPath = StelFileMgr::findFile("data/user_locations.txt", StelFileMgr::Flags(StelFileMgr::Writable|StelFileMgr::File));
@@ -253,13 +392,7 @@ bool StelLocationMgr::saveUserLocation(const StelLocation& loc)
 // If the location comes from the base read only list, it cannot be deleted
 bool StelLocationMgr::canDeleteUserLocation(const QString& id) const
 {
-	QMap<QString, StelLocation>::const_iterator iter=locations.find(id);
-
-	// If it's not known at all there is a problem
-	if (iter==locations.end())
-		return false;
-
-	return iter.value().isUserLocation;
+	return userLocations.contains(id);
 }
 
 // Delete permanently the given location from the list of user locations
@@ -269,9 +402,10 @@ bool StelLocationMgr::deleteUserLocation(const QString& id)
 	if (!canDeleteUserLocation(id))
 		return false;
 
-	locations.remove(id);
+	userLocations.remove(id);
 	// Remove in the Qt model file
-	modelAllLocation->setStringList(locations.keys());
+	if (modelAllLocation)
+		modelAllLocation->setStringList(getAllIDs());
 
 	// Resave the whole remaining user locations file
 	QString cityDataPath = StelFileMgr::findFile("data/user_locations.txt", StelFileMgr::Writable);
@@ -301,12 +435,9 @@ bool StelLocationMgr::deleteUserLocation(const QString& id)
 	QTextStream outstream(&sourcefile);
 	outstream.setCodec("UTF-8");
 
-	for (QMap<QString, StelLocation>::ConstIterator iter=locations.constBegin();iter!=locations.constEnd();++iter)
+	for (QMap<QString, StelLocation>::ConstIterator iter=userLocations.constBegin();iter!=userLocations.constEnd();++iter)
 	{
-		if (iter.value().isUserLocation)
-		{
-			outstream << iter.value().serializeToLine() << '\n';
-		}
+		outstream << iter.value().serializeToLine() << '\n';
 	}
 
 	sourcefile.close();
@@ -21,14 +21,21 @@
 
 #include "StelLocation.hpp"
 #include <QString>
+#include <QStringList>
 #include <QObject>
 #include <QMetaType>
 #include <QMap>
+#include <QScopedPointer>
 
 class QStringListModel;
+class StelLocationDatabase;
 
 //! @class StelLocationMgr
 //! Manage the list of available location.
+//! The base locations are read from a binary database mapped in memory, see StelLocationDatabase.
+//! The database is generated from data/base_locations.txt at the first start, or when the text file
+//! changed, and saved in the user data directory. The user locations are still read from the text file
+//! data/user_locations.txt, they take precedence over the base locations with the same ID.
 class StelLocationMgr : public QObject
 {
 	Q_OBJECT
@@ -39,11 +46,27 @@ public:
 	//! Destructor
 	~StelLocationMgr();
 
-	//! Return the model containing all the city
-	QStringListModel* getModelAll() {return modelAllLocation;}
+	//! Return the model containing all the city.
+	//! It is created the first time it is requested.
+	QStringListModel* getModelAll();
 
-	//! Return the list of all loaded locations
-	QList<StelLocation> getAll() const {return locations.values();}
+	//! Return the list of all loaded locations.
+	//! All the base locations are decoded, prefer the other methods when possible.
+	QList<StelLocation> getAll() const;
+
+	//! Return the sorted names of the countries of the Earth locations.
+	QStringList getCountryNames() const;
+
+	//! Return the sorted names of the locations of a country.
+	QStringList getCityNames(const QString& country) const;
+
+	//! Return the sorted names of the locations of a country which start with the given prefix.
+	//! The base locations are found with a binary search of their IDs, which start with their names.
+	QStringList getCityNames(const QString& country, const QString& prefix) const;
+
+	//! Return the nearest Earth location from the given position in degrees.
+	//! The returned location is invalid if there is no Earth location.
+	const StelLocation getNearestLocation(float longitude, float latitude) const;
 
 	//! Return the StelLocation for a given string
 	//! Can match location name, or coordinates
@@ -71,17 +94,23 @@ public:
 	bool deleteUserLocation(const QString& id);
 
 private:
-	void generateBinaryLocationFile(const QString& txtFile, bool isUserLocation, const QString& binFile) const;
+	//! Open the database of the locations of a text file, and generate it if it is missing or older than the text file.
+	StelLocationDatabase* loadBaseLocations(const QString& fileName) const;
 
 	//! Load cities from a file
 	QMap<QString, StelLocation> loadCities(const QString& fileName, bool isUserLocation) const;
-	QMap<QString, StelLocation> loadCitiesBin(const QString& fileName) const;
 
-	//! Model containing all the city information
+	//! Return the IDs of all the locations, sorted.
+	QStringList getAllIDs() const;
+
+	//! Model containing all the city information, NULL until it is requested
 	QStringListModel* modelAllLocation;
 
-	//! The list of all loaded locations
-	QMap<QString, StelLocation> locations;
+	//! The base locations
+	QScopedPointer<StelLocationDatabase> baseLocations;
+
+	//! The user locations
+	QMap<QString, StelLocation> userLocations;
 	
 	StelLocation lastResortLocation;
 };
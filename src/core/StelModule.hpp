@@ -73,6 +73,20 @@ public:
 	//! @param deltaTime the time increment in second since last call.
 	virtual void update(double deltaTime) = 0;
 
+	//! Wait for the part of the update which the module runs in the background, and use its results.
+	//! A module can start in update() a computation which doesn't need to be finished before the other modules
+	//! are updated, e.g. a propagation from an immutable copy of the frame state, so that it runs while the
+	//! sky is being drawn. StelApp calls this method at the end of each frame, so that the module state is
+	//! complete between the frames, and the module must call it itself before using the results in draw().
+	virtual void finishUpdate() {;}
+
+	//! Get the delay after which the module must be drawn again, even if nothing else changes.
+	//! The sky is only drawn again when something changed, e.g. the view, the date or a fader, so the modules
+	//! with their own animations must tell when they need the next frame.
+	//! @return the delay in seconds, 0 for the next frame, or a negative value, the default, if the
+	//! module doesn't need another frame.
+	virtual double getRedrawDelay() const {return -1.;}
+
 	//! Get the version of the module, default is stellarium main version
 	virtual QString getModuleVersion() const;
 
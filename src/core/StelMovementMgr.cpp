@@ -46,12 +46,16 @@ StelMovementMgr::StelMovementMgr(StelCore* acore) : core(acore),
 	dragTimeMode(false),
 	flagAutoZoom(0),
 	flagAutoZoomOutResetsDirection(0),
-	dragTriggerDistance(8.f)
+	dragTriggerDistance(8.f),
+	lastFov(0.),
+	fovLogVelocity(0.)
 {
 	setObjectName("StelMovementMgr");
 	isDragging = false;
 	mountMode = MountAltAzimuthal;  // default
 	upVectorMountFrame.set(0,0,1);
+	lastViewDirectionJ2000.set(0,0,0);
+	viewVelocity.set(0,0,0);
 }
 
 StelMovementMgr::~StelMovementMgr()
@@ -516,6 +520,31 @@ void StelMovementMgr::updateMotion(double deltaTime)
 	}
 	panView(deltaAz, deltaAlt);
 	updateAutoZoom(deltaTime);
+
+	// Measure the speed of the view, smoothed over about a tenth of second
+	if (deltaTime>0. && lastFov>0.)
+	{
+		const double k = qMin(1., deltaTime/0.1);
+		viewVelocity = viewVelocity*(1.-k) + (viewDirectionJ2000-lastViewDirectionJ2000)*(k/deltaTime);
+		fovLogVelocity = fovLogVelocity*(1.-k) + std::log(currentFov/lastFov)*(k/deltaTime);
+	}
+	lastViewDirectionJ2000 = viewDirectionJ2000;
+	lastFov = currentFov;
+}
+
+Vec3d StelMovementMgr::getPredictedViewDirectionJ2000(double deltaTime) const
+{
+	Vec3d v = viewDirectionJ2000 + viewVelocity*deltaTime;
+	v.normalize();
+	return v;
+}
+
+double StelMovementMgr::getPredictedFov(double deltaTime) const
+{
+	if (flagAutoZoom)
+		return getAutoZoomFov(qMin(1., zoomMove.coef+zoomMove.speed*deltaTime*1000));
+	const double fov = currentFov*std::exp(fovLogVelocity*deltaTime);
+	return qBound(minFov, fov, maxFov);
 }
 
 
@@ -839,21 +868,7 @@ void StelMovementMgr::updateAutoZoom(double deltaTime)
 {
 	if (flagAutoZoom)
 	{
-		// Use a smooth function
-		double c;
-
-		if( zoomMove.start > zoomMove.aim )
-		{
-			// slow down as approach final view
-			c = 1 - (1-zoomMove.coef)*(1-zoomMove.coef)*(1-zoomMove.coef);
-		}
-		else
-		{
-			// speed up as leave zoom target
-			c = (zoomMove.coef)*(zoomMove.coef)*(zoomMove.coef);
-		}
-
-		setFov(zoomMove.start + (zoomMove.aim - zoomMove.start) * c);
+		setFov(getAutoZoomFov(zoomMove.coef));
 		zoomMove.coef+=zoomMove.speed*deltaTime*1000;
 		if (zoomMove.coef>=1.)
 		{
@@ -863,6 +878,25 @@ void StelMovementMgr::updateAutoZoom(double deltaTime)
 	}
 }
 
+double StelMovementMgr::getAutoZoomFov(double coef) const
+{
+	// Use a smooth function
+	double c;
+
+	if( zoomMove.start > zoomMove.aim )
+	{
+		// slow down as approach final view
+		c = 1 - (1-coef)*(1-coef)*(1-coef);
+	}
+	else
+	{
+		// speed up as leave zoom target
+		c = coef*coef*coef;
+	}
+
+	return zoomMove.start + (zoomMove.aim - zoomMove.start) * c;
+}
+
 // Zoom to the given field of view
 void StelMovementMgr::zoomTo(double aim_fov, float moveDuration)
 {
@@ -57,6 +57,11 @@ public:
 
 	//! Update time-dependent things (does nothing).
 	virtual void update(double) {;}
+	//! The next frame is needed during the movements and the zooms.
+	virtual double getRedrawDelay() const
+	{
+		return (flagAutoMove || flagAutoZoom || isDragging || deltaAz!=0. || deltaAlt!=0. || deltaFov!=0.) ? 0. : -1.;
+	}
 	//! Implement required draw function.  Does nothing.
 	virtual void draw(StelCore*) {;}
 	//! Handle keyboard events.
@@ -188,6 +193,13 @@ public slots:
 	//! If currently zooming, return the target FOV, otherwise return current FOV in degree.
 	double getAimFov(void) const;
 
+	//! Predict the viewing direction in equatorial J2000 frame after the given time in seconds,
+	//! from the speed of the view during the last frames.
+	Vec3d getPredictedViewDirectionJ2000(double deltaTime) const;
+	//! Predict the FOV in degree after the given time in seconds. When zooming to a target FOV the
+	//! zoom curve is followed, otherwise the zoom speed during the last frames is used.
+	double getPredictedFov(double deltaTime) const;
+
 	//! Viewing direction function : true move, false stop.
 	void turnRight(bool);
 	void turnLeft(bool);
@@ -231,6 +243,8 @@ private:
 
 	void updateVisionVector(double deltaTime);
 	void updateAutoZoom(double deltaTime); // Update autoZoom if activated
+	//! FOV of the auto zoom at the given progress between 0 and 1.
+	double getAutoZoomFov(double coef) const;
 
 	//! Make the first screen position correspond to the second (useful for mouse dragging)
 	void dragView(int x1, int y1, int x2, int y2);
@@ -312,6 +326,14 @@ private:
 	Vec3d upVectorMountFrame;
 
 	float dragTriggerDistance;
+
+	// Speed of the view measured in updateMotion(), to predict its movements
+	Vec3d lastViewDirectionJ2000;
+	double lastFov;
+	//! Derivative of the viewing direction in J2000 frame per second.
+	Vec3d viewVelocity;
+	//! Derivative of the logarithm of the FOV per second.
+	double fovLogVelocity;
 };
 
 #endif // _STELMOVEMENTMGR_HPP_
@@ -120,50 +120,19 @@ bool StelObjectMgr::findAndSelect(const StelCore* core, int x, int y, StelModule
 // Find an object in a "clever" way, v in J2000 frame
 StelObjectP StelObjectMgr::cleverFind(const StelCore* core, const Vec3d& v) const
 {
-	StelObjectP sobj;
-	QList<StelObjectP> candidates;
-
 	const StelProjectorP prj = core->getProjection(StelCore::FrameJ2000);
 
 	// Field of view for a searchRadiusPixel pixel diameter circle on screen
 	float fov_around = core->getMovementMgr()->getCurrentFov()/qMin(prj->getViewportWidth(), prj->getViewportHeight()) * prj->getDevicePixelsPerPixel() * searchRadiusPixel;
 
-	// Collect the objects inside the range
-	foreach (const StelObjectModule* m, objectsModule)
-		candidates += m->searchAround(v, fov_around, core);
-
+	// Select the object minimizing the function y = distance(in pixel) + magnitude,
+	// each module only gives its best object
 	float limitMag = core->getSkyDrawer()->getLimitMagnitude()-2.f;
-	QList<StelObjectP> tmp;
-	foreach (const StelObjectP& obj, candidates)
-	{
-		if (obj->getSelectPriority(core)<=limitMag)
-			tmp.append(obj);
-	}
-	
-	candidates = tmp;
-	
-	// Now select the object minimizing the function y = distance(in pixel) + magnitude
-	Vec3d winpos;
-	prj->project(v, winpos);
-	float xpos = winpos[0];
-	float ypos = winpos[1];
-
-	float best_object_value;
-	best_object_value = 100000.f;
-	foreach (const StelObjectP& obj, candidates)
-	{
-		prj->project(obj->getJ2000EquatorialPos(core), winpos);
-		float distance = sqrt((xpos-winpos[0])*(xpos-winpos[0]) + (ypos-winpos[1])*(ypos-winpos[1]))*distanceWeight;
-		float priority =  obj->getSelectPriority(core);
-		// qDebug() << (*iter).getShortInfoString(core) << ": " << priority << " " << distance;
-		if (distance + priority < best_object_value)
-		{
-			best_object_value = distance + priority;
-			sobj = obj;
-		}
-	}
+	StelObjectFinder finder(core, v, fov_around, limitMag, distanceWeight);
+	foreach (const StelObjectModule* m, objectsModule)
+		m->findAround(finder);
 
-	return sobj;
+	return finder.getBest();
 }
 
 /*************************************************************************
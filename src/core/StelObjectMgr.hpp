@@ -44,6 +44,8 @@ public:
 	virtual void init() {;}
 	virtual void draw(StelCore*) {;}
 	virtual void update(double) {;}
+	//! The pointer of the selected object is animated, but at a lower frame rate.
+	virtual double getRedrawDelay() const {return (objectPointerVisibility && !lastSelectedObjects.isEmpty()) ? 0.1 : -1.;}
 
 	///////////////////////////////////////////////////////////////////////////
 	//! Add a new StelObject manager into the list of supported modules.
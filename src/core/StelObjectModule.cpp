@@ -18,6 +18,47 @@
  */
 
 #include "StelObjectModule.hpp"
+#include "StelCore.hpp"
+#include "StelObject.hpp"
+#include "StelProjector.hpp"
+
+#include <cmath>
+
+StelObjectFinder::StelObjectFinder(const StelCore* acore, const Vec3d& v, double alimitFov, float alimitPriority, float adistanceWeight)
+	: core(acore), position(v), limitFov(alimitFov), cosLimitFov(std::cos(alimitFov*M_PI/180.)),
+	  limitPriority(alimitPriority), distanceWeight(adistanceWeight), bestValue(100000.f)
+{
+	position.normalize();
+	prj = core->getProjection(StelCore::FrameJ2000);
+	Vec3d winpos;
+	prj->project(v, winpos);
+	xpos = winpos[0];
+	ypos = winpos[1];
+}
+
+float StelObjectFinder::getValue(const Vec3d& pos, float priority) const
+{
+	Vec3d winpos;
+	prj->project(pos, winpos);
+	const float distance = std::sqrt((xpos-winpos[0])*(xpos-winpos[0]) + (ypos-winpos[1])*(ypos-winpos[1]))*distanceWeight;
+	return distance + priority;
+}
+
+void StelObjectFinder::add(const StelObjectP& obj, float value)
+{
+	if (value < bestValue)
+	{
+		bestValue = value;
+		best = obj;
+	}
+}
+
+void StelObjectFinder::add(const StelObjectP& obj)
+{
+	const float priority = obj->getSelectPriority(core);
+	if (isCandidate(priority))
+		add(obj, getValue(obj->getJ2000EquatorialPos(core), priority));
+}
 
 StelObjectModule::StelObjectModule()
  : StelModule()
@@ -29,4 +70,8 @@ StelObjectModule::~StelObjectModule()
 {
 }
 
-
+void StelObjectModule::findAround(StelObjectFinder& finder) const
+{
+	foreach (const StelObjectP& obj, searchAround(finder.getPosition(), finder.getLimitFov(), finder.getCore()))
+		finder.add(obj);
+}
@@ -25,8 +25,61 @@
 #include <QStringList>
 #include "StelModule.hpp"
 #include "StelObjectType.hpp"
+#include "StelProjectorType.hpp"
 #include "VecMath.hpp"
 
+class StelCore;
+
+//! @class StelObjectFinder
+//! Keep the best object to select around a position, see StelObjectMgr::cleverFind().
+//! The best object minimizes its select priority plus its weighted distance in pixel to the position.
+//! The modules give their objects around the position with StelObjectModule::findAround().
+class StelObjectFinder
+{
+public:
+	//! @param v the search position in J2000 frame.
+	//! @param limitFov the search radius in degree.
+	//! @param limitPriority the objects with a higher select priority are ignored.
+	//! @param distanceWeight the weight of the distance in pixel relative to the select priority.
+	StelObjectFinder(const StelCore* core, const Vec3d& v, double limitFov, float limitPriority, float distanceWeight);
+
+	const StelCore* getCore() const {return core;}
+	//! The normalized search position in J2000 frame.
+	const Vec3d& getPosition() const {return position;}
+	//! The search radius in degree, and its cosine.
+	double getLimitFov() const {return limitFov;}
+	double getCosLimitFov() const {return cosLimitFov;}
+
+	//! Return whether an object with this select priority can be better than the current best object.
+	//! Use it to skip the objects before computing their position or creating their StelObjectP.
+	bool isCandidate(float priority) const {return priority<=limitPriority && priority<bestValue;}
+
+	//! Compute the value of an object, the lower the better.
+	//! @param pos the position of the object in J2000 frame.
+	float getValue(const Vec3d& pos, float priority) const;
+
+	//! Keep the object if its value is lower than the one of the current best object.
+	void add(const StelObjectP& obj, float value);
+	//! Same as above, computing the value from the position and select priority of the object.
+	void add(const StelObjectP& obj);
+
+	StelObjectP getBest() const {return best;}
+
+private:
+	const StelCore* core;
+	StelProjectorP prj;
+	Vec3d position;
+	double limitFov;
+	double cosLimitFov;
+	float limitPriority;
+	float distanceWeight;
+	//! Position of the search position on screen.
+	float xpos, ypos;
+
+	StelObjectP best;
+	float bestValue;
+};
+
 //! @class StelObjectModule
 //! Specialization of StelModule which manages a collection of StelObject.
 //! Instances deriving from the StelObjectModule class can be managed by the StelObjectMgr.
@@ -45,6 +98,12 @@ public:
 	//! @param core the core instance to use.
 	//! @return the list of all the displayed objects contained in the defined zone.
 	virtual QList<StelObjectP> searchAround(const Vec3d& v, double limitFov, const StelCore* core) const = 0;
+
+	//! Give the displayed objects around the position of the finder to it, to select an object.
+	//! The default implementation gives all the objects returned by searchAround(). The modules with many
+	//! objects should use a spatial index, skip the objects which are not candidates of the finder,
+	//! and only create the StelObjectP of their best object.
+	virtual void findAround(StelObjectFinder& finder) const;
 	
 	//! Find a StelObject by name.
 	//! @param nameI18n The translated name for the current sky locale.
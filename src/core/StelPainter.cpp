@@ -33,91 +33,22 @@
 #include <QMutex>
 #include <QVarLengthArray>
 #include <QPaintEngine>
-#include <QCache>
 #include <QOpenGLPaintDevice>
 #include <QOpenGLShader>
-#include <QOpenGLTexture>
-#include <QtEndian>
 
-// QOpenGLTexture has a bug on android, this is a temporary fix using a very simple
-// minimal implemetation of it.
-#if defined Q_OS_ANDROID || defined Q_OS_IOS
-#define QOpenGLTexture OpenGLTexture
+#include <cstring>
 
-static QByteArray convertToGLFormat(const QImage& image)
-{
-	QByteArray ret;
-	const int width = image.width();
-	const int height = image.height();
-	int bpp = 4;
-	ret.reserve(width * height * bpp);
-	QImage tmp = image.convertToFormat(QImage::Format_ARGB32);
-
-	for (int i = 0; i < height; ++i)
-	{
-		uint *p = (uint *) tmp.scanLine(i);
-		for (int x = 0; x < width; ++x)
-		{
-			uint c = qToBigEndian(p[x]);
-			const char* ptr = (const char*)&c;
-			ret.append(ptr + 1, 3);
-			ret.append(ptr, 1);
-		}
-	}
-	return ret;
-}
-
-class OpenGLTexture
-{
-public:
-	OpenGLTexture(const QImage& img);
-	~OpenGLTexture();
-	void bind();
-	void release();
-	int width() const {return m_width;}
-	int height() const {return m_height;}
-private:
-	GLuint id;
-	int m_width;
-	int m_height;
-};
-
-OpenGLTexture::OpenGLTexture(const QImage& img) : id(0)
-{
-	m_width = img.width();
-	m_height = img.height();
-	QByteArray data = convertToGLFormat(img);
-	glGenTextures(1, &id);
-	glBindTexture(GL_TEXTURE_2D, id);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height, 0, GL_RGBA,
-				 GL_UNSIGNED_BYTE, data.constData());
-}
-
-OpenGLTexture::~OpenGLTexture()
-{
-	if (id)
-		glDeleteTextures(1, &id);
-}
-
-void OpenGLTexture::bind()
-{
-	glBindTexture(GL_TEXTURE_2D, id);
-}
-
-void OpenGLTexture::release()
-{
-}
-
-
-#endif // End of the fix for android.
-
-static const int TEX_CACHE_LIMIT = 7000000;
+// Set while flushText() draws the text batch with drawFromArray()
+static bool flushingText = false;
 
 #ifndef NDEBUG
 QMutex* StelPainter::globalMutex = new QMutex();
 #endif
 
-QCache<QByteArray, StringTexture> StelPainter::texCache(TEX_CACHE_LIMIT);
+StelGlyphAtlas* StelPainter::glyphAtlas=NULL;
+QVector<float> StelPainter::textVertices;
+QVector<float> StelPainter::textTexCoords;
+QVector<float> StelPainter::textColors;
 QOpenGLShaderProgram* StelPainter::texturesShaderProgram=NULL;
 QOpenGLShaderProgram* StelPainter::basicShaderProgram=NULL;
 QOpenGLShaderProgram* StelPainter::colorShaderProgram=NULL;
@@ -192,6 +123,7 @@ StelPainter::StelPainter(const StelProjectorP& proj) : prj(proj)
 
 void StelPainter::setProjector(const StelProjectorP& p)
 {
+	flushText();
 	prj=p;
 	// Init GL viewport to current projector values
 	glViewport(prj->viewportXywh[0], prj->viewportXywh[1], prj->viewportXywh[2], prj->viewportXywh[3]);
@@ -200,6 +132,8 @@ void StelPainter::setProjector(const StelProjectorP& p)
 
 StelPainter::~StelPainter()
 {
+	flushText();
+
 #ifndef NDEBUG
 	GLenum er = glGetError();
 	if (er!=GL_NO_ERROR)
@@ -678,49 +612,6 @@ void StelPainter::drawText(const Vec3d& v, const QString& str, float angleDeg, f
  Draw the string at the given position and angle with the given font
 *************************************************************************/
 
-// Container for one cached string texture
-struct StringTexture
-{
-	QOpenGLTexture* texture;
-	QSize size;
-	QSizeF getTexSize() const {
-		return QSizeF((float)size.width() / texture->width(),
-		              (float)size.height() / texture->height());
-	}
-
-	StringTexture(QOpenGLTexture* tex, const QSize& size) :
-	     texture(tex), size(size) {}
-	~StringTexture() {delete texture;}
-};
-
-
-StringTexture* StelPainter::getTexTexture(const QString& str, int pixelSize)
-{
-	// Render first the text into a QPixmap, then create a QOpenGLTexture
-	// from it.  We could optimize by directly using a QImage, but for some
-	// reason the result is not exactly the same than with a QPixmap.
-	QByteArray hash = str.toUtf8() + QByteArray::number(pixelSize);
-	StringTexture* cachedTex = texCache.object(hash);
-	if (cachedTex)
-		return cachedTex;
-	QFont tmpFont = currentFont;
-	tmpFont.setPixelSize(currentFont.pixelSize()*prj->getDevicePixelsPerPixel()*StelApp::getInstance().getGlobalScalingRatio());
-	QRect strRect = QFontMetrics(tmpFont).boundingRect(str);
-	int w = strRect.width()+1+(int)(0.02f*strRect.width());
-	int h = strRect.height();
-
-	QPixmap strImage = QPixmap(StelUtils::getBiggerPowerOfTwo(w), StelUtils::getBiggerPowerOfTwo(h));
-	strImage.fill(Qt::transparent);
-	QPainter painter(&strImage);
-	painter.setFont(tmpFont);
-	painter.setRenderHints(QPainter::TextAntialiasing);
-	painter.setPen(Qt::white);
-	painter.drawText(-strRect.x(), -strRect.y(), str);
-	StringTexture* newTex = new StringTexture(new QOpenGLTexture(strImage.toImage()), QSize(w, h));
-	texCache.insert(hash, newTex, 3*w*h);
-	return newTex;
-}
-
 void StelPainter::drawText(float x, float y, const QString& str, float angleDeg, float xshift, float yshift, bool noGravity)
 {
 	if (prj->gravityLabels && !noGravity)
@@ -728,54 +619,124 @@ void StelPainter::drawText(float x, float y, const QString& str, float angleDeg,
 		drawTextGravity180(x, y, str, xshift, yshift);
 		return;
 	}
-	StringTexture* tex = getTexTexture(str, currentFont.pixelSize());
-	Q_ASSERT(tex);
+	if (!glyphAtlas)
+		glyphAtlas = new StelGlyphAtlas();
+
+	QFont tmpFont = currentFont;
+	tmpFont.setPixelSize(currentFont.pixelSize()*prj->getDevicePixelsPerPixel()*StelApp::getInstance().getGlobalScalingRatio());
+	const StelGlyphAtlas::TextLayout* layout = glyphAtlas->getLayout(str, tmpFont);
 	if (!noGravity)
 		angleDeg += prj->defautAngleForGravityText;
-	tex->texture->bind();
 
-	enableTexture2d(true);
-	static float vertexData[8];
-	// compute the vertex coordinates applying the translation and the rotation
-	static const float vertexBase[] = {0., 0., 1., 0., 0., 1., 1., 1.};
-	if (std::fabs(angleDeg)>1.f*M_PI/180.f)
-	{
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		const float cosr = std::cos(angleDeg * M_PI/180.);
-		const float sinr = std::sin(angleDeg * M_PI/180.);
-		for (int i = 0; i < 8; i+=2)
-		{
-			vertexData[i] = int(x + (tex->size.width()*vertexBase[i]+xshift) * cosr - (tex->size.height()*vertexBase[i+1]+yshift) * sinr);
-			vertexData[i+1] = int(y  + (tex->size.width()*vertexBase[i]+xshift) * sinr + (tex->size.height()*vertexBase[i+1]+yshift) * cosr);
-		}
+	// The lower left corner of the bounding rectangle of the text is at (x+xshift, y+yshift) before the rotation.
+	// Compute the beginning of the baseline in this frame (y up).
+	const QRect& rect = layout->boundingRect;
+	float originX = xshift - rect.x();
+	float originY = yshift + rect.y() + rect.height();
+	const bool rotated = std::fabs(angleDeg)>1.f*M_PI/180.f;
+	float cosr = 1.f, sinr = 0.f;
+	if (rotated)
+	{
+		cosr = std::cos(angleDeg * M_PI/180.);
+		sinr = std::sin(angleDeg * M_PI/180.);
 	}
 	else
 	{
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		for (int i = 0; i < 8; i+=2)
-		{
-			vertexData[i] = int(x + tex->size.width()*vertexBase[i]+xshift);
-			vertexData[i+1] = int(y  + tex->size.height()*vertexBase[i+1]+yshift);
-		}
+		// Align the glyphs on the pixels to keep them sharp
+		originX = std::floor(x + originX) - x;
+		originY = std::floor(y + originY) - y;
 	}
 
-	float* texCoords = new float[8];
-	for (int i=0;i<4;i++)
+	for (int r=0;r<layout->runs.size();++r)
 	{
-		texCoords[i*2+0] = tex->getTexSize().width() * (i % 2);
-		texCoords[i*2+1] = tex->getTexSize().height() * (1 - i / 2);
+		const StelGlyphAtlas::Run& run = layout->runs.at(r);
+		for (int i=0;i<run.glyphIndexes.size();++i)
+		{
+			StelGlyphAtlas::Glyph glyph;
+			if (!glyphAtlas->getGlyph(run, i, glyph))
+			{
+				// The atlas is full: draw what uses it and start again with an empty one
+				flushText();
+				glyphAtlas->clear();
+				if (!glyphAtlas->getGlyph(run, i, glyph))
+					continue;
+			}
+			if (glyph.width==0 || glyph.height==0)
+				continue;
+
+			const QPointF& pen = run.positions.at(i);
+			float left = pen.x() + glyph.left;
+			float top = pen.y() + glyph.top;
+			if (!rotated)
+			{
+				left = qRound(left);
+				top = qRound(top);
+			}
+			const float x0 = originX + left;
+			const float x1 = x0 + glyph.width;
+			const float y1 = originY - top;
+			const float y0 = y1 - glyph.height;
+
+			// Two triangles per glyph
+			const float quad[6][4] = {
+				{x0, y0, glyph.u0, glyph.v1}, {x1, y0, glyph.u1, glyph.v1}, {x0, y1, glyph.u0, glyph.v0},
+				{x1, y0, glyph.u1, glyph.v1}, {x1, y1, glyph.u1, glyph.v0}, {x0, y1, glyph.u0, glyph.v0}};
+			for (int v=0;v<6;++v)
+			{
+				textVertices << x + quad[v][0]*cosr - quad[v][1]*sinr << y + quad[v][0]*sinr + quad[v][1]*cosr;
+				textTexCoords << quad[v][2] << quad[v][3];
+				textColors << currentColor[0] << currentColor[1] << currentColor[2] << currentColor[3];
+			}
+		}
 	}
-	setTexCoordPointer(2, GL_FLOAT, texCoords);
+}
+
+void StelPainter::flushText()
+{
+	if (textVertices.isEmpty() || flushingText)
+		return;
+
+	// This can be called from any drawing method: keep the state of the caller
+	GLState glState;
+	GLint boundTexture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+	const ArrayDesc savedVertexArray = vertexArray;
+	const ArrayDesc savedTexCoordArray = texCoordArray;
+	const ArrayDesc savedColorArray = colorArray;
+	const ArrayDesc savedNormalArray = normalArray;
+	const bool savedTexture2dEnabled = texture2dEnabled;
+
+	glyphAtlas->bind();
+	enableTexture2d(true);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glEnable(GL_BLEND);
-	enableClientStates(true, true);
-	setVertexPointer(2, GL_FLOAT, vertexData);
-	drawFromArray(TriangleStrip, 4, 0, false);
-	enableClientStates(false, false);
-	tex->texture->release();
-	delete[] texCoords;
+	enableClientStates(true, true, true);
+	setVertexPointer(2, GL_FLOAT, textVertices.constData());
+	setTexCoordPointer(2, GL_FLOAT, textTexCoords.constData());
+	setColorPointer(4, GL_FLOAT, textColors.constData());
+	flushingText = true;
+	drawFromArray(Triangles, textVertices.size()/2, 0, false);
+	flushingText = false;
+	// Keep the allocated memory for the next texts
+	textVertices.resize(0);
+	textTexCoords.resize(0);
+	textColors.resize(0);
+
+	vertexArray = savedVertexArray;
+	texCoordArray = savedTexCoordArray;
+	colorArray = savedColorArray;
+	normalArray = savedNormalArray;
+	texture2dEnabled = savedTexture2dEnabled;
+	glBindTexture(GL_TEXTURE_2D, boundTexture);
+}
+
+StelGlyphAtlas::Statistics StelPainter::getTextCacheStatistics()
+{
+	if (glyphAtlas)
+		return glyphAtlas->getStatistics();
+	StelGlyphAtlas::Statistics statistics;
+	memset(&statistics, 0, sizeof(statistics));
+	return statistics;
 }
 
 // Recursive method cutting a small circle in small segments
@@ -1963,7 +1924,14 @@ void StelPainter::deinitGLShaders()
 	texturesShaderProgram = NULL;
 	delete texturesColorShaderProgram;
 	texturesColorShaderProgram = NULL;
-	texCache.clear();
+	if (glyphAtlas)
+	{
+		const StelGlyphAtlas::Statistics statistics = glyphAtlas->getStatistics();
+		qDebug() << "StelPainter: text layouts hits/misses:" << statistics.layoutHits << "/" << statistics.layoutMisses
+			 << "glyphs hits/misses:" << statistics.glyphHits << "/" << statistics.glyphMisses << "atlas clears:" << statistics.clears;
+		delete glyphAtlas;
+		glyphAtlas = NULL;
+	}
 }
 
 
@@ -1995,6 +1963,8 @@ void StelPainter::enableClientStates(bool vertex, bool texture, bool color, bool
 
 void StelPainter::drawFromArray(DrawingMode mode, int count, int offset, bool doProj, const unsigned short* indices)
 {
+	flushText();
+
 	ArrayDesc projectedVertexArray = vertexArray;
 	if (doProj)
 	{
@@ -23,6 +23,7 @@
 #include "StelSphereGeometry.hpp"
 #include "StelProjectorType.hpp"
 #include "StelProjector.hpp"
+#include "StelGlyphAtlas.hpp"
 #include <QString>
 #include <QVarLengthArray>
 #include <QFontMetrics>
@@ -287,10 +288,14 @@ public:
 	//! @return true if the link was successful.
 	static bool linkProg(class QOpenGLShaderProgram* prog, const QString& name);
 
+	//! Get the hit and miss counts of the glyph and text layout caches used by drawText().
+	static StelGlyphAtlas::Statistics getTextCacheStatistics();
+
 private:
 
 	friend class StelTextureMgr;
 	friend class StelTexture;
+	friend class StelSkyDrawer;
 
 	//! RAII class used to store and restore the opengl state.
 	//! to use it we just need to instanciate it at the beginning of a method that might change the state.
@@ -304,8 +309,18 @@ private:
 		int blendSrcRGB, blendDstRGB, blendSrcAlpha, blendDstAlpha;
 	};
 
-	static QCache<QByteArray, struct StringTexture> texCache;
-	struct StringTexture* getTexTexture(const QString& str, int pixelSize);
+	//! Glyphs used by all the texts, created on the first drawText()
+	static StelGlyphAtlas* glyphAtlas;
+
+	//! The glyph quads of the texts drawn since the last flushText(), drawn all at once
+	//! with the glyph atlas texture. There is only one StelPainter at a time so they are shared.
+	static QVector<float> textVertices;
+	static QVector<float> textTexCoords;
+	static QVector<float> textColors;
+	//! Draw the pending glyph quads, keeping the current openGL state and arrays.
+	//! Called before any other drawing so that the texts stay in the drawing order,
+	//! also by StelSkyDrawer which draws the point sources with its own shaders.
+	void flushText();
 
 	//! Struct describing one opengl array
 	typedef struct
@@ -0,0 +1,226 @@
+/*
+ * Stellarium
+ * Copyright (C) 2015 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelProfiler.hpp"
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// The ring buffer holds 2^RING_BITS events
+const int RING_BITS = 14;
+const int RING_SIZE = 1<<RING_BITS;
+
+struct ProfileEvent
+{
+	//! 0 while the event is written, then the round of the ring buffer in which it was written.
+	QAtomicInt sequence;
+	const char* name;
+	qint64 start;
+	qint64 duration;
+	qint64 threadId;
+};
+
+// Allocated when the profiler is first enabled and never freed, some threads may still write in it
+ProfileEvent* ring = NULL;
+QAtomicInt writeIndex;
+QElapsedTimer profilerClock;
+
+QMutex namesMutex;
+QHash<QString, QByteArray> internedNames;
+
+struct EventCopy
+{
+	const char* name;
+	qint64 start;
+	qint64 duration;
+	qint64 threadId;
+};
+
+// Copy the complete events in the ring buffer, skipping the ones being written
+QVector<EventCopy> getEvents()
+{
+	QVector<EventCopy> events;
+	if (!ring)
+		return events;
+	events.reserve(RING_SIZE);
+	for (int i=0;i<RING_SIZE;++i)
+	{
+		const ProfileEvent& e = ring[i];
+		const int sequence = e.sequence.loadAcquire();
+		if (sequence==0)
+			continue;
+		EventCopy copy;
+		copy.name = e.name;
+		copy.start = e.start;
+		copy.duration = e.duration;
+		copy.threadId = e.threadId;
+		// An acquire load would let the copy be reordered after it, on ARM: the release of this
+		// read-modify-write keeps the copy before the check that the event was not rewritten meanwhile.
+		if (e.sequence.fetchAndAddOrdered(0)==sequence)
+			events.append(copy);
+	}
+	return events;
+}
+
+bool startLessThan(const EventCopy& e1, const EventCopy& e2)
+{
+	return e1.start < e2.start;
+}
+
+// Nearest rank percentile of sorted values
+double percentile(const QVector<qint64>& sorted, double p)
+{
+	int rank = (int)std::ceil(p/100.*sorted.size()) - 1;
+	rank = qBound(0, rank, sorted.size()-1);
+	return sorted.at(rank)*1e-6;
+}
+}
+
+QAtomicInt StelProfiler::enabled;
+
+void StelProfiler::setEnabled(bool b)
+{
+	if (b && !ring)
+	{
+		ring = new ProfileEvent[RING_SIZE];
+		for (int i=0;i<RING_SIZE;++i)
+			ring[i].sequence.storeRelease(0);
+		profilerClock.start();
+	}
+	enabled.storeRelease(b ? 1 : 0);
+	qDebug() << "StelProfiler:" << (b ? "enabled" : "disabled");
+}
+
+qint64 StelProfiler::now()
+{
+	return profilerClock.nsecsElapsed();
+}
+
+void StelProfiler::record(const char* name, qint64 start, qint64 end)
+{
+	if (!ring)
+		return;
+	const int index = writeIndex.fetchAndAddRelaxed(1);
+	ProfileEvent& e = ring[index & (RING_SIZE-1)];
+	// A release store would let the fields be written before it, on ARM: the acquire of this
+	// read-modify-write keeps them after the event is marked as being written.
+	e.sequence.fetchAndStoreOrdered(0);
+	e.name = name;
+	e.start = start;
+	e.duration = end-start;
+	e.threadId = (qint64)(quintptr)QThread::currentThreadId();
+	e.sequence.storeRelease((int)((quint32)index>>RING_BITS) + 1);
+}
+
+const char* StelProfiler::internName(const QString& name)
+{
+	QMutexLocker locker(&namesMutex);
+	QHash<QString, QByteArray>::const_iterator it = internedNames.constFind(name);
+	if (it==internedNames.constEnd())
+		it = internedNames.insert(name, name.toUtf8());
+	// The data of the QByteArray is shared by the copies made when the hash grows
+	return it.value().constData();
+}
+
+void StelProfiler::clear()
+{
+	if (!ring)
+		return;
+	for (int i=0;i<RING_SIZE;++i)
+		ring[i].sequence.storeRelease(0);
+}
+
+QVariantMap StelProfiler::getStatistics()
+{
+	QHash<const char*, QVector<qint64> > durations;
+	foreach (const EventCopy& e, getEvents())
+		durations[e.name].append(e.duration);
+
+	QVariantMap statistics;
+	for (QHash<const char*, QVector<qint64> >::iterator it=durations.begin();it!=durations.end();++it)
+	{
+		QVector<qint64>& values = it.value();
+		std::sort(values.begin(), values.end());
+		qint64 sum = 0;
+		foreach (qint64 v, values)
+			sum += v;
+		QVariantMap map;
+		map["count"] = values.size();
+		map["mean"] = sum*1e-6/values.size();
+		map["p50"] = percentile(values, 50.);
+		map["p90"] = percentile(values, 90.);
+		map["p99"] = percentile(values, 99.);
+		map["max"] = values.last()*1e-6;
+		statistics[QString::fromUtf8(it.key())] = map;
+	}
+	return statistics;
+}
+
+bool StelProfiler::dumpChromeTrace(const QString& fileName)
+{
+	QVector<EventCopy> events = getEvents();
+	std::sort(events.begin(), events.end(), startLessThan);
+
+	// Small thread numbers are easier to read than the native ids
+	QHash<qint64, int> threadNumbers;
+	QJsonArray traceEvents;
+	foreach (const EventCopy& e, events)
+	{
+		QHash<qint64, int>::const_iterator it = threadNumbers.constFind(e.threadId);
+		if (it==threadNumbers.constEnd())
+			it = threadNumbers.insert(e.threadId, threadNumbers.size()+1);
+		QJsonObject event;
+		event["name"] = QString::fromUtf8(e.name);
+		event["cat"] = QString("stellarium");
+		event["ph"] = QString("X");
+		event["ts"] = e.start*1e-3;
+		event["dur"] = e.duration*1e-3;
+		event["pid"] = 1;
+		event["tid"] = it.value();
+		traceEvents.append(event);
+	}
+	QJsonObject trace;
+	trace["traceEvents"] = traceEvents;
+	trace["displayTimeUnit"] = QString("ms");
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning() << "StelProfiler: cannot write the trace file" << fileName;
+		return false;
+	}
+	file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+	qDebug() << "StelProfiler: wrote" << events.size() << "events to" << fileName;
+	return true;
+}
@@ -0,0 +1,94 @@
+/*
+ * Stellarium
+ * Copyright (C) 2015 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STELPROFILER_HPP_
+#define _STELPROFILER_HPP_
+
+#include <QAtomicInt>
+#include <QString>
+#include <QVariantMap>
+
+//! @class StelProfiler
+//! Records how long the instrumented scopes take, see StelProfileScope.
+//! The last events of all threads are kept in a fixed size ring buffer which is written without locks,
+//! so that the profiler can stay enabled on the target hardware.
+//! The statistics are computed on demand from the events in the ring buffer, i.e. over the last frames.
+class StelProfiler
+{
+public:
+	//! Start or stop recording. Nothing is recorded by default.
+	static void setEnabled(bool b);
+	static bool isEnabled() {return enabled.loadAcquire()!=0;}
+
+	//! Time in nanoseconds since the profiler was first enabled.
+	static qint64 now();
+
+	//! Add one event to the ring buffer. Can be called from any thread.
+	//! @param name the name of the scope, it must stay valid as long as the program runs.
+	//! @param start, end the times given by now().
+	static void record(const char* name, qint64 start, qint64 end);
+
+	//! Get a name suitable for record() from a dynamic string, e.g. a module name.
+	static const char* internName(const QString& name);
+
+	//! Remove all the recorded events.
+	static void clear();
+
+	//! Get the statistics of the recorded events by scope name.
+	//! Each value is a map with the number of events and the mean, 50th, 90th, 99th percentiles
+	//! and maximum durations in milliseconds: count, mean, p50, p90, p99, max.
+	static QVariantMap getStatistics();
+
+	//! Write the recorded events in the Chrome trace event format, for chrome://tracing.
+	//! @return false if the file could not be written.
+	static bool dumpChromeTrace(const QString& fileName);
+
+private:
+	//! Read by the scopes of all threads.
+	static QAtomicInt enabled;
+};
+
+//! @class StelProfileScope
+//! Record the time spent between its construction and its destruction when the profiler is enabled.
+//! Use the STEL_PROFILE_SCOPE macro at the beginning of the block to measure.
+class StelProfileScope
+{
+public:
+	//! @param aname the name of the scope, a literal or a name given by StelProfiler::internName().
+	//! Nothing is recorded if it is NULL.
+	StelProfileScope(const char* aname)
+		: name(StelProfiler::isEnabled() ? aname : NULL), start(name ? StelProfiler::now() : 0) {}
+	~StelProfileScope()
+	{
+		if (name)
+			StelProfiler::record(name, start, StelProfiler::now());
+	}
+
+private:
+	const char* name;
+	qint64 start;
+};
+
+//! Measure the enclosing block.
+//! The variable is named after the line, so that nested blocks can have their own scope.
+#define STEL_PROFILE_SCOPE(name) StelProfileScope STEL_PROFILE_CONCAT(stelProfileScope, __LINE__)(name)
+#define STEL_PROFILE_CONCAT(a, b) STEL_PROFILE_CONCAT_EXPANDED(a, b)
+#define STEL_PROFILE_CONCAT_EXPANDED(a, b) a##b
+
+#endif // _STELPROFILER_HPP_
@@ -82,6 +82,14 @@ Mat4d StelProjector::Mat4dTransform::getApproximateLinearTransfo() const
 	return transfoMat;
 }
 
+bool StelProjector::Mat4dTransform::getShaderTransfo(Mat4f& preTransfo, float& refractionCorr, Mat4f& postTransfo) const
+{
+	preTransfo = Mat4f::identity();
+	refractionCorr = -1.f;
+	postTransfo = transfoMatf;
+	return true;
+}
+
 StelProjector::ModelViewTranformP StelProjector::Mat4dTransform::clone() const
 {
 	return ModelViewTranformP(new Mat4dTransform(transfoMat));
@@ -469,6 +477,13 @@ Mat4f StelProjector::getProjectionMatrix() const
 	return Mat4f(2.f/viewportXywh[2], 0, 0, 0, 0, 2.f/viewportXywh[3], 0, 0, 0, 0, -1., 0., -(2.f*viewportXywh[0] + viewportXywh[2])/viewportXywh[2], -(2.f*viewportXywh[1] + viewportXywh[3])/viewportXywh[3], 0, 1);
 }
 
+void StelProjector::getViewportTransfo(Vec2f& center, Vec2f& scale, Vec2f& depth) const
+{
+	center = viewportCenter;
+	scale.set(flipHorz*pixelPerRad, flipVert*pixelPerRad);
+	depth.set(zNear, oneOverZNearMinusZFar);
+}
+
 StelProjector::StelProjectorMaskType StelProjector::getMaskType(void) const
 {
 	return maskType;
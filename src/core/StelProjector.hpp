@@ -25,6 +25,8 @@
 #include "VecMath.hpp"
 #include "StelSphereGeometry.hpp"
 
+#include <QByteArray>
+
 //! @class StelProjector
 //! Provide the main interface to all operations of projecting coordinates from sky to screen.
 //! The StelProjector also defines the viewport size and position.
@@ -61,6 +63,14 @@ public:
 		virtual ModelViewTranformP clone() const=0;
 
 		virtual Mat4d getApproximateLinearTransfo() const=0;
+
+		//! Decompose the transformation for a vertex shader into a first matrix, an optional
+		//! atmospheric refraction and a second matrix.
+		//! @param refractionCorr the pressure and temperature factor of the Saemundsson formula, negative for no refraction.
+		//! A factor of 0 still applies the constant term of the formula, like Refraction::forward().
+		//! @return false if the transformation can't be expressed this way
+		virtual bool getShaderTransfo(Mat4f& preTransfo, float& refractionCorr, Mat4f& postTransfo) const
+			{Q_UNUSED(preTransfo); Q_UNUSED(refractionCorr); Q_UNUSED(postTransfo); return false;}
 	};
 
 	class Mat4dTransform: public ModelViewTranform
@@ -73,6 +83,7 @@ public:
         void backward(Vec3f& v) const;
         void combine(const Mat4d& m);
         Mat4d getApproximateLinearTransfo() const;
+        bool getShaderTransfo(Mat4f& preTransfo, float& refractionCorr, Mat4f& postTransfo) const;
         ModelViewTranformP clone() const;
 
 	private:
@@ -265,6 +276,14 @@ public:
 	//! Get the current projection matrix.
 	Mat4f getProjectionMatrix() const;
 
+	//! Get the GLSL source of a function "bool projectorForward(inout vec3 v)" doing the same as forward().
+	//! @return an empty array if the projection has no vertex shader implementation.
+	virtual QByteArray getForwardShaderSource() const {return QByteArray();}
+
+	//! Get the viewport transformation applied by projectInPlace() after forward():
+	//! win = (center + scale*v.xy, (v.z-depth[0])*depth[1]).
+	void getViewportTransfo(Vec2f& center, Vec2f& scale, Vec2f& depth) const;
+
 	///////////////////////////////////////////////////////////////////////////
 	//! Get a string description of a StelProjectorMaskType.
 	static const QString maskTypeToString(StelProjectorMaskType type);
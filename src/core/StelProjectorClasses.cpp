@@ -57,6 +57,18 @@ float StelProjectorPerspective::deltaZoom(float fov) const
 	return vsf / (1.f+vsf*vsf);
 }
 
+QByteArray StelProjectorPerspective::getForwardShaderSource() const
+{
+	return "bool projectorForward(inout vec3 v)\n"
+	       "{\n"
+	       "    float r = length(v);\n"
+	       "    if (v.z < 0.) {v = vec3(v.xy/(-v.z), r); return true;}\n"
+	       "    if (v.z > 0.) {v = vec3(v.xy/v.z, r); return false;}\n"
+	       "    v = vec3(1e30, 1e30, r);\n"
+	       "    return false;\n"
+	       "}\n";
+}
+
 
 QString StelProjectorEqualArea::getNameI18() const
 {
@@ -103,6 +115,16 @@ float StelProjectorEqualArea::deltaZoom(float fov) const
 	return fov;
 }
 
+QByteArray StelProjectorEqualArea::getForwardShaderSource() const
+{
+	return "bool projectorForward(inout vec3 v)\n"
+	       "{\n"
+	       "    float r = length(v);\n"
+	       "    v = vec3(v.xy*sqrt(2./(r*(r-v.z))), r);\n"
+	       "    return true;\n"
+	       "}\n";
+}
+
 QString StelProjectorStereographic::getNameI18() const
 {
 	return q_("Stereographic");
@@ -137,6 +159,18 @@ float StelProjectorStereographic::deltaZoom(float fov) const
 	return 4.f*vsf / (4.f+vsf*vsf);
 }
 
+QByteArray StelProjectorStereographic::getForwardShaderSource() const
+{
+	return "bool projectorForward(inout vec3 v)\n"
+	       "{\n"
+	       "    float r = length(v);\n"
+	       "    float h = 0.5*(r-v.z);\n"
+	       "    if (h <= 0.) {v = vec3(1e30, 1e30, 0.); return false;}\n"
+	       "    v = vec3(v.xy/h, r);\n"
+	       "    return true;\n"
+	       "}\n";
+}
+
 
 
 
@@ -175,6 +209,23 @@ float StelProjectorFisheye::deltaZoom(float fov) const
 	return fov;
 }
 
+QByteArray StelProjectorFisheye::getForwardShaderSource() const
+{
+	return "bool projectorForward(inout vec3 v)\n"
+	       "{\n"
+	       "    float rq1 = dot(v.xy, v.xy);\n"
+	       "    if (rq1 > 0.)\n"
+	       "    {\n"
+	       "        float h = sqrt(rq1);\n"
+	       "        v = vec3(v.xy*(atan(h, -v.z)/h), sqrt(rq1 + v.z*v.z));\n"
+	       "        return true;\n"
+	       "    }\n"
+	       "    if (v.z < 0.) {v = vec3(0., 0., 1.); return true;}\n"
+	       "    v = vec3(1e30, 1e30, 0.);\n"
+	       "    return false;\n"
+	       "}\n";
+}
+
 
 
 QString StelProjectorHammer::getNameI18() const
@@ -54,6 +54,7 @@ public:
 	float fovToViewScalingFactor(float fov) const;
 	float viewScalingFactorToFov(float vsf) const;
 	float deltaZoom(float fov) const;
+	QByteArray getForwardShaderSource() const;
 protected:
 	virtual bool hasDiscontinuity() const {return false;}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d&, const Vec3d&) const {return false;}
@@ -80,6 +81,7 @@ public:
 	float fovToViewScalingFactor(float fov) const;
 	float viewScalingFactorToFov(float vsf) const;
 	float deltaZoom(float fov) const;
+	QByteArray getForwardShaderSource() const;
 protected:
 	virtual bool hasDiscontinuity() const {return false;}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d&, const Vec3d&) const {return false;}
@@ -129,6 +131,7 @@ public:
 	float fovToViewScalingFactor(float fov) const;
 	float viewScalingFactorToFov(float vsf) const;
 	float deltaZoom(float fov) const;
+	QByteArray getForwardShaderSource() const;
 protected:
 	virtual bool hasDiscontinuity() const {return false;}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d&, const Vec3d&) const {return false;}
@@ -168,6 +171,7 @@ public:
 	float fovToViewScalingFactor(float fov) const;
 	float viewScalingFactorToFov(float vsf) const;
 	float deltaZoom(float fov) const;
+	QByteArray getForwardShaderSource() const;
 protected:
 	virtual bool hasDiscontinuity() const {return false;}
 	virtual bool intersectViewportDiscontinuityInternal(const Vec3d&, const Vec3d&) const {return false;}
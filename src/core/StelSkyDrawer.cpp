@@ -25,6 +25,8 @@
 #endif
 
 #include <QOpenGLShaderProgram>
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
 
 #include "StelSkyDrawer.hpp"
 #include "StelProjector.hpp"
@@ -43,6 +45,8 @@
 #include <QDebug>
 #include <QtGlobal>
 
+#include <cstddef>
+
 // The 0.025 corresponds to the maximum eye resolution in degree
 #define EYE_RESOLUTION (0.25f)
 #define MAX_LINEAR_RADIUS 8.f
@@ -75,6 +79,7 @@ StelSkyDrawer::StelSkyDrawer(StelCore* acore) : core(acore)
 	setMaxAdaptFov(conf->value("stars/mag_converter_max_fov",70.0).toFloat());
 	setMinAdaptFov(conf->value("stars/mag_converter_min_fov",0.1).toFloat());
 	setFlagLuminanceAdaptation(conf->value("viewing/use_luminance_adaptation",true).toBool());
+	setFlagPointSourceBuffers(conf->value("stars/flag_point_source_buffers",false).toBool());
 	setFlagStarMagnitudeLimit((conf->value("astro/flag_star_magnitude_limit", false).toBool()));
 	setCustomStarMagnitudeLimit(conf->value("astro/star_magnitude_limit", 6.5).toFloat());
 	setFlagNebulaMagnitudeLimit((conf->value("astro/flag_nebula_magnitude_limit", false).toBool()));
@@ -114,6 +119,8 @@ StelSkyDrawer::StelSkyDrawer(StelCore* acore) : core(acore)
 	if (!ok)
 		setAtmospherePressure(1013.0);
 
+	currentPointBufferShader = NULL;
+
 	// Initialize buffers for use by gl vertex array
 	nbPointSources = 0;
 	maxPointSources = 1000;
@@ -139,6 +146,9 @@ StelSkyDrawer::~StelSkyDrawer()
 	
 	delete starShaderProgram;
 	starShaderProgram = NULL;
+
+	foreach (const PointBufferShader& shader, pointBufferShaders)
+		delete shader.program;
 }
 
 // Init parameters from config file
@@ -381,6 +391,8 @@ void StelSkyDrawer::postDrawPointSource(StelPainter* sPainter)
 
 	if (nbPointSources==0)
 		return;
+	// The labels queued before must stay below the stars, as when they were drawn immediately
+	sPainter->flushText();
 	texHalo->bind();
 	sPainter->enableTexture2d(true);
 	glBlendFunc(GL_ONE, GL_ONE);
@@ -466,6 +478,292 @@ bool StelSkyDrawer::drawPointSource(StelPainter* sPainter, const Vec3f& v, const
 }
 
 
+float StelSkyDrawer::getBigHaloMinRadius()
+{
+	return MAX_LINEAR_RADIUS+5.f;
+}
+
+void StelSkyDrawer::setPointSourceVertexColor(PointSourceVertex& vertex, unsigned int bV)
+{
+	const Vec3f& color = colorTable[bV];
+	for (int i=0;i<3;++i)
+		vertex.color[i] = (unsigned char)std::min((int)(color[i]*255+0.5f), 255);
+	vertex.color[3] = 255;
+}
+
+bool StelSkyDrawer::canDrawPointSourceBuffers(const StelProjectorP& prj)
+{
+	if (!flagPointSourceBuffers)
+		return false;
+	Mat4f preTransfo, postTransfo;
+	float refractionCorr;
+	if (!prj->getModelViewTransform()->getShaderTransfo(preTransfo, refractionCorr, postTransfo))
+		return false;
+	const QByteArray forwardSource = prj->getForwardShaderSource();
+	return !forwardSource.isEmpty() && getPointBufferShader(forwardSource)->program!=NULL;
+}
+
+StelSkyDrawer::PointBufferShader* StelSkyDrawer::getPointBufferShader(const QByteArray& forwardSource)
+{
+	QHash<QByteArray, PointBufferShader>::iterator it = pointBufferShaders.find(forwardSource);
+	if (it!=pointBufferShaders.end())
+		return &it.value();
+
+	PointBufferShader& shader = pointBufferShaders[forwardSource];
+	memset(&shader, 0, sizeof(PointBufferShader));
+
+	// Same computations as StelProjector::projectInPlace(), Refraction::forward(),
+	// Extinction::forward() and computeRCMag(), one vertex per source drawn as a point sprite.
+	// gl_PointCoord needs GLSL 1.20 on desktop openGL
+	const QByteArray version = QOpenGLContext::currentContext()->isOpenGLES() ? "#version 100\n" : "#version 120\n";
+	QByteArray vsrc = version +
+		"attribute highp vec3 pos;\n"
+		"attribute highp vec3 motion;\n"
+		"attribute mediump float mag;\n"
+		"attribute mediump vec3 color;\n"
+		"uniform highp mat4 projectionMatrix;\n"
+		"uniform highp mat4 preTransfo;\n"
+		"uniform highp float refractionCorr;\n"
+		"uniform highp mat4 postTransfo;\n"
+		"uniform highp vec2 viewportCenter;\n"
+		"uniform highp vec2 viewportScale;\n"
+		"uniform highp float movementFactor;\n"
+		"uniform mediump vec2 radiusMagFactors;\n"
+		"uniform mediump float radiusScale;\n"
+		"uniform mediump float maxLinearRadius;\n"
+		"uniform highp vec3 altRow;\n"
+		"uniform mediump float extinctionCoeff;\n"
+		"uniform mediump float undergroundExtinctionMode;\n"
+		"uniform mediump float cutoffMag;\n"
+		"uniform mediump float twinkleAmount;\n"
+		"uniform highp float twinkleSeed;\n"
+		"varying mediump vec3 outColor;\n"
+		+ forwardSource +
+		"float refractionAltitude(float alt)\n"
+		"{\n"
+		"    return refractionCorr/tan(radians(alt + 10.3/(alt + 5.11))) + 0.0019279;\n"
+		"}\n"
+		"vec3 applyRefraction(vec3 v)\n"
+		"{\n"
+		"    if (refractionCorr < 0.)\n"
+		"        return v;\n"
+		"    float len = length(v);\n"
+		"    float alt = degrees(asin(clamp(v.z/len, -1., 1.)));\n"
+		"    if (alt > -3.54)\n"
+		"        v.z = sin(radians(min(alt + refractionAltitude(alt), 90.)))*len;\n"
+		"    else if (alt > -5.)\n"
+		"        v.z = sin(radians(alt + refractionAltitude(-3.54)*(alt + 5.)/1.46))*len;\n"
+		"    return v;\n"
+		"}\n"
+		"float airmass(float cosZ)\n"
+		"{\n"
+		"    if (cosZ < -0.035)\n"
+		"    {\n"
+		"        if (undergroundExtinctionMode < 0.5)\n"
+		"            return 0.;\n"
+		"        if (undergroundExtinctionMode < 1.5)\n"
+		"            return 42.;\n"
+		"        cosZ = min(1., -0.035 - (cosZ + 0.035));\n"
+		"    }\n"
+		"    return ((1.002432*cosZ + 0.148386)*cosZ + 0.0096467) / (((cosZ + 0.149864)*cosZ + 0.0102963)*cosZ + 0.000303978);\n"
+		"}\n"
+		"void main(void)\n"
+		"{\n"
+		"    vec3 v = pos + movementFactor*motion;\n"
+		"    float m = mag;\n"
+		"    if (extinctionCoeff > 0.)\n"
+		"        m += airmass(dot(altRow, normalize(v)))*extinctionCoeff;\n"
+		"    float radius = exp(radiusMagFactors.x*m + radiusMagFactors.y);\n"
+		"    float luminance = 1.;\n"
+		"    if (radius < 1.2)\n"
+		"    {\n"
+		"        luminance = radius*radius*radius/1.728;\n"
+		"        radius = (radius < 0.3 || luminance < 0.05) ? 0. : 1.2;\n"
+		"    }\n"
+		"    else if (radius > maxLinearRadius)\n"
+		"        radius = maxLinearRadius + sqrt(1. + radius - maxLinearRadius) - 1.;\n"
+		"    radius *= radiusScale;\n"
+		"    vec3 w = (postTransfo*vec4(applyRefraction((preTransfo*vec4(v, 1.)).xyz), 1.)).xyz;\n"
+		"    if (!projectorForward(w) || radius <= 0. || m > cutoffMag)\n"
+		"    {\n"
+		"        gl_Position = vec4(2., 2., 2., 1.);\n"
+		"        gl_PointSize = 0.;\n"
+		"        outColor = vec3(0.);\n"
+		"        return;\n"
+		"    }\n"
+		"    gl_Position = projectionMatrix*vec4(viewportCenter + viewportScale*w.xy, 0., 1.);\n"
+		"    gl_PointSize = 2.*radius;\n"
+		"    float tw = 1. - twinkleAmount*fract(sin(dot(pos.xy + vec2(twinkleSeed), vec2(12.9898, 78.233)))*43758.5453);\n"
+		"    outColor = color*(luminance*tw/255.);\n"
+		"}\n";
+	QOpenGLShader vshader(QOpenGLShader::Vertex);
+	vshader.compileSourceCode(vsrc);
+	if (!vshader.log().isEmpty()) { qWarning() << "StelSkyDrawer::getPointBufferShader(): Warnings while compiling vshader: " << vshader.log(); }
+
+	QOpenGLShader fshader(QOpenGLShader::Fragment);
+	const QByteArray fsrc = version +
+		"#ifdef GL_ES\n"
+		"precision mediump float;\n"
+		"#endif\n"
+		"varying mediump vec3 outColor;\n"
+		"uniform sampler2D tex;\n"
+		"void main(void)\n"
+		"{\n"
+		"    gl_FragColor = texture2D(tex, gl_PointCoord)*vec4(outColor, 1.);\n"
+		"}\n";
+	fshader.compileSourceCode(fsrc);
+	if (!fshader.log().isEmpty()) { qWarning() << "StelSkyDrawer::getPointBufferShader(): Warnings while compiling fshader: " << fshader.log(); }
+
+	if (!vshader.isCompiled() || !fshader.isCompiled())
+	{
+		qWarning() << "StelSkyDrawer: point source buffers disabled for this projection";
+		return &shader;
+	}
+
+	shader.program = new QOpenGLShaderProgram(QOpenGLContext::currentContext());
+	shader.program->addShader(&vshader);
+	shader.program->addShader(&fshader);
+	if (!shader.program->link())
+	{
+		qWarning() << "StelSkyDrawer: point source buffers disabled for this projection: " << shader.program->log();
+		delete shader.program;
+		shader.program = NULL;
+		return &shader;
+	}
+	shader.pos = shader.program->attributeLocation("pos");
+	shader.motion = shader.program->attributeLocation("motion");
+	shader.mag = shader.program->attributeLocation("mag");
+	shader.color = shader.program->attributeLocation("color");
+	shader.projectionMatrix = shader.program->uniformLocation("projectionMatrix");
+	shader.preTransfo = shader.program->uniformLocation("preTransfo");
+	shader.refractionCorr = shader.program->uniformLocation("refractionCorr");
+	shader.postTransfo = shader.program->uniformLocation("postTransfo");
+	shader.viewportCenter = shader.program->uniformLocation("viewportCenter");
+	shader.viewportScale = shader.program->uniformLocation("viewportScale");
+	shader.movementFactor = shader.program->uniformLocation("movementFactor");
+	shader.radiusMagFactors = shader.program->uniformLocation("radiusMagFactors");
+	shader.radiusScale = shader.program->uniformLocation("radiusScale");
+	shader.maxLinearRadius = shader.program->uniformLocation("maxLinearRadius");
+	shader.altRow = shader.program->uniformLocation("altRow");
+	shader.extinctionCoeff = shader.program->uniformLocation("extinctionCoeff");
+	shader.undergroundExtinctionMode = shader.program->uniformLocation("undergroundExtinctionMode");
+	shader.cutoffMag = shader.program->uniformLocation("cutoffMag");
+	shader.twinkleAmount = shader.program->uniformLocation("twinkleAmount");
+	shader.twinkleSeed = shader.program->uniformLocation("twinkleSeed");
+	shader.texture = shader.program->uniformLocation("tex");
+	return &shader;
+}
+
+// Convert a Mat4f to the row major QMatrix4x4
+static QMatrix4x4 toQMatrix(const Mat4f& m)
+{
+	return QMatrix4x4(m[0], m[4], m[8], m[12], m[1], m[5], m[9], m[13], m[2], m[6], m[10], m[14], m[3], m[7], m[11], m[15]);
+}
+
+void StelSkyDrawer::preDrawPointSourceBuffers(StelPainter* sPainter, float movementFactor, float cutoffMag, float radiusScale)
+{
+	Q_ASSERT(sPainter);
+	Q_ASSERT(currentPointBufferShader==NULL);
+	sPainter->flushText();
+	const StelProjectorP prj = sPainter->getProjector();
+	currentPointBufferShader = getPointBufferShader(prj->getForwardShaderSource());
+	Q_ASSERT(currentPointBufferShader->program);
+
+	Mat4f preTransfo, postTransfo;
+	float refractionCorr;
+	prj->getModelViewTransform()->getShaderTransfo(preTransfo, refractionCorr, postTransfo);
+	Vec2f viewportCenter, viewportScale, depth;
+	prj->getViewportTransfo(viewportCenter, viewportScale, depth);
+
+	// ln(radius) of computeRCMag() before clamping is linear in the magnitude
+	const float radius0 = eye->adaptLuminanceScaledLn(pointSourceMagToLnLuminance(0.f), starRelativeScale*1.40f/2.f)*starLinearScale;
+	const float radius1 = eye->adaptLuminanceScaledLn(pointSourceMagToLnLuminance(1.f), starRelativeScale*1.40f/2.f)*starLinearScale;
+	const float lnRadius0 = std::log(qMax(radius0, 1e-30f));
+	const float lnRadius1 = std::log(qMax(radius1, 1e-30f));
+
+	// The extinction only needs sin(altitude), i.e. the third row of the J2000->AltAz rotation.
+	const bool withExtinction = flagHasAtmosphere && extinction.getExtinctionCoefficient()>=0.01f;
+	Vec3f altRow(0.f);
+	if (withExtinction)
+	{
+		for (int j=0;j<3;++j)
+		{
+			Vec3f axis(0.f);
+			axis[j] = 1.f;
+			core->j2000ToAltAzInPlaceNoRefraction(&axis);
+			altRow[j] = axis[2];
+		}
+	}
+
+	texHalo->bind();
+	sPainter->enableTexture2d(true);
+	glBlendFunc(GL_ONE, GL_ONE);
+	glEnable(GL_BLEND);
+	if (!QOpenGLContext::currentContext()->isOpenGLES())
+	{
+		glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+		glEnable(GL_POINT_SPRITE);
+	}
+
+	QOpenGLShaderProgram* program = currentPointBufferShader->program;
+	program->bind();
+	program->setUniformValue(currentPointBufferShader->projectionMatrix, toQMatrix(prj->getProjectionMatrix()));
+	program->setUniformValue(currentPointBufferShader->preTransfo, toQMatrix(preTransfo));
+	program->setUniformValue(currentPointBufferShader->refractionCorr, refractionCorr);
+	program->setUniformValue(currentPointBufferShader->postTransfo, toQMatrix(postTransfo));
+	program->setUniformValue(currentPointBufferShader->viewportCenter, viewportCenter[0], viewportCenter[1]);
+	program->setUniformValue(currentPointBufferShader->viewportScale, viewportScale[0], viewportScale[1]);
+	program->setUniformValue(currentPointBufferShader->movementFactor, movementFactor);
+	program->setUniformValue(currentPointBufferShader->radiusMagFactors, lnRadius1-lnRadius0, lnRadius0);
+	program->setUniformValue(currentPointBufferShader->radiusScale, radiusScale);
+	program->setUniformValue(currentPointBufferShader->maxLinearRadius, MAX_LINEAR_RADIUS);
+	program->setUniformValue(currentPointBufferShader->altRow, altRow[0], altRow[1], altRow[2]);
+	program->setUniformValue(currentPointBufferShader->extinctionCoeff, withExtinction ? extinction.getExtinctionCoefficient() : 0.f);
+	program->setUniformValue(currentPointBufferShader->undergroundExtinctionMode, (GLfloat)extinction.getUndergroundExtinctionMode());
+	program->setUniformValue(currentPointBufferShader->cutoffMag, cutoffMag);
+	program->setUniformValue(currentPointBufferShader->twinkleAmount, (flagStarTwinkle && flagHasAtmosphere) ? twinkleAmount : 0.f);
+	program->setUniformValue(currentPointBufferShader->twinkleSeed, (GLfloat)rand()/RAND_MAX);
+	program->setUniformValue(currentPointBufferShader->texture, 0);
+	program->enableAttributeArray(currentPointBufferShader->pos);
+	program->enableAttributeArray(currentPointBufferShader->motion);
+	program->enableAttributeArray(currentPointBufferShader->mag);
+	program->enableAttributeArray(currentPointBufferShader->color);
+}
+
+void StelSkyDrawer::drawPointSourceBuffer(QOpenGLBuffer& buffer, int first, int count)
+{
+	Q_ASSERT(currentPointBufferShader);
+	if (count<=0)
+		return;
+
+	Q_ASSERT(sizeof(PointSourceVertex)==32);
+	QOpenGLShaderProgram* program = currentPointBufferShader->program;
+	buffer.bind();
+	program->setAttributeBuffer(currentPointBufferShader->pos, GL_FLOAT, offsetof(PointSourceVertex, pos), 3, sizeof(PointSourceVertex));
+	program->setAttributeBuffer(currentPointBufferShader->motion, GL_FLOAT, offsetof(PointSourceVertex, motion), 3, sizeof(PointSourceVertex));
+	program->setAttributeBuffer(currentPointBufferShader->mag, GL_FLOAT, offsetof(PointSourceVertex, mag), 1, sizeof(PointSourceVertex));
+	program->setAttributeBuffer(currentPointBufferShader->color, GL_UNSIGNED_BYTE, offsetof(PointSourceVertex, color), 3, sizeof(PointSourceVertex));
+	glDrawArrays(GL_POINTS, first, count);
+	buffer.release();
+}
+
+void StelSkyDrawer::postDrawPointSourceBuffers()
+{
+	Q_ASSERT(currentPointBufferShader);
+	QOpenGLShaderProgram* program = currentPointBufferShader->program;
+	program->disableAttributeArray(currentPointBufferShader->pos);
+	program->disableAttributeArray(currentPointBufferShader->motion);
+	program->disableAttributeArray(currentPointBufferShader->mag);
+	program->disableAttributeArray(currentPointBufferShader->color);
+	program->release();
+	if (!QOpenGLContext::currentContext()->isOpenGLES())
+	{
+		glDisable(GL_POINT_SPRITE);
+		glDisable(GL_VERTEX_PROGRAM_POINT_SIZE);
+	}
+	currentPointBufferShader = NULL;
+}
+
 // Terminate drawing of a 3D model, draw the halo
 void StelSkyDrawer::postDrawSky3dModel(StelPainter* painter, const Vec3f& v, float illuminatedArea, float mag, const Vec3f& color)
 {
@@ -26,10 +26,14 @@
 #include "RefractionExtinction.hpp"
 
 #include <QObject>
+#include <QHash>
+#include <QByteArray>
 
 class StelToneReproducer;
 class StelCore;
 class StelPainter;
+class QOpenGLBuffer;
+class QOpenGLShaderProgram;
 
 //! Contains the 2 parameters necessary to draw a star on screen.
 //! the radius and luminance of the star halo texture.
@@ -78,6 +82,41 @@ public:
 
 	bool drawPointSource(StelPainter* sPainter, const Vec3f& v, const RCMag &rcMag, const Vec3f& bcolor, bool checkInScreen=false);
 
+	//! Static attributes of a point source stored in a persistent vertex buffer.
+	//! The J2000 position at a given date is pos + movementFactor*motion.
+	struct PointSourceVertex
+	{
+		Vec3f pos;
+		Vec3f motion;
+		float mag;
+		unsigned char color[4];
+	};
+
+	//! Fill the color of a PointSourceVertex from a B-V index.
+	static void setPointSourceVertexColor(PointSourceVertex& vertex, unsigned int bV);
+
+	//! Get whether point sources stored in vertex buffers can be drawn with the given projector.
+	//! This is false if the buffers are disabled in the configuration, if the shader failed to
+	//! compile or if the projection or its model view transformation has no shader implementation.
+	bool canDrawPointSourceBuffers(const StelProjectorP& prj);
+
+	//! Set the proper openGL state and shader uniforms before calls to drawPointSourceBuffer().
+	//! Projection, extinction, magnitude to radius conversion and twinkling all happen in the vertex shader.
+	//! canDrawPointSourceBuffers() must have returned true for the painter's projector.
+	//! @param movementFactor the factor applied to the motion of the vertices
+	//! @param cutoffMag the sources fainter than this magnitude after extinction are not drawn
+	//! @param radiusScale factor applied to the halo radius of all the sources, e.g. for fading
+	void preDrawPointSourceBuffers(StelPainter* sPainter, float movementFactor, float cutoffMag, float radiusScale=1.f);
+
+	//! Draw @a count point sources starting at vertex @a first of a buffer filled with PointSourceVertex.
+	void drawPointSourceBuffer(QOpenGLBuffer& buffer, int first, int count);
+
+	//! Restore the openGL state after the calls to drawPointSourceBuffer().
+	void postDrawPointSourceBuffers();
+
+	//! Get the halo radius above which drawPointSource() also draws the big halo texture.
+	static float getBigHaloMinRadius();
+
 	//! Terminate drawing of a 3D model, draw the halo
 	//! @param p the StelPainter instance to use for this drawing operation
 	//! @param v the 3d position of the source in J2000 reference frame
@@ -139,6 +178,11 @@ public slots:
 	//! Get source twinkle amount.
 	float getTwinkleAmount() const {return twinkleAmount;}
 
+	//! Set whether point sources may be drawn from persistent vertex buffers, see canDrawPointSourceBuffers().
+	void setFlagPointSourceBuffers(bool b) {flagPointSourceBuffers=b;}
+	//! Get whether point sources may be drawn from persistent vertex buffers.
+	bool getFlagPointSourceBuffers() const {return flagPointSourceBuffers;}
+
 	//! Set flag for source twinkling.
 	void setFlagTwinkle(bool b) {flagStarTwinkle=b;}
 	//! Get flag for source twinkling.
@@ -359,6 +403,42 @@ private:
 	//! Maximum number of sources which can be stored in the buffers
 	unsigned int maxPointSources;
 
+	//! Whether point sources may be drawn from persistent vertex buffers
+	bool flagPointSourceBuffers;
+
+	//! Shader drawing point sources from persistent vertex buffers, one per projection
+	struct PointBufferShader {
+		QOpenGLShaderProgram* program;
+		int pos;
+		int motion;
+		int mag;
+		int color;
+		int projectionMatrix;
+		int preTransfo;
+		int refractionCorr;
+		int postTransfo;
+		int viewportCenter;
+		int viewportScale;
+		int movementFactor;
+		int radiusMagFactors;
+		int radiusScale;
+		int maxLinearRadius;
+		int altRow;
+		int extinctionCoeff;
+		int undergroundExtinctionMode;
+		int cutoffMag;
+		int twinkleAmount;
+		int twinkleSeed;
+		int texture;
+	};
+	//! Shaders keyed by the GLSL source of the projection, NULL program if it failed to link
+	QHash<QByteArray, PointBufferShader> pointBufferShaders;
+	//! Shader used between preDrawPointSourceBuffers() and postDrawPointSourceBuffers()
+	PointBufferShader* currentPointBufferShader;
+
+	//! Get or build the point buffer shader for the projection with the given GLSL source.
+	PointBufferShader* getPointBufferShader(const QByteArray& forwardSource);
+
 	//! The maximum transformed luminance to apply at the next update
 	float maxLum;
 	//! The previously used world luminance
@@ -0,0 +1,376 @@
+/*
+ * Stellarium
+ * Copyright (C) 2015 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelSkyImageIndex.hpp"
+#include "MultiLevelJsonBase.hpp"
+#include "StelFileMgr.hpp"
+#include "StelUtils.hpp"
+#include "VecMath.hpp"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QPair>
+#include <QVector>
+
+#include <cstring>
+#include <stdexcept>
+
+const char* StelSkyImageIndex::FileExtension = ".stsi";
+
+namespace
+{
+const char Magic[4] = {'S', 'T', 'S', 'I'};
+const quint32 ByteOrderMark = 0x01020304;
+const quint32 Version = 1;
+
+quint32 align8(quint32 offset)
+{
+	return (offset+7) & ~7u;
+}
+
+// Load a local JSON file, relative to the search paths or to the directory of the file referring to it
+QVariantMap loadJsonFile(const QString& url, const QString& referrerDir, QString& dir)
+{
+	if (url.startsWith("http://"))
+		throw std::runtime_error(qPrintable(QString("remote JSON files are not supported: %1").arg(url)));
+	QString fileName = StelFileMgr::findFile(url);
+	if (fileName.isEmpty() && !referrerDir.isEmpty())
+		fileName = StelFileMgr::findFile(referrerDir+url);
+	if (fileName.isEmpty())
+		throw std::runtime_error(qPrintable(QString("can't find JSON description: %1").arg(url)));
+	QFile f(fileName);
+	if (!f.open(QIODevice::ReadOnly))
+		throw std::runtime_error(qPrintable(QString("can't open %1").arg(fileName)));
+	dir = QFileInfo(fileName).absolutePath()+'/';
+	return MultiLevelJsonBase::loadFromJSON(f, fileName.endsWith(".qZ"), fileName.endsWith(".gz"));
+}
+
+float toFloat(const QVariant& v, const char* name)
+{
+	bool ok;
+	const float f = v.toFloat(&ok);
+	if (!ok)
+		throw std::runtime_error(qPrintable(QString("%1 expect a float value, found: \"%2\"").arg(name).arg(v.toString())));
+	return f;
+}
+
+// The strings of the index, shared when they are repeated
+class StringTable
+{
+public:
+	StringTable() : data(1, '\0') {}
+	quint32 add(const QString& s)
+	{
+		if (s.isEmpty())
+			return 0;
+		QHash<QString, quint32>::const_iterator it = offsets.constFind(s);
+		if (it!=offsets.constEnd())
+			return it.value();
+		const quint32 offset = data.size();
+		data.append(s.toUtf8());
+		data.append('\0');
+		offsets.insert(s, offset);
+		return offset;
+	}
+	QByteArray data;
+private:
+	QHash<QString, quint32> offsets;
+};
+}
+
+struct StelSkyImageIndex::Header
+{
+	char magic[4];
+	quint32 byteOrder;
+	quint32 version;
+	quint32 tileCount;
+	quint32 polygonCount;
+	quint32 stringsSize;
+	quint32 tilesOffset;
+	quint32 polygonsOffset;
+	quint32 stringsOffset;
+	quint32 rootStrings[RootStringCount];
+	quint32 reserved;
+};
+
+StelSkyImageIndex::StelSkyImageIndex() : data(NULL), size(0), header(NULL), tiles(NULL), tileCount(0),
+	polygons(NULL), polygonCount(0), strings(NULL), stringsSize(0)
+{
+}
+
+StelSkyImageIndex::~StelSkyImageIndex()
+{
+	// The mapping is removed when the file is closed
+	file.close();
+}
+
+StelSkyImageIndexP StelSkyImageIndex::open(const QString& fileName)
+{
+	StelSkyImageIndexP index(new StelSkyImageIndex());
+	if (!index->load(fileName))
+	{
+		qWarning() << "WARNING : Invalid sky image index: " << QDir::toNativeSeparators(fileName);
+		return StelSkyImageIndexP();
+	}
+	return index;
+}
+
+bool StelSkyImageIndex::load(const QString& fileName)
+{
+	file.setFileName(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+	size = file.size();
+	if (size<(qint64)sizeof(Header))
+		return false;
+	data = file.map(0, size);
+	if (!data)
+	{
+		memoryData.resize((size+7)/8);
+		if (file.read(reinterpret_cast<char*>(memoryData.data()), size)!=size)
+			return false;
+		file.close();
+		data = reinterpret_cast<const uchar*>(memoryData.constData());
+	}
+	baseDir = QFileInfo(fileName).absolutePath()+'/';
+
+	header = reinterpret_cast<const Header*>(data);
+	if (memcmp(header->magic, Magic, 4)!=0 || header->byteOrder!=ByteOrderMark || header->version!=Version)
+		return false;
+	tileCount = header->tileCount;
+	polygonCount = header->polygonCount;
+	stringsSize = header->stringsSize;
+	if (tileCount==0 || stringsSize==0 || header->tilesOffset%8!=0 || header->polygonsOffset%8!=0)
+		return false;
+	if ((quint64)header->tilesOffset+(quint64)tileCount*sizeof(Tile)>(quint64)size
+		|| (quint64)header->polygonsOffset+(quint64)polygonCount*sizeof(Polygon)>(quint64)size
+		|| (quint64)header->stringsOffset+stringsSize>(quint64)size)
+		return false;
+	tiles = reinterpret_cast<const Tile*>(data+header->tilesOffset);
+	polygons = reinterpret_cast<const Polygon*>(data+header->polygonsOffset);
+	strings = reinterpret_cast<const char*>(data+header->stringsOffset);
+
+	// All the strings are terminated
+	if (strings[0]!='\0' || strings[stringsSize-1]!='\0')
+		return false;
+	for (int i=0;i<RootStringCount;++i)
+	{
+		if (header->rootStrings[i]>=stringsSize)
+			return false;
+	}
+	// The children always follow their parent, so that the tree has no cycle
+	for (quint32 i=0;i<tileCount;++i)
+	{
+		const Tile& t = tiles[i];
+		if (t.shortName>=stringsSize || t.imagePath>=stringsSize
+			|| (quint64)t.firstPolygon+t.polygonCount>polygonCount
+			|| (t.childCount>0 && (t.firstChild<=i || (quint64)t.firstChild+t.childCount>tileCount)))
+			return false;
+	}
+	return true;
+}
+
+QString StelSkyImageIndex::getRootString(RootString s) const
+{
+	return getString(header->rootStrings[s]);
+}
+
+bool StelSkyImageIndex::convertFromJson(const QString& jsonFileName, const QString& indexFileName)
+{
+	const QDir indexDir = QFileInfo(indexFileName).absoluteDir();
+	Header header;
+	memset(&header, 0, sizeof(header));
+	QVector<Tile> tiles;
+	QVector<Polygon> polygons;
+	StringTable strings;
+
+	try
+	{
+		// The tiles to convert in breadth first order, with the directory of the JSON file they come from
+		QList<QPair<QVariantMap, QString> > queue;
+		QString dir;
+		const QVariantMap rootMap = loadJsonFile(jsonFileName, QString(), dir);
+		queue.append(qMakePair(rootMap, dir));
+
+		header.rootStrings[Description] = strings.add(rootMap.value("description").toString());
+		const QVariantMap imageCredits = rootMap.value("imageCredits").toMap();
+		header.rootStrings[ImageCreditsShort] = strings.add(imageCredits.value("short").toString());
+		header.rootStrings[ImageCreditsFull] = strings.add(imageCredits.value("full").toString());
+		header.rootStrings[ImageCreditsInfoUrl] = strings.add(imageCredits.value("infoUrl").toString());
+		const QVariantMap serverCredits = rootMap.value("serverCredits").toMap();
+		header.rootStrings[ServerCreditsShort] = strings.add(serverCredits.value("short").toString());
+		header.rootStrings[ServerCreditsFull] = strings.add(serverCredits.value("full").toString());
+		header.rootStrings[ServerCreditsInfoUrl] = strings.add(serverCredits.value("infoUrl").toString());
+
+		for (int i=0;i<queue.size();++i)
+		{
+			// Free the maps as soon as they are converted
+			const QVariantMap map = queue[i].first;
+			const QString mapDir = queue[i].second;
+			queue[i] = QPair<QVariantMap, QString>();
+
+			Tile t;
+			memset(&t, 0, sizeof(t));
+			t.shortName = strings.add(map.value("shortName").toString());
+			if (!map.contains("minResolution"))
+				throw std::runtime_error("minResolution is mandatory");
+			t.minResolution = toFloat(map.value("minResolution"), "minResolution");
+			if (map.contains("luminance"))
+			{
+				t.brightness = toFloat(map.value("luminance"), "luminance");
+				t.flags |= TileHasLuminance;
+			}
+			if (map.contains("maxBrightness"))
+			{
+				t.brightness = toFloat(map.value("maxBrightness"), "maxBrightness");
+				t.flags = (t.flags & ~TileHasLuminance) | TileHasMaxBrightness;
+			}
+			if (map.contains("alphaBlend"))
+				t.flags |= TileHasAlphaBlend | (map.value("alphaBlend").toBool() ? TileAlphaBlend : 0);
+
+			// Same polygon keys as StelSkyImageTile::loadFromQVariantMap()
+			QVariantList polyList = map.value("skyConvexPolygons").toList();
+			if (polyList.empty())
+				polyList = map.value("worldCoords").toList();
+			const QVariantList texCoordList = map.value("textureCoords").toList();
+			if (!texCoordList.isEmpty())
+			{
+				if (polyList.size()!=texCoordList.size())
+					throw std::runtime_error("the number of convex polygons does not match the number of texture space polygon");
+				t.flags |= TileHasTextureCoords;
+			}
+			t.firstPolygon = polygons.size();
+			t.polygonCount = polyList.size();
+			for (int p=0;p<polyList.size();++p)
+			{
+				Polygon poly;
+				memset(&poly, 0, sizeof(poly));
+				const QVariantList raDecList = polyList.at(p).toList();
+				if (raDecList.size()!=4)
+					throw std::runtime_error("the polygons must have 4 vertices");
+				for (int v=0;v<4;++v)
+				{
+					const QVariantList vl = raDecList.at(v).toList();
+					if (vl.size()!=2)
+						throw std::runtime_error("wrong Ra and Dec, expect 2 values");
+					Vec3d vertex;
+					StelUtils::spheToRect(toFloat(vl.at(0), "Ra")*M_PI/180.f, toFloat(vl.at(1), "Dec")*M_PI/180.f, vertex);
+					for (int k=0;k<3;++k)
+						poly.vertices[v][k] = vertex[k];
+				}
+				if (!texCoordList.isEmpty())
+				{
+					const QVariantList xyList = texCoordList.at(p).toList();
+					if (xyList.size()!=4)
+						throw std::runtime_error("the texture polygons must have 4 vertices");
+					for (int v=0;v<4;++v)
+					{
+						const QVariantList vl = xyList.at(v).toList();
+						if (vl.size()!=2)
+							throw std::runtime_error("wrong X and Y, expect 2 values");
+						poly.texCoords[v][0] = toFloat(vl.at(0), "X");
+						poly.texCoords[v][1] = toFloat(vl.at(1), "Y");
+					}
+				}
+				polygons.append(poly);
+			}
+
+			if (map.contains("imageUrl"))
+			{
+				t.flags |= TileHasImage;
+				const QString imageUrl = map.value("imageUrl").toString();
+				const QString imagePath = StelFileMgr::findFile(mapDir+imageUrl);
+				if (!imagePath.isEmpty())
+				{
+					t.imagePath = strings.add(indexDir.relativeFilePath(imagePath));
+					t.flags |= TileImageInBaseDir;
+				}
+				else
+				{
+					// Maybe a file in stellarium local files
+					t.imagePath = strings.add(imageUrl);
+				}
+			}
+
+			// The children are appended at the end of the queue, so they get contiguous indices
+			const QVariantList subTiles = map.value("subTiles").toList();
+			t.firstChild = queue.size();
+			t.childCount = subTiles.size();
+			foreach (const QVariant& sub, subTiles)
+			{
+				if (sub.type()==QVariant::Map)
+				{
+					const QVariantMap m = sub.toMap();
+					if (m.size()==1 && m.contains("$ref"))
+					{
+						const QVariantMap subMap = loadJsonFile(m.value("$ref").toString(), mapDir, dir);
+						queue.append(qMakePair(subMap, dir));
+					}
+					else
+						queue.append(qMakePair(m, mapDir));
+				}
+				else
+				{
+					const QVariantMap subMap = loadJsonFile(sub.toString(), mapDir, dir);
+					queue.append(qMakePair(subMap, dir));
+				}
+			}
+			if (t.childCount==0)
+				t.firstChild = 0;
+			tiles.append(t);
+		}
+	}
+	catch (std::runtime_error& e)
+	{
+		qWarning() << "WARNING : Can't convert sky image: " << QDir::toNativeSeparators(jsonFileName) << ": " << e.what();
+		return false;
+	}
+
+	memcpy(header.magic, Magic, 4);
+	header.byteOrder = ByteOrderMark;
+	header.version = Version;
+	header.tileCount = tiles.size();
+	header.polygonCount = polygons.size();
+	header.stringsSize = strings.data.size();
+	header.tilesOffset = align8(sizeof(Header));
+	header.polygonsOffset = align8(header.tilesOffset+tiles.size()*sizeof(Tile));
+	header.stringsOffset = header.polygonsOffset+polygons.size()*sizeof(Polygon);
+
+	QFile out(indexFileName);
+	if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning() << "WARNING : Can't write sky image index: " << QDir::toNativeSeparators(indexFileName);
+		return false;
+	}
+	out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	out.write(QByteArray(header.tilesOffset-sizeof(Header), '\0'));
+	out.write(reinterpret_cast<const char*>(tiles.constData()), tiles.size()*sizeof(Tile));
+	out.write(QByteArray(header.polygonsOffset-header.tilesOffset-tiles.size()*sizeof(Tile), '\0'));
+	out.write(reinterpret_cast<const char*>(polygons.constData()), polygons.size()*sizeof(Polygon));
+	out.write(strings.data);
+	if (out.error()!=QFile::NoError)
+	{
+		qWarning() << "WARNING : Can't write sky image index: " << QDir::toNativeSeparators(indexFileName) << ": " << out.errorString();
+		return false;
+	}
+	qDebug() << "Wrote sky image index" << QDir::toNativeSeparators(indexFileName) << "with" << tiles.size() << "tiles and" << polygons.size() << "polygons";
+	return true;
+}
@@ -0,0 +1,135 @@
+/*
+ * Stellarium
+ * Copyright (C) 2015 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STELSKYIMAGEINDEX_HPP_
+#define _STELSKYIMAGEINDEX_HPP_
+
+#include <QFile>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+//! @class StelSkyImageIndex
+//! Binary description of a whole tree of sky image tiles, replacing the JSON files of a local survey.
+//! The file is memory mapped once, or read in memory where it can't be mapped, e.g. in the Android assets,
+//! and the tiles read it directly, so that creating a tile needs neither a file access nor a JSON parsing.
+//! The file contains a header, the tiles in breadth first order so that the children of a tile are
+//! contiguous, the polygons of all the tiles and a table of UTF-8 strings. It uses the byte order of
+//! the machine which wrote it and is rejected on a machine with another byte order.
+//! The image paths are relative to the directory of the index file, or to the stellarium data directories.
+//! An index is created from the JSON description of a survey with convertFromJson(), e.g. with the
+//! --convert-survey command line option.
+class StelSkyImageIndex
+{
+public:
+	//! Extension of the index files, used to recognize them in the survey URLs.
+	static const char* FileExtension;
+
+	enum TileFlag
+	{
+		TileHasLuminance = 1,		//!< brightness is a luminance in cd/m^2
+		TileHasMaxBrightness = 2,	//!< brightness is a surface brightness in Vmag/arcmin^2
+		TileHasAlphaBlend = 4,		//!< the alpha blend flag is given, else it is the one of the parent
+		TileAlphaBlend = 8,
+		TileHasImage = 16,
+		TileHasTextureCoords = 32,
+		TileImageInBaseDir = 64		//!< the image path is relative to the directory of the index
+	};
+
+	struct Tile
+	{
+		float minResolution;
+		float brightness;
+		quint32 flags;
+		quint32 shortName;
+		quint32 imagePath;
+		quint32 firstPolygon;
+		quint32 polygonCount;
+		quint32 firstChild;
+		quint32 childCount;
+		quint32 reserved;
+	};
+
+	//! A quadrilateral in J2000 rectangular coordinates, with the matching texture coordinates.
+	struct Polygon
+	{
+		double vertices[4][3];
+		float texCoords[4][2];
+	};
+
+	//! Map an index file, or read it if it can't be mapped.
+	//! @return NULL if the file can't be read or is not a valid index.
+	static QSharedPointer<StelSkyImageIndex> open(const QString& fileName);
+
+	//! Write the index of the local survey described by a JSON file and all the JSON files it refers to.
+	//! @return false if a file can't be read or has an unsupported content, e.g. remote subtiles.
+	static bool convertFromJson(const QString& jsonFileName, const QString& indexFileName);
+
+	~StelSkyImageIndex();
+
+	//! The directory of the index file, with a trailing slash.
+	const QString& getBaseDir() const {return baseDir;}
+
+	//! The tile 0 is the root of the tree.
+	const Tile& getTile(quint32 i) const {Q_ASSERT(i<tileCount); return tiles[i];}
+	const Polygon& getPolygon(quint32 i) const {Q_ASSERT(i<polygonCount); return polygons[i];}
+	//! Get a string from its offset in the string table, the offset 0 is the empty string.
+	QString getString(quint32 offset) const {Q_ASSERT(offset<stringsSize); return QString::fromUtf8(strings+offset);}
+
+	//! Strings of the root tile.
+	enum RootString
+	{
+		Description,
+		ImageCreditsShort,
+		ImageCreditsFull,
+		ImageCreditsInfoUrl,
+		ServerCreditsShort,
+		ServerCreditsFull,
+		ServerCreditsInfoUrl,
+		RootStringCount
+	};
+	QString getRootString(RootString s) const;
+
+private:
+	struct Header;
+
+	StelSkyImageIndex();
+
+	//! Map the file and check that it is a valid index, so that the accessors don't need to.
+	bool load(const QString& fileName);
+
+	QFile file;
+	//! The content of the file when it can't be mapped, in 8 bytes words to keep the polygons aligned.
+	QVector<quint64> memoryData;
+	QString baseDir;
+	const uchar* data;
+	qint64 size;
+
+	const Header* header;
+	const Tile* tiles;
+	quint32 tileCount;
+	const Polygon* polygons;
+	quint32 polygonCount;
+	const char* strings;
+	quint32 stringsSize;
+};
+
+typedef QSharedPointer<StelSkyImageIndex> StelSkyImageIndexP;
+
+#endif // _STELSKYIMAGEINDEX_HPP_
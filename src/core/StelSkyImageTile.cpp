@@ -27,11 +27,32 @@
 #include "StelCore.hpp"
 #include "StelSkyDrawer.hpp"
 #include "StelPainter.hpp"
+#include "StelMovementMgr.hpp"
+#include "StelProfiler.hpp"
 
 #include <QDebug>
 
+#include <cmath>
 #include <stdio.h>
 
+namespace
+{
+// The tiles which will be displayed within this time in seconds are prefetched, i.e. about 30 frames
+const double PrefetchHorizon = 0.5;
+// Number of predicted views between now and the horizon
+const int PrefetchSteps = 2;
+// Maximum number of tile descriptions and textures whose loading is started by the prefetch in a frame
+const int PrefetchLoadsPerFrame = 4;
+// Relative margin of the viewport size and of the resolution within which the loaded subtiles are kept
+const double KeepMargin = 0.2;
+
+// Return the cos of the scaled radius of a cap
+double scaleCapRadius(double d, double scale)
+{
+	return std::cos(qMin(M_PI, std::acos(qBound(-1., d, 1.))*scale));
+}
+}
+
 StelSkyImageTile::StelSkyImageTile()
 {
 	initCtor();
@@ -44,10 +65,11 @@ void StelSkyImageTile::initCtor()
 	alphaBlend = false;
 	noTexture = false;
 	texFader = NULL;
+	indexTile = 0;
 }
 
 // Constructor
-StelSkyImageTile::StelSkyImageTile(const QString& url, StelSkyImageTile* parent) : MultiLevelJsonBase(parent)
+StelSkyImageTile::StelSkyImageTile(const QString& url, StelSkyImageTile* parent, bool prefetch) : MultiLevelJsonBase(parent)
 {
 	initCtor();
 	if (parent!=NULL)
@@ -55,7 +77,10 @@ StelSkyImageTile::StelSkyImageTile(const QString& url, StelSkyImageTile* parent)
 		luminance = parent->luminance;
 		alphaBlend = parent->alphaBlend;
 	}
-	initFromUrl(url);
+	if (url.endsWith(StelSkyImageIndex::FileExtension))
+		initFromIndexFile(url, prefetch);
+	else
+		initFromUrl(url, prefetch);
 }
 
 // Constructor from a map used for JSON files with more than 1 level
@@ -70,6 +95,19 @@ StelSkyImageTile::StelSkyImageTile(const QVariantMap& map, StelSkyImageTile* par
 	initFromQVariantMap(map);
 }
 
+// Constructor from a tile of a binary index, which needs no file access
+StelSkyImageTile::StelSkyImageTile(const StelSkyImageIndexP& aindex, quint32 aindexTile, StelSkyImageTile* parent) : MultiLevelJsonBase(parent)
+{
+	initCtor();
+	luminance = parent->luminance;
+	alphaBlend = parent->alphaBlend;
+	baseUrl = parent->baseUrl;
+	contructorUrl = parent->contructorUrl + "/?";
+	index = aindex;
+	indexTile = aindexTile;
+	loadFromIndex();
+}
+
 // Destructor
 StelSkyImageTile::~StelSkyImageTile()
 {
@@ -80,8 +118,15 @@ void StelSkyImageTile::draw(StelCore* core, StelPainter& sPainter, float)
 	const StelProjectorP prj = core->getProjection(StelCore::FrameJ2000);
 
 	const float limitLuminance = core->getSkyDrawer()->getLimitLuminance();
+	// The subtiles just outside the viewport are kept, so that they are still there when the view comes back
+	const SphericalCap& viewportCap = prj->getBoundingCap();
+	const SphericalRegionP keepRegion(new SphericalCap(viewportCap.n, scaleCapRadius(viewportCap.d, 1.+KeepMargin)));
 	QMultiMap<double, StelSkyImageTile*> result;
-	getTilesToDraw(result, core, prj->getViewportConvexPolygon(0, 0), limitLuminance, true);
+	{
+		// getTilesToDraw() is recursive, measure only the top level call
+		STEL_PROFILE_SCOPE("StelSkyImageTile::getTilesToDraw");
+		getTilesToDraw(result, core, prj->getViewportConvexPolygon(0, 0), keepRegion, limitLuminance, true);
+	}
 
 	int numToBeLoaded=0;
 	foreach (StelSkyImageTile* t, result)
@@ -99,11 +144,142 @@ void StelSkyImageTile::draw(StelCore* core, StelPainter& sPainter, float)
 		i.value()->drawTile(core, sPainter);
 	}
 
+	{
+		STEL_PROFILE_SCOPE("StelSkyImageTile::prefetch");
+		prefetch(core, limitLuminance);
+	}
+
 	deleteUnusedSubTiles();
 }
 
+void StelSkyImageTile::prefetch(StelCore* core, float limitLuminance)
+{
+	const StelProjectorP prj = core->getProjection(StelCore::FrameJ2000);
+	const StelMovementMgr* mvmgr = core->getMovementMgr();
+	const SphericalCap& viewportCap = prj->getBoundingCap();
+	const double degPerPixel = 1./prj->getPixelPerRadAtCenter()*180./M_PI;
+	Vec3d viewDirection = mvmgr->getViewDirectionJ2000();
+	viewDirection.normalize();
+
+	int maxLoads = PrefetchLoadsPerFrame;
+	for (int i=1;i<=PrefetchSteps;++i)
+	{
+		const double deltaTime = PrefetchHorizon*i/PrefetchSteps;
+		const Vec3d move = mvmgr->getPredictedViewDirectionJ2000(deltaTime)-viewDirection;
+		const double scale = mvmgr->getPredictedFov(deltaTime)/mvmgr->getCurrentFov();
+		// The current view is already loaded by getTilesToDraw()
+		if (move.lengthSquared()<1e-8 && std::fabs(scale-1.)<0.01)
+			continue;
+		Vec3d n = viewportCap.n+move;
+		n.normalize();
+		const SphericalRegionP region(new SphericalCap(n, scaleCapRadius(viewportCap.d, scale)));
+		prefetchTiles(region, degPerPixel*scale, limitLuminance, maxLoads);
+	}
+}
+
+void StelSkyImageTile::prefetchTiles(const SphericalRegionP& region, double degPerPixel, float limitLuminance, int& maxLoads)
+{
+	if (errorOccured || updateLoading() || maxLoads<=0)
+		return;
+
+	if (luminance>0 && luminance<limitLuminance)
+		return;
+
+	if (!skyConvexPolygons.isEmpty())
+	{
+		bool intersect = false;
+		foreach (const SphericalRegionP& poly, skyConvexPolygons)
+		{
+			if (region->intersects(poly))
+			{
+				intersect = true;
+				break;
+			}
+		}
+		if (!intersect)
+			return;
+	}
+
+	// The tile will soon be displayed, don't delete it
+	cancelOwnDeletion();
+
+	if (noTexture==false)
+	{
+		if (!tex)
+		{
+			StelTextureMgr& texMgr=StelApp::getInstance().getTextureManager();
+			tex = texMgr.createTextureThread(absoluteImageURI, StelTexture::StelTextureParams(true));
+			if (!tex)
+			{
+				qWarning() << "WARNING : Can't create tile: " << absoluteImageURI;
+				errorOccured = true;
+				return;
+			}
+		}
+		if (tex->prefetch())
+			--maxLoads;
+	}
+
+	if (degPerPixel < minResolution)
+	{
+		if (canCreateSubTiles())
+		{
+			if (maxLoads<=0)
+				return;
+			createSubTiles(true);
+			--maxLoads;
+		}
+		foreach (MultiLevelJsonBase* tile, subTiles)
+			qobject_cast<StelSkyImageTile*>(tile)->prefetchTiles(region, degPerPixel, limitLuminance, maxLoads);
+	}
+}
+
+// The tiles covering a large part of the screen are parsed first
+int StelSkyImageTile::getLoadPriority() const
+{
+	const StelSkyImageTile* parent = qobject_cast<StelSkyImageTile*>(QObject::parent());
+	if (parent==NULL)
+		return 0;
+	// The tile is not known yet, use the area of its parent
+	double radius = 0.;
+	foreach (const SphericalRegionP& poly, parent->skyConvexPolygons)
+		radius = qMax(radius, std::acos(qBound(-1., poly->getBoundingCap().d, 1.)));
+	const double pixels = radius*StelApp::getInstance().getCore()->getProjection(StelCore::FrameJ2000)->getPixelPerRadAtCenter();
+	return qBound(0, (int)(pixels/100.), 100);
+}
+
+bool StelSkyImageTile::canCreateSubTiles() const
+{
+	if (!subTiles.isEmpty())
+		return false;
+	return index ? index->getTile(indexTile).childCount>0 : !subTilesUrls.isEmpty();
+}
+
+void StelSkyImageTile::createSubTiles(bool prefetch)
+{
+	if (index)
+	{
+		const StelSkyImageIndex::Tile& t = index->getTile(indexTile);
+		for (quint32 i=0;i<t.childCount;++i)
+			subTiles.append(new StelSkyImageTile(index, t.firstChild+i, this));
+		return;
+	}
+	foreach (QVariant s, subTilesUrls)
+	{
+		StelSkyImageTile* nt;
+		if (s.type()==QVariant::Map)
+			nt = new StelSkyImageTile(s.toMap(), this);
+		else
+		{
+			Q_ASSERT(s.type()==QVariant::String);
+			nt = new StelSkyImageTile(s.toString(), this, prefetch);
+		}
+		subTiles.append(nt);
+	}
+}
+
 // Return the list of tiles which should be drawn.
-void StelSkyImageTile::getTilesToDraw(QMultiMap<double, StelSkyImageTile*>& result, StelCore* core, const SphericalRegionP& viewPortPoly, float limitLuminance, bool recheckIntersect)
+void StelSkyImageTile::getTilesToDraw(QMultiMap<double, StelSkyImageTile*>& result, StelCore* core, const SphericalRegionP& viewPortPoly, const SphericalRegionP& keepRegion, float limitLuminance, bool recheckIntersect)
 {
 
 #ifndef NDEBUG
@@ -126,8 +302,8 @@ void StelSkyImageTile::getTilesToDraw(QMultiMap<double, StelSkyImageTile*>& resu
 	if (errorOccured)
 		return;
 
-	// The JSON file is currently being downloaded
-	if (downloading)
+	// The JSON file is currently being downloaded or parsed
+	if (updateLoading())
 	{
 		//qDebug() << "Downloading " << contructorUrl;
 		return;
@@ -171,7 +347,12 @@ void StelSkyImageTile::getTilesToDraw(QMultiMap<double, StelSkyImageTile*>& resu
 	// The tile is outside screen
 	if (fullInScreen==false && intersectScreen==false)
 	{
-		// Schedule a deletion
+		// Schedule a deletion, unless the tile is just outside
+		foreach (const SphericalRegionP& poly, skyConvexPolygons)
+		{
+			if (keepRegion->intersects(poly))
+				return;
+		}
 		scheduleChildsDeletion();
 		return;
 	}
@@ -203,29 +384,18 @@ void StelSkyImageTile::getTilesToDraw(QMultiMap<double, StelSkyImageTile*>& resu
 	const double degPerPixel = 1./core->getProjection(StelCore::FrameJ2000)->getPixelPerRadAtCenter()*180./M_PI;
 	if (degPerPixel < minResolution)
 	{
-		if (subTiles.isEmpty() && !subTilesUrls.isEmpty())
+		if (canCreateSubTiles())
 		{
 			// Load the sub tiles because we reached the maximum resolution and they are not yet loaded
-			foreach (QVariant s, subTilesUrls)
-			{
-				StelSkyImageTile* nt;
-				if (s.type()==QVariant::Map)
-					nt = new StelSkyImageTile(s.toMap(), this);
-				else
-				{
-					Q_ASSERT(s.type()==QVariant::String);
-					nt = new StelSkyImageTile(s.toString(), this);
-				}
-				subTiles.append(nt);
-			}
+			createSubTiles(false);
 		}
 		// Try to add the subtiles
 		foreach (MultiLevelJsonBase* tile, subTiles)
 		{
-			qobject_cast<StelSkyImageTile*>(tile)->getTilesToDraw(result, core, viewPortPoly, limitLuminance, !fullInScreen);
+			qobject_cast<StelSkyImageTile*>(tile)->getTilesToDraw(result, core, viewPortPoly, keepRegion, limitLuminance, !fullInScreen);
 		}
 	}
-	else
+	else if (degPerPixel >= minResolution*(1.+KeepMargin))
 	{
 		// The subtiles should not be displayed because their resolution is too high
 		scheduleChildsDeletion();
@@ -475,6 +645,90 @@ void StelSkyImageTile::loadFromQVariantMap(const QVariantMap& map)
 // 	}
 }
 
+void StelSkyImageTile::initFromIndexFile(const QString& url, bool prefetch)
+{
+	contructorUrl = url;
+	const QString fileName = StelFileMgr::findFile(url);
+	if (fileName.isEmpty())
+	{
+		qWarning() << "WARNING : Can't find sky image index: " << url;
+		errorOccured = true;
+		return;
+	}
+	index = StelSkyImageIndex::open(fileName);
+	if (!index)
+	{
+		// The survey can still be shown from the JSON description the index was converted from
+		const QString jsonUrl = url.left(url.lastIndexOf('.')) + ".json";
+		if (!StelFileMgr::findFile(jsonUrl).isEmpty())
+		{
+			qWarning() << "Using the JSON file" << jsonUrl << "instead";
+			initFromUrl(jsonUrl, prefetch);
+			return;
+		}
+		errorOccured = true;
+		return;
+	}
+	baseUrl = index->getBaseDir();
+	indexTile = 0;
+	loadFromIndex();
+}
+
+// Load the tile from the index, the same way as from a QVariantMap
+void StelSkyImageTile::loadFromIndex()
+{
+	const StelSkyImageIndex::Tile& t = index->getTile(indexTile);
+	if (parent()==NULL)
+	{
+		dataSetCredits.shortCredits = index->getRootString(StelSkyImageIndex::ImageCreditsShort);
+		dataSetCredits.fullCredits = index->getRootString(StelSkyImageIndex::ImageCreditsFull);
+		dataSetCredits.infoURL = index->getRootString(StelSkyImageIndex::ImageCreditsInfoUrl);
+		serverCredits.shortCredits = index->getRootString(StelSkyImageIndex::ServerCreditsShort);
+		serverCredits.fullCredits = index->getRootString(StelSkyImageIndex::ServerCreditsFull);
+		serverCredits.infoURL = index->getRootString(StelSkyImageIndex::ServerCreditsInfoUrl);
+		htmlDescription = index->getRootString(StelSkyImageIndex::Description) + "<h3>URL: "+contructorUrl+"</h3>";
+	}
+
+	shortName = index->getString(t.shortName);
+	if (shortName.isEmpty())
+		shortName = "no name";
+	minResolution = t.minResolution;
+	if (t.flags & StelSkyImageIndex::TileHasLuminance)
+		luminance = t.brightness;
+	else if (t.flags & StelSkyImageIndex::TileHasMaxBrightness)
+		luminance = StelSkyDrawer::surfacebrightnessToLuminance(t.brightness);
+	if (t.flags & StelSkyImageIndex::TileHasAlphaBlend)
+		alphaBlend = (t.flags & StelSkyImageIndex::TileAlphaBlend)!=0;
+
+	for (quint32 i=0;i<t.polygonCount;++i)
+	{
+		const StelSkyImageIndex::Polygon& p = index->getPolygon(t.firstPolygon+i);
+		QVector<Vec3d> vertices(4);
+		for (int v=0;v<4;++v)
+			vertices[v].set(p.vertices[v][0], p.vertices[v][1], p.vertices[v][2]);
+		if (t.flags & StelSkyImageIndex::TileHasTextureCoords)
+		{
+			QVector<Vec2f> texCoords(4);
+			for (int v=0;v<4;++v)
+				texCoords[v].set(p.texCoords[v][0], p.texCoords[v][1]);
+			skyConvexPolygons.append(SphericalRegionP(new SphericalTexturedConvexPolygon(vertices, texCoords)));
+		}
+		else
+		{
+			skyConvexPolygons.append(SphericalRegionP(new SphericalConvexPolygon(vertices)));
+		}
+	}
+
+	if (t.flags & StelSkyImageIndex::TileHasImage)
+	{
+		absoluteImageURI = index->getString(t.imagePath);
+		if (t.flags & StelSkyImageIndex::TileImageInBaseDir)
+			absoluteImageURI.prepend(baseUrl);
+	}
+	else
+		noTexture = true;
+}
+
 // Convert the image informations to a map following the JSON structure.
 QVariantMap StelSkyImageTile::toQVariantMap() const
 {
@@ -22,6 +22,7 @@
 
 #include "StelTextureTypes.hpp"
 #include "StelSphereGeometry.hpp"
+#include "StelSkyImageIndex.hpp"
 #include "MultiLevelJsonBase.hpp"
 
 #include <QTimeLine>
@@ -72,9 +73,12 @@ public:
 	StelSkyImageTile();
 
 	//! Constructor
-	StelSkyImageTile(const QString& url, StelSkyImageTile* parent=NULL);
+	//! @param prefetch if true the JSON file is downloaded with a low priority, because the tile is not displayed yet.
+	StelSkyImageTile(const QString& url, StelSkyImageTile* parent=NULL, bool prefetch=false);
 	//! Constructor
 	StelSkyImageTile(const QVariantMap& map, StelSkyImageTile* parent);
+	//! Constructor from a tile of a binary index.
+	StelSkyImageTile(const StelSkyImageIndexP& index, quint32 indexTile, StelSkyImageTile* parent);
 
 	//! Destructor
 	~StelSkyImageTile();
@@ -106,6 +110,9 @@ protected:
 	//! Load the tile from a valid QVariantMap.
 	virtual void loadFromQVariantMap(const QVariantMap& map);
 
+	//! Return a priority growing with the size of the tile on the screen, so that the visible tiles are loaded first.
+	virtual int getLoadPriority() const;
+
 	//! The credits of the server where this data come from
 	ServerCredits serverCredits;
 
@@ -137,9 +144,25 @@ private:
 	//! init the StelSkyImageTile
 	void initCtor();
 
+	//! Init the root tile from a binary index file, or from the JSON file next to it if the index is invalid.
+	void initFromIndexFile(const QString& url, bool prefetch);
+	//! Load the tile from its description in the binary index.
+	void loadFromIndex();
+	//! Return true if the tile has subtiles which are not created yet.
+	bool canCreateSubTiles() const;
+
 	//! Return the list of tiles which should be drawn.
 	//! @param result a map containing resolution, pointer to the tiles
-	void getTilesToDraw(QMultiMap<double, StelSkyImageTile*>& result, StelCore* core, const SphericalRegionP& viewPortPoly, float limitLuminance, bool recheckIntersect=true);
+	//! @param keepRegion the subtiles of the tiles outside the viewport but intersecting this region are not deleted
+	void getTilesToDraw(QMultiMap<double, StelSkyImageTile*>& result, StelCore* core, const SphericalRegionP& viewPortPoly, const SphericalRegionP& keepRegion, float limitLuminance, bool recheckIntersect=true);
+	//! Start loading the tiles which will be displayed in the next frames, predicted from the movement of the view.
+	void prefetch(StelCore* core, float limitLuminance);
+	//! Start loading the JSON descriptions and textures of the tiles intersecting the region at the given resolution.
+	//! @param maxLoads the maximum number of loads to start, decreased by the number of started loads
+	void prefetchTiles(const SphericalRegionP& region, double degPerPixel, float limitLuminance, int& maxLoads);
+	//! Create the subtiles from their URL or JSON map.
+	//! @param prefetch true if the subtiles are not displayed yet
+	void createSubTiles(bool prefetch);
 
 	//! Draw the image on the screen.
 	//! @return true if the tile was actually displayed
@@ -151,6 +174,11 @@ private:
 	//! The list of all the subTiles URL or already loaded JSON map for this tile
 	QVariantList subTilesUrls;
 
+	//! The binary index describing the tile, if the survey has one
+	StelSkyImageIndexP index;
+	//! Number of the tile in the index
+	quint32 indexTile;
+
 	// Used for smooth fade in
 	QTimeLine* texFader;
 
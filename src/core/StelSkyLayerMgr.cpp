@@ -37,6 +37,7 @@
 #include <QVariantMap>
 #include <QVariantList>
 #include <QDir>
+#include <QFileInfo>
 #include <QSettings>
 
 StelSkyLayerMgr::StelSkyLayerMgr(void) : flagShow(true)
@@ -63,7 +64,24 @@ double StelSkyLayerMgr::getCallOrder(StelModuleActionName actionName) const
 // read from stream
 void StelSkyLayerMgr::init()
 {
-	QString path = StelFileMgr::findFile("nebulae/default/textures.json");
+	// Prefer the binary index of the default textures when it was generated with --convert-survey,
+	// unless the JSON description was edited since
+	QString path = StelFileMgr::findFile(QString("nebulae/default/textures")+StelSkyImageIndex::FileExtension);
+	const QString jsonPath = StelFileMgr::findFile("nebulae/default/textures.json");
+	if (!path.isEmpty() && !jsonPath.isEmpty() && QFileInfo(path).lastModified()<QFileInfo(jsonPath).lastModified())
+	{
+		qWarning() << "The sky image index" << QDir::toNativeSeparators(path) << "is older than"
+		           << QDir::toNativeSeparators(jsonPath) << "- using the JSON file, regenerate the index with --convert-survey";
+		path.clear();
+	}
+	// A truncated index, or one written by another version, would leave the sky without images
+	if (!path.isEmpty() && !jsonPath.isEmpty() && !StelSkyImageIndex::open(path))
+	{
+		qWarning() << "Can't use the sky image index" << QDir::toNativeSeparators(path) << "- using the JSON file";
+		path.clear();
+	}
+	if (path.isEmpty())
+		path = jsonPath;
 	if (path.isEmpty())
 		qWarning() << "ERROR while loading nebula texture set default";
 	else
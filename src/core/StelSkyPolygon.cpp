@@ -79,8 +79,8 @@ void StelSkyPolygon::getTilesToDraw(QMultiMap<double, StelSkyPolygon*>& result,
 	if (errorOccured)
 		return;
 
-	// The JSON file is currently being downloaded
-	if (downloading)
+	// The JSON file is currently being downloaded or parsed
+	if (updateLoading())
 		return;
 
 	// Check that we are in the screen
@@ -51,6 +51,13 @@ public:
 		rootNode->processBoundingCapIntersectingRegions(cap, func);
 	}
 	
+	//! Process all the objects whose bounding cap intersects the given cap using the passed function object.
+	//! Unlike processBoundingCapIntersectingRegions() the function object gets the shared pointer of the objects.
+	template<class FuncObject> void processBoundingCapIntersectingObjects(const SphericalCap& cap, FuncObject& func) const
+	{
+		rootNode->processBoundingCapIntersectingObjects(cap, func);
+	}
+
 	//! Process all the objects contained in the given region using the passed function object.
 	template<class FuncObject> void processContainedRegions(const SphericalRegion* region, FuncObject& func) const
 	{
@@ -201,6 +208,11 @@ private:
 				processBoundingCapIntersectingRegions(*this, cap, func);
 			}
 
+			template<class FuncObject> void processBoundingCapIntersectingObjects(const SphericalCap& cap, FuncObject& func) const
+			{
+				processBoundingCapIntersectingObjects(*this, cap, func);
+			}
+
 			//! Process all the objects contained the given region using the passed function object.
 			template<class FuncObject> void processContainedRegions(const SphericalRegion* region, FuncObject& func) const
 			{
@@ -298,6 +310,22 @@ private:
 				}
 			}
 
+			template<class FuncObject> void processBoundingCapIntersectingObjects(const Node& node, const SphericalCap& cap, FuncObject& func) const
+			{
+				foreach (const NodeElem& el, node.elements)
+				{
+					if (cap.intersects(el.cap))
+						func(el.obj);
+				}
+				foreach (const Node& child, node.children)
+				{
+					if (cap.contains(child.triangle))
+						processAllObjects(child, func);
+					else if (cap.intersects(child.triangle))
+						processBoundingCapIntersectingObjects(child, cap, func);
+				}
+			}
+
 			//! Process all the objects contained the given region using the passed function object.
 			template<class FuncObject> void processContainedRegions(const Node& node, const SphericalRegion* region, FuncObject& func) const
 			{
@@ -324,6 +352,15 @@ private:
 					processAll(child, func);
 			}
 
+			//! Process all the objects passing their shared pointer to the function object.
+			template<class FuncObject> void processAllObjects(const Node& node, FuncObject& func) const
+			{
+				foreach (const NodeElem& el, node.elements)
+					func(el.obj);
+				foreach (const Node& child, node.children)
+					processAllObjects(child, func);
+			}
+
 			//! The maximum number of objects per node.
 			int maxObjectsPerNode;
 			//! The maximum level of the grid. Prevents grid split into too small triangles if unecessary.
@@ -25,7 +25,10 @@
 #include "StelUtils.hpp"
 #include "StelPainter.hpp"
 
+#include <QElapsedTimer>
 #include <QImageReader>
+#include <QRunnable>
+#include <QThreadPool>
 #include <QSize>
 #include <QDebug>
 #include <QUrl>
@@ -34,7 +37,37 @@
 #include <QtEndian>
 #include <QFuture>
 
-StelTexture::StelTexture() : networkReply(NULL), errorOccured(false), id(0), avgLuminance(-1.f)
+//! Decode an image and convert it to the openGL format in the texture manager threads.
+class ImageLoader : public QRunnable
+{
+public:
+	ImageLoader(const QSharedPointer<StelTexture::AsyncData>& data, const QString& path, const QByteArray& downloadedData)
+		: data(data), path(path), downloadedData(downloadedData) {}
+
+	virtual void run()
+	{
+		if (data->cancelled.loadAcquire())
+			return;
+		QImage image;
+		if (downloadedData.isEmpty())
+			image.load(path);
+		else
+			image.loadFromData(downloadedData);
+		if (image.isNull())
+			data->errorMessage = QString("Cannot load the image %1").arg(path);
+		else
+			data->glData = StelTexture::imageToGLData(image);
+		data->ready.storeRelease(1);
+	}
+
+private:
+	QSharedPointer<StelTexture::AsyncData> data;
+	QString path;
+	QByteArray downloadedData;
+};
+
+StelTexture::StelTexture() : networkReply(NULL), errorOccured(false), id(0), avgLuminance(-1.f),
+	textureMgr(NULL), gpuBytes(0), lastBindFrame(0), prefetched(false), synchronous(false)
 {
 	width = -1;
 	height = -1;
@@ -43,6 +76,8 @@ StelTexture::StelTexture() : networkReply(NULL), errorOccured(false), id(0), avg
 
 StelTexture::~StelTexture()
 {
+	if (textureMgr)
+		textureMgr->textureDeleted(this);
 	if (id != 0)
 	{
 		if (glIsTexture(id)==GL_FALSE)
@@ -60,6 +95,8 @@ StelTexture::~StelTexture()
 		networkReply->abort();
 		networkReply->deleteLater();
 	}
+	if (asyncData)
+		asyncData->cancelled.storeRelease(1);
 }
 
 /*************************************************************************
@@ -69,6 +106,9 @@ void StelTexture::reportError(const QString& aerrorMessage)
 {
 	errorOccured = true;
 	errorMessage = aerrorMessage;
+	// The next texture created with this path tries again
+	if (textureMgr)
+		textureMgr->textureFailed(this);
 	// Report failure of texture loading
 	emit(loadingProcessFinished(true));
 }
@@ -91,9 +131,19 @@ StelTexture::GLData StelTexture::imageToGLData(const QImage &image)
 
 bool StelTexture::bind()
 {
+	if (prefetched)
+	{
+		// First bind since the prefetch, count whether it was worth it
+		prefetched = false;
+		if (textureMgr)
+			textureMgr->prefetchedTextureBound(id!=0 || (asyncData && asyncData->ready.loadAcquire()));
+	}
+
 	if (id != 0)
 	{
 		// The texture is already fully loaded, just bind and return true;
+		if (textureMgr)
+			textureMgr->textureBound(this);
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, id);
 		return true;
@@ -101,27 +151,92 @@ bool StelTexture::bind()
 	if (errorOccured)
 		return false;
 
+	// Unloaded to stay in the memory budget, load it again as when it was created
+	if (synchronous && !asyncData && networkReply==NULL)
+	{
+		QElapsedTimer timer;
+		timer.start();
+		const QImage image(fullPath);
+		if (image.isNull())
+		{
+			reportError(QString("Cannot load the image %1").arg(fullPath));
+			return false;
+		}
+		const bool ok = glLoad(image);
+		if (textureMgr)
+			textureMgr->addUpload(timer.nsecsElapsed());
+		return ok;
+	}
+
+	// The image is decoded in the loader threads, only upload it here within the budget of the frame
+	if (asyncData)
+	{
+		if (!asyncData->ready.loadAcquire())
+		{
+			StelApp::getInstance().reportPendingLoad();
+			return false;
+		}
+		if (textureMgr && !textureMgr->canUpload())
+		{
+			StelApp::getInstance().reportPendingLoad();
+			return false;
+		}
+		const QSharedPointer<AsyncData> data = asyncData;
+		asyncData.clear();
+		if (!data->errorMessage.isEmpty())
+		{
+			reportError(data->errorMessage);
+			return false;
+		}
+		QElapsedTimer timer;
+		timer.start();
+		const bool ok = glLoad(data->glData);
+		if (textureMgr)
+			textureMgr->addUpload(timer.nsecsElapsed());
+		return ok;
+	}
+
+	// The network connection is still running, or starts now.
+	StelApp::getInstance().reportPendingLoad();
+	if (networkReply != NULL)
+		return false;
+	startLoading();
+	return false;
+}
+
+bool StelTexture::prefetch()
+{
+	if (id != 0 || errorOccured || asyncData || networkReply != NULL)
+		return false;
+	prefetched = true;
+	if (textureMgr)
+		textureMgr->texturePrefetched();
+	startLoading();
+	return true;
+}
+
+void StelTexture::startLoading()
+{
 	// If the file is remote, start a network connection.
-	if (networkReply == NULL && fullPath.startsWith("http://")) {
+	if (fullPath.startsWith("http://")) {
 		QNetworkRequest req = QNetworkRequest(QUrl(fullPath));
 		// Define that preference should be given to cached files (no etag checks)
 		req.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
 		req.setRawHeader("User-Agent", StelUtils::getApplicationName().toLatin1());
+		if (prefetched)
+			req.setPriority(QNetworkRequest::LowPriority);
 		networkReply = StelApp::getInstance().getNetworkAccessManager()->get(req);
 		connect(networkReply, SIGNAL(finished()), this, SLOT(onNetworkReply()));
-		return false;
+		return;
 	}
-	// The network connection is still running.
-	if (networkReply != NULL)
-		return false;
-	if (!fullPath.startsWith("http://"))
-		image.load(fullPath);
+	startDecoding();
+}
 
-	if (image.isNull())
-		return false;
-	glLoad(image);
-	image = QImage();
-	return true;
+void StelTexture::startDecoding(const QByteArray& downloadedData)
+{
+	asyncData = QSharedPointer<AsyncData>(new AsyncData());
+	// The images being displayed are decoded before the prefetched ones
+	StelApp::getInstance().getLoaderPool()->start(new ImageLoader(asyncData, fullPath, downloadedData), prefetched ? -1 : 0);
 }
 
 void StelTexture::onNetworkReply()
@@ -132,8 +247,7 @@ void StelTexture::onNetworkReply()
 	}
 	else
 	{
-		QByteArray data = networkReply->readAll();
-		image.loadFromData(data);
+		startDecoding(networkReply->readAll());
 	}
 	networkReply->deleteLater();
 	networkReply = NULL;
@@ -244,6 +358,7 @@ bool StelTexture::glLoad(const GLData& data)
 	}
 	width = data.width;
 	height = data.height;
+	gpuBytes = (qint64)data.data.size();
 	glActiveTexture(GL_TEXTURE0);
 	glGenTextures(1, &id);
 	glBindTexture(GL_TEXTURE_2D, id);
@@ -258,12 +373,24 @@ bool StelTexture::glLoad(const GLData& data)
 	{
 		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
 		glGenerateMipmap(GL_TEXTURE_2D);
+		// The mipmaps take one third more memory
+		gpuBytes = gpuBytes*4/3;
 	}
+	if (textureMgr)
+		textureMgr->textureLoaded(this);
 	// Report success of texture loading
 	emit(loadingProcessFinished(false));
 	return true;
 }
 
+void StelTexture::unload()
+{
+	if (id != 0)
+		glDeleteTextures(1, &id);
+	id = 0;
+	gpuBytes = 0;
+}
+
 // Actually load the texture to openGL memory
 bool StelTexture::glLoad(const QImage& image)
 {
@@ -22,9 +22,11 @@
 
 #include "StelTextureTypes.hpp"
 
+#include <QAtomicInt>
 #include <QObject>
 #include <QImage>
 #include <QOpenGLFunctions>
+#include <QSharedPointer>
 
 class QFile;
 class StelTextureMgr;
@@ -82,7 +84,12 @@ public:
 	const QString& getFullPath() const {return fullPath;}
 
 	//! Return whether the image is currently being loaded
-	bool isLoading() const {return networkReply && !canBind();}
+	bool isLoading() const {return (networkReply || asyncData) && !canBind();}
+
+	//! Start loading the texture before it is bound, e.g. for an image which will soon be displayed.
+	//! The download and decoding have a lower priority than the ones of the textures already bound.
+	//! @return true if the loading was started, false if the texture is already loaded or loading, or if it failed.
+	bool prefetch();
 
 signals:
 	//! Emitted when the texture is ready to be bind(), i.e. when downloaded, imageLoading and	glLoading is over
@@ -96,6 +103,7 @@ private slots:
 
 private:
 	friend class StelTextureMgr;
+	friend class ImageLoader;
 
 	//! structure returned by the loader threads, containing all the
 	//! data and information to create the OpenGL texture.
@@ -109,6 +117,25 @@ private:
 	};
 	static GLData imageToGLData(const QImage &image);
 
+	//! Image decoded by an ImageLoader in the texture manager threads.
+	//! It is shared with the loader so that the texture can be deleted during the decoding.
+	struct AsyncData
+	{
+		AsyncData() : ready(0), cancelled(0) {}
+		//! Set to 1 by the loader once glData or errorMessage is set.
+		QAtomicInt ready;
+		//! Set to 1 when the texture is deleted, so that the loader doesn't decode it for nothing.
+		QAtomicInt cancelled;
+		GLData glData;
+		QString errorMessage;
+	};
+
+	//! Start decoding the image in the texture manager threads.
+	//! @param downloadedData the content of the remote file, or empty to read the local file.
+	void startDecoding(const QByteArray& downloadedData=QByteArray());
+	//! Start the download of a remote image or the decoding of a local one.
+	void startLoading();
+
 	//! Private constructor
 	StelTexture();
 
@@ -119,6 +146,9 @@ private:
 	//! @param errorMessage the human friendly error message
 	void reportError(const QString& errorMessage);
 
+	//! Delete the openGL texture. It will be loaded again the next time it is bound.
+	void unload();
+
 	//! Load the texture already in the RAM to the openGL memory
 	//! This function uses openGL routines and must be called in the main thread
 	//! @return false if an error occured
@@ -133,8 +163,8 @@ private:
 
 	//! The URL where to download the file
 	QString fullPath;
-	//! The temporay image used when we get data from the network
-	QImage image;
+	//! The image being decoded, NULL if the decoding was not started or is over.
+	QSharedPointer<AsyncData> asyncData;
 
 	//! True when something when wrong in the loading process
 	bool errorOccured;
@@ -150,6 +180,18 @@ private:
 
 	GLsizei width;	//! Texture image width
 	GLsizei height;	//! Texture image height
+
+	//! The manager of the texture cache, NULL once it is deleted.
+	StelTextureMgr* textureMgr;
+	//! Estimated size of the texture in openGL memory.
+	qint64 gpuBytes;
+	//! Frame number of the manager at the last bind() of the loaded texture.
+	qint64 lastBindFrame;
+	//! True if the loading was started by prefetch() and the texture was not bound since.
+	bool prefetched;
+	//! True if the texture was loaded by StelTextureMgr::createTexture(). Its users expect it to be drawn
+	//! at once, so it is loaded again synchronously when it is bound after being unloaded.
+	bool synchronous;
 };
 
 
@@ -27,14 +27,138 @@
 #include <QFile>
 #include <QDebug>
 #include <QNetworkRequest>
-#include <QThread>
 #include <QSettings>
+#include <QVector>
 #include <cstdlib>
+#include <cstring>
+#include <algorithm>
 #include <QOpenGLContext>
 
+StelTextureMgr::StelTextureMgr() : maxUploadsPerFrame(4), uploadBudget(4000000), uploadCount(0), uploadTime(0),
+	residentBytes(0), memoryBudget(128*1024*1024), frame(0), budgetExceeded(false)
+{
+	memset(&statistics, 0, sizeof(statistics));
+}
+
+StelTextureMgr::~StelTextureMgr()
+{
+	const Statistics s = getStatistics();
+	qDebug() << "Texture cache:" << s.residentTextures << "textures in" << s.residentBytes/1024 << "kB,"
+	         << s.hits << "hits," << s.misses << "misses," << s.evictions << "evictions,"
+	         << s.prefetchHits << "/" << s.prefetches << "prefetches in time";
+
+	// Some textures are static members of the modules and are deleted after the manager
+	for (QHash<QString, QWeakPointer<StelTexture> >::iterator it=textureCache.begin();it!=textureCache.end();++it)
+	{
+		StelTextureSP tex = it.value().toStrongRef();
+		if (tex)
+			tex->textureMgr = NULL;
+	}
+}
 
 void StelTextureMgr::init()
 {
+	QSettings* conf = StelApp::getInstance().getSettings();
+	maxUploadsPerFrame = qMax(1, conf->value("video/texture_uploads_per_frame", 4).toInt());
+	uploadBudget = (qint64)(conf->value("video/texture_upload_budget_ms", 4.).toDouble()*1000000.);
+	memoryBudget = (qint64)(conf->value("video/texture_memory_budget_mb", 128.).toDouble()*1024*1024);
+}
+
+void StelTextureMgr::beginFrame()
+{
+	++frame;
+	uploadCount = 0;
+	uploadTime = 0;
+	if (residentBytes>memoryBudget)
+		evictTextures();
+}
+
+StelTextureMgr::Statistics StelTextureMgr::getStatistics() const
+{
+	Statistics s = statistics;
+	s.residentBytes = residentBytes;
+	s.budgetBytes = memoryBudget;
+	s.residentTextures = residentTextures.size();
+	return s;
+}
+
+QString StelTextureMgr::getCacheKey(const QString& path, const StelTexture::StelTextureParams& params)
+{
+	return QString("%1|%2|%3|%4").arg(path).arg(params.generateMipmaps).arg(params.filtering).arg(params.wrapMode);
+}
+
+StelTextureSP StelTextureMgr::getCachedTexture(const QString& path, const StelTexture::StelTextureParams& params, bool& found)
+{
+	const QString key = getCacheKey(path, params);
+	StelTextureSP tex = textureCache.value(key).toStrongRef();
+	found = !tex.isNull();
+	if (found)
+	{
+		++statistics.hits;
+		return tex;
+	}
+	++statistics.misses;
+	tex = StelTextureSP(new StelTexture());
+	tex->textureMgr = this;
+	tex->fullPath = path;
+	tex->loadParams = params;
+	textureCache.insert(key, tex.toWeakRef());
+	return tex;
+}
+
+void StelTextureMgr::textureLoaded(StelTexture* tex)
+{
+	residentTextures.insert(tex);
+	residentBytes += tex->gpuBytes;
+	tex->lastBindFrame = frame;
+}
+
+void StelTextureMgr::textureDeleted(StelTexture* tex)
+{
+	if (residentTextures.remove(tex))
+		residentBytes -= tex->gpuBytes;
+	// The entry of the texture has no strong reference left, unless it was replaced by a new texture
+	QHash<QString, QWeakPointer<StelTexture> >::iterator it = textureCache.find(getCacheKey(tex->fullPath, tex->loadParams));
+	if (it!=textureCache.end() && it.value().isNull())
+		textureCache.erase(it);
+}
+
+void StelTextureMgr::textureFailed(StelTexture* tex)
+{
+	QHash<QString, QWeakPointer<StelTexture> >::iterator it = textureCache.find(getCacheKey(tex->fullPath, tex->loadParams));
+	if (it!=textureCache.end() && it.value().toStrongRef().data()==tex)
+		textureCache.erase(it);
+}
+
+bool StelTextureMgr::lastBindLessThan(const StelTexture* t1, const StelTexture* t2)
+{
+	return t1->lastBindFrame < t2->lastBindFrame;
+}
+
+void StelTextureMgr::evictTextures()
+{
+	QVector<StelTexture*> candidates;
+	foreach (StelTexture* tex, residentTextures)
+	{
+		if (tex->lastBindFrame < frame-1)
+			candidates.append(tex);
+	}
+	std::sort(candidates.begin(), candidates.end(), lastBindLessThan);
+	foreach (StelTexture* tex, candidates)
+	{
+		if (residentBytes<=memoryBudget)
+			break;
+		residentTextures.remove(tex);
+		residentBytes -= tex->gpuBytes;
+		tex->unload();
+		++statistics.evictions;
+	}
+	if (residentBytes>memoryBudget && !budgetExceeded)
+	{
+		qWarning() << "The textures of a single frame need" << residentBytes/(1024*1024) << "MB, more than the budget of"
+		           << memoryBudget/(1024*1024) << "MB (video/texture_memory_budget_mb)";
+		budgetExceeded = true;
+	}
 }
 
 StelTextureSP StelTextureMgr::createTexture(const QString& afilename, const StelTexture::StelTextureParams& params)
@@ -42,14 +166,31 @@ StelTextureSP StelTextureMgr::createTexture(const QString& afilename, const Stel
 	if (afilename.isEmpty())
 		return StelTextureSP();
 
-	StelTextureSP tex = StelTextureSP(new StelTexture());
-	tex->fullPath = afilename;
+	bool found;
+	StelTextureSP tex = getCachedTexture(afilename, params, found);
+	if (found)
+	{
+		// The shared texture may have been unloaded to stay in the memory budget, or still be loading
+		// in the background after createTextureThread(): load it now, this function returns a loaded texture.
+		if (tex->canBind())
+			return tex;
+		if (tex->errorOccured)
+			return StelTextureSP();
+		// A download can't be completed synchronously, keep it going
+		if (tex->networkReply)
+			return tex;
+		if (tex->asyncData)
+		{
+			tex->asyncData->cancelled.storeRelease(1);
+			tex->asyncData.clear();
+		}
+	}
 
 	QImage image(tex->fullPath);
 	if (image.isNull())
 		return StelTextureSP();
 
-	tex->loadParams = params;
+	tex->synchronous = true;
 	if (tex->glLoad(image))
 		return tex;
 	else
@@ -62,10 +203,9 @@ StelTextureSP StelTextureMgr::createTextureThread(const QString& url, const Stel
 	if (url.isEmpty())
 		return StelTextureSP();
 
-	StelTextureSP tex = StelTextureSP(new StelTexture());
-	tex->loadParams = params;
-	tex->fullPath = url;
-	if (!lazyLoading)
+	bool found;
+	StelTextureSP tex = getCachedTexture(url, params, found);
+	if (!lazyLoading && !found)
 	{
 		tex->bind();
 	}
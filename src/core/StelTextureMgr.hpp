@@ -21,26 +21,67 @@
 #define _STELTEXTUREMGR_HPP_
 
 #include "StelTexture.hpp"
+#include <QHash>
 #include <QObject>
+#include <QSet>
+#include <QWeakPointer>
 
 class QNetworkReply;
-class QThread;
 
 
 //! @class StelTextureMgr
 //! Manage textures loading.
 //! It provides method for loading images in a separate thread.
+//! The images of the textures created by createTextureThread() are decoded and converted to the
+//! openGL format by the loader threads of StelApp. The main thread only uploads them, and at most
+//! video/texture_uploads_per_frame textures or video/texture_upload_budget_ms milliseconds per frame,
+//! so that panning over many new tiles doesn't stall the rendering.
+//! The textures are shared: creating a texture with the same path and parameters as a texture still in use
+//! returns the same instance. When the textures in openGL memory exceed video/texture_memory_budget_mb,
+//! the least recently bound ones are unloaded at the beginning of the next frame. They are loaded again
+//! when they are bound again, in the loader threads, or at once for the textures made by createTexture().
+//! A texture which failed to load is not shared, so that creating it again retries.
 class StelTextureMgr : QObject
 {
 public:
+	//! Texture cache usage since the creation of the manager.
+	struct Statistics
+	{
+		//! Bytes of openGL memory used by the loaded textures, estimated from their size and format.
+		qint64 residentBytes;
+		qint64 budgetBytes;
+		//! Number of textures in openGL memory.
+		int residentTextures;
+		//! Number of textures created or shared.
+		qint64 hits;
+		qint64 misses;
+		//! Number of textures unloaded to stay in the budget.
+		qint64 evictions;
+		//! Number of textures loaded in advance with StelTexture::prefetch(),
+		//! and number of them which were ready when they were bound for the first time.
+		qint64 prefetches;
+		qint64 prefetchHits;
+	};
+
+	StelTextureMgr();
+	~StelTextureMgr();
+
 	//! Initialize some variable from the openGL contex.
 	//! Must be called after the creation of the GLContext.
 	void init();
 
+	//! Reset the texture upload budget and unload the textures exceeding the memory budget.
+	//! Called at the beginning of each frame.
+	void beginFrame();
+
+	Statistics getStatistics() const;
+
 	//! Load an image from a file and create a new texture from it
 	//! @param filename the texture file name, can be absolute path if starts with '/' otherwise
 	//!    the file will be looked in stellarium standard textures directories.
 	//! @param params the texture creation parameters.
+	//! @return a loaded texture, or NULL if it can't be loaded. A shared texture which was unloaded or is
+	//!    still loading in the background is loaded again synchronously, unless it is being downloaded.
 	StelTextureSP createTexture(const QString& filename, const StelTexture::StelTextureParams& params=StelTexture::StelTextureParams());
 
 	//! Load an image from a file and create a new texture from it in a new thread.
@@ -53,6 +94,53 @@ public:
 private:
 	friend class StelTexture;
 	friend class ImageLoader;
+
+	//! Return whether one more decoded texture can be uploaded during this frame.
+	//! The first upload of a frame is always allowed, even with a budget of 0 ms.
+	bool canUpload() const {return uploadCount==0 || (uploadCount<maxUploadsPerFrame && uploadTime<uploadBudget);}
+	//! Count one texture upload of this frame, which took the given time in nanoseconds.
+	void addUpload(qint64 duration) {++uploadCount; uploadTime+=duration;}
+
+	//! Get the key of a texture in the cache.
+	static QString getCacheKey(const QString& path, const StelTexture::StelTextureParams& params);
+	//! Get a texture still in use from the cache, or a new one which is added to the cache.
+	StelTextureSP getCachedTexture(const QString& path, const StelTexture::StelTextureParams& params, bool& found);
+
+	//! Called by the textures when they are uploaded, bound, or deleted.
+	void textureLoaded(StelTexture* tex);
+	void textureBound(StelTexture* tex) {tex->lastBindFrame = frame;}
+	void textureDeleted(StelTexture* tex);
+	//! Remove a texture which failed to load from the cache, so that it isn't shared any more.
+	void textureFailed(StelTexture* tex);
+	//! Called by the textures to count the prefetches and whether the prefetched textures were ready in time.
+	void texturePrefetched() {++statistics.prefetches;}
+	void prefetchedTextureBound(bool ready) {if (ready) ++statistics.prefetchHits;}
+
+	//! Unload the least recently bound textures until the loaded textures fit in the memory budget.
+	//! The textures bound during the last frame are never unloaded.
+	void evictTextures();
+	static bool lastBindLessThan(const StelTexture* t1, const StelTexture* t2);
+
+	int maxUploadsPerFrame;
+	//! Maximum time spent uploading textures in a frame in nanoseconds.
+	//! One texture is always uploaded, even if it takes longer.
+	qint64 uploadBudget;
+	//! Uploads done during the current frame.
+	int uploadCount;
+	qint64 uploadTime;
+
+	//! All the textures in use, by cache key.
+	QHash<QString, QWeakPointer<StelTexture> > textureCache;
+	//! The textures in openGL memory.
+	QSet<StelTexture*> residentTextures;
+	qint64 residentBytes;
+	qint64 memoryBudget;
+	//! Number of the current frame, to know when the textures were last bound.
+	qint64 frame;
+	//! Whether the textures bound in a frame didn't fit in the budget, only reported once.
+	bool budgetExceeded;
+
+	Statistics statistics;
 };
 
 
@@ -24,65 +24,149 @@
 #include "StelObject.hpp"
 #include "Planet.hpp"
 
-TrailGroup::TrailGroup(float te) : timeExtent(te), opacity(1.f)
+#include <algorithm>
+
+namespace
+{
+	// Interval between the points of new trails in days, i.e. 1 minute
+	const double MinTrailStep = 1./1440.;
+	// Maximum number of vertices of a draw call, the indices being unsigned shorts
+	const int MaxDrawVertices = 65536;
+}
+
+TrailGroup::Trail::Trail(const StelObjectP& obj, const Vec3f& col) : stelObject(obj), color(col)
 {
+	planet = dynamic_cast<const Planet*>(obj.data());
+}
+
+TrailGroup::TrailGroup(float te, int amaxPoints) : timeExtent(te), maxPoints(amaxPoints), head(0), count(0), step(MinTrailStep), opacity(1.f)
+{
+	Q_ASSERT(maxPoints>1 && maxPoints<MaxDrawVertices);
 	j2000ToTrailNative=Mat4d::identity();
 	j2000ToTrailNativeInverted=Mat4d::identity();
+	times.resize(maxPoints);
 }
 
-static QVector<Vec3d> vertexArray;
-static QVector<Vec4f> colorArray;
 void TrailGroup::draw(StelCore* core, StelPainter* sPainter)
 {
+	if (count==0)
+		return;
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	float currentTime = core->getJDay();
+	const double currentTime = core->getJDay();
 	StelProjector::ModelViewTranformP transfo = core->getJ2000ModelViewTransform();
 	transfo->combine(j2000ToTrailNativeInverted);
 	sPainter->setProjector(core->getProjection(transfo));
-	foreach (const Trail& trail, allTrails)
+
+	// The fading only depends on the time of the points, which is shared by all the trails
+	alphas.resize(count+1);
+	for (int i=0;i<count;++i)
+		alphas[i] = (1.f-(currentTime-times.at(ringIndex(i)))/timeExtent)*opacity;
+	alphas[count] = opacity;
+
+	const Planet* homePlanet = core->getCurrentPlanet().data();
+	for (int t=0;t<allTrails.size();++t)
+	{
+		// Avoid drawing the trails if the object is the home planet
+		if (allTrails.at(t).planet!=NULL && allTrails.at(t).planet==homePlanet)
+			continue;
+		if (vertexArray.size()+count+1>MaxDrawVertices)
+			drawVertices(sPainter);
+		appendTrailVertices(core, t);
+	}
+	drawVertices(sPainter);
+}
+
+void TrailGroup::appendTrailVertices(StelCore* core, int t)
+{
+	const Trail& trail = allTrails.at(t);
+	const int first = vertexArray.size();
+	vertexArray.resize(first+count+1);
+	colorArray.resize(first+count+1);
+
+	// The ring is made of 2 contiguous parts at most
+	const Vec3d* ring = positions.constData()+t*maxPoints;
+	const int firstPart = qMin(count, maxPoints-head);
+	std::copy(ring+head, ring+head+firstPart, vertexArray.data()+first);
+	std::copy(ring, ring+count-firstPart, vertexArray.data()+first+firstPart);
+	vertexArray[first+count] = j2000ToTrailNative*trail.stelObject->getJ2000EquatorialPos(core);
+
+	for (int i=0;i<=count;++i)
+		colorArray[first+i].set(trail.color[0], trail.color[1], trail.color[2], alphas.at(i));
+	for (int i=0;i<count;++i)
+		indexArray << first+i << first+i+1;
+}
+
+void TrailGroup::drawVertices(StelPainter* sPainter)
+{
+	if (!indexArray.isEmpty())
 	{
-		Planet* hpl = dynamic_cast<Planet*>(trail.stelObject.data());
-		if (hpl!=NULL)
-		{
-			// Avoid drawing the trails if the object is the home planet
-			QString homePlanetName = hpl==NULL ? "" : hpl->getEnglishName();
-			if (homePlanetName==StelApp::getInstance().getCore()->getCurrentLocation().planetName)
-				continue;
-		}
-		const QList<Vec3d>& posHistory = trail.posHistory;
-		vertexArray.resize(posHistory.size());
-		colorArray.resize(posHistory.size());
-		for (int i=0;i<posHistory.size();++i)
-		{
-			float colorRatio = 1.f-(currentTime-times.at(i))/timeExtent;
-			colorArray[i].set(trail.color[0], trail.color[1], trail.color[2], colorRatio*opacity);
-			vertexArray[i]=posHistory.at(i);
-		}
 		sPainter->setVertexPointer(3, GL_DOUBLE, vertexArray.constData());
 		sPainter->setColorPointer(4, GL_FLOAT, colorArray.constData());
 		sPainter->enableClientStates(true, false, true);
-		sPainter->drawFromArray(StelPainter::LineStrip, vertexArray.size(), 0, true);
+		sPainter->drawFromArray(StelPainter::Lines, indexArray.size(), 0, true, indexArray.constData());
 		sPainter->enableClientStates(false);
 	}
+	vertexArray.resize(0);
+	colorArray.resize(0);
+	indexArray.resize(0);
 }
 
-// Add 1 point to all the curves at current time and suppress too old points
+// Add 1 point to all the curves at current time if it's far enough from the last one and suppress too old points
 void TrailGroup::update()
 {
-	times.append(StelApp::getInstance().getCore()->getJDay());
-	for (QList<Trail>::Iterator iter=allTrails.begin();iter!=allTrails.end();++iter)
+	StelCore* core = StelApp::getInstance().getCore();
+	const double jd = core->getJDay();
+
+	// When the time goes backward, the points after the current time are removed
+	while (count>0 && times.at(ringIndex(count-1))>jd)
+		--count;
+	while (count>0 && jd-times.at(head)>timeExtent)
+		removeOldestPoint();
+	if (count==0)
 	{
-		iter->posHistory.append(j2000ToTrailNative*iter->stelObject->getJ2000EquatorialPos(StelApp::getInstance().getCore()));
+		// The trails start again with the best resolution
+		head = 0;
+		step = MinTrailStep;
 	}
-	if (StelApp::getInstance().getCore()->getJDay()-times.at(0)>timeExtent)
+	else if (jd-times.at(ringIndex(count-1))<step)
 	{
-		times.pop_front();
-		for (QList<Trail>::Iterator iter=allTrails.begin();iter!=allTrails.end();++iter)
-		{
-			iter->posHistory.pop_front();
-		}
+		return;
 	}
+
+	if (count==maxPoints)
+		decimate();
+	const int r = ringIndex(count);
+	times[r] = jd;
+	for (int t=0;t<allTrails.size();++t)
+		positions[t*maxPoints+r] = j2000ToTrailNative*allTrails.at(t).stelObject->getJ2000EquatorialPos(core);
+	++count;
+}
+
+void TrailGroup::removeOldestPoint()
+{
+	head = (head+1)%maxPoints;
+	--count;
+}
+
+void TrailGroup::decimate()
+{
+	// Put the oldest point at the start of the rings, then keep every other point, including the newest one
+	const int start = (count-1)%2;
+	const int newCount = (count+1-start)/2;
+	std::rotate(times.begin(), times.begin()+head, times.end());
+	for (int k=0;k<newCount;++k)
+		times[k] = times.at(start+2*k);
+	for (int t=0;t<allTrails.size();++t)
+	{
+		Vec3d* ring = positions.data()+t*maxPoints;
+		std::rotate(ring, ring+head, ring+maxPoints);
+		for (int k=0;k<newCount;++k)
+			ring[k] = ring[start+2*k];
+	}
+	head = 0;
+	count = newCount;
+	step *= 2.;
 }
 
 // Set the matrix to use to post process J2000 positions before storing in the trail
@@ -95,13 +179,14 @@ void TrailGroup::setJ2000ToTrailNative(const Mat4d& m)
 void TrailGroup::addObject(const StelObjectP& obj, const Vec3f* col)
 {
 	allTrails.append(TrailGroup::Trail(obj, col==NULL ? obj->getInfoColor() : *col));
+	positions.resize(allTrails.size()*maxPoints);
+	// The new trail has no past positions
+	reset();
 }
 
 void TrailGroup::reset()
 {
-	times.clear();
-	for (QList<Trail>::Iterator iter=allTrails.begin();iter!=allTrails.end();++iter)
-	{
-		iter->posHistory.clear();
-	}
+	head = 0;
+	count = 0;
+	step = MinTrailStep;
 }
@@ -25,15 +25,25 @@
 #include "StelObjectType.hpp"
 
 class StelPainter;
-
+class Planet;
+
+//! @class TrailGroup
+//! Trails of the past positions of a group of objects, e.g. the planets.
+//! The positions are stored in one ring buffer per trail, all sharing a single ring of the times of the
+//! points. Each ring holds a fixed number of points: when it is full, every other point is dropped and the
+//! interval between the points doubles, so that long trails over centuries don't take more memory.
+//! The current position of each object is added at the end of its trail when it is drawn.
 class TrailGroup
 {
 public:
-	TrailGroup(float atimeExtent);
+	//! @param atimeExtent the maximum time extent of the trails in days.
+	//! @param amaxPoints the capacity of the ring of each trail.
+	TrailGroup(float atimeExtent, int amaxPoints=1024);
 
+	//! Draw all the trails at once.
 	void draw(StelCore* core, StelPainter*);
 
-	// Add 1 point to all the curves at current time and suppress too old points
+	// Add 1 point to all the curves at current time if it's far enough from the last one and suppress too old points
 	void update();
 
 	// Set the matrix to use to post process J2000 positions before storing in the trail
@@ -50,19 +60,46 @@ private:
 	class Trail
 	{
 	public:
-		Trail(const StelObjectP& obj, const Vec3f& col) : stelObject(obj), color(col) {;}
+		Trail() : planet(NULL) {;}
+		Trail(const StelObjectP& obj, const Vec3f& col);
 		StelObjectP stelObject;
-		// All previous positions
-		QList<Vec3d> posHistory;
+		// The object as a planet, to skip the trail of the home planet, or NULL
+		const Planet* planet;
 		Vec3f color;
 	};
 
-	QList<Trail> allTrails;
+	//! Position of the point i of the rings, 0 being the oldest.
+	int ringIndex(int i) const {return (head+i)%maxPoints;}
+	void removeOldestPoint();
+	//! Drop every other point, and double the interval between the points.
+	void decimate();
+	//! Append the points of a trail in chronological order, followed by its current position, to the vertices to draw.
+	void appendTrailVertices(StelCore* core, int trail);
+	void drawVertices(StelPainter* sPainter);
+
+	QVector<Trail> allTrails;
 
 	// Maximum time extent in days
 	float timeExtent;
 
-	QList<float> times;
+	// Capacity of the rings
+	int maxPoints;
+	// Ring of the times of the points, shared by all the trails
+	QVector<double> times;
+	// Rings of the positions, the one of the trail t being at t*maxPoints
+	QVector<Vec3d> positions;
+	// Position of the oldest point in the rings
+	int head;
+	// Number of points in the rings
+	int count;
+	// Minimum interval between 2 points in days, increased when the rings are full
+	double step;
+
+	// Per frame buffers of the draw, kept to avoid reallocations
+	QVector<float> alphas;
+	QVector<Vec3d> vertexArray;
+	QVector<Vec4f> colorArray;
+	QVector<unsigned short> indexArray;
 
 	Mat4d j2000ToTrailNative;
 	Mat4d j2000ToTrailNativeInverted;
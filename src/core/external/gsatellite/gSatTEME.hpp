@@ -128,6 +128,14 @@ public:
 		return satrec.error;
 	}
 
+	// Operation: getMeanMotion()
+	//! @brief Get the SGP4 mean motion of the satellite
+	//! @return double Mean motion measured in radians per minute
+	double getMeanMotion() const
+	{
+		return satrec.no;
+	}
+
 private:
 	// Operation:  computeSubPoint
 	//! @brief Compute the Geographic satellite subpoint Vector
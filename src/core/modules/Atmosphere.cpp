@@ -17,9 +17,12 @@
  * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
  */
 
+#include <QAtomicInt>
 #include <QDebug>
 #include <QSettings>
 #include <QOpenGLShaderProgram>
+#include <QRunnable>
+#include <QThreadPool>
 #include "Atmosphere.hpp"
 #include "StelUtils.hpp"
 #include "StelApp.hpp"
@@ -29,17 +32,71 @@
 #include "StelPainter.hpp"
 #include "StelFileMgr.hpp"
 
+#include <cmath>
+
 inline bool myisnan(double value)
 {
 	return value != value;
 }
 
+namespace
+{
+// Number of grid rows a thread takes at once from the shared counter
+const int GridChunkRows = 4;
+// Maximum change of the unprojected viewport samples before the grid points are unprojected again
+const double ProjectionTolerance = 1e-6;
+}
+
+// Rows of the grid are taken in chunks from a counter shared by all the threads
+class AtmosphereGridBatch
+{
+public:
+	AtmosphereGridBatch(Atmosphere* atmosphere) : atmosphere(atmosphere), next(0) {}
+
+	void process()
+	{
+		const int nbRows = atmosphere->skyResolutionY+1;
+		for (int first = next.fetchAndAddOrdered(GridChunkRows); first < nbRows; first = next.fetchAndAddOrdered(GridChunkRows))
+			atmosphere->computeGridRows(first, qMin(first+GridChunkRows, nbRows));
+	}
+
+private:
+	Atmosphere* atmosphere;
+	QAtomicInt next;
+};
+
+namespace
+{
+class AtmosphereGridRunnable : public QRunnable
+{
+public:
+	AtmosphereGridRunnable(AtmosphereGridBatch* batch) : batch(batch) {setAutoDelete(true);}
+	virtual void run() {batch->process();}
+private:
+	AtmosphereGridBatch* batch;
+};
+}
+
 Atmosphere::Atmosphere(void) :viewport(0,0,0,0), posGrid(NULL), posGridBuffer(QOpenGLBuffer::VertexBuffer), 
 	indicesBuffer(QOpenGLBuffer::IndexBuffer), colorGrid(NULL), colorGridBuffer(QOpenGLBuffer::VertexBuffer),
-	averageLuminance(0.f), eclipseFactor(1.f), lightPollutionLuminance(0)
+	averageLuminance(0.f), eclipseFactor(1.f), lightPollutionLuminance(0), gridValid(false), gridUnproject(true),
+	gridProjector(NULL), gridPool(NULL)
 {
 	setFadeDuration(1.5f);
 
+	QSettings* conf = StelApp::getInstance().getSettings();
+	// The sky luminance is only computed again when the sun or moon moved by more than this angle in degree
+	gridTolerance = conf->value("landscape/atmosphere_cache_tolerance", 0.005).toFloat()*M_PI/180.;
+	// The main thread computes the grid with the others
+	const int nbThreads = conf->value("landscape/atmosphere_threads", 1).toInt();
+	if (nbThreads>1)
+	{
+		gridPool = new QThreadPool();
+		gridPool->setMaxThreadCount(nbThreads-1);
+	}
+	for (int i=0;i<9;++i)
+		projectionSamples[i].set(0.,0.,0.);
+
 	qDebug() << "Use vertex shader for atmosphere rendering.";
 	QOpenGLShader vShader(QOpenGLShader::Vertex);
 	if (!vShader.compileSourceFile(":/shaders/xyYToRGB.glsl"))
@@ -101,6 +158,8 @@ Atmosphere::~Atmosphere(void)
 	colorGrid = NULL;
 	delete atmoShaderProgram;
 	atmoShaderProgram = NULL;
+	delete gridPool;
+	gridPool = NULL;
 }
 
 void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moonPhase,
@@ -170,6 +229,15 @@ void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moo
 		colorGridBuffer.bind();
 		colorGridBuffer.allocate(colorGrid, (1+skyResolutionX)*(1+skyResolutionY)*4*4);
 		colorGridBuffer.release();
+
+		const int nbPoints = (1+skyResolutionX)*(1+skyResolutionY);
+		gridPointX.resize(nbPoints);
+		gridPointY.resize(nbPoints);
+		gridPointZ.resize(nbPoints);
+		gridCosDistMoon.resize(nbPoints);
+		gridCosDistSun.resize(nbPoints);
+		gridLuminance.resize(nbPoints);
+		gridValid = false;
 	}
 
 	if (myisnan(_sunPos.length()))
@@ -217,84 +285,161 @@ void Atmosphere::computeColor(double JD, Vec3d _sunPos, Vec3d moonPos, float moo
 	if (!fader.getInterstate())
 	{
 		averageLuminance = 0.001f + lightPollutionLuminance;
+		// The grid no longer matches the average luminance: recompute both when the atmosphere fades in
+		gridValid = false;
 		return;
 	}
 
+	// Calculate the date from the julian day.
+	int year, month, day;
+	StelUtils::getDateFromJulianDay(JD, &year, &month, &day);
+
+	GridParams params;
+	params.sunPos.set(_sunPos[0], _sunPos[1], _sunPos[2]);
+	params.moonPos.set(moonPos[0], moonPos[1], moonPos[2]);
+	params.moonPhase = moonPhase;
+	params.latitude = latitude;
+	params.altitude = altitude;
+	params.temperature = temperature;
+	params.relativeHumidity = relativeHumidity;
+	params.year = year;
+	params.month = month;
+	params.eclipseFactor = eclipseFactor;
+	params.lightPollutionLuminance = lightPollutionLuminance;
+
+	// The grid is kept while the view and the sky barely change
+	gridUnproject = isProjectionChanged(prj.data()) || !gridValid;
+	if (!gridUnproject && isGridUpToDate(params))
+		return;
+	gridParams = params;
+	gridValid = true;
+
 	// Calculate the atmosphere RGB for each point of the grid
 	float sunPos[3];
 	sunPos[0] = _sunPos[0];
 	sunPos[1] = _sunPos[1];
 	sunPos[2] = _sunPos[2];
 
-	float moon_pos[3];
-	moon_pos[0] = moonPos[0];
-	moon_pos[1] = moonPos[1];
-	moon_pos[2] = moonPos[2];
-
 	sky.setParamsv(sunPos, 5.f);
 
 	skyb.setLocation(latitude * M_PI/180., altitude, temperature, relativeHumidity);
-	skyb.setSunMoon(moon_pos[2], sunPos[2]);
-
-	// Calculate the date from the julian day.
-	int year, month, day;
-	StelUtils::getDateFromJulianDay(JD, &year, &month, &day);
+	skyb.setSunMoon(moonPos[2], sunPos[2]);
 	skyb.setDate(year, month, moonPhase);
 
-	// Variables used to compute the average sky luminance
+	// Compute the sky color for every point, the rows are split between the threads
+	gridProjector = prj.data();
+	AtmosphereGridBatch batch(this);
+	int nbRunnables = 0;
+	if (gridPool)
+	{
+		nbRunnables = qMin(gridPool->maxThreadCount(), (skyResolutionY+1)/GridChunkRows);
+		for (int i=0;i<nbRunnables;++i)
+			gridPool->start(new AtmosphereGridRunnable(&batch));
+	}
+	batch.process();
+	if (nbRunnables > 0)
+		gridPool->waitForDone();
+	gridProjector = NULL;
+
+	colorGridBuffer.bind();
+	colorGridBuffer.write(0, colorGrid, (1+skyResolutionX)*(1+skyResolutionY)*4*4);
+	colorGridBuffer.release();
+
+	// Update average luminance
+	const int nbPoints = (1+skyResolutionX)*(1+skyResolutionY);
 	float sum_lum = 0.f;
+	for (int i=0; i<nbPoints; ++i)
+		sum_lum += colorGrid[i][3];
+	averageLuminance = sum_lum/nbPoints;
+}
 
-	Vec3d point(1., 0., 0.);
-	float lumi;
+bool Atmosphere::isGridUpToDate(const GridParams& params) const
+{
+	return gridValid
+		&& (params.sunPos-gridParams.sunPos).length() < gridTolerance
+		&& (params.moonPos-gridParams.moonPos).length() < gridTolerance
+		&& std::fabs(params.moonPhase-gridParams.moonPhase) < gridTolerance
+		&& params.latitude == gridParams.latitude
+		&& params.altitude == gridParams.altitude
+		&& params.temperature == gridParams.temperature
+		&& params.relativeHumidity == gridParams.relativeHumidity
+		&& params.year == gridParams.year
+		&& params.month == gridParams.month
+		&& params.eclipseFactor == gridParams.eclipseFactor
+		&& params.lightPollutionLuminance == gridParams.lightPollutionLuminance;
+}
 
-	// Compute the sky color for every point above the ground
-	for (int i=0; i<(1+skyResolutionX)*(1+skyResolutionY); ++i)
+bool Atmosphere::isProjectionChanged(const StelProjector* prj)
+{
+	// The corners, middle of the edges and center of the viewport cover the view direction, field of view and projection type
+	bool changed = false;
+	Vec3d v;
+	for (int i=0;i<9;++i)
 	{
-		const Vec2f &v(posGrid[i]);
-		prj->unProject(v[0],v[1],point);
-
-		Q_ASSERT(fabs(point.lengthSquared()-1.0) < 1e-10);
+		prj->unProject(viewport[0]+0.5*(i%3)*viewport[2], viewport[1]+0.5*(i/3)*viewport[3], v);
+		if ((v-projectionSamples[i]).lengthSquared() > ProjectionTolerance*ProjectionTolerance)
+		{
+			projectionSamples[i] = v;
+			changed = true;
+		}
+	}
+	return changed;
+}
 
-		if (point[2]<=0)
+void Atmosphere::computeGridRows(int firstRow, int lastRow)
+{
+	const int begin = firstRow*(1+skyResolutionX);
+	const int n = (lastRow-firstRow)*(1+skyResolutionX);
+	float* x = gridPointX.data()+begin;
+	float* y = gridPointY.data()+begin;
+	float* z = gridPointZ.data()+begin;
+	float* cosDistMoon = gridCosDistMoon.data()+begin;
+	float* cosDistSun = gridCosDistSun.data()+begin;
+	float* lumi = gridLuminance.data()+begin;
+
+	if (gridUnproject)
+	{
+		Vec3d point(1., 0., 0.);
+		for (int i=0; i<n; ++i)
 		{
-			point[2] = -point[2];
+			const Vec2f &v(posGrid[begin+i]);
+			gridProjector->unProject(v[0],v[1],point);
+			Q_ASSERT(fabs(point.lengthSquared()-1.0) < 1e-10);
+			x[i] = point[0];
+			y[i] = point[1];
 			// The sky below the ground is the symmetric of the one above :
 			// it looks nice and gives proper values for brightness estimation
+			z[i] = std::fabs(point[2]);
 		}
+	}
 
-		// Use the Skybright.cpp 's models for brightness which gives better results.
-		lumi = skyb.getLuminance(moon_pos[0]*point[0]+moon_pos[1]*point[1]+
-				moon_pos[2]*point[2], sunPos[0]*point[0]+sunPos[1]*point[1]+
-				sunPos[2]*point[2], point[2]);
-		lumi *= eclipseFactor;
-		// Add star background luminance
-		lumi += 0.0001f;
-		// Multiply by the input scale of the ToneConverter (is not done automatically by the xyYtoRGB method called later)
-		//lumi*=eye->getInputScale();
+	const Vec3f& sunPos = gridParams.sunPos;
+	const Vec3f& moonPos = gridParams.moonPos;
+	for (int i=0; i<n; ++i)
+	{
+		cosDistMoon[i] = moonPos[0]*x[i] + moonPos[1]*y[i] + moonPos[2]*z[i];
+		cosDistSun[i] = sunPos[0]*x[i] + sunPos[1]*y[i] + sunPos[2]*z[i];
+	}
 
+	// Use the Skybright.cpp 's models for brightness which gives better results.
+	skyb.getLuminances(cosDistMoon, cosDistSun, z, lumi, n);
+
+	for (int i=0; i<n; ++i)
+	{
+		// Add star background luminance
+		float l = lumi[i]*gridParams.eclipseFactor + 0.0001f;
 		// Add the light pollution luminance AFTER the scaling to avoid scaling it because it is the cause
 		// of the scaling itself
-		lumi += lightPollutionLuminance;
-
-		// Store for later statistics
-		sum_lum+=lumi;
+		l += gridParams.lightPollutionLuminance;
 
 		// Now need to compute the xy part of the color component
 		// This is done in the openGL shader
 		// Store the back projected position + luminance in the input color to the shader
-		colorGrid[i].set(point[0], point[1], point[2], lumi);
+		colorGrid[begin+i].set(x[i], y[i], z[i], l);
 	}
-	
-	colorGridBuffer.bind();
-	colorGridBuffer.write(0, colorGrid, (1+skyResolutionX)*(1+skyResolutionY)*4*4);
-	colorGridBuffer.release();
-	
-	// Update average luminance
-	averageLuminance = sum_lum/((1+skyResolutionX)*(1+skyResolutionY));
 }
 
 
-
 // Draw the atmosphere using the precalc values stored in tab_sky
 void Atmosphere::draw(StelCore* core)
 {
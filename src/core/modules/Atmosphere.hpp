@@ -28,7 +28,9 @@
 #include "StelFader.hpp"
 
 #include <QOpenGLBuffer>
+#include <QVector>
 
+class QThreadPool;
 class StelProjector;
 class StelToneReproducer;
 class StelCore;
@@ -77,6 +79,27 @@ public:
 	float getLightPollutionLuminance() const { return lightPollutionLuminance; }
 
 private:
+	friend class AtmosphereGridBatch;
+
+	//! The parameters of the last computation of the grid luminance.
+	struct GridParams
+	{
+		Vec3f sunPos;
+		Vec3f moonPos;
+		float moonPhase;
+		float latitude, altitude, temperature, relativeHumidity;
+		int year, month;
+		float eclipseFactor;
+		float lightPollutionLuminance;
+	};
+
+	//! Return whether the sky luminance of the grid would be about the same with these parameters.
+	bool isGridUpToDate(const GridParams& params) const;
+	//! Return whether the projection has changed since the grid points were last unprojected.
+	bool isProjectionChanged(const StelProjector* prj);
+	//! Compute the sky position and luminance of the points of the grid rows [firstRow, lastRow).
+	void computeGridRows(int firstRow, int lastRow);
+
 	Vec4i viewport;
 	Skylight sky;
 	Skybright skyb;
@@ -88,6 +111,24 @@ private:
 	Vec4f* colorGrid;
 	QOpenGLBuffer colorGridBuffer;
 
+	//! Sky position of the grid points, reflected above the ground, as separate arrays for the luminance kernel.
+	QVector<float> gridPointX, gridPointY, gridPointZ;
+	//! Work arrays of the luminance kernel.
+	QVector<float> gridCosDistMoon, gridCosDistSun, gridLuminance;
+	//! Parameters of the last grid computation, valid if gridValid is true.
+	GridParams gridParams;
+	bool gridValid;
+	//! Whether the grid points must be unprojected again by computeGridRows().
+	bool gridUnproject;
+	//! The projection used during the grid computation.
+	const StelProjector* gridProjector;
+	//! Unprojected sample points of the viewport used to detect a change of the projection.
+	Vec3d projectionSamples[9];
+	//! Maximum angular change of the sun and moon directions in radian before the grid is recomputed.
+	float gridTolerance;
+	//! Worker threads splitting the rows of the grid, NULL if the grid is computed by the main thread only.
+	QThreadPool* gridPool;
+
 	//! The average luminance of the atmosphere in cd/m2
 	float averageLuminance;
 	float eclipseFactor;
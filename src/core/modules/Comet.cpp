@@ -61,6 +61,7 @@ Comet::Comet(const QString& englishName,
 {
 	texMapName = atexMapName;
 	lastOrbitJD =0;
+	orbitHead = 0;
 	deltaJD = StelCore::JD_SECOND;
 	orbitCached = 0;
 	closeOrbit = acloseOrbit;
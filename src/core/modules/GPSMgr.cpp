@@ -21,6 +21,7 @@
 #include "StelTranslator.hpp"
 #include "StelApp.hpp"
 #include "StelCore.hpp"
+#include "StelLocationMgr.hpp"
 #include "StelModuleMgr.hpp"
 #include "StelQuickView.hpp"
 #include <QDebug>
@@ -72,6 +73,13 @@ void GPSMgr::positionUpdated(const QGeoPositionInfo &info)
 	if (info.coordinate().altitude() == qQNaN())
 		loc.altitude = 0;
 	loc.name = "GPS";
+	// The country and state of the nearest known location, the ID of a GPS location doesn't include them
+	const StelLocation nearest = StelApp::getInstance().getLocationMgr().getNearestLocation(loc.longitude, loc.latitude);
+	if (nearest.isValid())
+	{
+		loc.country = nearest.country;
+		loc.state = nearest.state;
+	}
 	StelApp::getInstance().getCore()->moveObserverTo(loc, 0.);
 	StelApp::getInstance().getCore()->setDefaultLocationID(loc.getID());
 	// Stop GPS when accuracy is < 500 m.
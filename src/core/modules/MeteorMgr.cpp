@@ -26,17 +26,32 @@
 #include "MeteorMgr.hpp"
 #include "StelApp.hpp"
 #include "StelCore.hpp"
-#include "Meteor.hpp"
+#include "MeteorPool.hpp"
 #include "LandscapeMgr.hpp"
 #include "StelModuleMgr.hpp"
 #include "StelPainter.hpp"
+#include "StelUtils.hpp"
 
-MeteorMgr::MeteorMgr(int zhr, int maxv ) : flagShow(true)
+namespace
+{
+	// The radiants of the meteors in the pool
+	enum MeteorRadiant
+	{
+		SporadicRadiant,
+		ShowerRadiant
+	};
+
+	// Maximum number of meteors visible at once, e.g. during a storm with an accelerated time
+	const int MaxActiveMeteors = 4096;
+}
+
+MeteorMgr::MeteorMgr(int zhr, int maxv ) : flagShow(true), showerZHR(0), showerVelocity(0), showerRadiant(0.,0.,1.)
 {
 	setObjectName("MeteorMgr");
 			
 	ZHR = zhr;
 	maxVelocity = maxv;
+	pool = new MeteorPool(MaxActiveMeteors);
 
 	// calculate factor for meteor creation rate per second since visible area ZHR is for
 	// estimated visible radius of 458km
@@ -49,11 +64,8 @@ MeteorMgr::MeteorMgr(int zhr, int maxv ) : flagShow(true)
 
 MeteorMgr::~MeteorMgr()
 {
-	for(std::vector<Meteor*>::iterator iter = active.begin(); iter != active.end(); ++iter)
-	{
-		delete *iter;
-	}
-	active.clear();
+	delete pool;
+	pool = NULL;
 }
 
 void MeteorMgr::init()
@@ -71,6 +83,11 @@ double MeteorMgr::getCallOrder(StelModuleActionName actionName) const
 	return 0;
 }
 
+double MeteorMgr::getRedrawDelay() const
+{
+	return (flagShow && pool->size()>0) ? 0. : -1.;
+}
+
 void MeteorMgr::setZHR(int zhr)
 {
 	ZHR = zhr;
@@ -87,6 +104,20 @@ void MeteorMgr::setMaxVelocity(int maxv)
 	maxVelocity = maxv;
 }
 
+void MeteorMgr::setShower(double ra, double dec, int zhr, int velocity)
+{
+	StelUtils::spheToRect(ra*M_PI/180., dec*M_PI/180., showerRadiant);
+	showerZHR = zhr;
+	showerVelocity = velocity;
+	// The meteors of the previous shower don't belong to the new one, the sporadic meteors stay
+	pool->clearRadiant(ShowerRadiant);
+}
+
+void MeteorMgr::clearShower()
+{
+	showerZHR = 0;
+}
+
 void MeteorMgr::update(double deltaTime)
 {
 #ifdef _MSC_BUILD
@@ -98,24 +129,12 @@ void MeteorMgr::update(double deltaTime)
 	deltaTime*=1000;
 	StelCore* core = StelApp::getInstance().getCore();
 
-	// step through and update all active meteors
-	for (std::vector<Meteor*>::iterator iter = active.begin(); iter != active.end(); ++iter)
-	{
-		if (!(*iter)->update(deltaTime))
-		{
-			// remove dead meteor
-			//      qDebug("Meteor \tdied\n");
-
-			delete *iter;
-			active.erase(iter);
-			iter--;  // important!
-		}
-	}
+	// update all active meteors, in real time
+	pool->update(deltaTime);
 
-	// only makes sense given lifetimes of meteors to draw when timeSpeed is realtime
-	// otherwise high overhead of large numbers of meteors
+	// the meteors are launched at the rate of the sky time, whatever its direction
 	double tspeed = core->getTimeRate()*86400;  // sky seconds per actual second
-	if (tspeed<=0 || fabs(tspeed)>1.)
+	if (tspeed==0)
 	{
 		// don't start any more meteors
 		return;
@@ -127,31 +146,39 @@ void MeteorMgr::update(double deltaTime)
 	{
 		deltaTime = 500;
 	}
+	const double skyTime = deltaTime/1000.*fabs(tspeed);
 
-	// determine average meteors per frame needing to be created
-	int mpf = (int)((double)ZHR*zhrToWsr*deltaTime/1000.0 + 0.5);
-	if (mpf<1)
-		mpf = 1;
-
-	int mlaunch = 0;
-	for (int i=0; i<mpf; ++i)
+	pool->setRadiantFrame(SporadicRadiant, MeteorPool::computeApexFrame(core));
+	launchMeteors(SporadicRadiant, ZHR, maxVelocity, skyTime);
+	if (showerZHR>0)
 	{
-		// start new meteor based on ZHR time probability
-		double prob = ((double)rand())/RAND_MAX;
-		if (ZHR>0 && prob<((double)ZHR*zhrToWsr*deltaTime/1000.0/(double)mpf) )
-		{
-			Meteor *m = new Meteor(StelApp::getInstance().getCore(), maxVelocity);
-			active.push_back(m);
-			mlaunch++;
-		}
+		pool->setRadiantFrame(ShowerRadiant, MeteorPool::computeRadiantFrame(core->j2000ToEquinoxEqu(showerRadiant)));
+		launchMeteors(ShowerRadiant, showerZHR, showerVelocity, skyTime);
 	}
-	//  qDebug("mpf: %d\tm launched: %d\t(mps: %f)\t%d\n", mpf, mlaunch, ZHR*zhrToWsr, deltaTime);
+}
+
+void MeteorMgr::launchMeteors(int radiant, int zhr, int velocity, double skyTime)
+{
+	if (zhr<=0)
+		return;
+	// determine the number of meteors needing to be created, the fractional part
+	// being created with its probability
+	const double expected = (double)zhr*zhrToWsr*skyTime;
+	int mlaunch = (int)expected;
+	if (((double)rand())/RAND_MAX < expected-mlaunch)
+		mlaunch++;
+	// most of the meteors are not visible from the observer, and the launch fails
+	mlaunch = qMin(mlaunch, pool->getCapacity());
+
+	const StelCore* core = StelApp::getInstance().getCore();
+	for (int i=0; i<mlaunch && !pool->isFull(); ++i)
+		pool->launch(core, radiant, velocity);
 }
 
 
 void MeteorMgr::draw(StelCore* core)
 {
-	if (!flagShow)
+	if (!flagShow || pool->size()==0)
 		return;
 	
 	LandscapeMgr* landmgr = (LandscapeMgr*)StelApp::getInstance().getModuleMgr().getModule("LandscapeMgr");
@@ -163,9 +190,6 @@ void MeteorMgr::draw(StelCore* core)
 	glEnable(GL_BLEND);
 	sPainter.enableTexture2d(false);
 
-	// step through and draw all active meteors
-	for (std::vector<Meteor*>::iterator iter = active.begin(); iter != active.end(); ++iter)
-	{
-		(*iter)->draw(core, sPainter);
-	}
+	// draw all active meteors at once
+	pool->draw(core, sPainter);
 }
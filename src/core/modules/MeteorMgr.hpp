@@ -20,13 +20,15 @@
 #ifndef _METEORMGR_HPP_
 #define _METEORMGR_HPP_
 
-#include <vector>
 #include "StelModule.hpp"
+#include "VecMath.hpp"
 
-class Meteor;
+class MeteorPool;
 
 //! @class MeteorMgr
-//! Simulates a meteor shower.
+//! Simulates the sporadic meteors and a meteor shower.
+//! The meteors are launched at the rate of the sky time, even when the time is accelerated, but each meteor
+//! burns at the speed of the real time, since it would only flash during a frame otherwise.
 class MeteorMgr : public StelModule
 {
 	Q_OBJECT
@@ -56,6 +58,9 @@ public:
 	//! ones based on the current rate, and removes those which have run their 
 	//! course.
 	virtual void update(double deltaTime);
+
+	//! The next frame is needed while meteors are visible. The new meteors only appear at the next frame.
+	virtual double getRedrawDelay() const;
 	
 	//! Defines the order in which the various modules are drawn.
 	virtual double getCallOrder(StelModuleActionName actionName) const;
@@ -75,16 +80,33 @@ public slots:
 	
 	//! Set the maximum velocity in km/s
 	void setMaxVelocity(int maxv);
+
+	//! Simulate a meteor shower, in addition to the sporadic meteors.
+	//! @param ra, dec the J2000 equatorial coordinates of the radiant in degrees.
+	//! @param zhr the zenith hourly rate of the shower, e.g. several thousands for a storm.
+	//! @param velocity the velocity of the meteors of the shower in km/s, e.g. 71 for the Leonids.
+	void setShower(double ra, double dec, int zhr, int velocity);
+	//! Stop the meteor shower, only the sporadic meteors remain.
+	void clearShower();
+	//! Get the zenith hourly rate of the meteor shower, 0 if there is none.
+	int getShowerZHR() const {return showerZHR;}
 	
 signals:
 	void zhrChanged(int);
 	
 private:
-	std::vector<Meteor*> active;		// Vector containing all active meteors
+	//! Launch the meteors of a radiant for the elapsed sky time.
+	void launchMeteors(int radiant, int zhr, int velocity, double skyTime);
+
+	MeteorPool* pool;		// All active meteors
 	int ZHR;
 	int maxVelocity;
 	double zhrToWsr;  // factor to convert from zhr to whole earth per second rate
 	bool flagShow;
+
+	int showerZHR;
+	int showerVelocity;
+	Vec3d showerRadiant;  // J2000 direction of the radiant
 };
 
 
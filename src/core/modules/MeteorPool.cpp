@@ -0,0 +1,348 @@
+/*
+ * Stellarium
+ * This file Copyright (C) 2004 Robert Spearman
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+// This is an ad hoc meteor model
+// Could use a simple ablation physics model in the future
+
+/*
+NOTE: The radiant of the sporadic meteors is always along the ecliptic at the apex of the Earth's way.
+The meteor showers have their own radiants, which are generally not at the apex of the Earth's way.
+*/
+
+// Improved realism and efficiency 2004-12
+
+#include <cstdlib>
+#include "MeteorPool.hpp"
+#include "StelCore.hpp"
+
+#include "StelToneReproducer.hpp"
+#include "StelMovementMgr.hpp"
+#include "StelPainter.hpp"
+#include "StelSkyDrawer.hpp"
+#include "RefractionExtinction.hpp"
+
+MeteorPool::MeteorPool(int acapacity) : capacity(acapacity), count(0)
+{
+	Q_ASSERT(capacity>0);
+	for (int r=0;r<MaxRadiants;++r)
+		radiantFrames[r] = Mat4d::identity();
+	radiant.resize(capacity);
+	train.resize(capacity);
+	pathOrigin.resize(capacity);
+	pathDirection.resize(capacity);
+	headZ.resize(capacity);
+	trainZ.resize(capacity);
+	startH.resize(capacity);
+	endH.resize(capacity);
+	velocity.resize(capacity);
+	mag.resize(capacity);
+	obsZ.resize(capacity);
+	xydistance.resize(capacity);
+	minDist.resize(capacity);
+	distMultiplier.resize(capacity);
+	lineVertices.reserve(capacity*4);
+	lineColors.reserve(capacity*4);
+	pointVertices.reserve(capacity);
+}
+
+void MeteorPool::setRadiantFrame(int r, const Mat4d& frame)
+{
+	Q_ASSERT(r>=0 && r<MaxRadiants);
+	radiantFrames[r] = frame;
+}
+
+void MeteorPool::clearRadiant(int r)
+{
+	int i = 0;
+	while (i<count)
+	{
+		if (radiant[i]==r)
+			remove(i);
+		else
+			++i;
+	}
+}
+
+Mat4d MeteorPool::computeApexFrame(const StelCore* core)
+{
+	// determine meteor model view matrix (want z in dir of travel of earth, z=0 at center of earth)
+	// meteor life is so short, no need to recalculate during the life of a meteor
+	double equ_rotation; // rotation needed to align with path of earth
+	Vec3d sun_dir = core->heliocentricEclipticToEquinoxEqu( Vec3d(0,0,0) );
+
+	Mat4d tmat = Mat4d::xrotation(-23.45f*M_PI/180.f);  // ecliptical tilt
+	sun_dir.transfo4d(tmat);  // convert to ecliptical coordinates
+	sun_dir.normalize();
+	equ_rotation = acos( sun_dir.dot( Vec3d(1,0,0) ) );
+	if( sun_dir[1] < 0 ) equ_rotation = 2*M_PI - equ_rotation;
+
+	equ_rotation -= M_PI_2;
+
+	return Mat4d::xrotation(23.45f*M_PI/180.f) * Mat4d::zrotation(equ_rotation) * Mat4d::yrotation(M_PI_2);
+}
+
+Mat4d MeteorPool::computeRadiantFrame(const Vec3d& aradiant)
+{
+	Vec3d z(aradiant);
+	z.normalize();
+	// Any x axis orthogonal to the path will do, the meteors are spread around it
+	Vec3d x = Vec3d(0,0,1)^z;
+	if (x.length()<1e-6)
+		x = Vec3d(1,0,0);
+	x.normalize();
+	const Vec3d y = z^x;
+	return Mat4d(x[0], x[1], x[2], 0,
+	             y[0], y[1], y[2], 0,
+	             z[0], z[1], z[2], 0,
+	             0, 0, 0, 1);
+}
+
+bool MeteorPool::launch(const StelCore* core, int r, float v)
+{
+	Q_ASSERT(r>=0 && r<MaxRadiants);
+	if (isFull())
+		return false;
+
+	const Mat4d& mmat = radiantFrames[r];
+
+	// select random trajectory using polar coordinates in XY plane, centered on observer
+	const double xyd = (double)rand()/((double)RAND_MAX+1)*(VISIBLE_RADIUS);
+	const double angle = (double)rand()/((double)RAND_MAX+1)*2*M_PI;
+
+	// find observer position in meteor coordinate system
+	Vec3d obs = core->altAzToEquinoxEqu(Vec3d(0,0,EARTH_RADIUS));
+	obs.transfo4d(mmat.transpose());
+
+	// set meteor start x,y
+	const double x = xyd*cos(angle) +obs[0];
+	const double y = xyd*sin(angle) +obs[1];
+
+	// determine life of meteor (start and end z value based on atmosphere burn altitudes)
+
+	// D is distance from center of earth
+	const double D = sqrt(x*x + y*y);
+
+	if( D > EARTH_RADIUS+HIGH_ALTITUDE ) {
+		// won't be visible
+		return false;
+	}
+
+	const double sH = sqrt( pow(EARTH_RADIUS+HIGH_ALTITUDE,2) - D*D);
+	double eH;
+	double minD;
+
+	// determine end of burn point, and nearest point to observer for distance mag calculation
+	// mag should be max at nearest point still burning
+	if( D > EARTH_RADIUS+LOW_ALTITUDE ) {
+		eH = -sH;  // earth grazing
+		minD = xyd;
+	} else {
+		eH = sqrt( pow(EARTH_RADIUS+LOW_ALTITUDE,2) - D*D);
+		minD = sqrt( xyd*xyd + pow( eH - obs[2], 2) );
+	}
+
+	if(minD > VISIBLE_RADIUS ) {
+		// on average, not visible (although if were zoomed ...)
+		return false;
+	}
+
+	// Determine drawing color given magnitude and eye
+	// (won't be visible during daylight)
+
+	// *** color varies somewhat based on velocity, plus atmosphere reddening
+
+	// determine intensity
+	float Mag1 = (double)rand()/((double)RAND_MAX+1)*6.75f - 3;
+	float Mag2 = (double)rand()/((double)RAND_MAX+1)*6.75f - 3;
+	float Mag = (Mag1 + Mag2)/2.0f;
+
+	float m = (5. + Mag) / 256.0;
+	if (m>250) m = m - 256;
+
+	float term1 = std::exp(-0.92103f*(m + 12.12331f)) * 108064.73f;
+
+	float cmag=1.f;
+	float rmag;
+
+	// Compute the equivalent star luminance for a 5 arc min circle and convert it
+	// in function of the eye adaptation
+	rmag = core->getToneReproducer()->adaptLuminanceScaled(term1);
+	rmag = rmag/powf(core->getMovementMgr()->getCurrentFov(),0.85f)*500.f;
+
+	// if size of star is too small (blink) we put its size to 1.2 --> no more blink
+	// And we compensate the difference of brighteness with cmag
+	if (rmag<1.2f) {
+		cmag=rmag*rmag/1.44f;
+	}
+
+	m = cmag;  // assumes white
+
+	// most visible meteors are under about 180km distant
+	// scale max mag down if outside this range
+	float scale = 1;
+	if(minD!=0) scale = 180*180/(minD*minD);
+	if( scale < 1 ) m *= scale;
+
+	// Keep the path in the local frame of the launch, without refraction which isn't linear.
+	// Otherwise the meteors would follow the rotation of the sky with an accelerated time,
+	// and jump when the frame of their radiant is updated.
+	Vec3d origin(x, y, 0.);
+	origin.transfo4d(mmat);
+	origin = core->equinoxEquToAltAz(origin, StelCore::RefractionOff);
+	Vec3d direction(0., 0., 1.);
+	direction.transfo4d(mmat);
+	direction = core->equinoxEquToAltAz(direction, StelCore::RefractionOff);
+
+	const int i = count++;
+	radiant[i] = r;
+	train[i] = 0;
+	pathOrigin[i] = Vec3f(origin[0], origin[1], origin[2]);
+	pathDirection[i] = Vec3f(direction[0], direction[1], direction[2]);
+	headZ[i] = trainZ[i] = startH[i] = sH;
+	endH[i] = eH;
+	velocity[i] = v;
+	mag[i] = m;
+	obsZ[i] = obs[2];
+	xydistance[i] = xyd;
+	minDist[i] = minD;
+	distMultiplier[i] = 1.f;
+	return true;
+}
+
+void MeteorPool::remove(int i)
+{
+	const int last = --count;
+	if (i==last)
+		return;
+	radiant[i] = radiant[last];
+	train[i] = train[last];
+	pathOrigin[i] = pathOrigin[last];
+	pathDirection[i] = pathDirection[last];
+	headZ[i] = headZ[last];
+	trainZ[i] = trainZ[last];
+	startH[i] = startH[last];
+	endH[i] = endH[last];
+	velocity[i] = velocity[last];
+	mag[i] = mag[last];
+	obsZ[i] = obsZ[last];
+	xydistance[i] = xydistance[last];
+	minDist[i] = minDist[last];
+	distMultiplier[i] = distMultiplier[last];
+}
+
+void MeteorPool::update(double deltaTime)
+{
+	const float dt = deltaTime/1000.;
+	// The last meteor replaces the dead ones, so only go to the next one when the current one survives
+	int i = 0;
+	while (i<count)
+	{
+		const float dz = velocity[i]*dt;
+		if (headZ[i] < endH[i])
+		{
+			// burning has stopped so magnitude fades out
+			// assume linear fade out (the maximum magnitude is 1)
+			mag[i] -= deltaTime/500.0f;
+			if (mag[i] < 0)
+			{
+				// no longer visible
+				remove(i);
+				continue;
+			}
+		}
+
+		// *** would need time direction multiplier to allow reverse time replay
+		headZ[i] -= dz;
+
+		// train doesn't extend beyond start of burn
+		if (headZ[i] + velocity[i]*0.5f > startH[i])
+			trainZ[i] = startH[i];
+		else
+			trainZ[i] -= dz;
+
+		// determine visual magnitude based on distance to observer
+		const float dh = headZ[i]-obsZ[i];
+		float dist2 = xydistance[i]*xydistance[i] + dh*dh;
+		if (dist2 == 0) dist2 = .0001f;  // just to be cautious (meteor hits observer!)
+		distMultiplier[i] = minDist[i]*minDist[i] / dist2;
+		++i;
+	}
+}
+
+Vec3d MeteorPool::toAltAz(const Refraction* refraction, int i, float z) const
+{
+	const Vec3f& o = pathOrigin[i];
+	const Vec3f& d = pathDirection[i];
+	Vec3d p(o[0]+z*d[0], o[1]+z*d[1], o[2]+z*d[2]);
+	if (refraction)
+		refraction->forward(p);
+	// correct for earth radius [since equ and local coordinates in stellarium use same 0 point!]
+	p[2] -= EARTH_RADIUS;
+	// 1216 is to scale down under 1 for desktop version
+	p /= 1216;
+	return p;
+}
+
+// Assumes that we are in local frame
+void MeteorPool::draw(const StelCore* core, StelPainter& sPainter)
+{
+	lineVertices.resize(0);
+	lineColors.resize(0);
+	pointVertices.resize(0);
+	// The refraction of StelCore::equinoxEquToAltAz(), applied to the paths in the local frame
+	const StelSkyDrawer* skyDrawer = core->getSkyDrawer();
+	const Refraction* refraction = skyDrawer && skyDrawer->getFlagHasAtmosphere() ? &skyDrawer->getRefraction() : NULL;
+	for (int i=0;i<count;++i)
+	{
+		const Vec3d spos = toAltAz(refraction, i, headZ[i]);
+		if (train[i])
+		{
+			// connect this point with last drawn point
+			const float tmag = mag[i]*distMultiplier[i];
+			// compute an intermediate point so can curve slightly along projection distortions
+			const Vec3d posi = toAltAz(refraction, i, headZ[i] + (trainZ[i] - headZ[i])/2);
+			const Vec3d epos = toAltAz(refraction, i, trainZ[i]);
+
+			// draw dark to light, as 2 segments
+			lineVertices << epos << posi << posi << spos;
+			lineColors << Vec4f(0,0,0,0) << Vec4f(1,1,1,tmag*0.5) << Vec4f(1,1,1,tmag*0.5) << Vec4f(1,1,1,tmag);
+		}
+		else
+		{
+			pointVertices << spos;
+			train[i] = 1;
+		}
+	}
+
+	if (!lineVertices.isEmpty())
+	{
+		sPainter.setColorPointer(4, GL_FLOAT, lineColors.constData());
+		sPainter.setVertexPointer(3, GL_DOUBLE, lineVertices.constData());
+		sPainter.enableClientStates(true, false, true);
+		sPainter.drawFromArray(StelPainter::Lines, lineVertices.size(), 0, true);
+		sPainter.enableClientStates(false);
+	}
+	if (!pointVertices.isEmpty())
+	{
+		sPainter.setVertexPointer(3, GL_DOUBLE, pointVertices.constData());
+		sPainter.enableClientStates(true);
+		sPainter.drawFromArray(StelPainter::Points, pointVertices.size(), 0, true);
+		sPainter.enableClientStates(false);
+	}
+}
@@ -0,0 +1,117 @@
+/*
+ * Stellarium
+ * This file Copyright (C) 2004 Robert Spearman
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _METEORPOOL_HPP_
+#define _METEORPOOL_HPP_
+
+#include "VecMath.hpp"
+
+#include <QVector>
+
+class Refraction;
+class StelCore;
+class StelPainter;
+
+// all in km - altitudes make up meteor range
+#define EARTH_RADIUS 6369.f
+#define HIGH_ALTITUDE 115.f
+#define LOW_ALTITUDE 70.f
+#define VISIBLE_RADIUS 457.8f
+
+//! @class MeteorPool
+//! Models the visible meteors, in a pool of fixed capacity.
+//! Control of the meteor rate is performed in the MeteorMgr class. Each meteor comes from a radiant and
+//! travels along a straight line in the coordinate system of its radiant, whose z axis points to the
+//! radiant. At launch the path is converted to the local frame, so that the meteor stays fixed relative to
+//! the ground whatever the time rate. Once launched, a meteor only lasts for some amount of time, and then "dies".
+//! The meteors are stored as structure of arrays, the dead ones are replaced by the last one, and all
+//! the meteors are drawn at once, so that a meteor storm doesn't allocate anything nor stall the frames.
+class MeteorPool
+{
+public:
+	//! Maximum number of radiants of the meteors.
+	static const int MaxRadiants = 4;
+
+	//! Create a pool for at most capacity meteors, all allocated at once.
+	MeteorPool(int capacity);
+
+	int size() const {return count;}
+	int getCapacity() const {return capacity;}
+	bool isFull() const {return count>=capacity;}
+	void clear() {count = 0;}
+	//! Remove the meteors of a radiant.
+	void clearRadiant(int radiant);
+
+	//! Set the coordinate system of the meteors of a radiant, for the meteors launched afterwards.
+	//! @param frame the transformation from the meteor coordinates to equinox equatorial coordinates.
+	void setRadiantFrame(int radiant, const Mat4d& frame);
+
+	//! Coordinate system of the sporadic meteors, whose radiant is the apex of the Earth's way along the ecliptic.
+	static Mat4d computeApexFrame(const StelCore* core);
+
+	//! Coordinate system of a meteor shower.
+	//! @param radiant the direction of the radiant in equinox equatorial coordinates.
+	static Mat4d computeRadiantFrame(const Vec3d& radiant);
+
+	//! Launch a meteor from a random position around the observer.
+	//! @param velocity the velocity of the meteor in km/s.
+	//! @return false if the meteor wouldn't be visible or the pool is full, in which case it isn't added.
+	bool launch(const StelCore* core, int radiant, float velocity);
+
+	//! Update the position of the meteors, and remove the ones which burned out.
+	//! @param deltaTime the time increment in ms.
+	void update(double deltaTime);
+
+	//! Draw all the meteors with a single call for the trains, in the local frame.
+	void draw(const StelCore* core, StelPainter& sPainter);
+
+private:
+	//! Replace the meteor i by the last one.
+	void remove(int i);
+	//! Position of a point of the path of meteor i in the local frame, scaled like the rest of the sky.
+	//! @param refraction the refraction to apply, NULL without atmosphere.
+	Vec3d toAltAz(const Refraction* refraction, int i, float z) const;
+
+	int capacity;
+	int count;
+	Mat4d radiantFrames[MaxRadiants];
+
+	// The meteors, one element of each array per meteor
+	QVector<quint8> radiant;
+	QVector<quint8> train;    // whether the train is visible, i.e. the meteor was drawn once
+	QVector<Vec3f> pathOrigin;     // point of the path at height 0, in the local frame of the launch
+	QVector<Vec3f> pathDirection;  // unit vector of the path toward the radiant, in the same frame
+	QVector<float> headZ;     // height of the head along the path
+	QVector<float> trainZ;    // height of the end of the train
+	QVector<float> startH;    // start height above center of earth
+	QVector<float> endH;      // end height
+	QVector<float> velocity;  // km/s
+	QVector<float> mag;       // apparent magnitude at head, 0-1
+	QVector<float> obsZ;      // observer position along the path
+	QVector<float> xydistance;  // distance in XY plane (orthogonal to meteor path) from observer to meteor
+	QVector<float> minDist;   // nearest point to observer along path
+	QVector<float> distMultiplier;  // scale magnitude due to changes in distance
+
+	// Vertices of the batched draw, kept to avoid reallocations
+	QVector<Vec3d> lineVertices;
+	QVector<Vec4f> lineColors;
+	QVector<Vec3d> pointVertices;
+};
+
+#endif // _METEORPOOL_HPP_
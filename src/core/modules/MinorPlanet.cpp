@@ -62,6 +62,7 @@ MinorPlanet::MinorPlanet(const QString& englishName,
 {
 	texMapName = atexMapName;
 	lastOrbitJD =0;
+	orbitHead = 0;
 	deltaJD = StelCore::JD_SECOND;
 	orbitCached = 0;
 	closeOrbit = acloseOrbit;
@@ -71,6 +71,7 @@ public:
 
 private:
 	friend struct DrawNebulaFuncObject;
+	friend struct FindNebulaFuncObject;
 	
 	//! @enum NebulaType Nebula types
 	enum NebulaType
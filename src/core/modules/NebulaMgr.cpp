@@ -311,6 +311,31 @@ QList<StelObjectP> NebulaMgr::searchAround(const Vec3d& av, double limitFov, con
 	return result;
 }
 
+struct FindNebulaFuncObject
+{
+	FindNebulaFuncObject(StelObjectFinder& afinder) : finder(afinder) {;}
+	void operator()(const StelRegionObjectP& obj)
+	{
+		const Nebula* n = static_cast<const Nebula*>(obj.data());
+		if (n->XYZ*finder.getPosition()<finder.getCosLimitFov())
+			return;
+		const float priority = n->getSelectPriority(finder.getCore());
+		if (!finder.isCandidate(priority))
+			return;
+		finder.add(qSharedPointerCast<Nebula>(obj), finder.getValue(n->XYZ, priority));
+	}
+	StelObjectFinder& finder;
+};
+
+void NebulaMgr::findAround(StelObjectFinder& finder) const
+{
+	if (!getFlagShow())
+		return;
+
+	FindNebulaFuncObject func(finder);
+	nebGrid.processBoundingCapIntersectingObjects(SphericalCap(finder.getPosition(), finder.getCosLimitFov()), func);
+}
+
 NebulaP NebulaMgr::searchM(unsigned int M)
 {
 	foreach (const NebulaP& n, nebArray)
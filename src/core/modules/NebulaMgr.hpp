@@ -83,6 +83,9 @@ public:
 	//! @return an list containing the nebulae located inside the limitFov circle around position v.
 	virtual QList<StelObjectP> searchAround(const Vec3d& v, double limitFov, const StelCore* core) const;
 
+	//! Give the nebulae around the position of the finder using the spatial index of the nebulae.
+	virtual void findAround(StelObjectFinder& finder) const;
+
 	//! Return the matching nebula object's pointer if exists or NULL.
 	//! @param nameI18n The case in-sensistive nebula name or NGC M catalog name : format can
 	//! be M31, M 31, NGC31, NGC 31
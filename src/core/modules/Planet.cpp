@@ -75,6 +75,7 @@ Planet::Planet(const QString& englishName,
 {
 	texMapName = atexMapName;
 	lastOrbitJD =0;
+	orbitHead = 0;
 	deltaJD = StelCore::JD_SECOND;
 	orbitCached = 0;
 	closeOrbit = acloseOrbit;
@@ -302,129 +303,54 @@ void Planet::computePositionWithoutOrbits(const double date)
 
 void Planet::computePosition(const double date)
 {
+	// The orbit points are only brought to the date when the orbit is drawn, see updateOrbit()
+	computePositionWithoutOrbits(date);
+}
 
-	if (orbitFader.getInterstate()>0.000001 && deltaOrbitJD > 0 && (fabs(lastOrbitJD-date)>deltaOrbitJD || !orbitCached))
-	{
-		double calc_date;
-		// int delta_points = (int)(0.5 + (date - lastOrbitJD)/date_increment);
-		int delta_points;
-
-		if( date > lastOrbitJD )
-		{
-			delta_points = (int)(0.5 + (date - lastOrbitJD)/deltaOrbitJD);
-		}
-		else
-		{
-			delta_points = (int)(-0.5 + (date - lastOrbitJD)/deltaOrbitJD);
-		}
-		double new_date = lastOrbitJD + delta_points*deltaOrbitJD;
-
-		// qDebug( "Updating orbit coordinates for %s (delta %f) (%d points)\n", name.c_str(), deltaOrbitJD, delta_points);
-
-		if( delta_points > 0 && delta_points < ORBIT_SEGMENTS && orbitCached)
-		{
-
-			for( int d=0; d<ORBIT_SEGMENTS-1; d++ )
-			{
-				if(d + delta_points >= ORBIT_SEGMENTS )
-				{
-					// calculate new points
-					calc_date = new_date + (d-ORBIT_SEGMENTS/2)*deltaOrbitJD;
-
-					// date increments between points will not be completely constant though
-					computeTransMatrix(calc_date);
-					if (osculatingFunc)
-					{
-						(*osculatingFunc)(date,calc_date,eclipticPos);
-					}
-					else
-					{
-						coordFunc(calc_date, eclipticPos, userDataPtr);
-					}
-					orbitP[d] = eclipticPos;
-					orbit[d] = getHeliocentricEclipticPos();
-				}
-				else
-				{
-					orbitP[d] = orbitP[d+delta_points];
-					orbit[d] = getHeliocentricPos(orbitP[d]);
-				}
-			}
-
-			lastOrbitJD = new_date;
-		}
-		else if( delta_points < 0 && abs(delta_points) < ORBIT_SEGMENTS  && orbitCached)
-		{
-
-			for( int d=ORBIT_SEGMENTS-1; d>=0; d-- )
-			{
-				if(d + delta_points < 0 )
-				{
-					// calculate new points
-					calc_date = new_date + (d-ORBIT_SEGMENTS/2)*deltaOrbitJD;
-
-					computeTransMatrix(calc_date);
-					if (osculatingFunc) {
-						(*osculatingFunc)(date,calc_date,eclipticPos);
-					}
-					else
-					{
-						coordFunc(calc_date, eclipticPos, userDataPtr);
-					}
-					orbitP[d] = eclipticPos;
-					orbit[d] = getHeliocentricEclipticPos();
-				}
-				else
-				{
-					orbitP[d] = orbitP[d+delta_points];
-					orbit[d] = getHeliocentricPos(orbitP[d]);
-				}
-			}
-
-			lastOrbitJD = new_date;
-
-		}
-		else if( delta_points || !orbitCached)
-		{
-
-			// update all points (less efficient)
-			for( int d=0; d<ORBIT_SEGMENTS; d++ )
-			{
-				calc_date = date + (d-ORBIT_SEGMENTS/2)*deltaOrbitJD;
-				computeTransMatrix(calc_date);
-				if (osculatingFunc)
-				{
-					(*osculatingFunc)(date,calc_date,eclipticPos);
-				}
-				else
-				{
-					coordFunc(calc_date, eclipticPos, userDataPtr);
-				}
-				orbitP[d] = eclipticPos;
-				orbit[d] = getHeliocentricEclipticPos();
-			}
-
-			lastOrbitJD = date;
-			if (!osculatingFunc) orbitCached = 1;
-		}
-
-
-		// calculate actual Planet position
-		coordFunc(date, eclipticPos, userDataPtr);
+void Planet::updateOrbit(const double date)
+{
+	if (deltaOrbitJD <= 0 || (orbitCached && fabs(lastOrbitJD-date)<=deltaOrbitJD))
+		return;
 
-		lastJD = date;
+	int deltaPoints;
+	if (date > lastOrbitJD)
+		deltaPoints = (int)(0.5 + (date - lastOrbitJD)/deltaOrbitJD);
+	else
+		deltaPoints = (int)(-0.5 + (date - lastOrbitJD)/deltaOrbitJD);
 
+	// Range of the points to compute, counted from the head of the circular buffer.
+	// The osculating orbits depend on the date, they can't reuse any point.
+	int dirtyBegin = 0;
+	int dirtyEnd = ORBIT_SEGMENTS;
+	if (orbitCached && !osculatingFunc && deltaPoints > 0 && deltaPoints < ORBIT_SEGMENTS)
+	{
+		// Time goes forward: the earliest points are overwritten by the new latest ones
+		lastOrbitJD += deltaPoints*deltaOrbitJD;
+		orbitHead = (orbitHead + deltaPoints) % ORBIT_SEGMENTS;
+		dirtyBegin = ORBIT_SEGMENTS - deltaPoints;
 	}
-	else if (fabs(lastJD-date)>deltaJD)
+	else if (orbitCached && !osculatingFunc && deltaPoints < 0 && -deltaPoints < ORBIT_SEGMENTS)
 	{
-		// calculate actual Planet position
-		coordFunc(date, eclipticPos, userDataPtr);
-		// XXX: do we need to do that even when the orbit is not visible?
-		for( int d=0; d<ORBIT_SEGMENTS; d++ )
-			orbit[d]=getHeliocentricPos(orbitP[d]);
-		lastJD = date;
+		// Time goes backward: the latest points are overwritten by the new earliest ones
+		lastOrbitJD += deltaPoints*deltaOrbitJD;
+		orbitHead = (orbitHead + deltaPoints + ORBIT_SEGMENTS) % ORBIT_SEGMENTS;
+		dirtyEnd = -deltaPoints;
+	}
+	else
+	{
+		lastOrbitJD = date;
 	}
 
+	for (int d=dirtyBegin; d<dirtyEnd; ++d)
+	{
+		const double calcDate = lastOrbitJD + (d-ORBIT_SEGMENTS/2)*deltaOrbitJD;
+		Vec3d& point = orbitP[(orbitHead+d) % ORBIT_SEGMENTS];
+		if (osculatingFunc)
+			(*osculatingFunc)(date, calcDate, point);
+		else
+			coordFunc(calcDate, point, userDataPtr);
+	}
+	orbitCached = true;
 }
 
 // Compute the transformation matrix from the local Planet coordinate to the parent Planet coordinate
@@ -1143,8 +1069,22 @@ void Planet::drawOrbit(const StelCore* core)
 	if (!re.siderealPeriod)
 		return;
 
+	// The orbit is computed at the date of the last computed position, i.e. with the light time travel
+	updateOrbit(lastJD);
+
 	const StelProjectorP prj = core->getProjection(StelCore::FrameHeliocentricEcliptic);
 
+	// The orbit points are relative to the parent, convert them to heliocentric coordinates here
+	// so that it's only done for the orbits which are drawn.
+	// Special case - use current Planet position as center vertex so that draws
+	// on it's orbit all the time (since segmented rather than smooth curve)
+	const Vec3d parentPos = getHeliocentricPos(Vec3d(0.));
+	Vec3d orbit[ORBIT_SEGMENTS+1];
+	for (int d=0; d<ORBIT_SEGMENTS; ++d)
+		orbit[d] = orbitP[(orbitHead+d) % ORBIT_SEGMENTS] + parentPos;
+	orbit[ORBIT_SEGMENTS/2] = getHeliocentricEclipticPos();
+	orbit[ORBIT_SEGMENTS] = orbit[0];
+
 	StelPainter sPainter(prj);
 
 	// Normal transparency mode
@@ -1153,11 +1093,6 @@ void Planet::drawOrbit(const StelCore* core)
 
 	sPainter.setColor(orbitColor[0], orbitColor[1], orbitColor[2], orbitFader.getInterstate());
 	Vec3d onscreen;
-	// special case - use current Planet position as center vertex so that draws
-	// on it's orbit all the time (since segmented rather than smooth curve)
-	Vec3d savePos = orbit[ORBIT_SEGMENTS/2];
-	orbit[ORBIT_SEGMENTS/2]=getHeliocentricEclipticPos();
-	orbit[ORBIT_SEGMENTS]=orbit[0];
 	int nbIter = closeOrbit ? ORBIT_SEGMENTS : ORBIT_SEGMENTS-1;
 	QVarLengthArray<float, 1024> vertexArray;
 
@@ -1177,7 +1112,6 @@ void Planet::drawOrbit(const StelCore* core)
 			vertexArray.clear();
 		}
 	}
-	orbit[ORBIT_SEGMENTS/2]=savePos;
 	if (!vertexArray.isEmpty())
 	{
 		sPainter.setVertexPointer(2, GL_FLOAT, vertexArray.constData());
@@ -222,9 +222,11 @@ public:
 	LinearFader orbitFader;
 	// draw orbital path of Planet
 	void drawOrbit(const StelCore*);
-	Vec3d orbit[ORBIT_SEGMENTS+1];   // store heliocentric coordinates for drawing the orbit
-	Vec3d orbitP[ORBIT_SEGMENTS+1];  // store local coordinate for orbit
-	double lastOrbitJD;
+	// Bring the orbit points to the given date, only computing the points which are not cached yet
+	void updateOrbit(double date);
+	Vec3d orbitP[ORBIT_SEGMENTS];    // circular buffer of the orbit points in the parent coordinate system
+	int orbitHead;                   // index in orbitP of the first (earliest) orbit point
+	double lastOrbitJD;              // date of the middle orbit point
 	double deltaJD;
 	double deltaOrbitJD;
 	bool orbitCached;                // whether orbit calculations are cached for drawing orbit yet
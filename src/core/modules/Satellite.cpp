@@ -423,34 +423,41 @@ void Satellite::update(double)
 		double JD = core->getJDay();
 		epochTime = JD - core->getDeltaT(JD)/86400; // Delta T anti-correction for artificial satellites
 
-		pSatWrapper->setEpoch(epochTime);
-		position                 = pSatWrapper->getTEMEPos();
-		velocity                 = pSatWrapper->getTEMEVel();
-		latLongSubPointPosition  = pSatWrapper->getSubPoint();
-		height                   = latLongSubPointPosition[2];
-		if (height <= 0.0)
-		{
-			// The orbit is no longer valid.  Causes include very out of date
-			// TLE, system date and time out of a reasonable range, and orbital
-			// degradation and re-entry of a satellite.  In any of these cases
-			// we might end up with a problem - usually a crash of Stellarium
-			// because of a div/0 or something.  To prevent this, we turn off
-			// the satellite.
-			qWarning() << "Satellite has invalid orbit:" << name << id;
-			orbitValid = false;
-			return;
-		}
+		gSatWrapper::State state;
+		pSatWrapper->computeState(gSatWrapper::computeEpochContext(epochTime), state);
+		applyState(state);
+	}
+}
 
-		elAzPosition             = pSatWrapper->getAltAz();
-		elAzPosition.normalize();
+void Satellite::applyState(const gSatWrapper::State& state)
+{
+	position                 = state.temePos;
+	velocity                 = state.temeVel;
+	latLongSubPointPosition  = state.subPoint;
+	height                   = latLongSubPointPosition[2];
+	if (height <= 0.0)
+	{
+		// The orbit is no longer valid.  Causes include very out of date
+		// TLE, system date and time out of a reasonable range, and orbital
+		// degradation and re-entry of a satellite.  In any of these cases
+		// we might end up with a problem - usually a crash of Stellarium
+		// because of a div/0 or something.  To prevent this, we turn off
+		// the satellite.
+		qWarning() << "Satellite has invalid orbit:" << name << id;
+		orbitValid = false;
+		return;
+	}
 
-		pSatWrapper->getSlantRange(range, rangeRate);
-		visibility = pSatWrapper->getVisibilityPredict();
-		phaseAngle = pSatWrapper->getPhaseAngle();
+	elAzPosition             = state.altAz;
+	elAzPosition.normalize();
 
-		// Compute orbit points to draw orbit line.
-		if (orbitDisplayed) computeOrbitPoints();
-	}
+	range      = state.range;
+	rangeRate  = state.rangeRate;
+	visibility = state.visibility;
+	phaseAngle = state.phaseAngle;
+
+	// Compute orbit points to draw orbit line.
+	if (orbitDisplayed) computeOrbitPoints();
 }
 
 double Satellite::getDoppler(double freq) const
@@ -661,7 +668,7 @@ void Satellite::computeOrbitPoints()
 	gTime epochTm;
 	gTime epoch(epochTime);
 	gTime lastEpochComp(lastEpochCompForOrbit);
-	Vec3f elAzVector;
+	QVector<double> epochs;
 	int diffSlots;
 
 
@@ -671,11 +678,12 @@ void Satellite::computeOrbitPoints()
 
 		for (int i=0; i<=orbitLineSegments; i++)
 		{
-			pSatWrapper->setEpoch(epochTm.getGmtTm());
-			elAzVector  = pSatWrapper->getAltAz();
-			orbitPoints.append(elAzVector);
+			epochs.append(epochTm.getGmtTm());
 			epochTm    += computeInterval;
 		}
+		const QVector<Vec3f> elAzVectors = computeAltAzPositions(epochs);
+		for (int i=0; i<elAzVectors.size(); i++)
+			orbitPoints.append(elAzVectors.at(i));
 		lastEpochCompForOrbit = epochTime;
 	}
 	else if (epochTime > lastEpochCompForOrbit)
@@ -698,13 +706,16 @@ void Satellite::computeOrbitPoints()
 
 			for (int i=0; i<diffSlots; i++)
 			{
-				//remove points at beginning of list and add points at end.
-				orbitPoints.removeFirst();
-				pSatWrapper->setEpoch(epochTm.getGmtTm());
-				elAzVector  = pSatWrapper->getAltAz();
-				orbitPoints.append(elAzVector);
+				epochs.append(epochTm.getGmtTm());
 				epochTm    += computeInterval;
 			}
+			//remove points at beginning of list and add points at end.
+			const QVector<Vec3f> elAzVectors = computeAltAzPositions(epochs);
+			for (int i=0; i<diffSlots; i++)
+			{
+				orbitPoints.removeFirst();
+				orbitPoints.append(elAzVectors.at(i));
+			}
 
 			lastEpochCompForOrbit = epochTime;
 		}
@@ -726,19 +737,38 @@ void Satellite::computeOrbitPoints()
 				epochTm   = epoch - orbitSpan - computeInterval;
 			}
 			for (int i=0; i<diffSlots; i++)
-			{ //remove points at end of list and add points at beginning.
-				orbitPoints.removeLast();
-				pSatWrapper->setEpoch(epochTm.getGmtTm());
-				elAzVector  = pSatWrapper->getAltAz();
-				orbitPoints.push_front(elAzVector);
+			{
+				epochs.append(epochTm.getGmtTm());
 				epochTm -= computeInterval;
-
+			}
+			//remove points at end of list and add points at beginning.
+			const QVector<Vec3f> elAzVectors = computeAltAzPositions(epochs);
+			for (int i=0; i<diffSlots; i++)
+			{
+				orbitPoints.removeLast();
+				orbitPoints.push_front(elAzVectors.at(i));
 			}
 			lastEpochCompForOrbit = epochTime;
 		}
 	}
 }
 
+QVector<Vec3f> Satellite::computeAltAzPositions(const QVector<double>& epochs)
+{
+	// Same batch propagation as Satellites::update(), with the observer at each epoch computed once
+	const StelLocation& loc = StelApp::getInstance().getCore()->getCurrentLocation();
+	QVector<gSatWrapper::EpochContext> contexts(epochs.size());
+	for (int i=0; i<epochs.size(); i++)
+		contexts[i] = gSatWrapper::computeEpochContext(epochs.at(i), loc);
+	QVector<gSatWrapper::State> states(epochs.size());
+	gSatWrapper::computeStates(QVector<gSatWrapper*>(1, pSatWrapper), contexts, states.data());
+
+	QVector<Vec3f> positions(epochs.size());
+	for (int i=0; i<states.size(); i++)
+		positions[i] = states.at(i).altAz;
+	return positions;
+}
+
 
 bool operator <(const SatelliteP& left, const SatelliteP& right)
 {
@@ -165,8 +165,15 @@ public:
 	float calculateIlluminatedFraction() const;
 
 private:
+	//! Store the state computed by gSatWrapper for the current epochTime.
+	//! Invalidates the orbit if the satellite has decayed.
+	void applyState(const gSatWrapper::State& state);
+
 	//draw orbits methods
 	void computeOrbitPoints();
+	//! Propagate the satellite at the given epochs in Julian Days with the batch API of gSatWrapper.
+	//! @return the positions in the same frame as gSatWrapper::getAltAz(), one per epoch.
+	QVector<Vec3f> computeAltAzPositions(const QVector<double>& epochs);
 	void drawOrbit(StelPainter& painter);
 	//! returns 0 - 1.0 for the DRAWORBIT_FADE_NUMBER segments at
 	//! each end of an orbit, with 1 in the middle.
@@ -246,12 +253,6 @@ private:
 	double    lastEpochCompForOrbit; //measured in Julian Days
 	double    epochTime;  //measured in Julian Days
 	QList<Vec3f> orbitPoints; //orbit points represented by ElAzPos vectors
-
-	// Used for optimization.  Where a satellite is not visible, we put it
-	// in the asleep state, where it is not updated or rendered anymore.
-	// The satellite manager takes care of waking up satellites after a
-	// while.
-	bool asleep = false;
 };
 
 typedef QSharedPointer<Satellite> SatelliteP;
@@ -20,9 +20,11 @@
 #include "StelPainter.hpp"
 #include "StelApp.hpp"
 #include "StelCore.hpp"
+#include "StelGeodesicGrid.hpp"
 #include "StelLocation.hpp"
 #include "StelObjectMgr.hpp"
 #include "StelModuleMgr.hpp"
+#include "StelMovementMgr.hpp"
 #include "StelLocaleMgr.hpp"
 #include "StelFileMgr.hpp"
 #include "StelTextureMgr.hpp"
@@ -35,6 +37,7 @@
 #include "StelTranslator.hpp"
 #include "StelProgressController.hpp"
 #include "StelUtils.hpp"
+#include "StelProfiler.hpp"
 
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
@@ -47,12 +50,20 @@
 #include <QVariant>
 #include <QDir>
 #include <QBuffer>
+#include <QThreadPool>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QTextStream>
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
 
 #define SATELLITES_VERSION "0.8.1"
 
+// Level of the geodesic grid used to index the satellites by zone, i.e. 1280 zones
+static const int SATELLITE_ZONE_LEVEL = 3;
+
 
 TleSource::~TleSource()
 {
@@ -61,16 +72,46 @@ TleSource::~TleSource()
 	reply = NULL;
 }
 
+namespace
+{
+// Batch propagation of the displayed satellites, run in the background while the sky is drawn
+class BatchPropagationRunnable : public QRunnable
+{
+public:
+	BatchPropagationRunnable(const QVector<gSatWrapper*>& wrappers, const QVector<gSatWrapper::EpochContext>& epochs,
+	                         gSatWrapper::State* states, QThreadPool* pool)
+		: wrappers(wrappers), epochs(epochs), states(states), pool(pool) {setAutoDelete(true);}
+	virtual void run() {gSatWrapper::computeStates(wrappers, epochs, states, pool);}
+private:
+	const QVector<gSatWrapper*>& wrappers;
+	const QVector<gSatWrapper::EpochContext>& epochs;
+	gSatWrapper::State* states;
+	QThreadPool* pool;
+};
+}
+
 Satellites::Satellites() :
 	  earth(NULL),
 	  defaultHintColor(0.0, 0.4, 0.6),
-	  defaultOrbitColor(0.0, 0.3, 0.6)
-{
+	  defaultOrbitColor(0.0, 0.3, 0.6),
+	  batchEpochTime(0.),
+	  batchPending(false),
+	  zoneIndexDirty(true),
+	  maxPixelSpeed(0.)
+{
+	propagationPool = new QThreadPool(this);
+	updatePool = new QThreadPool(this);
+	updatePool->setMaxThreadCount(1);
+	predictionPool = new QThreadPool(this);
 	setObjectName("Satellites");
 }
 
 void Satellites::deinit()
 {
+	// Don't leave the propagation running on satellites being deleted
+	updatePool->waitForDone();
+	batchPending = false;
+	predictionPool->waitForDone();
 	Satellite::hintTexture.clear();
 	texPointer.clear();
 }
@@ -244,6 +285,89 @@ QList<StelObjectP> Satellites::searchAround(const Vec3d& av, double limitFov, co
 	return result;
 }
 
+void Satellites::findAround(StelObjectFinder& finder) const
+{
+	if (!fader || StelApp::getInstance().getCore()->getCurrentLocation().planetName != earth->getEnglishName() || !isValidRangeDates())
+		return;
+	if (zoneIndexDirty)
+		updateZoneIndex(finder.getCore());
+	if (zoneEntries.isEmpty())
+		return;
+
+	const StelGeodesicGrid* grid = finder.getCore()->getGeodesicGrid(SATELLITE_ZONE_LEVEL);
+	const GeodesicSearchResult* result = grid->search(QVector<SphericalCap>() << SphericalCap(finder.getPosition(), finder.getCosLimitFov()), SATELLITE_ZONE_LEVEL);
+	const Satellite* best = NULL;
+	int bestIndex = -1;
+	float bestValue = 0.f;
+	int zone;
+	for (int pass=0;pass<2;++pass)
+	{
+		GeodesicSearchInsideIterator inside(*result, SATELLITE_ZONE_LEVEL);
+		GeodesicSearchBorderIterator border(*result, SATELLITE_ZONE_LEVEL);
+		while ((zone = (pass==0 ? inside.next() : border.next())) >= 0)
+		{
+			for (int i=zoneStart.at(zone);i<zoneStart.at(zone+1);++i)
+			{
+				const ZoneEntry& e = zoneEntries.at(i);
+				// The list may have changed since the last draw
+				if (e.index>=satellites.size() || satellites.at(e.index).data()!=e.satellite)
+					continue;
+				const Satellite* sat = e.satellite;
+				if (!sat->initialized || !sat->displayed)
+					continue;
+				Vec3d equPos = sat->XYZ;
+				equPos.normalize();
+				if (equPos*finder.getPosition()<finder.getCosLimitFov())
+					continue;
+				const float priority = sat->getSelectPriority(finder.getCore());
+				if (!finder.isCandidate(priority))
+					continue;
+				const float value = finder.getValue(sat->XYZ, priority);
+				if (!best || value<bestValue)
+				{
+					best = sat;
+					bestIndex = e.index;
+					bestValue = value;
+				}
+			}
+		}
+	}
+	if (best)
+		finder.add(qSharedPointerCast<StelObject>(satellites.at(bestIndex)), bestValue);
+}
+
+void Satellites::updateZoneIndex(const StelCore* core) const
+{
+	zoneIndexDirty = false;
+	const StelGeodesicGrid* grid = core->getGeodesicGrid(SATELLITE_ZONE_LEVEL);
+	const int nbZones = StelGeodesicGrid::nrOfZones(SATELLITE_ZONE_LEVEL);
+
+	// Counting sort of the satellites by zone
+	zoneStart.fill(0, nbZones+1);
+	QVector<int> zones(satellites.size(), -1);
+	for (int i=0;i<satellites.size();++i)
+	{
+		const Satellite* sat = satellites.at(i).data();
+		if (sat && sat->initialized && sat->displayed && sat->XYZ.lengthSquared()>0.)
+		{
+			zones[i] = grid->getZoneNumberForPoint(Vec3f(sat->XYZ[0], sat->XYZ[1], sat->XYZ[2]), SATELLITE_ZONE_LEVEL);
+			++zoneStart[zones[i]+1];
+		}
+	}
+	for (int z=0;z<nbZones;++z)
+		zoneStart[z+1] += zoneStart[z];
+	zoneEntries.resize(zoneStart.at(nbZones));
+	QVector<int> next = zoneStart;
+	for (int i=0;i<satellites.size();++i)
+	{
+		if (zones.at(i)<0)
+			continue;
+		ZoneEntry& e = zoneEntries[next[zones.at(i)]++];
+		e.index = i;
+		e.satellite = satellites.at(i).data();
+	}
+}
+
 StelObjectP Satellites::searchByNameI18n(const QString& nameI18n) const
 {
 	if (!fader || StelApp::getInstance().getCore()->getCurrentLocation().planetName != earth->getEnglishName() || !isValidRangeDates())
@@ -846,6 +970,123 @@ QStringList Satellites::listAllIds()
 	return result;
 }
 
+void Satellites::displayAllSatellites()
+{
+	foreach(const SatelliteP& sat, satellites)
+		sat->displayed = true;
+}
+
+QMap<QString, QVector<gSatWrapper::Pass> > Satellites::predictPasses(const QStringList& ids, double startJD,
+                                                                     double days, float minElevation)
+{
+	QMap<QString, QVector<gSatWrapper::Pass> > result;
+	StelCore* core = StelApp::getInstance().getCore();
+	const StelLocation loc = core->getCurrentLocation();
+	if (loc.planetName != earth->getEnglishName() || days <= 0.)
+		return result;
+
+	// The prediction changes the epoch of the wrappers, while the batch propagation of update() may be
+	// running in the background on the wrappers of the satellites: predict with copies made from the TLEs,
+	// on a pool of their own, so that neither waits for the tasks of the other.
+	QStringList passIds;
+	QVector<gSatWrapper*> wrappers;
+	foreach (const SatelliteP& sat, satellites)
+	{
+		if (sat->initialized && sat->pSatWrapper && sat->orbitValid && (ids.isEmpty() || ids.contains(sat->id)))
+		{
+			passIds.append(sat->id);
+			wrappers.append(new gSatWrapper(sat->id, QString(sat->tleElements.first), QString(sat->tleElements.second)));
+		}
+	}
+
+	// Delta T anti-correction for artificial satellites, as in update()
+	const double deltaT = core->getDeltaT(startJD)/86400;
+	QVector<QVector<gSatWrapper::Pass> > passes(wrappers.size());
+	gSatWrapper::predictPasses(wrappers, loc, startJD - deltaT, startJD - deltaT + days, minElevation,
+	                           passes.data(), predictionPool);
+	qDeleteAll(wrappers);
+
+	for (int i = 0; i < passes.size(); i++)
+	{
+		if (passes.at(i).isEmpty())
+			continue;
+		QVector<gSatWrapper::Pass>& satPasses = passes[i];
+		for (int j = 0; j < satPasses.size(); j++)
+		{
+			gSatWrapper::Pass& pass = satPasses[j];
+			pass.aosJD += deltaT;
+			pass.culminationJD += deltaT;
+			pass.losJD += deltaT;
+			if (pass.eclipseEntryJD > 0.)
+				pass.eclipseEntryJD += deltaT;
+			if (pass.eclipseExitJD > 0.)
+				pass.eclipseExitJD += deltaT;
+		}
+		result.insert(passIds.at(i), satPasses);
+	}
+	return result;
+}
+
+int Satellites::execPassPrediction(QSettings* conf)
+{
+	QOffscreenSurface surface;
+	surface.create();
+	QOpenGLContext context;
+	context.setFormat(surface.format());
+	if (!context.create() || !context.makeCurrent(&surface))
+	{
+		qWarning() << "Satellites: cannot create an offscreen openGL context for the pass prediction";
+		return 1;
+	}
+
+	// Same initialization as in StelQuickView, without any view
+	StelApp* app = new StelApp();
+	StelApp::initStatic();
+	app->setGlobalScalingRatio(1.f);
+	app->init(conf);
+	int ret = 0;
+	Satellites* satellites = GETSTELMODULE(Satellites);
+	if (satellites)
+	{
+		satellites->printPassPredictions(qApp->property("onetime_predict_passes").toDouble(),
+		                                 qApp->property("onetime_pass_min_elevation").toFloat());
+	}
+	else
+	{
+		qWarning() << "Satellites: the satellites are not loaded, no pass to predict";
+		ret = 1;
+	}
+	delete app;
+	StelApp::deinitStatic();
+	return ret;
+}
+
+void Satellites::printPassPredictions(double days, float minElevation)
+{
+	StelCore* core = StelApp::getInstance().getCore();
+	const double JD = core->getJDay();
+	const QMap<QString, QVector<gSatWrapper::Pass> > passes = predictPasses(QStringList(), JD, days, minElevation);
+
+	QTextStream out(stdout);
+	out << "# id\tname\taos\taosAz\tculmination\tculminationAz\tmaxElevation\tlos\tlosAz\teclipseEntry\teclipseExit\tvisible\n";
+	for (QMap<QString, QVector<gSatWrapper::Pass> >::const_iterator it = passes.constBegin(); it != passes.constEnd(); ++it)
+	{
+		const QString name = getById(it.key())->name;
+		foreach (const gSatWrapper::Pass& pass, it.value())
+		{
+			out << it.key() << '\t' << name << '\t'
+			    << StelUtils::julianDayToISO8601String(pass.aosJD) << '\t' << QString::number(pass.aosAzimuth, 'f', 1) << '\t'
+			    << StelUtils::julianDayToISO8601String(pass.culminationJD) << '\t' << QString::number(pass.culminationAzimuth, 'f', 1) << '\t'
+			    << QString::number(pass.maxElevation, 'f', 1) << '\t'
+			    << StelUtils::julianDayToISO8601String(pass.losJD) << '\t' << QString::number(pass.losAzimuth, 'f', 1) << '\t'
+			    << (pass.eclipseEntryJD > 0. ? StelUtils::julianDayToISO8601String(pass.eclipseEntryJD) : QString("-")) << '\t'
+			    << (pass.eclipseExitJD > 0. ? StelUtils::julianDayToISO8601String(pass.eclipseExitJD) : QString("-")) << '\t'
+			    << (pass.visible ? "yes" : "no") << '\n';
+		}
+	}
+	out.flush();
+}
+
 bool Satellites::add(const TleData& tleData)
 {
 	//TODO: Duplicates check!!! --BM
@@ -1450,30 +1691,61 @@ void Satellites::update(double deltaTime)
 	if (StelApp::getInstance().getCore()->getCurrentLocation().planetName != earth->getEnglishName() || !isValidRangeDates() || (!fader && fader.getInterstate() <= 0.))
 		return;
 
-	// Counter to wake up the satellites.
-	// wake_nb is the number of satellites we awake at each update.  If
-	// we don't see the hints we can make that lower.
-	const int wake_nb = hintsFader.getInterstate() == 0.0 ? 32 : 128;
-	static int t = 0;
-	t += wake_nb;
-	if (t >= satellites.size()) t = 0;
-
+	STEL_PROFILE_SCOPE("Satellites::update");
 	fader.update((int)(deltaTime*1000));
 	hintsFader.update((int)(deltaTime*1000));
 
-	for (int i = 0; i < satellites.size(); i++)
+	StelCore* core = StelApp::getInstance().getCore();
+	const double JD = core->getJDay();
+	const double epochTime = JD - core->getDeltaT(JD)/86400; // Delta T anti-correction for artificial satellites
+
+	// Propagate all the displayed satellites at once: the observer and Sun dependent
+	// part is computed a single time and the SGP4 propagation runs on the worker pool.
+	// The propagation only uses this copy of the frame state, so it runs in the background
+	// while the other modules are updated and drawn, until finishUpdate().
+	finishUpdate();
+	batchSatellites.clear();
+	batchWrappers.clear();
+	foreach (const SatelliteP& sat, satellites)
 	{
-		Satellite* sat = satellites.at(i).data();
-		// Wake up the next batch of asleep satellites.
-		if (i >= t && i < t + wake_nb) sat->asleep = false;
+		if (sat->initialized && sat->displayed && sat->pSatWrapper && sat->orbitValid)
+		{
+			batchSatellites.append(sat.data());
+			batchWrappers.append(sat->pSatWrapper);
+		}
+	}
+	if (batchSatellites.isEmpty())
+		return;
+	batchStates.resize(batchSatellites.size());
+	batchEpochs.fill(gSatWrapper::computeEpochContext(epochTime, core->getCurrentLocation()), 1);
+	batchEpochTime = epochTime;
+	batchPending = true;
+	updatePool->start(new BatchPropagationRunnable(batchWrappers, batchEpochs, batchStates.data(), propagationPool));
 
-		if (!sat->asleep && sat->initialized && sat->displayed)
-			sat->update(deltaTime);
+	// The movements follow the tracked satellite from its new position, in their own update
+	if (GETSTELMODULE(StelMovementMgr)->getFlagTracking() && !GETSTELMODULE(StelObjectMgr)->getSelectedObject("Satellite").isEmpty())
+		finishUpdate();
+}
+
+void Satellites::finishUpdate()
+{
+	if (!batchPending)
+		return;
+	STEL_PROFILE_SCOPE("Satellites::finishUpdate");
+	updatePool->waitForDone();
+	batchPending = false;
+	for (int i = 0; i < batchSatellites.size(); i++)
+	{
+		Satellite* sat = batchSatellites.at(i);
+		sat->epochTime = batchEpochTime;
+		sat->applyState(batchStates.at(i));
 	}
 }
 
 void Satellites::draw(StelCore* core)
 {
+	finishUpdate();
+	maxPixelSpeed = 0.;
 	if (core->getCurrentLocation().planetName != earth->getEnglishName() ||	!isValidRangeDates() || (!fader && fader.getInterstate() <= 0.))
 		return;
 
@@ -1486,16 +1758,40 @@ void Satellites::draw(StelCore* core)
 	glEnable(GL_BLEND);
 	Satellite::hintTexture->bind();
 	Satellite::viewportHalfspace = painter.getProjector()->getBoundingCap();
+	double maxAngularSpeed = 0.;
 	foreach (const SatelliteP& sat, satellites)
 	{
-		if (sat && !sat->asleep && sat->initialized && sat->displayed)
-			sat->asleep = !sat->draw(core, painter, 1.0);
+		if (sat && sat->initialized && sat->displayed)
+		{
+			sat->draw(core, painter, 1.0);
+			if (sat->elAzPosition[2]>0.f && sat->range>0.)
+			{
+				// Angular speed seen from the observer (rad/s), from the velocity across the line of sight
+				const double crossSpeed2 = sat->velocity.lengthSquared() - sat->rangeRate*sat->rangeRate;
+				if (crossSpeed2>0.)
+					maxAngularSpeed = qMax(maxAngularSpeed, std::sqrt(crossSpeed2)/sat->range);
+			}
+		}
 	}
+	maxPixelSpeed = maxAngularSpeed*prj->getPixelPerRadAtCenter();
+	// The satellite positions used by the zone index are computed when they are drawn
+	zoneIndexDirty = true;
 
 	if (GETSTELMODULE(StelObjectMgr)->getFlagSelectedObjectPointer())
 		drawPointer(core, painter);
 }
 
+double Satellites::getRedrawDelay() const
+{
+	if (maxPixelSpeed<=0.)
+		return -1.;
+	// Seconds of simulated time per second
+	const double timeRate = fabs(StelApp::getInstance().getCore()->getTimeRate())*86400.;
+	if (timeRate==0.)
+		return -1.;
+	return 0.5/(maxPixelSpeed*timeRate);
+}
+
 void Satellites::drawPointer(StelCore* core, StelPainter& painter)
 {
 	const StelProjectorP prj = core->getProjection(StelCore::FrameJ2000);
@@ -30,6 +30,7 @@
 #include <QUrl>
 #include <QVariantMap>
 #include <QByteArray>
+#include <QMap>
 
 class Planet;
 class QNetworkAccessManager;
@@ -165,9 +166,13 @@ public:
 	virtual void init();
 	virtual void deinit();
 	virtual void update(double deltaTime);
+	virtual void finishUpdate();
 	virtual void draw(StelCore* core);
 	virtual void drawPointer(StelCore* core, StelPainter& painter);
 	virtual double getCallOrder(StelModuleActionName actionName) const;
+	//! The satellites above the horizon move much faster than the sky: the next frame is
+	//! needed when the fastest of them has moved by half a pixel.
+	virtual double getRedrawDelay() const;
 
 	///////////////////////////////////////////////////////////////////////////
 	// Methods defined in StelObjectManager class
@@ -178,6 +183,10 @@ public:
 	//! @return an list containing the satellites located inside the limitFov circle around position v.
 	virtual QList<StelObjectP> searchAround(const Vec3d& v, double limitFov, const StelCore* core) const;
 
+	//! Give the satellites around the position of the finder, using the zones of the satellites
+	//! drawn in the last frame. The zone index is rebuilt here when they have moved.
+	virtual void findAround(StelObjectFinder& finder) const;
+
 	//! Return the matching satellite object's pointer if exists or NULL.
 	//! @param nameI18n The case in-sensistive satellite name
 	virtual StelObjectP searchByNameI18n(const QString& nameI18n) const;
@@ -248,6 +257,21 @@ public:
 	
 	//! Returns a list of all satellite IDs.
 	QStringList listAllIds();
+
+	//! Display all the satellites of the catalog, not only the ones chosen by the user.
+	//! This is not saved in the catalog unless saveCatalog() is called.
+	void displayAllSatellites();
+
+	//! Predict the passes of satellites over the current location.
+	//! The prediction uses copies of the satellites made from their TLEs, spread over the threads of a pool
+	//! of its own, so that it can run while the satellites are propagated in the background.
+	//! @param ids the IDs of the satellites, or an empty list for the whole catalog
+	//! @param startJD start of the prediction, in the time scale of StelCore::getJDay()
+	//! @param days length of the prediction in days
+	//! @param minElevation minimum elevation of the passes in degrees
+	//! @return the passes, in the time scale of @a startJD, of the satellites having at least one
+	QMap<QString, QVector<gSatWrapper::Pass> > predictPasses(const QStringList& ids, double startJD,
+	                                                         double days, float minElevation=0.f);
 	
 	//! Add to the current collection the satellites described by the data list.
 	//! The changes are not saved to file.
@@ -335,6 +359,11 @@ public:
 	//! @note We are having permissions for use this file from Mike McCants.
 	//! @param name of file
 	void parseQSMagFile(QString qsMagFile);
+
+	//! Print the passes of all the satellites of the catalog for the --predict-passes command line
+	//! option, from an application initialized offscreen without any view, as in the benchmark mode.
+	//! @return the exit code of the program.
+	static int execPassPrediction(QSettings* conf);
 	
 	bool getFlagDisplayed() {return fader;}
 	//! get the label font size.
@@ -462,9 +491,16 @@ private:
 	//! Replace the qs.mag file with the default one.
 	void restoreDefaultQSMagFile();
 
+	//! Print the passes over the next @a days days of all the satellites of the catalog on
+	//! the standard output, for the --predict-passes command line option.
+	void printPassPredictions(double days, float minElevation);
+
 	//! Checks valid range dates of life of satellites
 	bool isValidRangeDates() const;
 
+	//! Sort the displayed satellites by zone of the geodesic grid, from their last drawn positions.
+	void updateZoneIndex(const StelCore* core) const;
+
 	//! Save a structure representing a satellite catalog to a JSON file.
 	//! If no path is specified, catalogPath is used.
 	bool saveDataMap(QString path=QString());
@@ -495,6 +531,41 @@ private:
 	QDir dataDir;
 	
 	QList<SatelliteP> satellites;
+
+	//! Per frame buffers of the batch propagation in update(), kept to avoid reallocations.
+	//! The states are written by the propagation in the background, and only applied to the satellites
+	//! by finishUpdate(), so that the satellites don't change while they are drawn.
+	QVector<Satellite*> batchSatellites;
+	QVector<gSatWrapper*> batchWrappers;
+	QVector<gSatWrapper::State> batchStates;
+	//! The epoch of the batch propagation, an immutable copy of the frame time and location.
+	QVector<gSatWrapper::EpochContext> batchEpochs;
+	double batchEpochTime;
+	//! Whether the batch propagation was started and its states not applied yet.
+	bool batchPending;
+	//! Worker threads of the batch propagation.
+	class QThreadPool* propagationPool;
+	//! Single thread running the batch propagation during the draw, which spreads it over the propagation pool.
+	class QThreadPool* updatePool;
+	//! Worker threads of predictPasses(), separate from the propagation which may run at the same time.
+	class QThreadPool* predictionPool;
+
+	//! A displayed satellite in the zone index, with its index in satellites.
+	struct ZoneEntry
+	{
+		int index;
+		const Satellite* satellite;
+	};
+	//! The displayed satellites sorted by zone, only rebuilt when an object is searched. The satellites
+	//! of the zone z are zoneEntries[zoneStart[z]] to zoneEntries[zoneStart[z+1]-1].
+	mutable QVector<ZoneEntry> zoneEntries;
+	mutable QVector<int> zoneStart;
+	//! Whether the satellites were drawn at new positions since the zone index was built.
+	mutable bool zoneIndexDirty;
+
+	//! Apparent angular speed on screen of the fastest satellite above the horizon in the last
+	//! frame, in pixels per second of simulated time, for getRedrawDelay().
+	double maxPixelSpeed;
 	
 	QHash<QString, double> qsMagList;
 	//! Union of the groups used by all loaded satellites - see @ref groups.
@@ -28,6 +28,8 @@ public:
 	virtual ~SensorsMgr();
 	virtual void init() Q_DECL_OVERRIDE;
 	virtual void update(double deltaTime) Q_DECL_OVERRIDE;
+	//! The view follows the sensors at each frame.
+	virtual double getRedrawDelay() const Q_DECL_OVERRIDE {return enabled ? 0. : -1.;}
 	bool isEnabled() const {return enabled;}
 	void setEnabled(bool value);
 signals:
@@ -143,3 +143,46 @@ float Skybright::getLuminance(float cosDistMoon,
 	// lambert -> cd/m^2 formula seems to be wrong...
 }
 
+// Same computation as getLuminance(), where the tests are replaced by selections
+void Skybright::getLuminances(const float* cosDistMoon, const float* cosDistSun, const float* cosDistZenith,
+			      float* luminance, int n) const
+{
+	const float minK = (K> 0.05f ? K : 0.05f);
+	const float moonTerm = 28860205.1341274269f * C3 + 440000.f * (1.f - C3);
+	for (int i=0;i<n;++i)
+	{
+		const float cosDistZ = cosDistZenith[i];
+		const float cosDistS = cosDistSun[i];
+		const float cosDistM = cosDistMoon[i] < 1.f ? cosDistMoon[i] : 1.f;
+
+		// Air mass
+		const float bKX = stelpow10f(-0.4f * K * (1.f / (cosDistZ + 0.025f*StelUtils::fastExp(-11.f*cosDistZ))));
+		const float oneMinusBKX = 1.f - bKX;
+
+		// Daylight brightness
+		const float distSun = StelUtils::fastAcos(cosDistS);
+		const float FS = 18886.28f / (distSun*distSun + 0.0007f)
+			       + stelpow10f(6.15f - (distSun+0.001f)* 1.43239f)
+			       + 229086.77f * ( 1.06f + cosDistS*cosDistS );
+		const float b_daylight = 9.289663e-12f * oneMinusBKX * (FS * C4 + 440000.f * (1.f - C4));
+
+		// Twilight brightness
+		const float b_twilight = stelpow10f(bTwilightTerm + 0.063661977f * StelUtils::fastAcos(cosDistZ)/minK) * (1.7453293f / distSun) * oneMinusBKX;
+
+		float b_total = (b_twilight<b_daylight) ? b_twilight : b_daylight;
+
+		// Moonlight brightness, only added if more than 1% daylight
+		const float distMoon = cosDistM > 0.99f ? std::acos(cosDistM) : StelUtils::fastAcos(cosDistM);
+		const float FM = 18886.28f / (distMoon*distMoon + 0.0005f)
+			       + stelpow10f(6.15f - distMoon * 1.43239f)
+			       + 229086.77f * ( 1.06f + cosDistM*cosDistM );
+		const float b_moon = bMoonTerm1 * oneMinusBKX * (FM * C3 + 440000.f * (1.f - C3));
+		b_total += (bMoonTerm1 * oneMinusBKX * moonTerm)/b_total>0.01f ? b_moon : 0.f;
+
+		// Dark night sky brightness, only added if more than 1% daylight
+		const float b_night = (0.4f + 0.6f / std::sqrt(0.04f + 0.96f * cosDistZ*cosDistZ)) * bNightTerm * bKX;
+		b_total += (bNightTerm*bKX)/b_total>0.01f ? b_night : 0.f;
+
+		luminance[i] = (b_total<0.f) ? 0.f : b_total * (900900.9f * static_cast<float>(M_PI) * 1e-4f * 3239389.f*2.f *1.5f);
+	}
+}
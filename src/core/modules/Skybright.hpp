@@ -53,6 +53,16 @@ public:
 	//! @param cosDistZenith cos(angular distance between zenith and the position)
 	float getLuminance(float cosDistMoon, float cosDistSun, float cosDistZenith) const;
 
+	//! Compute the luminance at many positions at once, with the same model as getLuminance().
+	//! The inputs are separate arrays and the loop has no branches so that the compiler can vectorize it.
+	//! @param cosDistMoon cos(angular distance between moon and each position)
+	//! @param cosDistSun cos(angular distance between sun and each position)
+	//! @param cosDistZenith cos(angular distance between zenith and each position)
+	//! @param luminance the computed luminances in cd/m^2
+	//! @param n the number of positions
+	void getLuminances(const float* cosDistMoon, const float* cosDistSun, const float* cosDistZenith,
+			   float* luminance, int n) const;
+
 private:
 	float airMassMoon;  // Air mass for the Moon
 	float airMassSun;   // Air mass for the Sun
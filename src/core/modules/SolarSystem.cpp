@@ -43,6 +43,7 @@
 #include "StelPainter.hpp"
 #include "TrailGroup.hpp"
 #include "RefractionExtinction.hpp"
+#include "StelProfiler.hpp"
 
 #include <functional>
 #include <algorithm>
@@ -57,6 +58,9 @@
 #include <QMapIterator>
 #include <QDebug>
 #include <QDir>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
 
 SolarSystem::SolarSystem()
 	: moonScale(1.),
@@ -64,6 +68,7 @@ SolarSystem::SolarSystem()
 	  flagLightTravelTime(false),
 	  allTrails(NULL)
 {
+	positionPool = new QThreadPool(this);
 	planetNameFont.setPixelSize(StelApp::getInstance().getSettings()->value("gui/base_font_size", 13).toInt());
 	setObjectName("SolarSystem");
 }
@@ -82,6 +87,8 @@ SolarSystem::~SolarSystem()
 		delete orb;
 		orb = NULL;
 	}
+	foreach (CoordsvContext* context, coordsvContexts)
+		delete_coordsv_context(context);
 	sun.clear();
 	moon.clear();
 	earth.clear();
@@ -115,6 +122,7 @@ void SolarSystem::init()
 	Q_ASSERT(conf);
 
 	loadPlanets();	// Load planets data
+	buildPlanetLevels();
 
 	// Compute position and matrix of sun and all the satellites (ie planets)
 	// for the first initialization Q_ASSERT that center is sun center (only impacts on light speed correction)	
@@ -791,6 +799,15 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 			exit(-1);
 		}
 
+		// Each body computed by an analytic theory gets its own interpolation caches,
+		// so that it can be computed concurrently with the other bodies.
+		if (funcName.endsWith("_special"))
+		{
+			CoordsvContext* context = create_coordsv_context();
+			coordsvContexts.append(context);
+			userDataPtr = context;
+		}
+
 		// Create the Solar System body and add it to the list
 		QString type = pd.value(secname+"/type").toString();
 		PlanetP p;
@@ -980,51 +997,142 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 	return true;
 }
 
-// Compute the position for every elements of the solar system.
-// The order is not important since the position is computed relatively to the mother body
-void SolarSystem::computePositions(double date, const Vec3d& observerPos)
+namespace
 {
-	if (flagLightTravelTime)
+// The steps of SolarSystem::computePositions which are run level by level
+enum PlanetLevelStep
+{
+	StepPositionWithoutOrbits,
+	StepPosition,
+	StepLightTimePosition,
+	StepTransMatrix,
+	StepLightTimeTransMatrix
+};
+
+// Don't bother waking up the worker threads for less bodies than this.
+// Low enough for the moons, whose theories are costly each time their interpolation window moves.
+const int MinConcurrentPlanets = 8;
+// Number of bodies a thread takes at once from the shared counter
+const int PlanetChunkSize = 4;
+
+void computePlanetStep(Planet* p, int step, double date, const Vec3d& observerPos)
+{
+	switch (step)
 	{
-		foreach (PlanetP p, systemPlanets)
-		{
+		case StepPositionWithoutOrbits:
 			p->computePositionWithoutOrbits(date);
-		}
-		foreach (PlanetP p, systemPlanets)
+			break;
+		case StepPosition:
+			p->computePosition(date);
+			break;
+		case StepLightTimePosition:
+			p->computePosition(date - (p->getHeliocentricEclipticPos()-observerPos).length() * (AU / (SPEED_OF_LIGHT * 86400)));
+			break;
+		case StepTransMatrix:
+			p->computeTransMatrix(date);
+			break;
+		case StepLightTimeTransMatrix:
+			p->computeTransMatrix(date - (p->getHeliocentricEclipticPos()-observerPos).length() * (AU / (SPEED_OF_LIGHT * 86400)));
+			break;
+	}
+}
+
+// One step over a list of bodies, shared by the worker threads and the calling thread
+// which all take chunks of bodies from the same counter until the list is exhausted.
+class PlanetBatch
+{
+public:
+	PlanetBatch(const QVector<Planet*>& planets, int step, double date, const Vec3d& observerPos)
+		: planets(planets), step(step), date(date), observerPos(observerPos), next(0) {}
+
+	void process()
+	{
+		const int n = planets.size();
+		for (int first = next.fetchAndAddOrdered(PlanetChunkSize); first < n; first = next.fetchAndAddOrdered(PlanetChunkSize))
 		{
-			const double light_speed_correction = (p->getHeliocentricEclipticPos()-observerPos).length() * (AU / (SPEED_OF_LIGHT * 86400));
-			p->computePosition(date-light_speed_correction);
+			const int last = qMin(first+PlanetChunkSize, n);
+			for (int i=first;i<last;++i)
+				computePlanetStep(planets.at(i), step, date, observerPos);
 		}
 	}
-	else
+
+private:
+	const QVector<Planet*>& planets;
+	const int step;
+	const double date;
+	const Vec3d observerPos;
+	QAtomicInt next;
+};
+
+class PlanetBatchRunnable : public QRunnable
+{
+public:
+	PlanetBatchRunnable(PlanetBatch* batch) : batch(batch) {setAutoDelete(true);}
+	virtual void run() {batch->process();}
+private:
+	PlanetBatch* batch;
+};
+}
+
+void SolarSystem::buildPlanetLevels()
+{
+	planetLevels.clear();
+	foreach (const PlanetP& p, systemPlanets)
 	{
-		foreach (PlanetP p, systemPlanets)
+		int depth = 0;
+		for (PlanetP parent = p->parent; parent; parent = parent->parent)
+			++depth;
+		if (depth >= planetLevels.size())
+			planetLevels.resize(depth+1);
+		planetLevels[depth].append(p.data());
+	}
+}
+
+void SolarSystem::computePlanetLevels(int step, double date, const Vec3d& observerPos)
+{
+	const int maxThreads = positionPool->maxThreadCount();
+	for (int l=0;l<planetLevels.size();++l)
+	{
+		STEL_PROFILE_SCOPE("SolarSystem::computePlanetLevels level");
+		const QVector<Planet*>& level = planetLevels.at(l);
+		PlanetBatch batch(level, step, date, observerPos);
+		int nbRunnables = 0;
+		if (maxThreads > 1 && level.size() >= MinConcurrentPlanets)
 		{
-			p->computePosition(date);
+			nbRunnables = qMin(maxThreads, level.size()/PlanetChunkSize);
+			for (int i=0;i<nbRunnables;++i)
+				positionPool->start(new PlanetBatchRunnable(&batch));
 		}
+		batch.process();
+		if (nbRunnables > 0)
+			positionPool->waitForDone();
 	}
-	computeTransMatrices(date, observerPos);
 }
 
-// Compute the transformation matrix for every elements of the solar system.
-// The elements have to be ordered hierarchically, eg. it's important to compute earth before moon.
-void SolarSystem::computeTransMatrices(double date, const Vec3d& observerPos)
+// Compute the position for every elements of the solar system.
+// The position is computed relatively to the mother body, so the bodies are processed
+// level by level in the hierarchy, and the bodies of one level possibly in parallel.
+void SolarSystem::computePositions(double date, const Vec3d& observerPos)
 {
+	STEL_PROFILE_SCOPE("SolarSystem::computePositions");
 	if (flagLightTravelTime)
 	{
-		foreach (PlanetP p, systemPlanets)
-		{
-			const double light_speed_correction = (p->getHeliocentricEclipticPos()-observerPos).length() * (AU / (SPEED_OF_LIGHT * 86400));
-			p->computeTransMatrix(date-light_speed_correction);
-		}
+		computePlanetLevels(StepPositionWithoutOrbits, date, observerPos);
+		computePlanetLevels(StepLightTimePosition, date, observerPos);
 	}
 	else
 	{
-		foreach (PlanetP p, systemPlanets)
-		{
-			p->computeTransMatrix(date);
-		}
+		computePlanetLevels(StepPosition, date, observerPos);
 	}
+	computeTransMatrices(date, observerPos);
+}
+
+// Compute the transformation matrix for every elements of the solar system.
+// The elements have to be ordered hierarchically, eg. it's important to compute earth before moon.
+void SolarSystem::computeTransMatrices(double date, const Vec3d& observerPos)
+{
+	STEL_PROFILE_SCOPE("SolarSystem::computeTransMatrices");
+	computePlanetLevels(flagLightTravelTime ? StepLightTimeTransMatrix : StepTransMatrix, date, observerPos);
 }
 
 // And sort them from the furthest to the closest to the observer
@@ -1537,6 +1645,9 @@ void SolarSystem::reloadPlanets()
 		orb = NULL;
 	}
 	orbits.clear();
+	foreach (CoordsvContext* context, coordsvContexts)
+		delete_coordsv_context(context);
+	coordsvContexts.clear();
 
 	sun.clear();
 	moon.clear();
@@ -1556,6 +1667,7 @@ void SolarSystem::reloadPlanets()
 
 	// Re-load the ssystem.ini file
 	loadPlanets();	
+	buildPlanetLevels();
 	computePositions(StelUtils::getJDFromSystem());
 	setSelected("");
 	recreateTrails();
@@ -26,6 +26,7 @@
 #endif
 
 #include <QFont>
+#include <QVector>
 #include "StelObjectModule.hpp"
 #include "StelTextureTypes.hpp"
 #include "Planet.hpp"
@@ -303,6 +304,14 @@ private:
 	//! observerPos is needed for light travel time computation.
 	void computeTransMatrices(double date, const Vec3d& observerPos = Vec3d(0.));
 
+	//! Group systemPlanets by depth in the parent hierarchy into planetLevels.
+	//! Must be called each time systemPlanets is reloaded.
+	void buildPlanetLevels();
+
+	//! Run one step of the position computation (see PlanetLevelStep in SolarSystem.cpp)
+	//! on every body, level after level so that parents are always up to date before their satellites.
+	void computePlanetLevels(int step, double date, const Vec3d& observerPos);
+
 	//! Draw a nice animated pointer around the object.
 	void drawPointer(const StelCore* core);
 
@@ -346,6 +355,16 @@ private:
 	//! List of all the bodies of the solar system.
 	QList<PlanetP> systemPlanets;
 
+	//! The bodies of each depth in the parent hierarchy (0: Sun, 1: planets, minor bodies and comets, 2: moons).
+	//! The bodies of one level don't share any state and are computed concurrently.
+	QVector<QVector<Planet*> > planetLevels;
+
+	//! Interpolation caches of the bodies computed by the analytic theories (see stellplanet.h).
+	QList<struct CoordsvContext*> coordsvContexts;
+
+	//! Worker threads used for the concurrent part of each level.
+	class QThreadPool* positionPool;
+
 	// Master settings
 	bool flagOrbits;
 	bool flagLightTravelTime;
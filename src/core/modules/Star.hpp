@@ -73,6 +73,11 @@ struct Star1 { // 28 byte
 	  pos+=((float)(x1)+movementFactor*dx1)*z->axis1;
 	  pos+=z->center;
   }
+  //! Get the star position in the zone frame (axis0, axis1 units) including proper motion.
+  void getJ2000Offsets(float movementFactor, float& u0, float& u1) const {
+	  u0 = (float)(x0)+movementFactor*dx0;
+	  u1 = (float)(x1)+movementFactor*dx1;
+  }
   float getBV(void) const {return IndexToBV(bV);}
   bool hasName() const {return hip;}
   QString getNameI18n(void) const;
@@ -108,6 +113,11 @@ struct Star2 {  // 10 byte
 	  pos+=((float)(x1)+movementFactor*dx1)*z->axis1;
 	  pos+=z->center;
   }
+  //! Get the star position in the zone frame (axis0, axis1 units) including proper motion.
+  void getJ2000Offsets(float movementFactor, float& u0, float& u1) const {
+	  u0 = (float)(x0)+movementFactor*dx0;
+	  u1 = (float)(x1)+movementFactor*dx1;
+  }
   float getBV(void) const {return IndexToBV(bV);}
   QString getNameI18n(void) const {return QString();}
   int hasComponentID(void) const {return 0;}
@@ -141,6 +151,11 @@ struct Star3 {  // 6 byte
 	  pos+=z->center;
 	  pos+=(float)(x1)*z->axis1;
   }
+  void getJ2000Offsets(float, float& u0, float& u1) const
+  {
+	  u0 = (float)(x0);
+	  u1 = (float)(x1);
+  }
   float getBV() const {return IndexToBV(bV);}
   QString getNameI18n() const {return QString();}
   int hasComponentID() const {return 0;}
@@ -54,6 +54,7 @@
 #include "ZoneArray.hpp"
 #include "StelSkyDrawer.hpp"
 #include "RefractionExtinction.hpp"
+#include "StelProfiler.hpp"
 
 static QStringList spectral_array;
 static QStringList component_array;
@@ -65,16 +66,34 @@ static const int StarCatalogFormatVersion = 9;
 
 // Initialise statics
 bool StarMgr::flagSciNames = true;
-QHash<int,QString> StarMgr::commonNamesMap;
-QHash<int,QString> StarMgr::commonNamesMapI18n;
-QMap<QString,int> StarMgr::commonNamesIndexI18n;
-QMap<QString,int> StarMgr::commonNamesIndex;
-QHash<int,QString> StarMgr::sciNamesMapI18n;
-QMap<QString,int> StarMgr::sciNamesIndexI18n;
-QHash<int,QString> StarMgr::sciAdditionalNamesMapI18n;
-QMap<QString,int> StarMgr::sciAdditionalNamesIndexI18n;
-QHash<int, varstar> StarMgr::varStarsMapI18n;
-QMap<QString, int> StarMgr::varStarsIndexI18n;
+QString StarMgr::currentSkyCultureDir;
+bool StarMgr::commonNamesLoaded = false;
+bool StarMgr::sciNamesLoaded = false;
+bool StarMgr::varStarsLoaded = false;
+bool StarMgr::commonNamesI18nLoaded = false;
+StarNameTable StarMgr::commonNames;
+StarNameTable StarMgr::commonNamesI18n;
+QHash<int,QString> StarMgr::commonNamesI18nCache;
+StarNameTable StarMgr::sciNames;
+StarNameTable StarMgr::sciAdditionalNames;
+StarNameTable StarMgr::varStars;
+
+// Fields of the GCVS records, in the order of the gcvs_hip_part.dat columns after the HIP number
+enum VarStarField
+{
+	VarStarDesignation,
+	VarStarType,
+	VarStarMaxMag,
+	VarStarMagFlag,
+	VarStarMin1Mag,
+	VarStarMin2Mag,
+	VarStarPhotometricSystem,
+	VarStarEpoch,
+	VarStarPeriod,
+	VarStarMM,
+	VarStarSpectralType,
+	VarStarFieldCount
+};
 
 QStringList initStringListFromFile(const QString& file_name)
 {
@@ -129,6 +148,7 @@ StarMgr::StarMgr(void) : hipIndex(new HipIndexStruct[NR_OF_HIP+1])
 	}
 	maxGeodesicGridLevel = -1;
 	lastMaxSearchLevel = -1;
+	starBufferBudget = 0;
 	starFont.setPixelSize(StelApp::getInstance().getSettings()->value("gui/base_font_size", 13).toInt());
 	objectMgr = GETSTELMODULE(StelObjectMgr);
 	Q_ASSERT(objectMgr);
@@ -156,74 +176,66 @@ StarMgr::~StarMgr(void)
 
 QString StarMgr::getCommonName(int hip)
 {
-	QHash<int,QString>::const_iterator it(commonNamesMapI18n.find(hip));
-	if (it!=commonNamesMapI18n.end())
+	QHash<int,QString>::const_iterator it(commonNamesI18nCache.find(hip));
+	if (it!=commonNamesI18nCache.end())
 		return it.value();
-	return QString();
+	const QString englishName = getCommonNames().getFieldByHip(hip);
+	const QString name = englishName.isEmpty() ? QString() : translateCommonName(englishName);
+	commonNamesI18nCache.insert(hip, name);
+	return name;
 }
 
 QString StarMgr::getSciName(int hip)
 {
-	QHash<int,QString>::const_iterator it(sciNamesMapI18n.find(hip));
-	if (it!=sciNamesMapI18n.end())
-		return it.value();
-	return QString();
+	return getSciNames().getFieldByHip(hip);
 }
 
 QString StarMgr::getSciAdditionalName(int hip)
 {
-	QHash<int,QString>::const_iterator it(sciAdditionalNamesMapI18n.find(hip));
-	if (it!=sciAdditionalNamesMapI18n.end())
-		return it.value();
-	return QString();
+	return getSciAdditionalNames().getFieldByHip(hip);
 }
 
 
 QString StarMgr::getGcvsName(int hip)
 {
-	QHash<int,varstar>::const_iterator it(varStarsMapI18n.find(hip));
-	if (it!=varStarsMapI18n.end())
-		return it.value().designation;
-	return QString();
+	return getVarStars().getFieldByHip(hip, VarStarDesignation);
 }
 
 QString StarMgr::getGcvsVariabilityType(int hip)
 {
-	QHash<int,varstar>::const_iterator it(varStarsMapI18n.find(hip));
-	if (it!=varStarsMapI18n.end())
-		return it.value().vtype;
-	return QString();
+	return getVarStars().getFieldByHip(hip, VarStarType);
 }
 
 float StarMgr::getGcvsMaxMagnitude(int hip)
 {
-	QHash<int,varstar>::const_iterator it(varStarsMapI18n.find(hip));
-	if (it!=varStarsMapI18n.end())
-		return it.value().maxmag;
+	const int i = getVarStars().find(hip);
+	if (i>=0)
+		return varStars.getField(i, VarStarMaxMag).toFloat();
 	return -99.f;
 }
 
 int StarMgr::getGcvsMagnitudeFlag(int hip)
 {
-	QHash<int,varstar>::const_iterator it(varStarsMapI18n.find(hip));
-	if (it!=varStarsMapI18n.end())
-		return it.value().mflag;
+	const int i = getVarStars().find(hip);
+	if (i>=0)
+		return varStars.getField(i, VarStarMagFlag).toInt();
 	return 0;
 }
 
 
 float StarMgr::getGcvsMinMagnitude(int hip, bool firstMinimumFlag)
 {
-	QHash<int,varstar>::const_iterator it(varStarsMapI18n.find(hip));
-	if (it!=varStarsMapI18n.end())
+	const int i = getVarStars().find(hip);
+	if (i>=0)
 	{
 		if (firstMinimumFlag)
 		{
-			return it.value().min1mag;
+			return varStars.getField(i, VarStarMin1Mag).toFloat();
 		}
 		else
 		{
-			return it.value().min2mag;
+			const QString min2mag = varStars.getField(i, VarStarMin2Mag);
+			return min2mag.isEmpty() ? 99.f : min2mag.toFloat();
 		}
 	}
 	return -99.f;
@@ -231,36 +243,104 @@ float StarMgr::getGcvsMinMagnitude(int hip, bool firstMinimumFlag)
 
 QString StarMgr::getGcvsPhotometricSystem(int hip)
 {
-	QHash<int,varstar>::const_iterator it(varStarsMapI18n.find(hip));
-	if (it!=varStarsMapI18n.end())
-		return it.value().photosys;
-	return QString();
+	return getVarStars().getFieldByHip(hip, VarStarPhotometricSystem);
 }
 
 double StarMgr::getGcvsEpoch(int hip)
 {
-	QHash<int,varstar>::const_iterator it(varStarsMapI18n.find(hip));
-	if (it!=varStarsMapI18n.end())
-		return it.value().epoch;
+	const int i = getVarStars().find(hip);
+	if (i>=0)
+		return varStars.getField(i, VarStarEpoch).toDouble();
 	return -99.f;
 }
 
 double StarMgr::getGcvsPeriod(int hip)
 {
-	QHash<int,varstar>::const_iterator it(varStarsMapI18n.find(hip));
-	if (it!=varStarsMapI18n.end())
-		return it.value().period;
+	const int i = getVarStars().find(hip);
+	if (i>=0)
+		return varStars.getField(i, VarStarPeriod).toDouble();
 	return -99.f;
 }
 
 int StarMgr::getGcvsMM(int hip)
 {
-	QHash<int,varstar>::const_iterator it(varStarsMapI18n.find(hip));
-	if (it!=varStarsMapI18n.end())
-		return it.value().Mm;
+	const int i = getVarStars().find(hip);
+	if (i>=0)
+		return varStars.getField(i, VarStarMM).toInt();
 	return -99;
 }
 
+const StarNameTable& StarMgr::getCommonNames()
+{
+	if (!commonNamesLoaded)
+	{
+		commonNamesLoaded = true;
+		// Load culture star names in english
+		const QString fic = StelFileMgr::findFile("skycultures/" + currentSkyCultureDir + "/star_names.fab");
+		if (fic.isEmpty())
+			qDebug() << "Could not load star_names.fab for sky culture " << QDir::toNativeSeparators(currentSkyCultureDir);
+		else
+			loadCommonNames(fic);
+	}
+	return commonNames;
+}
+
+const StarNameTable& StarMgr::getCommonNamesI18n()
+{
+	if (!commonNamesI18nLoaded)
+	{
+		commonNamesI18nLoaded = true;
+		const StarNameTable& names = getCommonNames();
+		QMap<QString,int> index;
+		for (int i=0; i<names.size(); ++i)
+			index[translateCommonName(names.getField(i, 0)).toUpper()] = names.getHip(i);
+		commonNamesI18n.build(QMap<int,QStringList>(), 0, index);
+	}
+	return commonNamesI18n;
+}
+
+const StarNameTable& StarMgr::getSciNames()
+{
+	if (!sciNamesLoaded)
+	{
+		sciNamesLoaded = true;
+		const QString fic = StelFileMgr::findFile("stars/default/name.fab");
+		if (fic.isEmpty())
+			qWarning() << "WARNING: could not load scientific star names file: stars/default/name.fab";
+		else
+			loadSciNames(fic);
+	}
+	return sciNames;
+}
+
+const StarNameTable& StarMgr::getSciAdditionalNames()
+{
+	// Both are in the same file
+	getSciNames();
+	return sciAdditionalNames;
+}
+
+const StarNameTable& StarMgr::getVarStars()
+{
+	if (!varStarsLoaded)
+	{
+		varStarsLoaded = true;
+		const QString fic = StelFileMgr::findFile("stars/default/gcvs_hip_part.dat");
+		if (fic.isEmpty())
+			qWarning() << "WARNING: could not load variable stars file: stars/default/gcvs_hip_part.dat";
+		else
+			loadGcvs(fic);
+	}
+	return varStars;
+}
+
+QString StarMgr::translateCommonName(const QString& englishName)
+{
+	QRegExp transRx("_[(]\"(.*)\"[)]");
+	transRx.exactMatch(englishName);
+	return StelApp::getInstance().getLocaleMgr().getSkyTranslator().qtranslate(transRx.capturedTexts().at(1));
+}
+
 void StarMgr::copyDefaultConfigFile()
 {
 	try
@@ -313,6 +393,7 @@ void StarMgr::init()
 	setFlagStars(conf->value("astro/flag_stars", true).toBool());
 	setFlagLabels(conf->value("astro/flag_star_name",true).toBool());
 	setLabelsAmount(conf->value("stars/labels_amount",3.f).toFloat());
+	starBufferBudget = (qint64)(conf->value("stars/point_source_buffers_mb", 32.).toDouble()*1024*1024);
 
 	objectMgr->registerStelObjectMgr(this);
 	texPointer = StelApp::getInstance().getTextureManager().createTexture(StelFileMgr::getInstallationDir()+"/textures/pointeur2.png");   // Load pointer texture
@@ -527,10 +608,9 @@ void StarMgr::loadData(QVariantMap starsConfig)
 // Load common names from file
 int StarMgr::loadCommonNames(const QString& commonNameFile)
 {
-	commonNamesMap.clear();
-	commonNamesMapI18n.clear();
-	commonNamesIndexI18n.clear();
-	commonNamesIndex.clear();
+	commonNames.clear();
+	QMap<int,QStringList> namesMap;
+	QMap<QString,int> namesIndex;
 
 	qDebug() << "Loading star names from" << QDir::toNativeSeparators(commonNameFile);
 	QFile cnFile(commonNameFile);
@@ -585,19 +665,14 @@ int StarMgr::loadCommonNames(const QString& commonNameFile)
 				continue;
 			}
 
-			// Fix for translate star names 
-			// englishCommonName.replace('_', ' ');
-			const QString commonNameI18n = q_(englishCommonName);
-			QString commonNameI18n_cap = commonNameI18n.toUpper();
-
-			commonNamesMap[hip] = englishCommonName;
-			commonNamesMapI18n[hip] = commonNameI18n;
-			commonNamesIndexI18n[commonNameI18n_cap] = hip;
-			commonNamesIndex[englishCommonName.toUpper()] = hip;
+			// The names are translated when they are looked up
+			namesMap[hip] = QStringList(englishCommonName);
+			namesIndex[englishCommonName.toUpper()] = hip;
 			readOk++;
 		}
 	}
 	cnFile.close();
+	commonNames.build(namesMap, 1, namesIndex);
 
 	qDebug() << "Loaded" << readOk << "/" << totalRecords << "common star names";
 	return 1;
@@ -607,10 +682,12 @@ int StarMgr::loadCommonNames(const QString& commonNameFile)
 // Load scientific names from file
 void StarMgr::loadSciNames(const QString& sciNameFile)
 {
-	sciNamesMapI18n.clear();
-	sciNamesIndexI18n.clear();
-	sciAdditionalNamesMapI18n.clear();
-	sciAdditionalNamesIndexI18n.clear();
+	sciNames.clear();
+	sciAdditionalNames.clear();
+	QMap<int,QStringList> namesMap;
+	QMap<QString,int> namesIndex;
+	QMap<int,QStringList> additionalNamesMap;
+	QMap<QString,int> additionalNamesIndex;
 
 	qDebug() << "Loading star names from" << QDir::toNativeSeparators(sciNameFile);
 	QFile snFile(sciNameFile);
@@ -664,19 +741,21 @@ void StarMgr::loadSciNames(const QString& sciNameFile)
 
 			sci_name_i18n.replace('_',' ');
 			// Don't set the main sci name if it's already set - it's additional sci name
-			if (sciNamesMapI18n.find(hip)!=sciNamesMapI18n.end())
+			if (namesMap.contains(hip))
 			{
-				sciAdditionalNamesMapI18n[hip] = sci_name_i18n;
-				sciAdditionalNamesIndexI18n[sci_name_i18n.toUpper()] = hip;
+				additionalNamesMap[hip] = QStringList(sci_name_i18n);
+				additionalNamesIndex[sci_name_i18n.toUpper()] = hip;
 			}
 			else
 			{
-				sciNamesMapI18n[hip] = sci_name_i18n;
-				sciNamesIndexI18n[sci_name_i18n.toUpper()] = hip;
+				namesMap[hip] = QStringList(sci_name_i18n);
+				namesIndex[sci_name_i18n.toUpper()] = hip;
 			}
 			++readOk;
 		}
 	}
+	sciNames.build(namesMap, 1, namesIndex);
+	sciAdditionalNames.build(additionalNamesMap, 1, additionalNamesIndex);
 
 	qDebug() << "Loaded" << readOk << "/" << totalRecords << "scientific star names";
 }
@@ -684,8 +763,9 @@ void StarMgr::loadSciNames(const QString& sciNameFile)
 // Load GCVS from file
 void StarMgr::loadGcvs(const QString& GcvsFile)
 {
-	varStarsMapI18n.clear();
-	varStarsIndexI18n.clear();
+	varStars.clear();
+	QMap<int,QStringList> starsMap;
+	QMap<QString,int> starsIndex;
 
 	qDebug() << "Loading variable stars from" << QDir::toNativeSeparators(GcvsFile);
 	QFile vsFile(GcvsFile);
@@ -720,31 +800,27 @@ void StarMgr::loadGcvs(const QString& GcvsFile)
 			continue;
 		}
 
+		if (fields.size()<=VarStarFieldCount)
+		{
+			qWarning() << "WARNING - parse error at line" << lineNumber << "in" << QDir::toNativeSeparators(GcvsFile)
+				   << " - record does not match record pattern";
+			continue;
+		}
+
 		// Don't set the star if it's already set
-		if (varStarsMapI18n.find(hip)!=varStarsMapI18n.end())
+		if (starsMap.contains(hip))
 			continue;
 
-		varstar variableStar;
+		// The numbers are only converted when they are looked up
+		QStringList variableStar;
+		for (int i=0; i<VarStarFieldCount; ++i)
+			variableStar << fields.at(i+1).trimmed();
 
-		variableStar.designation = fields.at(1).trimmed();
-		variableStar.vtype = fields.at(2).trimmed();
-		variableStar.maxmag = fields.at(3).toFloat();
-		variableStar.mflag = fields.at(4).toInt();
-		variableStar.min1mag = fields.at(5).toFloat();
-		if (fields.at(6).isEmpty())
-			variableStar.min2mag = 99.f;
-		else
-			variableStar.min2mag = fields.at(6).toFloat();
-		variableStar.photosys = fields.at(7).trimmed();
-		variableStar.epoch = fields.at(8).toDouble();
-		variableStar.period = fields.at(9).toDouble();
-		variableStar.Mm = fields.at(10).toInt();
-		variableStar.stype = fields.at(11).trimmed();
-
-		varStarsMapI18n[hip] = variableStar;
-		varStarsIndexI18n[variableStar.designation.toUpper()] = hip;
+		starsMap[hip] = variableStar;
+		starsIndex[variableStar.at(VarStarDesignation).toUpper()] = hip;
 		++readOk;
 	}
+	varStars.build(starsMap, VarStarFieldCount, starsIndex);
 
 	qDebug() << "Loaded" << readOk << "/" << totalRecords << "variable stars";
 }
@@ -768,6 +844,7 @@ int StarMgr::getMaxSearchLevel() const
 // Draw all the stars
 void StarMgr::draw(StelCore* core)
 {
+	STEL_PROFILE_SCOPE("StarMgr::draw");
 	const StelProjectorP prj = core->getProjection(StelCore::FrameJ2000);
 	StelSkyDrawer* skyDrawer = core->getSkyDrawer();
 	// If stars are turned off don't waste time below
@@ -790,10 +867,18 @@ void StarMgr::draw(StelCore* core)
 
 	// Prepare a table for storing precomputed RCMag for all ZoneArrays
 	RCMag rcmag_table[RCMAG_TABLE_SIZE];
+
+	// The faint stars can be drawn by the GPU from the persistent star buffers, which hold a whole level:
+	// only the levels fitting in the budget use them, a deep level would take hundreds of MB
+	const bool canUseBuffers = skyDrawer->canDrawPointSourceBuffers(prj);
+	qint64 bufferBytes = 0;
+	QVector<int> zones;
 	
 	// Draw all the stars of all the selected zones
-	foreach(const ZoneArray* z, gridLevels)
+	foreach(ZoneArray* z, gridLevels)
 	{
+		bufferBytes += (qint64)z->getNrOfStars()*sizeof(StelSkyDrawer::PointSourceVertex);
+		const bool useBuffers = canUseBuffers && bufferBytes<=starBufferBudget;
 		int limitMagIndex=RCMAG_TABLE_SIZE;
 		const float mag_min = 0.001f*z->mag_min;
 		const float k = (0.001f*z->mag_range)/z->mag_steps; // MagStepIncrement
@@ -830,12 +915,31 @@ void StarMgr::draw(StelCore* core)
 			if (x > 0)
 				maxMagStarName = x;
 		}
+
+		// Labelled stars and stars with a big halo stay on the CPU path
+		int firstBufferMagIndex = -1;
+		if (useBuffers)
+		{
+			firstBufferMagIndex = maxMagStarName;
+			while (firstBufferMagIndex<RCMAG_TABLE_SIZE && rcmag_table[firstBufferMagIndex].radius>StelSkyDrawer::getBigHaloMinRadius())
+				++firstBufferMagIndex;
+		}
+
+		STEL_PROFILE_SCOPE("StarMgr::draw zones");
 		int zone;
-		
+		zones.clear();
 		for (GeodesicSearchInsideIterator it1(*geodesic_search_result,z->level);(zone = it1.next()) >= 0;)
-			z->draw(&sPainter, zone, true, rcmag_table, limitMagIndex, core, maxMagStarName, names_brightness, viewportCaps);
+		{
+			z->draw(&sPainter, zone, true, rcmag_table, limitMagIndex, core, maxMagStarName, names_brightness, viewportCaps, firstBufferMagIndex);
+			zones.append(zone);
+		}
 		for (GeodesicSearchBorderIterator it1(*geodesic_search_result,z->level);(zone = it1.next()) >= 0;)
-			z->draw(&sPainter, zone, false, rcmag_table, limitMagIndex, core, maxMagStarName,names_brightness, viewportCaps);
+		{
+			z->draw(&sPainter, zone, false, rcmag_table, limitMagIndex, core, maxMagStarName,names_brightness, viewportCaps, firstBufferMagIndex);
+			zones.append(zone);
+		}
+		if (useBuffers)
+			z->drawFromBuffer(&sPainter, zones, firstBufferMagIndex, limitMagIndex, core, starsFader.getInterstate());
 	}
 	exit_loop:
 
@@ -899,21 +1003,32 @@ QList<StelObjectP > StarMgr::searchAround(const Vec3d& vv, double limFov, const
 	SphericalConvexPolygon c(e3, e2, e2, e0);
 	const GeodesicSearchResult* geodesic_search_result = core->getGeodesicGrid(lastMaxSearchLevel)->search(c.getBoundingSphericalCaps(),lastMaxSearchLevel);
 
+	// Only the stars bright enough to be displayed can be found
+	const StelSkyDrawer* skyDrawer = core->getSkyDrawer();
+	float limitMag = skyDrawer->getLimitMagnitude();
+	if (skyDrawer->getFlagStarMagnitudeLimit())
+		limitMag = qMin(limitMag, skyDrawer->getCustomStarMagnitudeLimit());
+
 	// Iterate over the stars inside the triangles
 	f = cos(limFov * M_PI/180.);
 	foreach(ZoneArray* z, gridLevels)
 	{
+		// Skip the levels with only fainter stars
+		if (z->mag_min > (int)(limitMag*1000.f))
+			continue;
+		const int maxMagIndex = ((int)(limitMag*1000.f) - z->mag_min)*z->mag_steps/z->mag_range;
+
 		//qDebug() << "search inside(" << it->first << "):";
 		int zone;
 		for (GeodesicSearchInsideIterator it1(*geodesic_search_result,z->level);(zone = it1.next()) >= 0;)
 		{
-			z->searchAround(core, zone,v,f,result);
+			z->searchAround(core, zone,v,f,maxMagIndex,result);
 			//qDebug() << " " << zone;
 		}
 		//qDebug() << endl << "search border(" << it->first << "):";
 		for (GeodesicSearchBorderIterator it1(*geodesic_search_result,z->level); (zone = it1.next()) >= 0;)
 		{
-			z->searchAround(core, zone,v,f,result);
+			z->searchAround(core, zone,v,f,maxMagIndex,result);
 			//qDebug() << " " << zone;
 		}
 	}
@@ -925,20 +1040,10 @@ QList<StelObjectP > StarMgr::searchAround(const Vec3d& vv, double limFov, const
 //! The translation is done using gettext with translated strings defined in translations.h
 void StarMgr::updateI18n()
 {
-	QRegExp transRx("_[(]\"(.*)\"[)]");
-	const StelTranslator& trans = StelApp::getInstance().getLocaleMgr().getSkyTranslator();
-	commonNamesMapI18n.clear();
-	commonNamesIndexI18n.clear();
-	for (QHash<int,QString>::ConstIterator it(commonNamesMap.constBegin());it!=commonNamesMap.constEnd();it++)
-	{
-		const int i = it.key();
-		transRx.exactMatch(it.value());
-		QString tt = transRx.capturedTexts().at(1);
-		const QString t = trans.qtranslate(tt);
-		//const QString t(trans.qtranslate(it.value()));
-		commonNamesMapI18n[i] = t;
-		commonNamesIndexI18n[t.toUpper()] = i;
-	}
+	// The names are translated again when they are looked up
+	commonNamesI18nCache.clear();
+	commonNamesI18n.clear();
+	commonNamesI18nLoaded = false;
 }
 
 // Search the star by HP number
@@ -969,32 +1074,32 @@ StelObjectP StarMgr::searchByNameI18n(const QString& nameI18n) const
 	}
 
 	// Search by I18n common name
-	QMap<QString,int>::const_iterator it(commonNamesIndexI18n.find(objw));
-	if (it!=commonNamesIndexI18n.end())
+	int hip = getCommonNamesI18n().findKey(objw);
+	if (hip>=0)
 	{
-		return searchHP(it.value());
+		return searchHP(hip);
 	}
 
 	// Search by sci name
-	QMap<QString,int>::const_iterator it2 = sciNamesIndexI18n.find(objw);
-	if (it2!=sciNamesIndexI18n.end())
+	hip = getSciNames().findKey(objw);
+	if (hip>=0)
 	{
-		return searchHP(it2.value());
+		return searchHP(hip);
 	}
 
 
 	// Search by additional sci name
-	QMap<QString,int>::const_iterator it3 = sciAdditionalNamesIndexI18n.find(objw);
-	if (it3!=sciAdditionalNamesIndexI18n.end())
+	hip = getSciAdditionalNames().findKey(objw);
+	if (hip>=0)
 	{
-		return searchHP(it3.value());
+		return searchHP(hip);
 	}
 
 	// Search by GCVS name
-	QMap<QString,int>::const_iterator it4 = varStarsIndexI18n.find(objw);
-	if (it4!=varStarsIndexI18n.end())
+	hip = getVarStars().findKey(objw);
+	if (hip>=0)
 	{
-		return searchHP(it4.value());
+		return searchHP(hip);
 	}
 
 	return StelObjectP();
@@ -1013,17 +1118,17 @@ StelObjectP StarMgr::searchByName(const QString& name) const
 	}
 
 	// Search by sci name
-	QMap<QString,int>::const_iterator it = sciNamesIndexI18n.find(objw);
-	if (it!=sciNamesIndexI18n.end())
+	int hip = getSciNames().findKey(objw);
+	if (hip>=0)
 	{
-		return searchHP(it.value());
+		return searchHP(hip);
 	}
 
 	// Search by additional sci name
-	QMap<QString,int>::const_iterator it2 = sciAdditionalNamesIndexI18n.find(objw);
-	if (it2!=sciAdditionalNamesIndexI18n.end())
+	hip = getSciAdditionalNames().findKey(objw);
+	if (hip>=0)
 	{
-		return searchHP(it2.value());
+		return searchHP(hip);
 	}
 
 	return StelObjectP();
@@ -1040,13 +1145,14 @@ QStringList StarMgr::listMatchingObjectsI18n(const QString& objPrefix, int maxNb
 
 	// Search for common names
 	if (useStartOfWords) {
-		for (QMap<QString,int>::const_iterator it(commonNamesIndexI18n.lowerBound(objw)); it!=commonNamesIndexI18n.end(); ++it)
+		const StarNameTable& index = getCommonNamesI18n();
+		for (int i=index.lowerBound(objw); i<index.getIndexSize(); ++i)
 		{
-			if (it.key().startsWith(objw))
+			if (index.getKey(i).startsWith(objw))
 			{
 				if (maxNbItem==0)
 					break;
-				result << getCommonName(it.value());
+				result << getCommonName(index.getKeyHip(i));
 				--maxNbItem;
 			}
 			else
@@ -1055,15 +1161,14 @@ QStringList StarMgr::listMatchingObjectsI18n(const QString& objPrefix, int maxNb
 	}
 	else
 	{
-		QMapIterator<QString, int> i(commonNamesIndexI18n);
-		while (i.hasNext())
+		const StarNameTable& index = getCommonNamesI18n();
+		for (int i=0; i<index.getIndexSize(); ++i)
 		{
-			i.next();
-			if (i.key().contains(objw))
+			if (index.getKey(i).contains(objw))
 			{
 				if (maxNbItem==0)
 					break;
-				result << getCommonName(i.value());
+				result << getCommonName(index.getKeyHip(i));
 				--maxNbItem;
 			}
 		}
@@ -1078,39 +1183,44 @@ QStringList StarMgr::listMatchingObjectsI18n(const QString& objPrefix, int maxNb
 	if (objw.at(0).unicode() >= 0x0391 && objw.at(0).unicode() <= 0x03A9)
 		bayerRegEx.setPattern(bayerPattern.insert(1,"\\d?"));
 
-	for (QMap<QString,int>::const_iterator it(sciNamesIndexI18n.lowerBound(objw)); it!=sciNamesIndexI18n.end(); ++it)
+	const StarNameTable& sciNamesIndex = getSciNames();
+	for (int i=sciNamesIndex.lowerBound(objw); i<sciNamesIndex.getIndexSize(); ++i)
 	{
-		if (it.key().indexOf(bayerRegEx)==0)
+		const QString key = sciNamesIndex.getKey(i);
+		if (key.indexOf(bayerRegEx)==0)
 		{
 			if (maxNbItem==0)
 				break;
-			result << getSciName(it.value());
+			result << getSciName(sciNamesIndex.getKeyHip(i));
 			--maxNbItem;
 		}
-		else if (it.key().at(0) != objw.at(0))
+		else if (key.at(0) != objw.at(0))
 			break;
 	}
 
-	for (QMap<QString,int>::const_iterator it(sciAdditionalNamesIndexI18n.lowerBound(objw)); it!=sciAdditionalNamesIndexI18n.end(); ++it)
+	const StarNameTable& sciAdditionalNamesIndex = getSciAdditionalNames();
+	for (int i=sciAdditionalNamesIndex.lowerBound(objw); i<sciAdditionalNamesIndex.getIndexSize(); ++i)
 	{
-		if (it.key().indexOf(bayerRegEx)==0)
+		const QString key = sciAdditionalNamesIndex.getKey(i);
+		if (key.indexOf(bayerRegEx)==0)
 		{
 			if (maxNbItem==0)
 				break;
-			result << getSciAdditionalName(it.value());
+			result << getSciAdditionalName(sciAdditionalNamesIndex.getKeyHip(i));
 			--maxNbItem;
 		}
-		else if (it.key().at(0) != objw.at(0))
+		else if (key.at(0) != objw.at(0))
 			break;
 	}
 
-	for (QMap<QString,int>::const_iterator it(varStarsIndexI18n.lowerBound(objw)); it!=varStarsIndexI18n.end(); ++it)
+	const StarNameTable& varStarsIndex = getVarStars();
+	for (int i=varStarsIndex.lowerBound(objw); i<varStarsIndex.getIndexSize(); ++i)
 	{
-		if (it.key().startsWith(objw))
+		if (varStarsIndex.getKey(i).startsWith(objw))
 		{
 			if (maxNbItem==0)
 				break;
-			result << getGcvsName(it.value());
+			result << getGcvsName(varStarsIndex.getKeyHip(i));
 			--maxNbItem;
 		}
 		else
@@ -1151,13 +1261,14 @@ QStringList StarMgr::listMatchingObjects(const QString& objPrefix, int maxNbItem
 	// Search for common names
 	if (useStartOfWords)
 	{
-		for (QMap<QString,int>::const_iterator it(commonNamesIndex.lowerBound(objw)); it!=commonNamesIndex.end(); ++it)
+		const StarNameTable& index = getCommonNames();
+		for (int i=index.lowerBound(objw); i<index.getIndexSize(); ++i)
 		{
-			if (it.key().startsWith(objw))
+			if (index.getKey(i).startsWith(objw))
 			{
 				if (maxNbItem==0)
 					break;
-				result << getCommonName(it.value());
+				result << getCommonName(index.getKeyHip(i));
 				--maxNbItem;
 			}
 			else
@@ -1166,15 +1277,14 @@ QStringList StarMgr::listMatchingObjects(const QString& objPrefix, int maxNbItem
 	}
 	else
 	{
-		QMapIterator<QString, int> i(commonNamesIndex);
-		while (i.hasNext())
+		const StarNameTable& index = getCommonNames();
+		for (int i=0; i<index.getIndexSize(); ++i)
 		{
-			i.next();
-			if (i.key().contains(objw))
+			if (index.getKey(i).contains(objw))
 			{
 				if (maxNbItem==0)
 					break;
-				result << getCommonName(i.value());
+				result << getCommonName(index.getKeyHip(i));
 				--maxNbItem;
 			}
 		}
@@ -1189,40 +1299,45 @@ QStringList StarMgr::listMatchingObjects(const QString& objPrefix, int maxNbItem
 	if (objw.at(0).unicode() >= 0x0391 && objw.at(0).unicode() <= 0x03A9)
 		bayerRegEx.setPattern(bayerPattern.insert(1,"\\d?"));
 
-	for (QMap<QString,int>::const_iterator it(sciNamesIndexI18n.lowerBound(objw)); it!=sciNamesIndexI18n.end(); ++it)
+	const StarNameTable& sciNamesIndex = getSciNames();
+	for (int i=sciNamesIndex.lowerBound(objw); i<sciNamesIndex.getIndexSize(); ++i)
 	{
-		if (it.key().indexOf(bayerRegEx)==0)
+		const QString key = sciNamesIndex.getKey(i);
+		if (key.indexOf(bayerRegEx)==0)
 		{
 			if (maxNbItem==0)
 				break;
-			result << getSciName(it.value());
+			result << getSciName(sciNamesIndex.getKeyHip(i));
 			--maxNbItem;
 		}
-		else if (it.key().at(0) != objw.at(0))
+		else if (key.at(0) != objw.at(0))
 			break;
 	}
 
-	for (QMap<QString,int>::const_iterator it(sciAdditionalNamesIndexI18n.lowerBound(objw)); it!=sciAdditionalNamesIndexI18n.end(); ++it)
+	const StarNameTable& sciAdditionalNamesIndex = getSciAdditionalNames();
+	for (int i=sciAdditionalNamesIndex.lowerBound(objw); i<sciAdditionalNamesIndex.getIndexSize(); ++i)
 	{
-		if (it.key().indexOf(bayerRegEx)==0)
+		const QString key = sciAdditionalNamesIndex.getKey(i);
+		if (key.indexOf(bayerRegEx)==0)
 		{
 			if (maxNbItem==0)
 				break;
-			result << getSciAdditionalName(it.value());
+			result << getSciAdditionalName(sciAdditionalNamesIndex.getKeyHip(i));
 			--maxNbItem;
 		}
-		else if (it.key().at(0) != objw.at(0))
+		else if (key.at(0) != objw.at(0))
 			break;
 	}
 
 	// Search for sci names for var stars
-	for (QMap<QString,int>::const_iterator it(varStarsIndexI18n.lowerBound(objw)); it!=varStarsIndexI18n.end(); ++it)
+	const StarNameTable& varStarsIndex = getVarStars();
+	for (int i=varStarsIndex.lowerBound(objw); i<varStarsIndex.getIndexSize(); ++i)
 	{
-		if (it.key().startsWith(objw))
+		if (varStarsIndex.getKey(i).startsWith(objw))
 		{
 			if (maxNbItem==0)
 				break;
-			result << getGcvsName(it.value());
+			result << getGcvsName(varStarsIndex.getKeyHip(i));
 			--maxNbItem;
 		}
 		else
@@ -1260,26 +1375,17 @@ void StarMgr::setFontSize(float newFontSize)
 
 void StarMgr::updateSkyCulture(const QString& skyCultureDir)
 {
-	// Load culture star names in english
-	QString fic = StelFileMgr::findFile("skycultures/" + skyCultureDir + "/star_names.fab");
-	if (fic.isEmpty())
-		qDebug() << "Could not load star_names.fab for sky culture " << QDir::toNativeSeparators(skyCultureDir);
-	else
-		loadCommonNames(fic);
-
-	fic = StelFileMgr::findFile("stars/default/name.fab");
-	if (fic.isEmpty())
-		qWarning() << "WARNING: could not load scientific star names file: stars/default/name.fab";
-	else
-		loadSciNames(fic);
-	
-	fic = StelFileMgr::findFile("stars/default/gcvs_hip_part.dat");
-	if (fic.isEmpty())
-		qWarning() << "WARNING: could not load variable stars file: stars/default/gcvs_hip_part.dat";
-	else
-		loadGcvs(fic);
+	// The culture star names are loaded when they are first needed, the scientific names and
+	// the variable stars don't depend on the culture
+	currentSkyCultureDir = skyCultureDir;
+	commonNames.clear();
+	commonNamesLoaded = false;
+	// The translated names and their search index come from the culture names too.
+	// A culture change doesn't emit languageChanged(), so updateI18n() isn't called by StelApp.
+	commonNamesI18nCache.clear();
+	commonNamesI18n.clear();
+	commonNamesI18nLoaded = false;
 
 	// Turn on sci names/catalog names for western culture only
 	setFlagSciNames(skyCultureDir.startsWith("western"));
-	updateI18n();
 }
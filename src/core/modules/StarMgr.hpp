@@ -27,6 +27,7 @@
 #include "StelObjectModule.hpp"
 #include "StelTextureTypes.hpp"
 #include "StelProjectorType.hpp"
+#include "StarNameTable.hpp"
 
 class StelObject;
 class StelToneReproducer;
@@ -39,21 +40,6 @@ struct HipIndexStruct;
 
 static const int RCMAG_TABLE_SIZE = 4096;
 
-typedef struct
-{
-	QString designation;	//! GCVS designation
-	QString vtype;		//! Type of variability
-	float maxmag;		//! Magnitude at maximum brightness
-	int mflag;		//! Magnitude flag code
-	float min1mag;		//! First minimum magnitude or amplitude
-	float min2mag;		//! Second minimum magnitude or amplitude
-	QString photosys;	//! The photometric system for magnitudes
-	double epoch;		//! Epoch for maximum light (Julian days)
-	double period;		//! Period of the variable star (days)
-	int Mm;			//! Rising time or duration of eclipse (%)
-	QString stype;		//! Spectral type
-} varstar;
-
 //! @class StarMgr
 //! Stores the star catalogue data.
 //! Used to render the stars themselves, as well as determine the color table
@@ -114,7 +100,8 @@ public:
 
 	///////////////////////////////////////////////////////////////////////////
 	// Methods defined in StelObjectManager class
-	//! Return a list containing the stars located inside the limFov circle around position v
+	//! Return a list containing the stars located inside the limFov circle around position v.
+	//! Only the stars bright enough to be displayed are returned.
 	virtual QList<StelObjectP > searchAround(const Vec3d& v, double limitFov, const StelCore* core) const;
 
 	//! Return the matching Stars object's pointer if exists or NULL
@@ -259,18 +246,33 @@ private:
 	void copyDefaultConfigFile();
 
 	//! Loads common names for stars from a file.
-	//! Called when the SkyCulture is updated.
+	//! Called when the common names are first needed.
 	//! @param the path to a file containing the common names for bright stars.
-	int loadCommonNames(const QString& commonNameFile);
+	static int loadCommonNames(const QString& commonNameFile);
 
 	//! Loads scientific names for stars from a file.
-	//! Called when the SkyCulture is updated.
+	//! Called when the scientific names are first needed.
 	//! @param the path to a file containing the scientific names for bright stars.
-	void loadSciNames(const QString& sciNameFile);
+	static void loadSciNames(const QString& sciNameFile);
 
 	//! Loads GCVS from a file.
+	//! Called when the variable stars are first needed.
 	//! @param the path to a file containing the GCVS.
-	void loadGcvs(const QString& GcvsFile);
+	static void loadGcvs(const QString& GcvsFile);
+
+	//! Get the common names of the current sky culture, in english, loading them if needed.
+	static const StarNameTable& getCommonNames();
+	//! Get the index of the translated common names, creating it if needed.
+	static const StarNameTable& getCommonNamesI18n();
+	//! Get the scientific names, loading them if needed.
+	static const StarNameTable& getSciNames();
+	//! Get the additional scientific names, loading them if needed.
+	static const StarNameTable& getSciAdditionalNames();
+	//! Get the GCVS data, loading it if needed.
+	static const StarNameTable& getVarStars();
+
+	//! Translate a common name as written in the star_names.fab files.
+	static QString translateCommonName(const QString& englishName);
 
 	//! Gets the maximum search level.
 	// TODO: add a non-lame description - what is the purpose of the max search level?
@@ -291,6 +293,9 @@ private:
 
 	int maxGeodesicGridLevel;
 	int lastMaxSearchLevel;
+	//! openGL memory in bytes for the persistent star buffers. The levels are drawn from buffers from the
+	//! brightest one, as long as all their stars fit in this budget, the other ones stay on the CPU path.
+	qint64 starBufferBudget;
 	
 	// A ZoneArray per grid level
 	QVector<ZoneArray*> gridLevels;
@@ -310,19 +315,25 @@ private:
 
 	HipIndexStruct *hipIndex; // array of hiparcos stars
 
-	static QHash<int, QString> commonNamesMap;
-	static QHash<int, QString> commonNamesMapI18n;
-	static QMap<QString, int> commonNamesIndexI18n;
-	static QMap<QString, int> commonNamesIndex;
-
-	static QHash<int, QString> sciNamesMapI18n;	
-	static QMap<QString, int> sciNamesIndexI18n;
-
-	static QHash<int, QString> sciAdditionalNamesMapI18n;
-	static QMap<QString, int> sciAdditionalNamesIndexI18n;
-
-	static QHash<int, varstar> varStarsMapI18n;
-	static QMap<QString, int> varStarsIndexI18n;
+	// The name tables are only loaded when a label or a search needs them
+	static QString currentSkyCultureDir;
+	static bool commonNamesLoaded;
+	static bool sciNamesLoaded;
+	static bool varStarsLoaded;
+	static bool commonNamesI18nLoaded;
+
+	//! English common names, indexed by their upper case.
+	static StarNameTable commonNames;
+	//! Index of the upper case translated common names.
+	static StarNameTable commonNamesI18n;
+	//! Translated common names of the stars already looked up, including the empty names.
+	static QHash<int, QString> commonNamesI18nCache;
+
+	static StarNameTable sciNames;
+	static StarNameTable sciAdditionalNames;
+
+	//! GCVS data of the variable stars, indexed by the upper case designations.
+	static StarNameTable varStars;
 
 	QFont starFont;
 	static bool flagSciNames;
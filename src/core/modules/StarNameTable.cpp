@@ -0,0 +1,170 @@
+/*
+ * Stellarium
+ * Copyright (C) 2015 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StarNameTable.hpp"
+
+#include <QHash>
+#include <QVector>
+
+namespace
+{
+	//! Accumulate the strings of a table, each stored once.
+	class StringTable
+	{
+	public:
+		//! The offset 0 is the empty string.
+		StringTable() : data(1, '\0') {}
+
+		quint32 add(const QString& s)
+		{
+			if (s.isEmpty())
+				return 0;
+			const QByteArray utf8 = s.toUtf8();
+			QHash<QByteArray, quint32>::ConstIterator it = offsets.constFind(utf8);
+			if (it!=offsets.constEnd())
+				return it.value();
+			const quint32 offset = data.size();
+			data.append(utf8);
+			data.append('\0');
+			offsets.insert(utf8, offset);
+			return offset;
+		}
+
+		QByteArray data;
+
+	private:
+		QHash<QByteArray, quint32> offsets;
+	};
+}
+
+StarNameTable::StarNameTable() : recordCount(0), fieldCount(0), indexCount(0), indexOffset(0), stringsOffset(0)
+{
+}
+
+void StarNameTable::clear()
+{
+	data.clear();
+	recordCount = 0;
+	fieldCount = 0;
+	indexCount = 0;
+	indexOffset = 0;
+	stringsOffset = 0;
+}
+
+void StarNameTable::build(const QMap<int, QStringList>& records, int afieldCount, const QMap<QString, int>& index)
+{
+	Q_ASSERT(afieldCount>=0);
+	StringTable strings;
+	QVector<quint32> w;
+	w.reserve(records.size()*(1+afieldCount)+index.size()*2);
+
+	// The QMap iterations give the records sorted by HIP number and the index sorted by key
+	for (QMap<int, QStringList>::ConstIterator it=records.constBegin(); it!=records.constEnd(); ++it)
+	{
+		Q_ASSERT(it.value().size()==afieldCount);
+		w.append(it.key());
+		for (int f=0; f<afieldCount; ++f)
+			w.append(strings.add(it.value().at(f)));
+	}
+	const int aindexOffset = w.size();
+	for (QMap<QString, int>::ConstIterator it=index.constBegin(); it!=index.constEnd(); ++it)
+	{
+		w.append(strings.add(it.key()));
+		w.append(it.value());
+	}
+
+	clear();
+	data.reserve(w.size()*sizeof(quint32)+strings.data.size());
+	data.append(reinterpret_cast<const char*>(w.constData()), w.size()*sizeof(quint32));
+	data.append(strings.data);
+	recordCount = records.size();
+	fieldCount = afieldCount;
+	indexCount = index.size();
+	indexOffset = aindexOffset;
+	stringsOffset = w.size()*sizeof(quint32);
+}
+
+int StarNameTable::find(int hip) const
+{
+	const quint32* w = words();
+	const int recordSize = 1+fieldCount;
+	int lo = 0;
+	int hi = recordCount;
+	while (lo<hi)
+	{
+		const int mid = (lo+hi)/2;
+		const int midHip = (int)w[mid*recordSize];
+		if (midHip==hip)
+			return mid;
+		if (midHip<hip)
+			lo = mid+1;
+		else
+			hi = mid;
+	}
+	return -1;
+}
+
+int StarNameTable::getHip(int record) const
+{
+	Q_ASSERT(record>=0 && record<recordCount);
+	return (int)words()[record*(1+fieldCount)];
+}
+
+QString StarNameTable::getField(int record, int field) const
+{
+	Q_ASSERT(record>=0 && record<recordCount);
+	Q_ASSERT(field>=0 && field<fieldCount);
+	return getString(words()[record*(1+fieldCount)+1+field]);
+}
+
+QString StarNameTable::getKey(int i) const
+{
+	Q_ASSERT(i>=0 && i<indexCount);
+	return getString(words()[indexOffset+i*2]);
+}
+
+int StarNameTable::getKeyHip(int i) const
+{
+	Q_ASSERT(i>=0 && i<indexCount);
+	return (int)words()[indexOffset+i*2+1];
+}
+
+int StarNameTable::lowerBound(const QString& key) const
+{
+	// Compare as QString, like the QMap the index was sorted by
+	int lo = 0;
+	int hi = indexCount;
+	while (lo<hi)
+	{
+		const int mid = (lo+hi)/2;
+		if (getKey(mid)<key)
+			lo = mid+1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+int StarNameTable::findKey(const QString& key) const
+{
+	const int i = lowerBound(key);
+	if (i<indexCount && getKey(i)==key)
+		return getKeyHip(i);
+	return -1;
+}
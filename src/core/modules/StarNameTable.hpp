@@ -0,0 +1,98 @@
+/*
+ * Stellarium
+ * Copyright (C) 2015 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STARNAMETABLE_HPP_
+#define _STARNAMETABLE_HPP_
+
+#include <QByteArray>
+#include <QMap>
+#include <QStringList>
+
+//! @class StarNameTable
+//! Compact read only table of star data by Hipparcos number, with a sorted index of search keys.
+//! Each record is a HIP number followed by a fixed number of string fields, and the records are sorted
+//! by HIP number. Each entry of the index is a key and a HIP number, and the entries are sorted by key.
+//! All the strings are stored once in UTF-8. The whole table is a single block of memory using offsets
+//! instead of pointers, so that it doesn't need a QHash or QMap node per star and could be mapped as it is.
+class StarNameTable
+{
+public:
+	StarNameTable();
+
+	//! Create the table, replacing its previous content.
+	//! @param records the fields of the records by HIP number. The records must all have fieldCount fields.
+	//! @param fieldCount the number of fields of each record.
+	//! @param index the HIP numbers by search key, typically the names in upper case.
+	void build(const QMap<int, QStringList>& records, int fieldCount, const QMap<QString, int>& index);
+
+	void clear();
+
+	//! Number of records.
+	int size() const {return recordCount;}
+
+	//! Find a record by HIP number with a binary search.
+	//! @return the number of the record, or -1 if there is none.
+	int find(int hip) const;
+
+	//! Get the HIP number of a record, between 0 and size()-1.
+	int getHip(int record) const;
+
+	//! Get a field of a record.
+	QString getField(int record, int field) const;
+
+	//! Get a field of the record of the given HIP number.
+	//! @return an empty string if there is no record for this star.
+	QString getFieldByHip(int hip, int field=0) const
+	{
+		const int record = find(hip);
+		return record<0 ? QString() : getField(record, field);
+	}
+
+	//! Number of entries of the index.
+	int getIndexSize() const {return indexCount;}
+
+	//! Get the key of an index entry, between 0 and getIndexSize()-1.
+	QString getKey(int i) const;
+
+	//! Get the HIP number of an index entry.
+	int getKeyHip(int i) const;
+
+	//! Find the first index entry whose key is not less than the given key.
+	//! @return getIndexSize() if all the keys are less than the given key.
+	int lowerBound(const QString& key) const;
+
+	//! Find the HIP number of the given key.
+	//! @return -1 if the key is not in the index.
+	int findKey(const QString& key) const;
+
+private:
+	const quint32* words() const {return reinterpret_cast<const quint32*>(data.constData());}
+	QString getString(quint32 offset) const {return QString::fromUtf8(data.constData()+stringsOffset+offset);}
+
+	QByteArray data;
+	int recordCount;
+	int fieldCount;
+	int indexCount;
+	//! Position of the index in words of the data.
+	int indexOffset;
+	//! Position of the strings in bytes of the data.
+	int stringsOffset;
+};
+
+#endif // _STARNAMETABLE_HPP_
@@ -320,7 +320,7 @@ template<class Star>
 SpecialZoneArray<Star>::SpecialZoneArray(QFile* file, bool byte_swap,bool use_mmap,
 					 int level, int mag_min, int mag_range, int mag_steps)
 		: ZoneArray(file->fileName(), file, level, mag_min, mag_range, mag_steps),
-		  stars(0), mmap_start(0)
+		  stars(0), mmap_start(0), starBuffer(NULL)
 {
 	if (nr_of_zones > 0)
 	{
@@ -477,24 +477,34 @@ SpecialZoneArray<Star>::~SpecialZoneArray(void)
 		delete[] getZones();
 		zones = NULL;
 	}
+	if (starBuffer)
+	{
+		delete starBuffer;
+		starBuffer = NULL;
+	}
 	nr_of_zones = 0;
 	nr_of_stars = 0;
 }
 
+// Number of stars decoded together by SpecialZoneArray<Star>::draw. The per block
+// buffers stay on the stack and the inner loops are plain float loops over
+// contiguous arrays, which the compiler turns into SSE/NEON code.
+static const int STAR_BLOCK_SIZE = 64;
+
 template<class Star>
 void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsideViewport, const RCMag* rcmag_table,
-	int limitMagIndex, StelCore* core, int maxMagStarName, float names_brightness, const QVector<SphericalCap> &boundingCaps) const
+	int limitMagIndex, StelCore* core, int maxMagStarName, float names_brightness, const QVector<SphericalCap> &boundingCaps,
+	int firstBufferMagIndex) const
 {
-    StelSkyDrawer* drawer = core->getSkyDrawer();
-    Vec3f vf;
-    static const double d2000 = 2451545.0;
-    const float movementFactor = (M_PI/180)*(0.0001/3600) * ((core->getJDay()-d2000)/365.25) / star_position_scale;
-    
-    // GZ, added for extinction
-    const Extinction& extinction=core->getSkyDrawer()->getExtinction();
-    const bool withExtinction=drawer->getFlagHasAtmosphere() && extinction.getExtinctionCoefficient()>=0.01f;
-    const float k = 0.001f*mag_range/mag_steps; // from StarMgr.cpp line 654
-	
+	StelSkyDrawer* drawer = core->getSkyDrawer();
+	static const double d2000 = 2451545.0;
+	const float movementFactor = (M_PI/180)*(0.0001/3600) * ((core->getJDay()-d2000)/365.25) / star_position_scale;
+
+	// GZ, added for extinction
+	const Extinction& extinction=core->getSkyDrawer()->getExtinction();
+	const bool withExtinction=drawer->getFlagHasAtmosphere() && extinction.getExtinctionCoefficient()>=0.01f;
+	const float k = 0.001f*mag_range/mag_steps; // from StarMgr.cpp line 654
+
 	// Allow artificial cutoff:
 	// find the (integer) mag at which is just bright enough to be drawn.
 	int cutoffMagStep=limitMagIndex;
@@ -505,84 +515,237 @@ void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsid
 			cutoffMagStep = limitMagIndex;
 	}
 	Q_ASSERT(cutoffMagStep<RCMAG_TABLE_SIZE);
-    
-	// Go through all stars, which are sorted by magnitude (bright stars first)
+
+	// The extinction only needs sin(altitude), i.e. the third row of the J2000->AltAz rotation.
+	float altRow[3] = {0.f, 0.f, 0.f};
+	if (withExtinction)
+	{
+		for (int j=0;j<3;++j)
+		{
+			Vec3f axis(0.f);
+			axis[j] = 1.f;
+			core->j2000ToAltAzInPlaceNoRefraction(&axis);
+			altRow[j] = axis[2];
+		}
+	}
+
+	// Stars from firstBufferMagIndex are drawn by drawFromBuffer(). The extinction test
+	// below still uses cutoffMagStep, extincted stars keep their place.
+	const int lastMagStep = firstBufferMagIndex>=0 ? qMin(cutoffMagStep, firstBufferMagIndex-1) : cutoffMagStep;
+
 	const SpecialZoneData<Star>* zoneToDraw = getZones() + index;
-	const Star* lastStar = zoneToDraw->getStars() + zoneToDraw->size;
-    for (const Star* s=zoneToDraw->getStars();s<lastStar;++s)
-    {
-		// Artifical cutoff per magnitude
-		if (s->mag > cutoffMagStep)
-			break;
-    
-		// Because of the test above, the star should always be visible from this point.
-		
-		// Array of 2 numbers containing radius and magnitude
-		const RCMag* tmpRcmag = &rcmag_table[s->mag];
-		
-		// Get the star position from the array
-		s->getJ2000Pos(zoneToDraw, movementFactor, vf);
-		
-		// If the star zone is not strictly contained inside the viewport, eliminate from the 
+	const Vec3f& center = zoneToDraw->center;
+	const Vec3f& axis0 = zoneToDraw->axis0;
+	const Vec3f& axis1 = zoneToDraw->axis1;
+
+	// Structure of arrays for one block of stars
+	float u0[STAR_BLOCK_SIZE], u1[STAR_BLOCK_SIZE];
+	float px[STAR_BLOCK_SIZE], py[STAR_BLOCK_SIZE], pz[STAR_BLOCK_SIZE];
+	float sinAlt[STAR_BLOCK_SIZE], extMagShift[STAR_BLOCK_SIZE];
+	unsigned char visible[STAR_BLOCK_SIZE];
+
+	// Go through all stars, which are sorted by magnitude (bright stars first)
+	const Star* s = zoneToDraw->getStars();
+	const Star* lastStar = s + zoneToDraw->size;
+	bool reachedCutoff = false;
+	while (s<lastStar && !reachedCutoff)
+	{
+		// Decode the packed records. Artifical cutoff per magnitude ends the last block.
+		const Star* blockStart = s;
+		int n = 0;
+		for (;n<STAR_BLOCK_SIZE && s<lastStar;++n,++s)
+		{
+			if ((int)s->mag > lastMagStep)
+			{
+				reachedCutoff = true;
+				break;
+			}
+			s->getJ2000Offsets(movementFactor, u0[n], u1[n]);
+		}
+
+		// Proper motion corrected J2000 positions
+		for (int i=0;i<n;++i)
+		{
+			px[i] = axis0[0]*u0[i] + axis1[0]*u1[i] + center[0];
+			py[i] = axis0[1]*u0[i] + axis1[1]*u1[i] + center[1];
+			pz[i] = axis0[2]*u0[i] + axis1[2]*u1[i] + center[2];
+			visible[i] = 1;
+		}
+
+		// If the star zone is not strictly contained inside the viewport, eliminate from the
 		// beginning the stars actually outside viewport.
 		if (!isInsideViewport)
 		{
-			bool isVisible = true;
-			vf.normalize();
+			for (int i=0;i<n;++i)
+			{
+				const float invLen = 1.f/std::sqrt(px[i]*px[i]+py[i]*py[i]+pz[i]*pz[i]);
+				px[i] *= invLen;
+				py[i] *= invLen;
+				pz[i] *= invLen;
+			}
 			foreach (const SphericalCap& cap, boundingCaps)
 			{
-				if (!cap.contains(vf))
-				{
-					isVisible = false;
-					continue;
-				}
+				const float nx = cap.n[0], ny = cap.n[1], nz = cap.n[2], d = cap.d;
+				for (int i=0;i<n;++i)
+					visible[i] &= (px[i]*nx+py[i]*ny+pz[i]*nz >= d);
 			}
-			if (!isVisible)
-				continue;
 		}
 
-		int extinctedMagIndex = s->mag;
 		if (withExtinction)
 		{
-			Vec3f altAz(vf);
-			altAz.normalize();
-			core->j2000ToAltAzInPlaceNoRefraction(&altAz);
-			float extMagShift=0.0f;
-			extinction.forward(altAz, &extMagShift);
-			extinctedMagIndex = s->mag + (int)(extMagShift/k);
-			if (extinctedMagIndex >= cutoffMagStep) // i.e., if extincted it is dimmer than cutoff, so remove
+			for (int i=0;i<n;++i)
+			{
+				const float invLen = 1.f/std::sqrt(px[i]*px[i]+py[i]*py[i]+pz[i]*pz[i]);
+				sinAlt[i] = (altRow[0]*px[i]+altRow[1]*py[i]+altRow[2]*pz[i])*invLen;
+				extMagShift[i] = 0.f;
+			}
+			extinction.forward(sinAlt, extMagShift, n);
+		}
+
+		for (int i=0;i<n;++i)
+		{
+			if (!visible[i])
 				continue;
-			tmpRcmag = &rcmag_table[extinctedMagIndex];
+			const Star* star = blockStart + i;
+
+			// Array of 2 numbers containing radius and magnitude
+			const RCMag* tmpRcmag = &rcmag_table[star->mag];
+			int extinctedMagIndex = star->mag;
+			if (withExtinction)
+			{
+				extinctedMagIndex = star->mag + (int)(extMagShift[i]/k);
+				if (extinctedMagIndex >= cutoffMagStep) // i.e., if extincted it is dimmer than cutoff, so remove
+					continue;
+				tmpRcmag = &rcmag_table[extinctedMagIndex];
+			}
+
+			const Vec3f vf(px[i], py[i], pz[i]);
+			if (drawer->drawPointSource(sPainter, vf, *tmpRcmag, star->bV, !isInsideViewport) && star->hasName() && extinctedMagIndex < maxMagStarName && star->hasComponentID()<=1)
+			{
+				const float offset = tmpRcmag->radius*0.7f;
+				const Vec3f colorr = StelSkyDrawer::indexToColor(star->bV)*0.75f;
+				sPainter->setColor(colorr[0], colorr[1], colorr[2],names_brightness);
+				sPainter->drawText(Vec3d(vf[0], vf[1], vf[2]), star->getNameI18n(), 0, offset, offset, false);
+			}
 		}
-	
-		if (drawer->drawPointSource(sPainter, vf, *tmpRcmag, s->bV, !isInsideViewport) && s->hasName() && extinctedMagIndex < maxMagStarName && s->hasComponentID()<=1)
+	}
+}
+
+template<class Star>
+void SpecialZoneArray<Star>::createStarBuffer()
+{
+	starBuffer = new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+	if (!starBuffer->create())
+	{
+		qWarning() << "SpecialZoneArray(" << level << "): could not create the star vertex buffer";
+		return;
+	}
+
+	int nbStars = 0;
+	for (unsigned int z=0;z<nr_of_zones;++z)
+		nbStars += getZones()[z].size;
+
+	// The position at a date is linear in the movement factor: keep its value and derivative at J2000
+	QVector<StelSkyDrawer::PointSourceVertex> vertices(nbStars);
+	zoneBufferOffsets.resize(nr_of_zones+1);
+	const float magMin = 0.001f*mag_min;
+	const float k = (0.001f*mag_range)/mag_steps;
+	int n = 0;
+	for (unsigned int z=0;z<nr_of_zones;++z)
+	{
+		zoneBufferOffsets[z] = n;
+		const SpecialZoneData<Star>* zone = getZones() + z;
+		const Star* s = zone->getStars();
+		for (int i=0;i<zone->size;++i,++s,++n)
 		{
-			const float offset = tmpRcmag->radius*0.7f;
-			const Vec3f colorr = StelSkyDrawer::indexToColor(s->bV)*0.75f;
-			sPainter->setColor(colorr[0], colorr[1], colorr[2],names_brightness);
-			sPainter->drawText(Vec3d(vf[0], vf[1], vf[2]), s->getNameI18n(), 0, offset, offset, false);
+			float u0, u1, v0, v1;
+			s->getJ2000Offsets(0.f, u0, u1);
+			s->getJ2000Offsets(1.f, v0, v1);
+			StelSkyDrawer::PointSourceVertex& vertex = vertices[n];
+			vertex.pos = zone->axis0*u0 + zone->axis1*u1 + zone->center;
+			vertex.motion = zone->axis0*(v0-u0) + zone->axis1*(v1-u1);
+			vertex.mag = magMin + k*s->mag;
+			StelSkyDrawer::setPointSourceVertexColor(vertex, s->bV);
 		}
-    }
+	}
+	zoneBufferOffsets[nr_of_zones] = n;
+
+	starBuffer->setUsagePattern(QOpenGLBuffer::StaticDraw);
+	starBuffer->bind();
+	starBuffer->allocate(vertices.constData(), n*sizeof(StelSkyDrawer::PointSourceVertex));
+	starBuffer->release();
+}
+
+// Number of stars of the zone brighter than the given magnitude index. The stars are sorted by magnitude.
+template<class Star>
+static int countStarsBrighterThan(const SpecialZoneData<Star>* zone, int magIndex)
+{
+	const Star* stars = zone->getStars();
+	int lo = 0, hi = zone->size;
+	while (lo < hi)
+	{
+		const int mid = (lo+hi)/2;
+		if ((int)stars[mid].mag < magIndex)
+			lo = mid+1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+template<class Star>
+void SpecialZoneArray<Star>::drawFromBuffer(StelPainter* sPainter, const QVector<int>& zoneIndices, int firstMagIndex,
+					    int limitMagIndex, StelCore* core, float radiusScale)
+{
+	StelSkyDrawer* drawer = core->getSkyDrawer();
+	static const double d2000 = 2451545.0;
+	const float movementFactor = (M_PI/180)*(0.0001/3600) * ((core->getJDay()-d2000)/365.25) / star_position_scale;
+
+	// Same artificial cutoff as draw()
+	int cutoffMagStep=limitMagIndex;
+	if (drawer->getFlagStarMagnitudeLimit())
+	{
+		cutoffMagStep = ((int)(drawer->getCustomStarMagnitudeLimit()*1000.f) - mag_min)*mag_steps/mag_range;
+		if (cutoffMagStep>limitMagIndex)
+			cutoffMagStep = limitMagIndex;
+	}
+	if (zoneIndices.isEmpty() || firstMagIndex>cutoffMagStep)
+		return;
+
+	if (!starBuffer)
+		createStarBuffer();
+	if (!starBuffer->isCreated())
+		return;
+
+	const float cutoffMag = 0.001f*mag_min + (0.001f*mag_range)/mag_steps*cutoffMagStep;
+	drawer->preDrawPointSourceBuffers(sPainter, movementFactor, cutoffMag, radiusScale);
+	foreach (int index, zoneIndices)
+	{
+		const SpecialZoneData<Star>* zone = getZones() + index;
+		const int first = countStarsBrighterThan(zone, firstMagIndex);
+		const int last = countStarsBrighterThan(zone, cutoffMagStep+1);
+		drawer->drawPointSourceBuffer(*starBuffer, zoneBufferOffsets[index]+first, last-first);
+	}
+	drawer->postDrawPointSourceBuffers();
 }
 
 template<class Star>
 void SpecialZoneArray<Star>::searchAround(const StelCore* core, int index, const Vec3d &v, double cosLimFov,
-					  QList<StelObjectP > &result)
+					  int maxMagIndex, QList<StelObjectP > &result)
 {
 	static const double d2000 = 2451545.0;
 	const double movementFactor = (M_PI/180.)*(0.0001/3600.) * ((core->getJDay()-d2000)/365.25)/ star_position_scale;
 	const SpecialZoneData<Star> *const z = getZones()+index;
 	Vec3f tmp;
 	Vec3f vf(v[0], v[1], v[2]);
-	for (const Star* s=z->getStars();s<z->getStars()+z->size;++s)
+	// The stars are sorted by magnitude, the first too faint one ends the search
+	const Star* end = z->getStars()+z->size;
+	for (const Star* s=z->getStars();s<end && (int)s->mag<=maxMagIndex;++s)
 	{
 		s->getJ2000Pos(z,movementFactor, tmp);
 		tmp.normalize();
 		if (tmp*vf >= cosLimFov)
-		{
-			// TODO: do not select stars that are too faint to display
 			result.push_back(s->createStelObject(this,z));
-		}
 	}
 }
 
@@ -26,6 +26,8 @@
 #include <QString>
 #include <QFile>
 #include <QDebug>
+#include <QVector>
+#include <QOpenGLBuffer>
 
 #include "ZoneData.hpp"
 #include "Star.hpp"
@@ -96,13 +98,17 @@ public:
 
 	//! Pure virtual method. See subclass implementation.
 	virtual void searchAround(const StelCore* core, int index,const Vec3d &v,double cosLimFov,
-							  QList<StelObjectP > &result) = 0;
+							  int maxMagIndex, QList<StelObjectP > &result) = 0;
 
 	//! Pure virtual method. See subclass implementation.
 	virtual void draw(StelPainter* sPainter, int index,bool is_inside,
 					  const RCMag* rcmag_table, int limitMagIndex, StelCore* core,
 					  int maxMagStarName, float names_brightness,
-					  const QVector<SphericalCap>& boundingCaps) const = 0;
+					  const QVector<SphericalCap>& boundingCaps, int firstBufferMagIndex) const = 0;
+
+	//! Pure virtual method. See subclass implementation.
+	virtual void drawFromBuffer(StelPainter* sPainter, const QVector<int>& zoneIndices, int firstMagIndex,
+				    int limitMagIndex, StelCore* core, float radiusScale) = 0;
 
 	//! Get whether or not the catalog was successfully loaded.
 	//! @return @c true if at least one zone was loaded, otherwise @c false
@@ -179,18 +185,46 @@ protected:
 	//! @param core core to use for drawing
 	//! @param maxMagStarName magnitude limit of stars that display labels
 	//! @param names_brightness brightness of labels
+	//! @param firstBufferMagIndex if not negative, the stars from this magnitude index
+	//! are left to drawFromBuffer()
 	virtual void draw(StelPainter* sPainter, int index, bool isInsideViewport,
 			  const RCMag *rcmag_table, int limitMagIndex, StelCore* core,
 			  int maxMagStarName, float names_brightness,
-			  const QVector<SphericalCap>& boundingCaps) const;
+			  const QVector<SphericalCap>& boundingCaps, int firstBufferMagIndex) const;
+	//! Draw stars from the persistent vertex buffer of this catalog, which is created on the first call.
+	//! The buffer takes sizeof(StelSkyDrawer::PointSourceVertex) bytes of openGL memory per star of the catalog.
+	//! Only the list of zones goes to openGL: the stars are projected and sized by the vertex shader.
+	//! @param sPainter the painter to use, its projector must be supported by StelSkyDrawer::canDrawPointSourceBuffers()
+	//! @param zoneIndices the zones to draw
+	//! @param firstMagIndex magnitude index of the brightest stars to draw
+	//! @param limitMagIndex magnitude index at which stars are not visible anymore
+	//! @param core core to use for drawing
+	//! @param radiusScale factor applied to the halo radius of the stars
+	virtual void drawFromBuffer(StelPainter* sPainter, const QVector<int>& zoneIndices, int firstMagIndex,
+				    int limitMagIndex, StelCore* core, float radiusScale);
 
 	virtual void scaleAxis();
+	//! Add the stars of a zone within the given angle of a position to a list.
+	//! @param index zone index to search
+	//! @param v the normalized search position
+	//! @param cosLimFov cosine of the search radius
+	//! @param maxMagIndex magnitude index of the faintest stars to add, the search of the zone stops
+	//! at the first fainter star since the stars are sorted by magnitude
+	//! @param result the list of the found stars
 	virtual void searchAround(const StelCore* core, int index,const Vec3d &v,double cosLimFov,
-					  QList<StelObjectP > &result);
+				  int maxMagIndex, QList<StelObjectP > &result);
 
 	Star *stars;
 private:
+	//! Fill starBuffer with the static attributes of all the stars, zone after zone.
+	void createStarBuffer();
+
 	uchar *mmap_start;
+
+	//! Persistent vertex buffer of StelSkyDrawer::PointSourceVertex, NULL until the first drawFromBuffer()
+	QOpenGLBuffer* starBuffer;
+	//! Index of the first vertex of each zone in starBuffer
+	QVector<int> zoneBufferOffsets;
 };
 
 //! @class HipZoneArray
@@ -33,6 +33,7 @@
 #include "gSatWrapper.hpp"
 #include "StelApp.hpp"
 #include "StelCore.hpp"
+#include "StelLocation.hpp"
 #include "StelUtils.hpp"
 
 #include "SolarSystem.hpp"
@@ -40,6 +41,11 @@
 
 #include <QDebug>
 #include <QByteArray>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+
+#include <cfloat>
 
 
 gSatWrapper::gSatWrapper(QString designation, QString tle1, QString tle2)
@@ -137,10 +143,13 @@ void gSatWrapper::setEpoch(double ai_julianDaysEpoch)
 void gSatWrapper::calcObserverECIPosition(Vec3f& ao_position, Vec3f& ao_velocity)
 {
 	const StelLocation& loc   = StelApp::getInstance().getCore()->getCurrentLocation();
+	calcObserverECIPosition(loc.latitude * KDEG2RAD, epoch.toThetaLMST(loc.longitude * KDEG2RAD),
+	                        loc.altitude/1000, ao_position, ao_velocity);
+}
 
-	float radLatitude = loc.latitude * KDEG2RAD;
-	float theta       = epoch.toThetaLMST(loc.longitude * KDEG2RAD);
-
+void gSatWrapper::calcObserverECIPosition(float radLatitude, float theta, float altitudeKm,
+                                          Vec3f& ao_position, Vec3f& ao_velocity)
+{
 	/* Reference:  Explanatory supplement to the Astronomical Almanac, page 209-210. */
 	/* Elipsoid earth model*/
 	/* c = Nlat/a */
@@ -148,30 +157,18 @@ void gSatWrapper::calcObserverECIPosition(Vec3f& ao_position, Vec3f& ao_velocity
 	const float c = 1.f/std::sqrt(1.f + __f*(__f - 2.f)*sinradLatitude*sinradLatitude);
 	const float sq = (1 - __f)*(1 - __f)*c;
 
-	float r = (KEARTHRADIUS*c + loc.altitude/1000)*std::cos(radLatitude);
+	float r = (KEARTHRADIUS*c + altitudeKm)*std::cos(radLatitude);
 	ao_position[0] = r * std::cos(theta);/*kilometers*/
 	ao_position[1] = r * std::sin(theta);
-	ao_position[2] = (KEARTHRADIUS*sq + loc.altitude/1000)*sinradLatitude;
+	ao_position[2] = (KEARTHRADIUS*sq + altitudeKm)*sinradLatitude;
 	ao_velocity[0] = -KMFACTOR*ao_position[1];/*kilometers/second*/
 	ao_velocity[1] =  KMFACTOR*ao_position[0];
 	ao_velocity[2] =  0;
 }
 
-
-
-Vec3f gSatWrapper::getAltAz()
+Vec3f gSatWrapper::calcTopocentricPos(const Vec3f& slantRange, float radLatitude, float theta)
 {
-	const StelLocation& loc   = StelApp::getInstance().getCore()->getCurrentLocation();
 	Vec3f topoSatPos;
-	Vec3f observerECIPos;
-	Vec3f observerECIVel;
-	calcObserverECIPosition(observerECIPos, observerECIVel);
-
-	const Vec3f& satECIPos = getTEMEPos();
-	Vec3f slantRange = satECIPos - observerECIPos;
-
-	const float  radLatitude    = loc.latitude * KDEG2RAD;
-	const float  theta          = epoch.toThetaLMST(loc.longitude * KDEG2RAD);
 
 	const float sinradLatitude = std::sin(radLatitude);
 	const float cosradLatitude = std::cos(radLatitude);
@@ -194,6 +191,19 @@ Vec3f gSatWrapper::getAltAz()
 	return topoSatPos;
 }
 
+Vec3f gSatWrapper::getAltAz()
+{
+	const StelLocation& loc   = StelApp::getInstance().getCore()->getCurrentLocation();
+	Vec3f observerECIPos;
+	Vec3f observerECIVel;
+	calcObserverECIPosition(observerECIPos, observerECIVel);
+
+	const Vec3f& satECIPos = getTEMEPos();
+	Vec3f slantRange = satECIPos - observerECIPos;
+
+	return calcTopocentricPos(slantRange, loc.latitude * KDEG2RAD, epoch.toThetaLMST(loc.longitude * KDEG2RAD));
+}
+
 void  gSatWrapper::getSlantRange(double &ao_slantRange, double &ao_slantRangeRate)
 {
 
@@ -232,49 +242,549 @@ Vec3f gSatWrapper::getSunECIPos()
 // @brief This operation predicts the satellite visibility contidions.
 int gSatWrapper::getVisibilityPredict()
 {
-	float sunSatAngle, Dist;
-	int   visibility;
-
 	const Vec3f satAltAzPos = getAltAz();
-	if (satAltAzPos[2] > 0)
+	if (satAltAzPos[2] <= 0)
+		return NOT_VISIBLE;
+
+	SolarSystem *solsystem = (SolarSystem*)StelApp::getInstance().getModuleMgr().getModule("SolarSystem");
+	Vec3d sunAltAzPos        = solsystem->getSun()->getAltAzPosGeometric(StelApp::getInstance().getCore());
+	return calcVisibility(satAltAzPos, getTEMEPos(), getSunECIPos(), sunAltAzPos[2] > 0.0);
+}
+
+float gSatWrapper::calcShadowDistance(const Vec3f& satECIPos, const Vec3f& sunECIPos)
+{
+	// Cylindrical shadow, as in calcVisibility(), but only on the night side of the Earth
+	const float sunSatAngle = sunECIPos.angle(satECIPos);
+	const float axisDist = sunSatAngle < M_PI/2 ? satECIPos.length() : satECIPos.length()*std::sin(sunSatAngle);
+	return axisDist - KEARTHRADIUS;
+}
+
+int gSatWrapper::calcVisibility(const Vec3f& satAltAzPos, const Vec3f& satECIPos,
+                                const Vec3f& sunECIPos, bool sunAboveHorizon)
+{
+	if (satAltAzPos[2] <= 0)
+		return NOT_VISIBLE;
+
+	if (sunAboveHorizon)
+		return RADAR_SUN;
+
+	const float sunSatAngle = sunECIPos.angle(satECIPos);
+	const float Dist = satECIPos.length()*std::cos(sunSatAngle - (M_PI/2));
+	return (Dist > KEARTHRADIUS) ? VISIBLE : RADAR_NIGHT;
+}
+
+float gSatWrapper::getPhaseAngle()
+{
+	Vec3f sunECIPos = getSunECIPos();
+	return sunECIPos.angle(getTEMEPos());
+}
+
+
+
+
+
+gSatWrapper::EpochContext gSatWrapper::computeEpochContext(double jd)
+{
+	StelCore* core = StelApp::getInstance().getCore();
+	const StelLocation& loc = core->getCurrentLocation();
+	const gTime epochTm(jd);
+
+	EpochContext ctx;
+	ctx.jd = jd;
+	ctx.radLatitude = loc.latitude * KDEG2RAD;
+	ctx.thetaLMST = epochTm.toThetaLMST(loc.longitude * KDEG2RAD);
+	calcObserverECIPosition(ctx.radLatitude, ctx.thetaLMST, loc.altitude/1000,
+	                        ctx.observerECIPos, ctx.observerECIVel);
+
+	SolarSystem *solsystem = (SolarSystem*)StelApp::getInstance().getModuleMgr().getModule("SolarSystem");
+	const Vec3d sunEquinoxEqPos = solsystem->getSun()->getEquinoxEquatorialPos(core);
+	ctx.sunECIPos.set(sunEquinoxEqPos[0]*AU, sunEquinoxEqPos[1]*AU, sunEquinoxEqPos[2]*AU);
+	ctx.sunECIPos += ctx.observerECIPos;
+	ctx.sunAboveHorizon = solsystem->getSun()->getAltAzPosGeometric(core)[2] > 0.0;
+	return ctx;
+}
+
+gSatWrapper::EpochContext gSatWrapper::computeEpochContext(double jd, const StelLocation& loc)
+{
+	const gTime epochTm(jd);
+
+	EpochContext ctx;
+	ctx.jd = jd;
+	ctx.radLatitude = loc.latitude * KDEG2RAD;
+	ctx.thetaLMST = epochTm.toThetaLMST(loc.longitude * KDEG2RAD);
+	calcObserverECIPosition(ctx.radLatitude, ctx.thetaLMST, loc.altitude/1000.f,
+	                        ctx.observerECIPos, ctx.observerECIVel);
+
+	// Low precision geocentric Sun position referred to the equinox of date.
+	// Reference: Astronomical Almanac, section C "Low precision formulas for the Sun"
+	const double n = jd - 2451545.0;
+	const double g = (357.528 + 0.9856003*n) * KDEG2RAD;
+	const double lambda = (280.460 + 0.9856474*n + 1.915*std::sin(g) + 0.020*std::sin(2.*g)) * KDEG2RAD;
+	const double epsilon = (23.439 - 0.0000004*n) * KDEG2RAD;
+	const double r = (1.00014 - 0.01671*std::cos(g) - 0.00014*std::cos(2.*g)) * KAU;
+	ctx.sunECIPos.set(r*std::cos(lambda), r*std::cos(epsilon)*std::sin(lambda), r*std::sin(epsilon)*std::sin(lambda));
+
+	ctx.sunAboveHorizon = calcTopocentricPos(ctx.sunECIPos - ctx.observerECIPos, ctx.radLatitude, ctx.thetaLMST)[2] > 0.f;
+	return ctx;
+}
+
+void gSatWrapper::computeState(const EpochContext& ctx, State& state)
+{
+	epoch = ctx.jd;
+	if (pSatellite)
+		pSatellite->setEpoch(ctx.jd);
+
+	state.temePos  = getTEMEPos();
+	state.temeVel  = getTEMEVel();
+	state.subPoint = getSubPoint();
+
+	const Vec3f slantRange = state.temePos - ctx.observerECIPos;
+	const Vec3f slantRangeVelocity = state.temeVel - ctx.observerECIVel;
+	state.altAz = calcTopocentricPos(slantRange, ctx.radLatitude, ctx.thetaLMST);
+	state.range = slantRange.length();
+	state.rangeRate = slantRange.dot(slantRangeVelocity)/state.range;
+	state.visibility = calcVisibility(state.altAz, state.temePos, ctx.sunECIPos, ctx.sunAboveHorizon);
+	state.phaseAngle = ctx.sunECIPos.angle(state.temePos);
+}
+
+namespace
+{
+// Number of satellites a thread takes at once from the shared counter
+const int SatelliteChunkSize = 16;
+
+// Satellites are taken in chunks from a counter shared by all the threads.
+// Each satellite is propagated through all the epochs by a single thread.
+class SatelliteBatch
+{
+public:
+	SatelliteBatch(const QVector<gSatWrapper*>& satellites, const QVector<gSatWrapper::EpochContext>& epochs,
+	               gSatWrapper::State* states)
+		: satellites(satellites), epochs(epochs), states(states), next(0) {}
+
+	void process()
+	{
+		const int n = satellites.size();
+		const int m = epochs.size();
+		for (int first = next.fetchAndAddOrdered(SatelliteChunkSize); first < n; first = next.fetchAndAddOrdered(SatelliteChunkSize))
+		{
+			const int last = qMin(first+SatelliteChunkSize, n);
+			for (int i=first;i<last;++i)
+			{
+				gSatWrapper* sat = satellites.at(i);
+				for (int j=0;j<m;++j)
+					sat->computeState(epochs.at(j), states[i*m+j]);
+			}
+		}
+	}
+
+private:
+	const QVector<gSatWrapper*>& satellites;
+	const QVector<gSatWrapper::EpochContext>& epochs;
+	gSatWrapper::State* states;
+	QAtomicInt next;
+};
+
+class SatelliteBatchRunnable : public QRunnable
+{
+public:
+	SatelliteBatchRunnable(SatelliteBatch* batch) : batch(batch) {setAutoDelete(true);}
+	virtual void run() {batch->process();}
+private:
+	SatelliteBatch* batch;
+};
+}
+
+void gSatWrapper::computeStates(const QVector<gSatWrapper*>& satellites, const QVector<EpochContext>& epochs,
+                                State* states, QThreadPool* pool)
+{
+	SatelliteBatch batch(satellites, epochs, states);
+	int nbRunnables = 0;
+	if (pool && pool->maxThreadCount() > 1)
 	{
-		const Vec3f satECIPos = getTEMEPos();
-		SolarSystem *solsystem = (SolarSystem*)StelApp::getInstance().getModuleMgr().getModule("SolarSystem");		
-		Vec3d sunAltAzPos        = solsystem->getSun()->getAltAzPosGeometric(StelApp::getInstance().getCore());
+		nbRunnables = qMin(pool->maxThreadCount(), satellites.size()/SatelliteChunkSize);
+		for (int i=0;i<nbRunnables;++i)
+			pool->start(new SatelliteBatchRunnable(&batch));
+	}
+	batch.process();
+	if (nbRunnables > 0)
+		pool->waitForDone();
+}
+
+namespace
+{
+// Number of elevation samples per orbital period used to bracket the culminations.
+// A pass has to be shorter than two samples to be missed, which is about 4 minutes for the ISS.
+const int PassSamplesPerOrbit = 48;
+// Bounds of the sampling step in days
+const double PassMinStep = 20./86400.;
+const double PassMaxStep = 30./1440.;
+// Maximum number of iterations of the Brent's methods
+const int BrentMaxIterations = 100;
+
+// Elevation of the satellite above the minimum elevation, as the difference of the sines
+class ElevationFunction
+{
+public:
+	ElevationFunction(gSatWrapper* sat, const StelLocation& loc, float minElevation)
+		: sat(sat), loc(loc), sinMinElevation(std::sin(minElevation*KDEG2RAD)) {}
+
+	double operator()(double jd)
+	{
+		sat->computeState(gSatWrapper::computeEpochContext(jd, loc), state);
+		return state.altAz[2]/state.range - sinMinElevation;
+	}
+
+	//! State at the last evaluation
+	gSatWrapper::State state;
+
+private:
+	gSatWrapper* sat;
+	const StelLocation& loc;
+	const double sinMinElevation;
+};
 
-		const Vec3f sunECIPos = getSunECIPos();
+// Opposite of the elevation, for the minimiser
+class NegatedElevationFunction
+{
+public:
+	NegatedElevationFunction(ElevationFunction& f) : f(f) {}
+	double operator()(double jd) {return -f(jd);}
+private:
+	ElevationFunction& f;
+};
+
+// Distance to the Earth shadow, negative when the satellite is eclipsed
+class ShadowFunction
+{
+public:
+	ShadowFunction(gSatWrapper* sat, const StelLocation& loc) : sat(sat), loc(loc) {}
+
+	double operator()(double jd)
+	{
+		const gSatWrapper::EpochContext ctx = gSatWrapper::computeEpochContext(jd, loc);
+		sat->computeState(ctx, state);
+		sunAboveHorizon = ctx.sunAboveHorizon;
+		return gSatWrapper::calcShadowDistance(state.temePos, ctx.sunECIPos);
+	}
 
-		if (sunAltAzPos[2] > 0.0)
+	gSatWrapper::State state;
+	bool sunAboveHorizon;
+
+private:
+	gSatWrapper* sat;
+	const StelLocation& loc;
+};
+
+// Brent's root finder. f(a) and f(b) must have opposite signs.
+// Reference: R. P. Brent, Algorithms for Minimization without Derivatives, chapter 4
+template<class F>
+double brentRoot(F& f, double a, double b, double fa, double fb, double tol)
+{
+	double c = b, fc = fb;
+	double d = b-a, e = d;
+	for (int iter=0; iter<BrentMaxIterations; ++iter)
+	{
+		if ((fb > 0. && fc > 0.) || (fb < 0. && fc < 0.))
+		{
+			c = a;
+			fc = fa;
+			d = e = b-a;
+		}
+		if (std::fabs(fc) < std::fabs(fb))
+		{
+			a = b; b = c; c = a;
+			fa = fb; fb = fc; fc = fa;
+		}
+		const double tol1 = 2.*DBL_EPSILON*std::fabs(b) + 0.5*tol;
+		const double xm = 0.5*(c-b);
+		if (std::fabs(xm) <= tol1 || fb == 0.)
+			return b;
+		if (std::fabs(e) >= tol1 && std::fabs(fa) > std::fabs(fb))
 		{
-			visibility = RADAR_SUN;
+			// Secant step when only two points are distinct, else inverse quadratic interpolation
+			double p, q;
+			const double s = fb/fa;
+			if (a == c)
+			{
+				p = 2.*xm*s;
+				q = 1.-s;
+			}
+			else
+			{
+				const double r = fb/fc;
+				q = fa/fc;
+				p = s*(2.*xm*q*(q-r) - (b-a)*(r-1.));
+				q = (q-1.)*(r-1.)*(s-1.);
+			}
+			if (p > 0.)
+				q = -q;
+			p = std::fabs(p);
+			if (2.*p < qMin(3.*xm*q - std::fabs(tol1*q), std::fabs(e*q)))
+			{
+				e = d;
+				d = p/q;
+			}
+			else
+			{
+				// Interpolation failed, bisect
+				d = xm;
+				e = d;
+			}
 		}
 		else
 		{
-			sunSatAngle = sunECIPos.angle(satECIPos);
-			Dist = satECIPos.length()*std::cos(sunSatAngle - (M_PI/2));
+			d = xm;
+			e = d;
+		}
+		a = b;
+		fa = fb;
+		b += std::fabs(d) > tol1 ? d : (xm > 0. ? tol1 : -tol1);
+		fb = f(b);
+	}
+	return b;
+}
 
-			if (Dist > KEARTHRADIUS)
+// Brent's minimiser on [a, b], combining golden section search and parabolic interpolation.
+// Reference: R. P. Brent, Algorithms for Minimization without Derivatives, chapter 5
+template<class F>
+double brentMinimum(F& f, double a, double b, double tol, double& fx)
+{
+	const double cGold = 0.3819660;
+	double x, w, v, fw, fv;
+	double d = 0., e = 0.;
+	x = w = v = a + cGold*(b-a);
+	fx = fw = fv = f(x);
+	for (int iter=0; iter<BrentMaxIterations; ++iter)
+	{
+		const double xm = 0.5*(a+b);
+		const double tol1 = 0.5*tol + 2.*DBL_EPSILON*std::fabs(x);
+		const double tol2 = 2.*tol1;
+		if (std::fabs(x-xm) <= tol2 - 0.5*(b-a))
+			break;
+		bool golden = true;
+		if (std::fabs(e) > tol1)
+		{
+			// Parabola through x, v and w
+			const double r = (x-w)*(fx-fv);
+			double q = (x-v)*(fx-fw);
+			double p = (x-v)*q - (x-w)*r;
+			q = 2.*(q-r);
+			if (q > 0.)
+				p = -p;
+			q = std::fabs(q);
+			const double etemp = e;
+			e = d;
+			if (std::fabs(p) < std::fabs(0.5*q*etemp) && p > q*(a-x) && p < q*(b-x))
 			{
-				visibility = VISIBLE;
+				d = p/q;
+				const double u = x+d;
+				if (u-a < tol2 || b-u < tol2)
+					d = xm >= x ? tol1 : -tol1;
+				golden = false;
 			}
+		}
+		if (golden)
+		{
+			e = x >= xm ? a-x : b-x;
+			d = cGold*e;
+		}
+		const double u = std::fabs(d) >= tol1 ? x+d : x + (d >= 0. ? tol1 : -tol1);
+		const double fu = f(u);
+		if (fu <= fx)
+		{
+			if (u >= x)
+				a = x;
+			else
+				b = x;
+			v = w; fv = fw;
+			w = x; fw = fx;
+			x = u; fx = fu;
+		}
+		else
+		{
+			if (u < x)
+				a = u;
 			else
+				b = u;
+			if (fu <= fw || w == x)
 			{
-				visibility = RADAR_NIGHT;
+				v = w; fv = fw;
+				w = u; fw = fu;
+			}
+			else if (fu <= fv || v == x || v == w)
+			{
+				v = u; fv = fu;
 			}
 		}
 	}
-	else
-		visibility = NOT_VISIBLE;
+	return x;
+}
 
-	return visibility; //TODO: put correct return
+// Azimuth in degrees from North through East of a topocentric position (South, East, Zenith)
+float topocentricAzimuth(const Vec3f& altAz)
+{
+	float az = std::atan2(altAz[1], -altAz[0]) / KDEG2RAD;
+	return az < 0.f ? az + 360.f : az;
+}
 }
 
-float gSatWrapper::getPhaseAngle()
+QVector<gSatWrapper::Pass> gSatWrapper::predictPasses(const StelLocation& loc, double startJD, double endJD,
+                                                      float minElevation, double precisionSeconds)
 {
-	Vec3f sunECIPos = getSunECIPos();
-	return sunECIPos.angle(getTEMEPos());
+	QVector<Pass> passes;
+	if (pSatellite == NULL || endJD <= startJD)
+		return passes;
+
+	double step = PassMaxStep;
+	const double meanMotion = pSatellite->getMeanMotion();
+	if (meanMotion > 0.)
+		step = qBound(PassMinStep, K2PI/meanMotion/1440./PassSamplesPerOrbit, PassMaxStep);
+	const double tol = precisionSeconds/86400.;
+
+	ElevationFunction elevation(this, loc, minElevation);
+	ShadowFunction shadow(this, loc);
+
+	// Coarse sampling of the elevation, stopped if the propagation fails (e.g. decayed orbit)
+	QVector<double> times, values;
+	times.reserve(int((endJD-startJD)/step) + 2);
+	values.reserve(times.capacity());
+	for (int i=0; ; ++i)
+	{
+		const double t = qMin(startJD + i*step, endJD);
+		const double value = elevation(t);
+		if (pSatellite->getErrorCode() != 0)
+			break;
+		times.append(t);
+		values.append(value);
+		if (t >= endJD)
+			break;
+	}
+	const int n = times.size();
+	if (n < 2)
+		return passes;
+	endJD = times.last();
+
+	for (int i=0; i<n; ++i)
+	{
+		// Local maximum of the samples: the culmination is in [times[i-1], times[i+1]]
+		if ((i > 0 && values[i] < values[i-1]) || (i < n-1 && values[i] <= values[i+1]))
+			continue;
+
+		Pass pass;
+		NegatedElevationFunction negated(elevation);
+		double maxValue;
+		pass.culminationJD = brentMinimum(negated, times[qMax(i-1, 0)], times[qMin(i+1, n-1)], tol, maxValue);
+		maxValue = -maxValue;
+		if (maxValue <= 0.)
+			continue;
+		elevation(pass.culminationJD);
+		pass.culminationAzimuth = topocentricAzimuth(elevation.state.altAz);
+		pass.maxElevation = std::asin(elevation.state.altAz[2]/elevation.state.range) / KDEG2RAD;
+
+		// Last sample below the minimum elevation before the culmination, and first one after it
+		int k = i;
+		while (k >= 0 && (times[k] >= pass.culminationJD || values[k] > 0.))
+			--k;
+		int l = i;
+		while (l < n && (times[l] <= pass.culminationJD || values[l] > 0.))
+			++l;
+
+		pass.aosJD = k < 0 ? startJD : brentRoot(elevation, times[k], pass.culminationJD, values[k], maxValue, tol);
+		elevation(pass.aosJD);
+		pass.aosAzimuth = topocentricAzimuth(elevation.state.altAz);
+		pass.losJD = l >= n ? endJD : brentRoot(elevation, pass.culminationJD, times[l], maxValue, values[l], tol);
+		elevation(pass.losJD);
+		pass.losAzimuth = topocentricAzimuth(elevation.state.altAz);
+
+		// Earth shadow transitions during the pass
+		pass.eclipseEntryJD = pass.eclipseExitJD = 0.;
+		const int nbShadowSteps = qMax(1, int(std::ceil((pass.losJD-pass.aosJD)/step)));
+		const double shadowStep = (pass.losJD-pass.aosJD)/nbShadowSteps;
+		double t0 = pass.aosJD;
+		double s0 = shadow(t0);
+		pass.sunlitAtAOS = s0 > 0.;
+		pass.visible = s0 > 0. && !shadow.sunAboveHorizon;
+		for (int j=1; j<=nbShadowSteps; ++j)
+		{
+			const double t1 = j == nbShadowSteps ? pass.losJD : pass.aosJD + j*shadowStep;
+			const double s1 = shadow(t1);
+			pass.visible = pass.visible || (s1 > 0. && !shadow.sunAboveHorizon);
+			if ((s0 > 0.) != (s1 > 0.))
+			{
+				const double transition = brentRoot(shadow, t0, t1, s0, s1, tol);
+				if (s0 > 0.)
+					pass.eclipseEntryJD = transition;
+				else
+					pass.eclipseExitJD = transition;
+			}
+			t0 = t1;
+			s0 = s1;
+		}
+
+		// Several sampled maxima in the same pass (slow satellites): keep the highest one
+		if (!passes.isEmpty() && pass.aosJD <= passes.last().losJD)
+		{
+			if (pass.maxElevation > passes.last().maxElevation)
+				passes.last() = pass;
+		}
+		else
+			passes.append(pass);
+	}
+	return passes;
 }
 
+namespace
+{
+// Same work sharing as SatelliteBatch, one satellite at a time since a
+// prediction over several days is much more work than a propagation.
+class PassBatch
+{
+public:
+	PassBatch(const QVector<gSatWrapper*>& satellites, const StelLocation& loc, double startJD, double endJD,
+	          float minElevation, QVector<gSatWrapper::Pass>* passes)
+		: satellites(satellites), loc(loc), startJD(startJD), endJD(endJD), minElevation(minElevation),
+		  passes(passes), next(0) {}
 
+	void process()
+	{
+		const int n = satellites.size();
+		for (int i = next.fetchAndAddOrdered(1); i < n; i = next.fetchAndAddOrdered(1))
+			passes[i] = satellites.at(i)->predictPasses(loc, startJD, endJD, minElevation);
+	}
 
+private:
+	const QVector<gSatWrapper*>& satellites;
+	const StelLocation& loc;
+	const double startJD;
+	const double endJD;
+	const float minElevation;
+	QVector<gSatWrapper::Pass>* passes;
+	QAtomicInt next;
+};
+
+class PassBatchRunnable : public QRunnable
+{
+public:
+	PassBatchRunnable(PassBatch* batch) : batch(batch) {setAutoDelete(true);}
+	virtual void run() {batch->process();}
+private:
+	PassBatch* batch;
+};
+}
 
+void gSatWrapper::predictPasses(const QVector<gSatWrapper*>& satellites, const StelLocation& loc,
+                                double startJD, double endJD, float minElevation,
+                                QVector<Pass>* passes, QThreadPool* pool)
+{
+	PassBatch batch(satellites, loc, startJD, endJD, minElevation, passes);
+	int nbRunnables = 0;
+	if (pool && pool->maxThreadCount() > 1)
+	{
+		nbRunnables = qMin(pool->maxThreadCount(), satellites.size()-1);
+		for (int i=0;i<nbRunnables;++i)
+			pool->start(new PassBatchRunnable(&batch));
+	}
+	batch.process();
+	if (nbRunnables > 0)
+		pool->waitForDone();
+}
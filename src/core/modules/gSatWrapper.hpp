@@ -30,6 +30,7 @@
 #define _GSATWRAPPER_HPP_ 1
 
 #include <QString>
+#include <QVector>
 
 #include "VecMath.hpp"
 
@@ -42,6 +43,9 @@
 #define  RADAR_NIGHT 3
 #define  NOT_VISIBLE 4
 
+class QThreadPool;
+class StelLocation;
+
 //! Wrapper allowing compatibility between gsat and Stellarium/Qt.
 class gSatWrapper
 {
@@ -50,6 +54,90 @@ public:
 	gSatWrapper(QString designation, QString tle1,QString tle2);
 	~gSatWrapper();
 
+	//! Observer and Sun dependent quantities at one epoch. They are the same for
+	//! every satellite, so batch propagation computes them only once per epoch.
+	struct EpochContext
+	{
+		double jd;            //!< Epoch in Julian Days (UTC)
+		float radLatitude;    //!< Observer latitude in radians
+		float thetaLMST;      //!< Local mean sidereal time in radians
+		Vec3f observerECIPos; //!< Observer ECI position in Km
+		Vec3f observerECIVel; //!< Observer ECI velocity in Km/s
+		Vec3f sunECIPos;      //!< Sun ECI position in Km
+		bool sunAboveHorizon;
+	};
+
+	//! Satellite state at one epoch, as filled by computeState().
+	struct State
+	{
+		Vec3f temePos;   //!< TEME position in Km
+		Vec3f temeVel;   //!< TEME velocity in Km/s
+		Vec3f subPoint;  //!< Latitude, longitude in degrees and altitude in Km
+		Vec3f altAz;     //!< Topocentric position in Km, see getAltAz()
+		double range;     //!< Slant range in Km
+		double rangeRate; //!< Slant range rate in Km/s
+		int visibility;   //!< See getVisibilityPredict()
+		float phaseAngle;
+	};
+
+	//! A pass of the satellite above the observer horizon, as found by predictPasses().
+	//! Times are Julian Days in the time scale given to predictPasses(), angles are in
+	//! degrees and azimuths are measured from North through East.
+	struct Pass
+	{
+		double aosJD;          //!< Acquisition of signal: the satellite rises above the minimum elevation
+		double culminationJD;  //!< Time of maximum elevation
+		double losJD;          //!< Loss of signal: the satellite sets below the minimum elevation
+		float aosAzimuth;
+		float culminationAzimuth;
+		float losAzimuth;
+		float maxElevation;
+		double eclipseEntryJD; //!< Time the satellite enters the Earth shadow during the pass, 0 if it doesn't
+		double eclipseExitJD;  //!< Time the satellite leaves the Earth shadow during the pass, 0 if it doesn't
+		bool sunlitAtAOS;      //!< true if the satellite is out of the Earth shadow at AOS
+		bool visible;          //!< true if the satellite is sunlit while the Sun is below the horizon during the pass
+	};
+
+	//! Compute the epoch context for the current location at Julian Day @a jd.
+	//! This queries StelCore and SolarSystem so it must be called from the main thread.
+	//! As in getSunECIPos(), the Sun position is the one at the current simulation time.
+	static EpochContext computeEpochContext(double jd);
+
+	//! Compute the epoch context for the location @a loc at Julian Day @a jd.
+	//! The Sun position comes from a low precision analytic theory (about 0.01 degree)
+	//! evaluated at @a jd, which is plenty for shadow and twilight tests over long spans.
+	//! Unlike the other overload this doesn't access any global state.
+	static EpochContext computeEpochContext(double jd, const StelLocation& loc);
+
+	//! Propagate the satellite to the epoch of @a ctx and fill @a state.
+	//! This doesn't access any global state: different satellites can be
+	//! computed from different threads at the same time.
+	void computeState(const EpochContext& ctx, State& state);
+
+	//! Propagate N satellites at M epochs.
+	//! @param satellites the N satellites
+	//! @param epochs the M epoch contexts, computed with computeEpochContext()
+	//! @param states array of N*M states, satellite major: states[i*M+j] is satellite i at epoch j
+	//! @param pool if not NULL, the satellites are spread over the threads of this pool
+	static void computeStates(const QVector<gSatWrapper*>& satellites, const QVector<EpochContext>& epochs,
+	                          State* states, QThreadPool* pool=NULL);
+
+	//! Predict the passes of the satellite above @a minElevation degrees between @a startJD and @a endJD.
+	//! The elevation is sampled at a fraction of the orbital period to bracket its maxima, then
+	//! culminations are refined with Brent's minimisation and rise, set and Earth shadow transitions
+	//! with Brent's root finder, so the cost barely depends on @a precisionSeconds.
+	//! Passes in progress at @a startJD or @a endJD are clipped to the interval.
+	//! This changes the epoch of the satellite and doesn't access any global state.
+	QVector<Pass> predictPasses(const StelLocation& loc, double startJD, double endJD,
+	                            float minElevation=0.f, double precisionSeconds=1.);
+
+	//! Predict the passes of N satellites, see predictPasses().
+	//! @param passes array of N pass lists, passes[i] is filled for satellite i
+	//! @param pool if not NULL, the satellites are spread over the threads of this pool
+	static void predictPasses(const QVector<gSatWrapper*>& satellites, const StelLocation& loc,
+	                          double startJD, double endJD, float minElevation,
+	                          QVector<Pass>* passes, QThreadPool* pool=NULL);
+
 	// Operation updateEpoch
 	//! @brief This operation update Epoch timestamp for gSatTEME object
 	//! from Stellarium Julian Date.
@@ -117,6 +205,9 @@ public:
 
 	float getPhaseAngle();
 
+	//! Signed distance in Km of the satellite to the Earth shadow cylinder, negative when eclipsed.
+	static float calcShadowDistance(const Vec3f& satECIPos, const Vec3f& sunECIPos);
+
 private:
 	// Operation calcObserverECIPosition
 	//! @brief This operation compute the observer ECI coordinates in Geocentric
@@ -132,6 +223,18 @@ private:
 	//! @param[out] ao_vel Observer ECI velocity vector measured in Km/s
 	void calcObserverECIPosition(Vec3f &ao_position, Vec3f &ao_vel);
 
+	//! Observer ECI position and velocity for given geodetic latitude (radians),
+	//! local sidereal time (radians) and altitude (Km). See calcObserverECIPosition().
+	static void calcObserverECIPosition(float radLatitude, float theta, float altitudeKm,
+	                                    Vec3f &ao_position, Vec3f &ao_vel);
+
+	//! Rotate the slant range vector into the topocentric horizon frame. See getAltAz().
+	static Vec3f calcTopocentricPos(const Vec3f& slantRange, float radLatitude, float theta);
+
+	//! Visibility condition from topocentric satellite position and Sun data. See getVisibilityPredict().
+	static int calcVisibility(const Vec3f& satAltAzPos, const Vec3f& satECIPos,
+	                          const Vec3f& sunECIPos, bool sunAboveHorizon);
+
 private:
 	gSatTEME *pSatellite;
 	gTime	 epoch;
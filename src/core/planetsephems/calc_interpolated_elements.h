@@ -51,3 +51,20 @@ The user must always supply the same delta_t
 for one set of (*t0,*t1,*t2,e0,e1,e2),
 and of course the same dim and calc_func.
 */
+
+extern
+void CalcInterpolatedElementsData(const double t,double elem[],
+                                  const int dim,
+                                  void (*calc_func)(const double t,double elem[],
+                                                    void *user_data),
+                                  void *user_data,
+                                  const double delta_t,
+                                  double *t0,double e0[],
+                                  double *t1,double e1[],
+                                  double *t2,double e2[]);
+
+/*
+Same as CalcInterpolatedElements, but user_data is passed through
+to (*calc_func)(t,elem,user_data). This allows calc_func to depend on
+parameters (e.g. the body number) without using static variables.
+*/
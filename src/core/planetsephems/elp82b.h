@@ -79,7 +79,21 @@ void GetElp82bCoor(double jd,double xyz[3]);
      ICRF, J2000 and FK5 are the same, while the transformation
      ICRF <-> VSOP87 must be done with the matrix given above.
    */
-     
+
+struct Elp82bContext {
+  double t_0,t_1,t_2;
+  double r_0[3];
+  double r_1[3];
+  double r_2[3];
+};
+  /* The last three lunar positions, 1 hour apart, interpolated for the
+     dates in between. GetElp82bCoor keeps them in a static context.
+  */
+
+void InitElp82bContext(struct Elp82bContext *ctx);
+void GetElp82bCoorR(struct Elp82bContext *ctx,double jd,double xyz[3]);
+  /* Reentrant version of GetElp82bCoor.
+  */
 
 #ifdef __cplusplus
 };
@@ -92,6 +92,27 @@ void GetGust86OsculatingCoor(const double jd0, const double jd, const int body,d
   /* The oculating orbit of epoch jd0, evatuated at jd, is returned.
   */
 
+#define GUST86_DIM (5*6)
+
+struct Gust86Context {
+  double t_0,t_1,t_2;
+  double elem_0[GUST86_DIM];
+  double elem_1[GUST86_DIM];
+  double elem_2[GUST86_DIM];
+  double jd0;
+  double elem[GUST86_DIM];
+};
+  /* Elements of the 5 uranian satellites interpolated around the last
+     dates asked for. The functions above keep them in a static context.
+  */
+
+void InitGust86Context(struct Gust86Context *ctx);
+void GetGust86CoorR(struct Gust86Context *ctx,double jd,int body,double *xyz);
+void GetGust86OsculatingCoorR(struct Gust86Context *ctx,const double jd0,const double jd,
+                              const int body,double *xyz);
+  /* Reentrant versions of GetGust86Coor and GetGust86OsculatingCoor.
+  */
+
 #ifdef __cplusplus
 }
 #endif
@@ -69,6 +69,27 @@ void GetL1OsculatingCoor(const double jd0,const double jd, const int body,double
   /* The oculating orbit of epoch jd0, evatuated at jd, is returned.
   */
 
+struct L1Context {
+  double t_0[4];
+  double t_1[4];
+  double t_2[4];
+  double elem_0[4*6];
+  double elem_1[4*6];
+  double elem_2[4*6];
+  double jd0[4];
+  double elem[4*6];
+};
+  /* Elements of each galilean satellite, interpolated separately.
+     GetL1Coor and GetL1OsculatingCoor keep them in a static context.
+  */
+
+void InitL1Context(struct L1Context *ctx);
+void GetL1CoorR(struct L1Context *ctx,double jd,int body,double *xyz);
+void GetL1OsculatingCoorR(struct L1Context *ctx,const double jd0,const double jd,
+                          const int body,double *xyz);
+  /* Reentrant versions of GetL1Coor and GetL1OsculatingCoor.
+  */
+
 
 #ifdef __cplusplus
 }
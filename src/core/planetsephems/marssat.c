@@ -408,44 +408,54 @@ void GenerateMarsSatToVSOP87(double t,double mars_sat_to_vsop87[9]) {
   }
 }
 
-static double t_0 = -1e100;
-static double t_1 = -1e100;
-static double t_2 = -1e100;
-static double marssat_elem_0[2*6];
-static double marssat_elem_1[2*6];
-static double marssat_elem_2[2*6];
-
 /* 1 day: */
 #define DELTA_T 1.0
 
-static double marssat_jd0 = -1e100;
-static double marssat_elem[2*6];
-
 static void CalcAllMarsSatElem(double t,double elem[12]) {
   CalcMarsSatElem(t,0,elem+(0*6));
   CalcMarsSatElem(t,1,elem+(1*6));
 }
 
-static double mars_sat_to_vsop87[9];
+static struct MarsSatContext marssat_static_context = {
+  -1e100,-1e100,-1e100,{0.0},{0.0},{0.0},-1e100,{0.0},{0.0}
+};
+
+void InitMarsSatContext(struct MarsSatContext *ctx) {
+  ctx->t_0 = -1e100;
+  ctx->t_1 = -1e100;
+  ctx->t_2 = -1e100;
+  ctx->jd0 = -1e100;
+}
 
 void GetMarsSatCoor(double jd,int body,double *xyz) {
-  GetMarsSatOsculatingCoor(jd,jd,body,xyz);
+  GetMarsSatOsculatingCoorR(&marssat_static_context,jd,jd,body,xyz);
 }
 
 void GetMarsSatOsculatingCoor(const double jd0,const double jd,
                               const int body,double *xyz) {
+  GetMarsSatOsculatingCoorR(&marssat_static_context,jd0,jd,body,xyz);
+}
+
+void GetMarsSatCoorR(struct MarsSatContext *ctx,double jd,int body,double *xyz) {
+  GetMarsSatOsculatingCoorR(ctx,jd,jd,body,xyz);
+}
+
+void GetMarsSatOsculatingCoorR(struct MarsSatContext *ctx,
+                               const double jd0,const double jd,
+                               const int body,double *xyz) {
+  const double *const mars_sat_to_vsop87 = ctx->to_vsop87;
   double x[3];
-  if (jd0 != marssat_jd0) {
+  if (jd0 != ctx->jd0) {
     const double t0 = jd0 - 2451545.0 + 6491.5;
-    marssat_jd0 = jd0;
-    CalcInterpolatedElements(t0,marssat_elem,12,
+    ctx->jd0 = jd0;
+    CalcInterpolatedElements(t0,ctx->elem,12,
                              &CalcAllMarsSatElem,DELTA_T,
-                             &t_0,marssat_elem_0,
-                             &t_1,marssat_elem_1,
-                             &t_2,marssat_elem_2);
-    GenerateMarsSatToVSOP87(t0,mars_sat_to_vsop87);
+                             &ctx->t_0,ctx->elem_0,
+                             &ctx->t_1,ctx->elem_1,
+                             &ctx->t_2,ctx->elem_2);
+    GenerateMarsSatToVSOP87(t0,ctx->to_vsop87);
   }
-  EllipticToRectangularA(mars_sat_bodies[body].mu,marssat_elem+(body*6),
+  EllipticToRectangularA(mars_sat_bodies[body].mu,ctx->elem+(body*6),
                          jd-jd0,x);
   xyz[0] = mars_sat_to_vsop87[0]*x[0]
          + mars_sat_to_vsop87[1]*x[1]
@@ -70,6 +70,26 @@ void GetMarsSatOsculatingCoor(const double jd0, const double jd, const int body,
   /* The oculating orbit of epoch jd0, evatuated at jd, is returned.
   */
 
+struct MarsSatContext {
+  double t_0,t_1,t_2;
+  double elem_0[2*6];
+  double elem_1[2*6];
+  double elem_2[2*6];
+  double jd0;
+  double elem[2*6];
+  double to_vsop87[9];
+};
+  /* Elements of Phobos and Deimos with the rotation to VSOP87 of their
+     date. The functions above keep them in a static context.
+  */
+
+void InitMarsSatContext(struct MarsSatContext *ctx);
+void GetMarsSatCoorR(struct MarsSatContext *ctx,double jd,int body,double *xyz);
+void GetMarsSatOsculatingCoorR(struct MarsSatContext *ctx,const double jd0,const double jd,
+                               const int body,double *xyz);
+  /* Reentrant versions of GetMarsSatCoor and GetMarsSatOsculatingCoor.
+  */
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,6 +22,61 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 #include "l1.h"
 #include "tass17.h"
 #include "gust86.h"
+#include "stellplanet.h"
+
+#include <stdlib.h>
+
+struct CoordsvContext {
+  struct Vsop87Context vsop87;
+  struct Elp82bContext elp82b;
+  struct MarsSatContext marssat;
+  struct L1Context l1;
+  struct Tass17Context tass17;
+  struct Gust86Context gust86;
+};
+
+struct CoordsvContext *create_coordsv_context(void) {
+  struct CoordsvContext *ctx = (struct CoordsvContext*)malloc(sizeof(struct CoordsvContext));
+  if (ctx) {
+    InitVsop87Context(&ctx->vsop87);
+    InitElp82bContext(&ctx->elp82b);
+    InitMarsSatContext(&ctx->marssat);
+    InitL1Context(&ctx->l1);
+    InitTass17Context(&ctx->tass17);
+    InitGust86Context(&ctx->gust86);
+  }
+  return ctx;
+}
+
+void delete_coordsv_context(struct CoordsvContext *ctx) {
+  free(ctx);
+}
+
+  /* Use the cache of the body when it has one, the static one of the theory otherwise */
+static void vsop87_coor(void *ctx,double jd,int body,double *xyz) {
+  if (ctx) GetVsop87CoorR(&((struct CoordsvContext*)ctx)->vsop87,jd,body,xyz);
+  else GetVsop87Coor(jd,body,xyz);
+}
+static void elp82b_coor(void *ctx,double jd,double *xyz) {
+  if (ctx) GetElp82bCoorR(&((struct CoordsvContext*)ctx)->elp82b,jd,xyz);
+  else GetElp82bCoor(jd,xyz);
+}
+static void marssat_coor(void *ctx,double jd,int body,double *xyz) {
+  if (ctx) GetMarsSatCoorR(&((struct CoordsvContext*)ctx)->marssat,jd,body,xyz);
+  else GetMarsSatCoor(jd,body,xyz);
+}
+static void l1_coor(void *ctx,double jd,int body,double *xyz) {
+  if (ctx) GetL1CoorR(&((struct CoordsvContext*)ctx)->l1,jd,body,xyz);
+  else GetL1Coor(jd,body,xyz);
+}
+static void tass17_coor(void *ctx,double jd,int body,double *xyz) {
+  if (ctx) GetTass17CoorR(&((struct CoordsvContext*)ctx)->tass17,jd,body,xyz);
+  else GetTass17Coor(jd,body,xyz);
+}
+static void gust86_coor(void *ctx,double jd,int body,double *xyz) {
+  if (ctx) GetGust86CoorR(&((struct CoordsvContext*)ctx)->gust86,jd,body,xyz);
+  else GetGust86Coor(jd,body,xyz);
+}
 
 /* Chapter 31 Pg 206-207 Equ 31.1 31.2 , 31.3 using VSOP 87
  * Calculate planets rectangular heliocentric ecliptical coordinates
@@ -37,15 +92,15 @@ void get_pluto_helio_coordsv(double jd,double xyz[3], void* unused)
 void get_sun_helio_coordsv(double jd,double xyz[3], void* unused)
   {xyz[0]=0.; xyz[1]=0.; xyz[2]=0.;}
 
-void get_mercury_helio_coordsv(double jd,double xyz[3], void* unused)
-  {GetVsop87Coor(jd,VSOP87_MERCURY,xyz);}
-void get_venus_helio_coordsv(double jd,double xyz[3], void* unused)
-  {GetVsop87Coor(jd,VSOP87_VENUS,xyz);}
+void get_mercury_helio_coordsv(double jd,double xyz[3], void* ctx)
+  {vsop87_coor(ctx,jd,VSOP87_MERCURY,xyz);}
+void get_venus_helio_coordsv(double jd,double xyz[3], void* ctx)
+  {vsop87_coor(ctx,jd,VSOP87_VENUS,xyz);}
 
-void get_earth_helio_coordsv(const double jd,double xyz[3]) {
+void get_earth_helio_coordsv(const double jd,double xyz[3], void* ctx) {
   double moon[3];
-  GetVsop87Coor(jd,VSOP87_EMB,xyz);
-  GetElp82bCoor(jd,moon);
+  vsop87_coor(ctx,jd,VSOP87_EMB,xyz);
+  elp82b_coor(ctx,jd,moon);
     /* Earth != EMB:
        0.0121505677733761 = mu_m/(1+mu_m),
        mu_m = mass(moon)/mass(earth) = 0.01230002 */
@@ -54,16 +109,16 @@ void get_earth_helio_coordsv(const double jd,double xyz[3]) {
   xyz[2] -= 0.0121505677733761 * moon[2];
 }
 
-void get_mars_helio_coordsv(double jd,double xyz[3], void* unused)
-  {GetVsop87Coor(jd,VSOP87_MARS,xyz);}
-void get_jupiter_helio_coordsv(double jd,double xyz[3], void* unused)
-  {GetVsop87Coor(jd,VSOP87_JUPITER,xyz);}
-void get_saturn_helio_coordsv(double jd,double xyz[3], void* unused)
-  {GetVsop87Coor(jd,VSOP87_SATURN,xyz);}
-void get_uranus_helio_coordsv(double jd,double xyz[3], void* unused)
-  {GetVsop87Coor(jd,VSOP87_URANUS,xyz);}
-void get_neptune_helio_coordsv(double jd,double xyz[3], void* unused)
-  {GetVsop87Coor(jd,VSOP87_NEPTUNE,xyz);}
+void get_mars_helio_coordsv(double jd,double xyz[3], void* ctx)
+  {vsop87_coor(ctx,jd,VSOP87_MARS,xyz);}
+void get_jupiter_helio_coordsv(double jd,double xyz[3], void* ctx)
+  {vsop87_coor(ctx,jd,VSOP87_JUPITER,xyz);}
+void get_saturn_helio_coordsv(double jd,double xyz[3], void* ctx)
+  {vsop87_coor(ctx,jd,VSOP87_SATURN,xyz);}
+void get_uranus_helio_coordsv(double jd,double xyz[3], void* ctx)
+  {vsop87_coor(ctx,jd,VSOP87_URANUS,xyz);}
+void get_neptune_helio_coordsv(double jd,double xyz[3], void* ctx)
+  {vsop87_coor(ctx,jd,VSOP87_NEPTUNE,xyz);}
 
 void get_mercury_helio_osculating_coords(double jd0,double jd,double xyz[3])
   {GetVsop87OsculatingCoor(jd0,jd,VSOP87_MERCURY,xyz);}
@@ -89,48 +144,48 @@ void get_neptune_helio_osculating_coords(double jd0,double jd,double xyz[3])
  * Michelle Chapront-Touze and Jean Chapront of the Bureau des Longitudes,
  * Paris. ELP 2000-82B theory
  * param jd Julian day, rect pos */
-void get_lunar_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetElp82bCoor(jd,xyz);}
-
-void get_phobos_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetMarsSatCoor(jd,MARS_SAT_PHOBOS,xyz);}
-void get_deimos_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetMarsSatCoor(jd,MARS_SAT_DEIMOS,xyz);}
-
-void get_io_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetL1Coor(jd,L1_IO,xyz);}
-void get_europa_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetL1Coor(jd,L1_EUROPA,xyz);}
-void get_ganymede_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetL1Coor(jd,L1_GANYMEDE,xyz);}
-void get_callisto_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetL1Coor(jd,L1_CALLISTO,xyz);}
-
-void get_mimas_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetTass17Coor(jd,TASS17_MIMAS,xyz);}
-void get_enceladus_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetTass17Coor(jd,TASS17_ENCELADUS,xyz);}
-void get_tethys_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetTass17Coor(jd,TASS17_TETHYS,xyz);}
-void get_dione_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetTass17Coor(jd,TASS17_DIONE,xyz);}
-void get_rhea_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetTass17Coor(jd,TASS17_RHEA,xyz);}
-void get_titan_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetTass17Coor(jd,TASS17_TITAN,xyz);}
-void get_hyperion_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetTass17Coor(jd,TASS17_HYPERION,xyz);}
-void get_iapetus_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetTass17Coor(jd,TASS17_IAPETUS,xyz);}
-
-void get_miranda_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetGust86Coor(jd,GUST86_MIRANDA,xyz);}
-void get_ariel_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetGust86Coor(jd,GUST86_ARIEL,xyz);}
-void get_umbriel_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetGust86Coor(jd,GUST86_UMBRIEL,xyz);}
-void get_titania_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetGust86Coor(jd,GUST86_TITANIA,xyz);}
-void get_oberon_parent_coordsv(double jd,double xyz[3], void* unused)
-  {GetGust86Coor(jd,GUST86_OBERON,xyz);}
+void get_lunar_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {elp82b_coor(ctx,jd,xyz);}
+
+void get_phobos_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {marssat_coor(ctx,jd,MARS_SAT_PHOBOS,xyz);}
+void get_deimos_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {marssat_coor(ctx,jd,MARS_SAT_DEIMOS,xyz);}
+
+void get_io_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {l1_coor(ctx,jd,L1_IO,xyz);}
+void get_europa_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {l1_coor(ctx,jd,L1_EUROPA,xyz);}
+void get_ganymede_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {l1_coor(ctx,jd,L1_GANYMEDE,xyz);}
+void get_callisto_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {l1_coor(ctx,jd,L1_CALLISTO,xyz);}
+
+void get_mimas_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {tass17_coor(ctx,jd,TASS17_MIMAS,xyz);}
+void get_enceladus_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {tass17_coor(ctx,jd,TASS17_ENCELADUS,xyz);}
+void get_tethys_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {tass17_coor(ctx,jd,TASS17_TETHYS,xyz);}
+void get_dione_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {tass17_coor(ctx,jd,TASS17_DIONE,xyz);}
+void get_rhea_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {tass17_coor(ctx,jd,TASS17_RHEA,xyz);}
+void get_titan_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {tass17_coor(ctx,jd,TASS17_TITAN,xyz);}
+void get_hyperion_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {tass17_coor(ctx,jd,TASS17_HYPERION,xyz);}
+void get_iapetus_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {tass17_coor(ctx,jd,TASS17_IAPETUS,xyz);}
+
+void get_miranda_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {gust86_coor(ctx,jd,GUST86_MIRANDA,xyz);}
+void get_ariel_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {gust86_coor(ctx,jd,GUST86_ARIEL,xyz);}
+void get_umbriel_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {gust86_coor(ctx,jd,GUST86_UMBRIEL,xyz);}
+void get_titania_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {gust86_coor(ctx,jd,GUST86_TITANIA,xyz);}
+void get_oberon_parent_coordsv(double jd,double xyz[3], void* ctx)
+  {gust86_coor(ctx,jd,GUST86_OBERON,xyz);}
 
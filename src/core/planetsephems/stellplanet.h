@@ -23,6 +23,17 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 extern "C" {
 #endif
 
+struct CoordsvContext;
+  /* Interpolation caches of the theories used by the get_*_coordsv functions.
+     Given as their last argument, it lets several bodies be computed from
+     different threads, each body having its own context. With NULL they
+     use the static caches of the theories and are not reentrant.
+     The get_*_osculating_coords functions always use the static caches.
+  */
+
+struct CoordsvContext *create_coordsv_context(void);
+void delete_coordsv_context(struct CoordsvContext *ctx);
+
 void get_sun_helio_coordsv(double jd,double xyz[3], void*);
 void get_mercury_helio_coordsv(double jd,double xyz[3], void*);
 void get_venus_helio_coordsv(double jd,double xyz[3], void*);
@@ -69,6 +69,27 @@ extern "C" {
 void GetTass17Coor(double jd,int body,double *xyz);
 void GetTass17OsculatingCoor(const double jd0,const double jd, const int body,double *xyz);
 
+#define TASS17_DIM (8*6)
+
+struct Tass17Context {
+  double t_0,t_1,t_2;
+  double elem_0[TASS17_DIM];
+  double elem_1[TASS17_DIM];
+  double elem_2[TASS17_DIM];
+  double jd0;
+  double elem[TASS17_DIM];
+};
+  /* Elements of the 8 saturnian satellites interpolated around the last
+     dates asked for. The functions above keep them in a static context.
+  */
+
+void InitTass17Context(struct Tass17Context *ctx);
+void GetTass17CoorR(struct Tass17Context *ctx,double jd,int body,double *xyz);
+void GetTass17OsculatingCoorR(struct Tass17Context *ctx,const double jd0,const double jd,
+                              const int body,double *xyz);
+  /* Reentrant versions of GetTass17Coor and GetTass17OsculatingCoor.
+  */
+
 #ifdef __cplusplus
 }
 #endif
@@ -72,6 +72,28 @@ void GetVsop87OsculatingCoor(const double jd0,const double jd, const int body,do
   /* The oculating orbit of epoch jd0, evatuated at jd, is returned.
   */
 
+#define VSOP87_DIM (8*6)
+
+struct Vsop87Context {
+  double t_0,t_1,t_2;
+  double elem_0[VSOP87_DIM];
+  double elem_1[VSOP87_DIM];
+  double elem_2[VSOP87_DIM];
+  double jd0;
+  double elem[VSOP87_DIM];
+};
+  /* Elements of the 8 planets interpolated around the last dates asked for.
+     GetVsop87Coor and GetVsop87OsculatingCoor keep theirs in a static
+     context, see stellplanet.h for the per body ones.
+  */
+
+void InitVsop87Context(struct Vsop87Context *ctx);
+void GetVsop87CoorR(struct Vsop87Context *ctx,double jd,int body,double *xyz);
+void GetVsop87OsculatingCoorR(struct Vsop87Context *ctx,const double jd0,const double jd,
+                              const int body,double *xyz);
+  /* Reentrant versions of GetVsop87Coor and GetVsop87OsculatingCoor.
+  */
+
 #ifdef __cplusplus
 }
 #endif
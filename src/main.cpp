@@ -26,6 +26,8 @@
 #include "CLIProcessor.hpp"
 #include "StelIniParser.hpp"
 #include "StelUtils.hpp"
+#include "StelBenchmark.hpp"
+#include "Satellites.hpp"
 
 #include <QDebug>
 
@@ -307,6 +309,24 @@ int main(int argc, char **argv)
 	CustomQTranslator trans;
 	app.installTranslator(&trans);
 
+	// Benchmark mode: run the scenarios offscreen without any view and quit
+	if (qApp->property("onetime_benchmark").isValid())
+	{
+		const int ret = StelBenchmark::exec();
+		delete confSettings;
+		StelLogger::deinit();
+		return ret;
+	}
+
+	// Pass prediction mode: print the satellite passes without any view and quit
+	if (qApp->property("onetime_predict_passes").isValid())
+	{
+		const int ret = Satellites::execPassPrediction(confSettings);
+		delete confSettings;
+		StelLogger::deinit();
+		return ret;
+	}
+
 #ifndef USE_QUICKVIEW
 	if (!QGLFormat::hasOpenGL())
 	{
@@ -29,6 +29,7 @@
 #include "MeteorMgr.hpp"
 #include "NebulaMgr.hpp"
 #include "Planet.hpp"
+#include "Satellites.hpp"
 #include "SolarSystem.hpp"
 #include "StarMgr.hpp"
 #include "StelApp.hpp"
@@ -45,9 +46,11 @@
 #include "StelObject.hpp"
 #include "StelObjectMgr.hpp"
 #include "StelProjector.hpp"
+#include "StelProfiler.hpp"
 #include "StelSkyCultureMgr.hpp"
 #include "StelSkyDrawer.hpp"
 #include "StelSkyLayerMgr.hpp"
+#include "StelTextureMgr.hpp"
 #include "StelUtils.hpp"
 #include "StelGuiBase.hpp"
 #include "MilkyWay.hpp"
@@ -851,6 +854,65 @@ QVariantMap StelMainScriptAPI::getSelectedObjectInfo()
 }
 
 
+QVariantList StelMainScriptAPI::getSatellitePasses(const QString& id, double days, double minElevation)
+{
+	QVariantList list;
+	Satellites* satellites = GETSTELMODULE(Satellites);
+	const QVector<gSatWrapper::Pass> passes = satellites->predictPasses(QStringList(id), getJDay(), days, minElevation).value(id);
+	foreach (const gSatWrapper::Pass& pass, passes)
+	{
+		QVariantMap map;
+		map.insert("aos", pass.aosJD);
+		map.insert("aos-azimuth", pass.aosAzimuth);
+		map.insert("culmination", pass.culminationJD);
+		map.insert("culmination-azimuth", pass.culminationAzimuth);
+		map.insert("max-elevation", pass.maxElevation);
+		map.insert("los", pass.losJD);
+		map.insert("los-azimuth", pass.losAzimuth);
+		if (pass.eclipseEntryJD > 0.)
+			map.insert("eclipse-entry", pass.eclipseEntryJD);
+		if (pass.eclipseExitJD > 0.)
+			map.insert("eclipse-exit", pass.eclipseExitJD);
+		map.insert("visible", pass.visible);
+		list.append(map);
+	}
+	return list;
+}
+
+void StelMainScriptAPI::setProfilerEnabled(bool b)
+{
+	StelProfiler::setEnabled(b);
+}
+
+QVariantMap StelMainScriptAPI::getProfilerStatistics()
+{
+	return StelProfiler::getStatistics();
+}
+
+bool StelMainScriptAPI::dumpProfilerTrace(const QString& fileName)
+{
+	if (QFileInfo(fileName).isAbsolute())
+		return StelProfiler::dumpChromeTrace(fileName);
+	return StelProfiler::dumpChromeTrace(StelFileMgr::getUserDir() + "/" + fileName);
+}
+
+QVariantMap StelMainScriptAPI::getTextureCacheStatistics()
+{
+	const StelTextureMgr::Statistics s = StelApp::getInstance().getTextureManager().getStatistics();
+	QVariantMap map;
+	map["residentBytes"] = s.residentBytes;
+	map["budgetBytes"] = s.budgetBytes;
+	map["residentTextures"] = s.residentTextures;
+	map["hits"] = s.hits;
+	map["misses"] = s.misses;
+	map["hitRate"] = s.hits+s.misses>0 ? (double)s.hits/(s.hits+s.misses) : 0.;
+	map["evictions"] = s.evictions;
+	map["prefetches"] = s.prefetches;
+	map["prefetchHits"] = s.prefetchHits;
+	map["prefetchHitRate"] = s.prefetches>0 ? (double)s.prefetchHits/s.prefetches : 0.;
+	return map;
+}
+
 void StelMainScriptAPI::clear(const QString& state)
 {
 	LandscapeMgr* lmgr = GETSTELMODULE(LandscapeMgr);
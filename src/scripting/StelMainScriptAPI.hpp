@@ -187,6 +187,43 @@ public slots:
 	//! - localized-name : localized name
 	QVariantMap getSelectedObjectInfo();
 
+	//! Predict the passes of a satellite over the current location.
+	//! @param id the identifier (NORAD number) of the satellite
+	//! @param days length of the prediction in days, starting at the current simulation time
+	//! @param minElevation minimum elevation of the passes in decimal degrees
+	//! @return a list of maps, one per pass.  Keys:
+	//! - aos, culmination, los : Julian Days of rise, maximum elevation and set
+	//! - aos-azimuth, culmination-azimuth, los-azimuth : azimuths in decimal degrees
+	//! - max-elevation : maximum elevation in decimal degrees
+	//! - eclipse-entry, eclipse-exit : Julian Days of the Earth shadow transitions, when they occur
+	//! - visible : true if the satellite may be seen with the naked eye during the pass
+	QVariantList getSatellitePasses(const QString& id, double days=1., double minElevation=0.);
+
+	//! Start or stop the recording of the time spent in the modules and in some of their hot functions.
+	//! @param b if true, the profiler records the last few thousands of measures.
+	void setProfilerEnabled(bool b);
+
+	//! Get the statistics of the profiler over the recorded measures.
+	//! @return a map from the measured scope names (e.g. "StarMgr::draw") to maps with the keys:
+	//! - count : number of measures
+	//! - mean, p50, p90, p99, max : mean, percentiles and maximum of the durations in milliseconds
+	QVariantMap getProfilerStatistics();
+
+	//! Write the recorded measures in the Chrome trace format, to be opened in chrome://tracing.
+	//! @param fileName a file name, relative to the user directory if it is not absolute.
+	//! @return true if the file was written.
+	bool dumpProfilerTrace(const QString& fileName);
+
+	//! Get the usage of the texture cache.
+	//! @return a map with the keys:
+	//! - residentBytes, budgetBytes : estimated openGL memory used by the loaded textures, and its budget
+	//! - residentTextures : number of loaded textures
+	//! - hits, misses, hitRate : textures shared with a previous request, new textures, and the ratio of shared ones
+	//! - evictions : number of textures unloaded to stay in the budget
+	//! - prefetches, prefetchHits, prefetchHitRate : textures loaded in advance, the ones which were ready
+	//!   when first displayed, and their ratio
+	QVariantMap getTextureCacheStatistics();
+
 	//! Clear the display options, setting a "standard" view.
 	//! Preset states:
 	//! - natural : azimuthal mount, atmosphere, landscape,
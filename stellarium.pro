@@ -127,15 +127,19 @@ HEADERS += \
 	src/core/StelActionMgr.hpp \
 	src/core/StelApp.hpp \
 	src/core/StelAudioMgr.hpp \
+	src/core/StelBenchmark.hpp \
 	src/core/StelCore.hpp \
+	src/core/StelDeltaTTable.hpp \
 	src/core/StelFader.hpp \
 	src/core/StelFileMgr.hpp \
 	src/core/StelGeodesicGrid.hpp \
+	src/core/StelGlyphAtlas.hpp \
 	src/core/StelGuiBase.hpp \
 	src/core/StelIniParser.hpp \
 	src/core/StelJsonParser.hpp \
 	src/core/StelLocaleMgr.hpp \
 	src/core/StelLocation.hpp \
+	src/core/StelLocationDatabase.hpp \
 	src/core/StelLocationMgr.hpp \
 	src/core/StelModule.hpp \
 	src/core/StelModuleMgr.hpp \
@@ -147,6 +151,7 @@ HEADERS += \
 	src/core/StelObserver.hpp \
 	src/core/StelPainter.hpp \
 	src/core/StelPluginInterface.hpp \
+	src/core/StelProfiler.hpp \
 	src/core/StelProjectorClasses.hpp \
 	src/core/StelProjector.hpp \
 	src/core/StelProjectorType.hpp \
@@ -154,6 +159,7 @@ HEADERS += \
 	src/core/StelRegionObject.hpp \
 	src/core/StelSkyCultureMgr.hpp \
 	src/core/StelSkyDrawer.hpp \
+	src/core/StelSkyImageIndex.hpp \
 	src/core/StelSkyImageTile.hpp \
 	src/core/StelSkyLayer.hpp \
 	src/core/StelSkyLayerMgr.hpp \
@@ -180,8 +186,8 @@ HEADERS += \
 	src/core/modules/LabelMgr.hpp \
 	src/core/modules/Landscape.hpp \
 	src/core/modules/LandscapeMgr.hpp \
-	src/core/modules/Meteor.hpp \
 	src/core/modules/MeteorMgr.hpp \
+	src/core/modules/MeteorPool.hpp \
 	src/core/modules/MilkyWay.hpp \
 	src/core/modules/MinorPlanet.hpp \
 	src/core/modules/Nebula.hpp \
@@ -197,6 +203,7 @@ HEADERS += \
 	src/core/modules/Solve.hpp \
 	src/core/modules/Star.hpp \
 	src/core/modules/StarMgr.hpp \
+	src/core/modules/StarNameTable.hpp \
 	src/core/modules/StarWrapper.hpp \
 	src/core/modules/ZoneArray.hpp \
 	src/core/modules/ZoneData.hpp \
@@ -289,14 +296,19 @@ SOURCES += \
 	src/core/StelActionMgr.cpp \
 	src/core/StelApp.cpp \
 	src/core/StelAudioMgr.cpp \
+	src/core/StelBenchmark.cpp \
 	src/core/StelCore.cpp \
+	src/core/StelDeltaTTable.cpp \
+	src/core/StelFader.cpp \
 	src/core/StelFileMgr.cpp \
 	src/core/StelGeodesicGrid.cpp \
+	src/core/StelGlyphAtlas.cpp \
 	src/core/StelGuiBase.cpp \
 	src/core/StelIniParser.cpp \
 	src/core/StelJsonParser.cpp \
 	src/core/StelLocaleMgr.cpp \
 	src/core/StelLocation.cpp \
+	src/core/StelLocationDatabase.cpp \
 	src/core/StelLocationMgr.cpp \
 	src/core/StelModule.cpp \
 	src/core/StelModuleMgr.cpp \
@@ -306,10 +318,12 @@ SOURCES += \
 	src/core/StelObjectModule.cpp \
 	src/core/StelObserver.cpp \
 	src/core/StelPainter.cpp \
+	src/core/StelProfiler.cpp \
 	src/core/StelProjectorClasses.cpp \
 	src/core/StelProjector.cpp \
 	src/core/StelSkyCultureMgr.cpp \
 	src/core/StelSkyDrawer.cpp \
+	src/core/StelSkyImageIndex.cpp \
 	src/core/StelSkyImageTile.cpp \
 	src/core/StelSkyLayer.cpp \
 	src/core/StelSkyLayerMgr.cpp \
@@ -335,8 +349,8 @@ SOURCES += \
 	src/core/modules/LabelMgr.cpp \
 	src/core/modules/Landscape.cpp \
 	src/core/modules/LandscapeMgr.cpp \
-	src/core/modules/Meteor.cpp \
 	src/core/modules/MeteorMgr.cpp \
+	src/core/modules/MeteorPool.cpp \
 	src/core/modules/MilkyWay.cpp \
 	src/core/modules/MinorPlanet.cpp \
 	src/core/modules/Nebula.cpp \
@@ -351,6 +365,7 @@ SOURCES += \
 	src/core/modules/SolarSystem.cpp \
 	src/core/modules/Star.cpp \
 	src/core/modules/StarMgr.cpp \
+	src/core/modules/StarNameTable.cpp \
 	src/core/modules/StarWrapper.cpp \
 	src/core/modules/ZoneArray.cpp \
 	src/core/external/glues_stel/source/glues_error.c \